@@ -20,7 +20,12 @@ int main(int argc, char **argv)
     uint32_t num_threads, R, L, disk_PQ, build_PQ, QD, Lf, filter_threshold;
     float B, M;
     bool append_reorder_data = false;
+    bool locality_layout = false;
+    bool packed_nhoods = false;
+    bool decoupled_layout = false;
+    bool pq_4bit = false;
     bool use_opq = false;
+    std::vector<std::string> stripe_dirs;
 
     po::options_description desc{
         program_options_utils::make_program_description("build_disk_index", "Build a disk-based index.")};
@@ -63,6 +68,21 @@ int main(int argc, char **argv)
         optional_configs.add_options()("append_reorder_data", po::bool_switch()->default_value(false),
                                        "Include full precision data in the index. Use only in "
                                        "conjuction with compressed data on SSD.");
+        optional_configs.add_options()("locality_layout", po::bool_switch(&locality_layout)->default_value(false),
+                                       "Write nodes to the SSD in BFS order from the medoid instead of id order, so "
+                                       "that graph neighbors tend to share sectors.");
+        optional_configs.add_options()("packed_nhoods", po::bool_switch(&packed_nhoods)->default_value(false),
+                                       "Store neighbor lists on the SSD sorted and delta encoded, so that more nodes "
+                                       "fit in a sector.");
+        optional_configs.add_options()("decoupled_layout", po::bool_switch(&decoupled_layout)->default_value(false),
+                                       "Store only the graph in the nodes on the SSD and the full precision vectors "
+                                       "in a separate region, read only to rerank the final candidates.");
+        optional_configs.add_options()("pq_4bit", po::bool_switch(&pq_4bit)->default_value(false),
+                                       "Compress the in-memory PQ vectors with 16 centers per chunk, two chunks per "
+                                       "byte, so that search scores neighbors with SIMD fast-scan lookups.");
+        optional_configs.add_options()("stripe_dirs", po::value<std::vector<std::string>>(&stripe_dirs)->multitoken(),
+                                       "Directories, one per device, to split the disk index file over so that "
+                                       "search reads from all the devices at once.");
         optional_configs.add_options()("build_PQ_bytes", po::value<uint32_t>(&build_PQ)->default_value(0),
                                        program_options_utils::BUIlD_GRAPH_PQ_BYTES);
         optional_configs.add_options()("use_opq", po::bool_switch()->default_value(false),
@@ -133,11 +153,36 @@ int main(int argc, char **argv)
         }
     }
 
+    if (decoupled_layout && disk_PQ != 0)
+    {
+        std::cout << "Error: A decoupled layout stores full precision vectors; use --append_reorder_data with "
+                     "vectors compressed on disk."
+                  << std::endl;
+        return -1;
+    }
+
     std::string params = std::string(std::to_string(R)) + " " + std::string(std::to_string(L)) + " " +
                          std::string(std::to_string(B)) + " " + std::string(std::to_string(M)) + " " +
                          std::string(std::to_string(num_threads)) + " " + std::string(std::to_string(disk_PQ)) + " " +
                          std::string(std::to_string(append_reorder_data)) + " " +
-                         std::string(std::to_string(build_PQ)) + " " + std::string(std::to_string(QD));
+                         std::string(std::to_string(build_PQ)) + " " + std::string(std::to_string(QD)) + " " +
+                         std::string(std::to_string(locality_layout)) + " " +
+                         std::string(std::to_string(packed_nhoods)) + " " +
+                         std::string(std::to_string(decoupled_layout)) + " " + std::string(std::to_string(pq_4bit));
+    if (!stripe_dirs.empty())
+    {
+        std::string stripe_dirs_param;
+        for (auto &dir : stripe_dirs)
+        {
+            if (dir.find_first_of(", \t") != std::string::npos)
+            {
+                std::cout << "Error: stripe directories can not contain commas or spaces: " << dir << std::endl;
+                return -1;
+            }
+            stripe_dirs_param += (stripe_dirs_param.empty() ? "" : ",") + dir;
+        }
+        params += " " + stripe_dirs_param;
+    }
 
     try
     {
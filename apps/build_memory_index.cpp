@@ -24,7 +24,8 @@ namespace po = boost::program_options;
 
 int main(int argc, char **argv)
 {
-    std::string data_type, dist_fn, data_path, index_path_prefix, label_file, universal_label, label_type;
+    std::string data_type, dist_fn, data_path, index_path_prefix, label_file, universal_label, label_type,
+        graph_store;
     uint32_t num_threads, R, L, Lf, build_PQ_bytes;
     float alpha;
     bool use_pq_build, use_opq;
@@ -70,6 +71,8 @@ int main(int argc, char **argv)
                                        program_options_utils::FILTERED_LBUILD);
         optional_configs.add_options()("label_type", po::value<std::string>(&label_type)->default_value("uint"),
                                        program_options_utils::LABEL_TYPE_DESCRIPTION);
+        optional_configs.add_options()("graph_store", po::value<std::string>(&graph_store)->default_value("vector"),
+                                       program_options_utils::GRAPH_STORE);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -112,6 +115,17 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    diskann::GraphStoreStrategy graph_strategy;
+    if (graph_store == std::string("vector"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY;
+    else if (graph_store == std::string("fixed_degree"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY_FIXED_DEGREE;
+    else
+    {
+        std::cout << "Unsupported graph store. Use vector or fixed_degree." << std::endl;
+        return -1;
+    }
+
     try
     {
         diskann::cout << "Starting index build with R: " << R << "  Lbuild: " << L << "  alpha: " << alpha
@@ -137,7 +151,7 @@ int main(int argc, char **argv)
                           .with_dimension(data_dim)
                           .with_max_points(data_num)
                           .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
-                          .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                          .with_graph_load_store_strategy(graph_strategy)
                           .with_data_type(data_type)
                           .with_label_type(label_type)
                           .is_dynamic_index(false)
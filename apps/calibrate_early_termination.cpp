@@ -0,0 +1,313 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "common_includes.h"
+#include <boost/program_options.hpp>
+
+#include "disk_utils.h"
+#include "pq_flash_index.h"
+#include "percentile_stats.h"
+#include "program_options_utils.hpp"
+
+#ifndef _WINDOWS
+#include "linux_aligned_file_reader.h"
+#else
+#ifdef USE_BING_INFRA
+#include "bing_aligned_file_reader.h"
+#else
+#include "windows_aligned_file_reader.h"
+#endif
+#endif
+
+namespace po = boost::program_options;
+
+// Picks early termination settings for search_disk_index offline: searches a
+// query sample with ground truth once without early termination and then once
+// per candidate setting, and recommends the setting with the lowest mean
+// latency whose recall is within max_recall_loss of the full search.
+
+struct CalibrationResult
+{
+    uint32_t patience_hops = 0;
+    float converge_ratio = 0;
+    double recall = 0;
+    double mean_latency = 0;
+    float latency_999 = 0;
+    double mean_hops = 0;
+    double mean_hops_saved = 0;
+};
+
+template <typename T, typename LabelT>
+CalibrationResult run_searches(diskann::PQFlashIndex<T, LabelT> &index, const T *query, const size_t query_num,
+                               const size_t query_aligned_dim, const uint32_t *gt_ids, const float *gt_dists,
+                               const size_t gt_dim, const uint32_t K, const uint32_t L, const uint32_t W,
+                               const uint32_t patience_hops, const float converge_ratio)
+{
+    index.set_early_termination(patience_hops, converge_ratio);
+
+    std::vector<uint64_t> result_ids_64(K * query_num);
+    std::vector<uint32_t> result_ids(K * query_num);
+    std::vector<float> result_dists(K * query_num);
+    std::vector<diskann::QueryStats> stats(query_num);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t i = 0; i < (int64_t)query_num; i++)
+    {
+        index.cached_beam_search(query + (i * query_aligned_dim), K, L, result_ids_64.data() + (i * K),
+                                 result_dists.data() + (i * K), W, false, stats.data() + i);
+    }
+    diskann::convert_types<uint64_t, uint32_t>(result_ids_64.data(), result_ids.data(), query_num, K);
+
+    CalibrationResult res;
+    res.patience_hops = patience_hops;
+    res.converge_ratio = converge_ratio;
+    res.recall = diskann::calculate_recall((uint32_t)query_num, const_cast<uint32_t *>(gt_ids),
+                                           const_cast<float *>(gt_dists), (uint32_t)gt_dim, result_ids.data(), K, K);
+    res.mean_latency = diskann::get_mean_stats<float>(stats.data(), query_num,
+                                                      [](const diskann::QueryStats &s) { return s.total_us; });
+    res.latency_999 = diskann::get_percentile_stats<float>(stats.data(), query_num, 0.999f,
+                                                           [](const diskann::QueryStats &s) { return s.total_us; });
+    res.mean_hops = diskann::get_mean_stats<uint32_t>(stats.data(), query_num,
+                                                      [](const diskann::QueryStats &s) { return s.n_hops; });
+    res.mean_hops_saved = diskann::get_mean_stats<uint32_t>(
+        stats.data(), query_num, [](const diskann::QueryStats &s) { return s.n_hops_saved; });
+    return res;
+}
+
+void print_result(const CalibrationResult &res)
+{
+    diskann::cout << std::setw(10) << res.patience_hops << std::setw(10) << res.converge_ratio << std::setw(16)
+                  << res.recall << std::setw(16) << res.mean_latency << std::setw(16) << res.latency_999
+                  << std::setw(12) << res.mean_hops << std::setw(12) << res.mean_hops_saved << std::endl;
+}
+
+template <typename T, typename LabelT = uint32_t>
+int calibrate(diskann::Metric &metric, const std::string &index_path_prefix, const std::string &query_file,
+              const std::string &gt_file, const uint32_t num_threads, const uint32_t K, const uint32_t L,
+              const uint32_t W, const uint32_t num_nodes_to_cache, const std::vector<uint32_t> &patience_values,
+              const std::vector<float> &ratio_values, const float max_recall_loss)
+{
+    T *query = nullptr;
+    uint32_t *gt_ids = nullptr;
+    float *gt_dists = nullptr;
+    size_t query_num, query_dim, query_aligned_dim, gt_num, gt_dim;
+    diskann::load_aligned_bin<T>(query_file, query, query_num, query_dim, query_aligned_dim);
+    diskann::load_truthset(gt_file, gt_ids, gt_dists, gt_num, gt_dim);
+    if (gt_num != query_num || gt_dim < K)
+    {
+        diskann::cerr << "Error. Ground truth has " << gt_num << " queries of " << gt_dim << " neighbors, expected "
+                      << query_num << " queries of at least " << K << std::endl;
+        diskann::aligned_free(query);
+        delete[] gt_ids;
+        delete[] gt_dists;
+        return -1;
+    }
+
+    std::shared_ptr<AlignedFileReader> reader = nullptr;
+#ifdef _WINDOWS
+#ifndef USE_BING_INFRA
+    reader.reset(new WindowsAlignedFileReader());
+#else
+    reader.reset(new diskann::BingAlignedFileReader());
+#endif
+#else
+    reader.reset(new LinuxAlignedFileReader());
+#endif
+
+    std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> index(new diskann::PQFlashIndex<T, LabelT>(reader, metric));
+    int res = index->load(num_threads, index_path_prefix.c_str());
+    if (res != 0)
+    {
+        return res;
+    }
+
+    std::vector<uint32_t> node_list;
+    index->cache_bfs_levels(num_nodes_to_cache, node_list);
+    index->load_cache_list(node_list);
+    omp_set_num_threads(num_threads);
+
+    diskann::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    diskann::cout.precision(2);
+    diskann::cout << std::setw(10) << "Patience" << std::setw(10) << "Ratio" << std::setw(16)
+                  << ("Recall@" + std::to_string(K)) << std::setw(16) << "Mean Latency" << std::setw(16)
+                  << "99.9 Latency" << std::setw(12) << "Mean Hops" << std::setw(12) << "Hops Saved" << std::endl;
+    diskann::cout << "==========================================================================================="
+                  << std::endl;
+
+    auto run = [&](uint32_t patience_hops, float converge_ratio) {
+        CalibrationResult r = run_searches(*index, query, query_num, query_aligned_dim, gt_ids, gt_dists, gt_dim, K,
+                                           L, W, patience_hops, converge_ratio);
+        print_result(r);
+        return r;
+    };
+
+    // a first pass warms up the caches so that the baseline latency is fair
+    run_searches(*index, query, query_num, query_aligned_dim, gt_ids, gt_dists, gt_dim, K, L, W, 0, 0);
+    CalibrationResult baseline = run(0, 0);
+    const double min_recall = baseline.recall - 100.0 * max_recall_loss;
+
+    // each rule on its own, then the best of each combined
+    CalibrationResult best = baseline, best_patience = baseline, best_ratio = baseline;
+    for (uint32_t p : patience_values)
+    {
+        CalibrationResult r = run(p, 0);
+        if (r.recall >= min_recall && r.mean_latency < best_patience.mean_latency)
+            best_patience = r;
+    }
+    for (float f : ratio_values)
+    {
+        CalibrationResult r = run(0, f);
+        if (r.recall >= min_recall && r.mean_latency < best_ratio.mean_latency)
+            best_ratio = r;
+    }
+    best = best_patience.mean_latency < best_ratio.mean_latency ? best_patience : best_ratio;
+    if (best_patience.patience_hops > 0 && best_ratio.converge_ratio > 0)
+    {
+        CalibrationResult r = run(best_patience.patience_hops, best_ratio.converge_ratio);
+        if (r.recall >= min_recall && r.mean_latency < best.mean_latency)
+            best = r;
+    }
+
+    diskann::cout << std::endl;
+    if (best.patience_hops == 0 && best.converge_ratio == 0)
+    {
+        diskann::cout << "No setting kept recall within " << 100.0 * max_recall_loss
+                      << "% of the full search; leave early termination off for L=" << L << std::endl;
+    }
+    else
+    {
+        diskann::cout << "Recommended for L=" << L << " W=" << W << ": --early_stop_patience " << best.patience_hops
+                      << " --early_stop_ratio " << best.converge_ratio << " (recall " << best.recall << " vs "
+                      << baseline.recall << ", mean latency " << best.mean_latency << " vs " << baseline.mean_latency
+                      << " us)" << std::endl;
+    }
+
+    diskann::aligned_free(query);
+    delete[] gt_ids;
+    delete[] gt_dists;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, dist_fn, index_path_prefix, query_file, gt_file;
+    uint32_t num_threads, K, L, W, num_nodes_to_cache;
+    std::vector<uint32_t> patience_values;
+    std::vector<float> ratio_values;
+    float max_recall_loss;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "calibrate_early_termination", "Picks early termination settings for search_disk_index")};
+    try
+    {
+        desc.add_options()("help,h", "Print information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("dist_fn", po::value<std::string>(&dist_fn)->required(),
+                                       program_options_utils::DISTANCE_FUNCTION_DESCRIPTION);
+        required_configs.add_options()("index_path_prefix", po::value<std::string>(&index_path_prefix)->required(),
+                                       program_options_utils::INDEX_PATH_PREFIX_DESCRIPTION);
+        required_configs.add_options()("query_file", po::value<std::string>(&query_file)->required(),
+                                       program_options_utils::QUERY_FILE_DESCRIPTION);
+        required_configs.add_options()("gt_file", po::value<std::string>(&gt_file)->required(),
+                                       program_options_utils::GROUND_TRUTH_FILE_DESCRIPTION);
+        required_configs.add_options()("recall_at,K", po::value<uint32_t>(&K)->required(),
+                                       program_options_utils::NUMBER_OF_RESULTS_DESCRIPTION);
+        required_configs.add_options()("search_list,L", po::value<uint32_t>(&L)->required(),
+                                       "Size of the search list to calibrate for.");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("beamwidth,W", po::value<uint32_t>(&W)->default_value(2),
+                                       program_options_utils::BEAMWIDTH);
+        optional_configs.add_options()("num_nodes_to_cache", po::value<uint32_t>(&num_nodes_to_cache)->default_value(0),
+                                       program_options_utils::NUMBER_OF_NODES_TO_CACHE);
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        optional_configs.add_options()("patience_values",
+                                       po::value<std::vector<uint32_t>>(&patience_values)
+                                           ->multitoken()
+                                           ->default_value({1, 2, 3, 4, 6, 8}, "1 2 3 4 6 8"),
+                                       "Values of --early_stop_patience to try.");
+        optional_configs.add_options()("ratio_values",
+                                       po::value<std::vector<float>>(&ratio_values)
+                                           ->multitoken()
+                                           ->default_value({1.5f, 2, 3, 4, 6}, "1.5 2 3 4 6"),
+                                       "Values of --early_stop_ratio to try.");
+        optional_configs.add_options()("max_recall_loss", po::value<float>(&max_recall_loss)->default_value(0.005f),
+                                       "Largest drop in recall, as a fraction, allowed for a recommended setting.  "
+                                       "Default value: 0.005");
+
+        // Merge required and optional parameters
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("mips"))
+    {
+        metric = diskann::Metric::INNER_PRODUCT;
+    }
+    else if (dist_fn == std::string("l2"))
+    {
+        metric = diskann::Metric::L2;
+    }
+    else if (dist_fn == std::string("cosine"))
+    {
+        metric = diskann::Metric::COSINE;
+    }
+    else
+    {
+        std::cout << "Unsupported distance function. Currently only L2/ Inner "
+                     "Product/Cosine are supported."
+                  << std::endl;
+        return -1;
+    }
+
+    if (L < K)
+    {
+        std::cout << "Error: L must be at least K" << std::endl;
+        return -1;
+    }
+
+    try
+    {
+        if (data_type == std::string("float"))
+            return calibrate<float>(metric, index_path_prefix, query_file, gt_file, num_threads, K, L, W,
+                                    num_nodes_to_cache, patience_values, ratio_values, max_recall_loss);
+        else if (data_type == std::string("int8"))
+            return calibrate<int8_t>(metric, index_path_prefix, query_file, gt_file, num_threads, K, L, W,
+                                     num_nodes_to_cache, patience_values, ratio_values, max_recall_loss);
+        else if (data_type == std::string("uint8"))
+            return calibrate<uint8_t>(metric, index_path_prefix, query_file, gt_file, num_threads, K, L, W,
+                                      num_nodes_to_cache, patience_values, ratio_values, max_recall_loss);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "Calibration failed." << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,358 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "common_includes.h"
+#include <boost/program_options.hpp>
+#include <thread>
+
+#include "disk_utils.h"
+#include "latency_histogram.h"
+#include "pq_flash_index.h"
+#include "program_options_utils.hpp"
+
+#ifndef _WINDOWS
+#include "linux_aligned_file_reader.h"
+#else
+#ifdef USE_BING_INFRA
+#include "bing_aligned_file_reader.h"
+#else
+#include "windows_aligned_file_reader.h"
+#endif
+#endif
+
+namespace po = boost::program_options;
+
+// Measures tail latency under an offered load: for each target rate, queries
+// arrive on a fixed schedule, independently of when earlier ones complete,
+// and the latency of a query runs from its scheduled arrival to its results,
+// so that it includes the time spent waiting for a free search thread. Unlike
+// the closed loop of search_disk_index, this shows how latency grows as the
+// offered load nears the throughput of the index.
+
+typedef std::chrono::steady_clock load_clock;
+
+struct LoadResult
+{
+    double offered_qps = 0;
+    double achieved_qps = 0;
+    uint64_t num_queries = 0;
+    double mean_us = 0;
+    uint64_t p50_us = 0;
+    uint64_t p90_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t p999_us = 0;
+    uint64_t max_us = 0;
+    double mean_ios = 0;
+};
+
+// arrival times, from the start of the run, of the queries of duration_s
+// seconds at qps queries per second, evenly spaced or as a Poisson process
+std::vector<load_clock::duration> arrival_schedule(const double qps, const double duration_s, const bool poisson)
+{
+    uint64_t num_arrivals = (uint64_t)(qps * duration_s);
+    std::vector<load_clock::duration> arrivals(num_arrivals);
+    std::mt19937_64 gen(42);
+    std::exponential_distribution<double> gap(qps);
+    double t = 0;
+    for (uint64_t i = 0; i < num_arrivals; i++)
+    {
+        t = poisson ? t + gap(gen) : i / qps;
+        arrivals[i] = std::chrono::duration_cast<load_clock::duration>(std::chrono::duration<double>(t));
+    }
+    return arrivals;
+}
+
+template <typename T, typename LabelT>
+LoadResult run_load(diskann::PQFlashIndex<T, LabelT> &index, const T *query, const size_t query_num,
+                    const size_t query_aligned_dim, const uint32_t num_threads, const uint32_t K, const uint32_t L,
+                    const uint32_t W, const uint32_t async_queue_depth, const double qps, const double duration_s,
+                    const bool poisson)
+{
+    std::vector<load_clock::duration> arrivals = arrival_schedule(qps, duration_s, poisson);
+    diskann::LatencyHistogram histogram;
+    std::atomic<uint64_t> total_ios{0};
+    auto record = [&histogram, &total_ios](load_clock::time_point arrival, const diskann::QueryStats &stats) {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(load_clock::now() - arrival);
+        histogram.record((uint64_t)latency.count());
+        total_ios.fetch_add(stats.n_ios, std::memory_order_relaxed);
+    };
+
+    // leave the threads time to get going before the first arrival
+    load_clock::time_point start = load_clock::now() + std::chrono::milliseconds(10);
+    if (async_queue_depth > 0)
+    {
+        // one thread dispatches the queries to the async search workers
+        index.start_async_search(num_threads, async_queue_depth);
+        for (uint64_t i = 0; i < arrivals.size(); i++)
+        {
+            load_clock::time_point arrival = start + arrivals[i];
+            std::this_thread::sleep_until(arrival);
+            index.async_search(query + (i % query_num) * query_aligned_dim, K, L, W,
+                               [&record, arrival](const uint64_t *, const float *, const diskann::QueryStats &stats) {
+                                   record(arrival, stats);
+                               });
+        }
+        index.stop_async_search();
+    }
+    else
+    {
+        // each thread takes the next arrival, waits for it if it is still
+        // ahead, and searches it; arrivals that find every thread busy queue
+        std::atomic<uint64_t> next{0};
+#pragma omp parallel num_threads(num_threads)
+        {
+            std::vector<uint64_t> ids(K);
+            std::vector<float> dists(K);
+            while (true)
+            {
+                uint64_t i = next.fetch_add(1);
+                if (i >= arrivals.size())
+                    break;
+                load_clock::time_point arrival = start + arrivals[i];
+                std::this_thread::sleep_until(arrival);
+                diskann::QueryStats stats;
+                index.cached_beam_search(query + (i % query_num) * query_aligned_dim, K, L, ids.data(), dists.data(),
+                                         W, false, &stats);
+                record(arrival, stats);
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = load_clock::now() - start;
+
+    LoadResult res;
+    res.offered_qps = qps;
+    res.num_queries = histogram.count();
+    res.achieved_qps = res.num_queries / elapsed.count();
+    res.mean_us = histogram.mean();
+    res.p50_us = histogram.value_at_percentile(50);
+    res.p90_us = histogram.value_at_percentile(90);
+    res.p99_us = histogram.value_at_percentile(99);
+    res.p999_us = histogram.value_at_percentile(99.9);
+    res.max_us = histogram.max();
+    res.mean_ios = res.num_queries == 0 ? 0 : (double)total_ios.load() / res.num_queries;
+    return res;
+}
+
+template <typename T, typename LabelT = uint32_t>
+int load_test(diskann::Metric &metric, const std::string &index_path_prefix, const std::string &query_file,
+              const uint32_t num_threads, const uint32_t K, const uint32_t L, const uint32_t W,
+              const uint32_t num_nodes_to_cache, const uint32_t async_queue_depth,
+              const std::vector<double> &qps_values, const double duration_s, const bool poisson,
+              const std::string &csv_file, const std::string &label)
+{
+    T *query = nullptr;
+    size_t query_num, query_dim, query_aligned_dim;
+    diskann::load_aligned_bin<T>(query_file, query, query_num, query_dim, query_aligned_dim);
+
+    std::shared_ptr<AlignedFileReader> reader = nullptr;
+#ifdef _WINDOWS
+#ifndef USE_BING_INFRA
+    reader.reset(new WindowsAlignedFileReader());
+#else
+    reader.reset(new diskann::BingAlignedFileReader());
+#endif
+#else
+    reader.reset(new LinuxAlignedFileReader());
+#endif
+
+    std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> index(new diskann::PQFlashIndex<T, LabelT>(reader, metric));
+    int res = index->load(num_threads, index_path_prefix.c_str());
+    if (res != 0)
+    {
+        diskann::aligned_free(query);
+        return res;
+    }
+
+    std::vector<uint32_t> node_list;
+    index->cache_bfs_levels(num_nodes_to_cache, node_list);
+    index->load_cache_list(node_list);
+
+    // a closed-loop pass over the queries warms up the page and node caches
+    {
+        std::vector<uint64_t> ids(K * query_num);
+        std::vector<float> dists(K * query_num);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (int64_t i = 0; i < (int64_t)query_num; i++)
+        {
+            index->cached_beam_search(query + (i * query_aligned_dim), K, L, ids.data() + (i * K),
+                                      dists.data() + (i * K), W);
+        }
+    }
+
+    std::ofstream csv;
+    if (!csv_file.empty())
+    {
+        bool write_header = !file_exists(csv_file);
+        csv.open(csv_file, std::ios::out | std::ios::app);
+        if (write_header)
+            csv << "label,arrival,threads,async_queue_depth,L,W,offered_qps,achieved_qps,num_queries,mean_us,p50_us,"
+                   "p90_us,p99_us,p999_us,max_us,mean_ios"
+                << std::endl;
+    }
+
+    diskann::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    diskann::cout.precision(2);
+    diskann::cout << std::setw(14) << "Offered QPS" << std::setw(14) << "Achieved QPS" << std::setw(12) << "Mean"
+                  << std::setw(12) << "P50" << std::setw(12) << "P90" << std::setw(12) << "P99" << std::setw(12)
+                  << "P99.9" << std::setw(12) << "Max" << std::setw(12) << "Mean IOs" << std::endl;
+    diskann::cout << "==========================================================================================="
+                  << "=================" << std::endl;
+
+    for (double qps : qps_values)
+    {
+        LoadResult r = run_load(*index, query, query_num, query_aligned_dim, num_threads, K, L, W, async_queue_depth,
+                                qps, duration_s, poisson);
+        diskann::cout << std::setw(14) << r.offered_qps << std::setw(14) << r.achieved_qps << std::setw(12)
+                      << r.mean_us << std::setw(12) << r.p50_us << std::setw(12) << r.p90_us << std::setw(12)
+                      << r.p99_us << std::setw(12) << r.p999_us << std::setw(12) << r.max_us << std::setw(12)
+                      << r.mean_ios << std::endl;
+        if (csv.is_open())
+        {
+            csv << label << "," << (poisson ? "poisson" : "fixed") << "," << num_threads << "," << async_queue_depth
+                << "," << L << "," << W << "," << r.offered_qps << "," << r.achieved_qps << "," << r.num_queries << ","
+                << r.mean_us << "," << r.p50_us << "," << r.p90_us << "," << r.p99_us << "," << r.p999_us << ","
+                << r.max_us << "," << r.mean_ios << std::endl;
+        }
+    }
+
+    diskann::aligned_free(query);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, dist_fn, index_path_prefix, query_file, arrival, csv_file, label;
+    uint32_t num_threads, K, L, W, num_nodes_to_cache, async_queue_depth;
+    std::vector<double> qps_values;
+    double duration_s;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "load_test_disk_index", "Measures disk index search latency at fixed offered loads")};
+    try
+    {
+        desc.add_options()("help,h", "Print information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("dist_fn", po::value<std::string>(&dist_fn)->required(),
+                                       program_options_utils::DISTANCE_FUNCTION_DESCRIPTION);
+        required_configs.add_options()("index_path_prefix", po::value<std::string>(&index_path_prefix)->required(),
+                                       program_options_utils::INDEX_PATH_PREFIX_DESCRIPTION);
+        required_configs.add_options()("query_file", po::value<std::string>(&query_file)->required(),
+                                       program_options_utils::QUERY_FILE_DESCRIPTION);
+        required_configs.add_options()("recall_at,K", po::value<uint32_t>(&K)->required(),
+                                       program_options_utils::NUMBER_OF_RESULTS_DESCRIPTION);
+        required_configs.add_options()("search_list,L", po::value<uint32_t>(&L)->required(),
+                                       "Size of the search list.");
+        required_configs.add_options()("qps", po::value<std::vector<double>>(&qps_values)->multitoken()->required(),
+                                       "Offered loads to sweep, in queries per second.");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("beamwidth,W", po::value<uint32_t>(&W)->default_value(2),
+                                       "Beamwidth for search.  Default value: 2");
+        optional_configs.add_options()("num_nodes_to_cache", po::value<uint32_t>(&num_nodes_to_cache)->default_value(0),
+                                       program_options_utils::NUMBER_OF_NODES_TO_CACHE);
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        optional_configs.add_options()("arrival", po::value<std::string>(&arrival)->default_value("poisson"),
+                                       "Arrival process, poisson or fixed (evenly spaced).  Default value: poisson");
+        optional_configs.add_options()("duration", po::value<double>(&duration_s)->default_value(10),
+                                       "Seconds of arrivals per offered load; the query file is replayed as often "
+                                       "as needed.  Default value: 10");
+        optional_configs.add_options()("async_queue_depth",
+                                       po::value<uint32_t>(&async_queue_depth)->default_value(0),
+                                       "Search with async_search on -T workers that each keep this many queries in "
+                                       "flight, instead of one thread per query.  Default value: 0");
+        optional_configs.add_options()("csv_file", po::value<std::string>(&csv_file)->default_value(""),
+                                       "CSV file to append a row per offered load to, with a header if it is new.");
+        optional_configs.add_options()("label", po::value<std::string>(&label)->default_value(""),
+                                       "Value of the label column of the CSV rows, such as the build being tested.");
+
+        // Merge required and optional parameters
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("mips"))
+    {
+        metric = diskann::Metric::INNER_PRODUCT;
+    }
+    else if (dist_fn == std::string("l2"))
+    {
+        metric = diskann::Metric::L2;
+    }
+    else if (dist_fn == std::string("cosine"))
+    {
+        metric = diskann::Metric::COSINE;
+    }
+    else
+    {
+        std::cout << "Unsupported distance function. Currently only L2/ Inner "
+                     "Product/Cosine are supported."
+                  << std::endl;
+        return -1;
+    }
+
+    if (arrival != std::string("poisson") && arrival != std::string("fixed"))
+    {
+        std::cout << "Error: --arrival must be poisson or fixed" << std::endl;
+        return -1;
+    }
+    for (double qps : qps_values)
+    {
+        if (qps <= 0)
+        {
+            std::cout << "Error: offered loads must be positive" << std::endl;
+            return -1;
+        }
+    }
+    if (L < K)
+    {
+        std::cout << "Error: L must be at least K" << std::endl;
+        return -1;
+    }
+
+    const bool poisson = arrival == std::string("poisson");
+    try
+    {
+        if (data_type == std::string("float"))
+            return load_test<float>(metric, index_path_prefix, query_file, num_threads, K, L, W, num_nodes_to_cache,
+                                    async_queue_depth, qps_values, duration_s, poisson, csv_file, label);
+        else if (data_type == std::string("int8"))
+            return load_test<int8_t>(metric, index_path_prefix, query_file, num_threads, K, L, W, num_nodes_to_cache,
+                                     async_queue_depth, qps_values, duration_s, poisson, csv_file, label);
+        else if (data_type == std::string("uint8"))
+            return load_test<uint8_t>(metric, index_path_prefix, query_file, num_threads, K, L, W,
+                                      num_nodes_to_cache, async_queue_depth, qps_values, duration_s, poisson,
+                                      csv_file, label);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "Load test failed." << std::endl;
+        return -1;
+    }
+}
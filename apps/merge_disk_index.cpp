@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <omp.h>
+#include <boost/program_options.hpp>
+
+#include "index.h"
+#include "disk_merge.h"
+#include "index_factory.h"
+#include "pq_flash_index.h"
+#include "program_options_utils.hpp"
+#include "timer.h"
+
+#ifndef _WINDOWS
+#include "linux_aligned_file_reader.h"
+#else
+#ifdef USE_BING_INFRA
+#include "bing_aligned_file_reader.h"
+#else
+#include "windows_aligned_file_reader.h"
+#endif
+#endif
+
+namespace po = boost::program_options;
+
+template <typename T>
+int merge_disk_index(const std::string &index_path_prefix, const std::string &delta_index_path,
+                     const std::string &deleted_ids_file, const std::string &output_path_prefix,
+                     const diskann::DiskMergeParameters &params)
+{
+    std::shared_ptr<AlignedFileReader> reader = nullptr;
+#ifdef _WINDOWS
+#ifndef USE_BING_INFRA
+    reader.reset(new WindowsAlignedFileReader());
+#else
+    reader.reset(new diskann::BingAlignedFileReader());
+#endif
+#else
+    reader.reset(new LinuxAlignedFileReader());
+#endif
+
+    diskann::PQFlashIndex<T> base(reader, diskann::Metric::L2);
+    uint32_t num_threads = params.num_threads == 0 ? omp_get_num_procs() : params.num_threads;
+    if (base.load(num_threads, index_path_prefix.c_str()) != 0)
+        return -1;
+
+    // the delta is a dynamic in-memory index with uint32_t tags, as saved by
+    // test_insert_deletes_consolidate
+    size_t delta_points, delta_dim;
+    diskann::get_bin_metadata(delta_index_path + ".data", delta_points, delta_dim);
+    auto config = diskann::IndexConfigBuilder()
+                      .with_metric(diskann::Metric::L2)
+                      .with_dimension(delta_dim)
+                      .with_max_points(0)
+                      .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
+                      .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                      .with_data_type(diskann_type_to_name<T>())
+                      .with_label_type(diskann_type_to_name<uint32_t>())
+                      .with_tag_type(diskann_type_to_name<uint32_t>())
+                      .is_dynamic_index(true)
+                      .is_enable_tags(true)
+                      .is_concurrent_consolidate(false)
+                      .is_pq_dist_build(false)
+                      .is_use_opq(false)
+                      .with_num_pq_chunks(0)
+                      .with_num_frozen_pts(diskann::get_graph_num_frozen_points(delta_index_path))
+                      .build();
+    auto delta = diskann::IndexFactory(config).create_instance();
+    delta->load(delta_index_path.c_str(), num_threads, params.search_l);
+
+    std::vector<uint32_t> deleted_ids;
+    if (deleted_ids_file != "")
+    {
+        std::unique_ptr<uint32_t[]> ids;
+        size_t num_ids, dim;
+        diskann::load_bin<uint32_t>(deleted_ids_file, ids, num_ids, dim);
+        deleted_ids.assign(ids.get(), ids.get() + num_ids * dim);
+    }
+
+    diskann::Timer timer;
+    diskann::merge_disk_index<T>(base, index_path_prefix, *delta, deleted_ids, output_path_prefix, params);
+    diskann::cout << "Merge took " << timer.elapsed_seconds() << "s" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, index_path_prefix, delta_index_path, deleted_ids_file, output_path_prefix;
+    diskann::DiskMergeParameters params;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "merge_disk_index", "Merges the inserts of an in-memory index and a list of deletes into a disk index")};
+    try
+    {
+        desc.add_options()("help,h", "Print information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("index_path_prefix", po::value<std::string>(&index_path_prefix)->required(),
+                                       program_options_utils::INDEX_PATH_PREFIX_DESCRIPTION);
+        required_configs.add_options()("delta_index_path", po::value<std::string>(&delta_index_path)->required(),
+                                       "Dynamic in-memory index with uint32 tags holding the points to insert; "
+                                       "each tag is the id of its point in the merged index");
+        required_configs.add_options()("output_path_prefix", po::value<std::string>(&output_path_prefix)->required(),
+                                       "Path prefix of the merged disk index");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("deleted_ids", po::value<std::string>(&deleted_ids_file)->default_value(""),
+                                       "uint32 bin file of the ids of the disk index to delete");
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&params.num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        optional_configs.add_options()("search_list,L", po::value<uint32_t>(&params.search_l)->default_value(75),
+                                       "Candidate list size used to place each inserted point");
+        optional_configs.add_options()("alpha", po::value<float>(&params.alpha)->default_value(1.2f),
+                                       program_options_utils::GRAPH_BUILD_ALPHA);
+        optional_configs.add_options()("beamwidth,W", po::value<uint32_t>(&params.beam_width)->default_value(4),
+                                       "Beamwidth of the searches on the disk index. Default value: 4");
+
+        // Merge required and optional parameters
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    try
+    {
+        if (data_type == std::string("float"))
+            return merge_disk_index<float>(index_path_prefix, delta_index_path, deleted_ids_file, output_path_prefix,
+                                           params);
+        else if (data_type == std::string("int8"))
+            return merge_disk_index<int8_t>(index_path_prefix, delta_index_path, deleted_ids_file, output_path_prefix,
+                                            params);
+        else if (data_type == std::string("uint8"))
+            return merge_disk_index<uint8_t>(index_path_prefix, delta_index_path, deleted_ids_file,
+                                             output_path_prefix, params);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "Index merge failed." << std::endl;
+        return -1;
+    }
+}
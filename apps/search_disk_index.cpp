@@ -10,8 +10,10 @@
 #include "memory_mapper.h"
 #include "partition.h"
 #include "pq_flash_index.h"
+#include "numa_utils.h"
 #include "timer.h"
 #include "percentile_stats.h"
+#include "query_metrics.h"
 #include "program_options_utils.hpp"
 
 #ifndef _WINDOWS
@@ -19,6 +21,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "linux_aligned_file_reader.h"
+#include "io_uring_aligned_file_reader.h"
+#include "mmap_aligned_file_reader.h"
 #else
 #ifdef USE_BING_INFRA
 #include "bing_aligned_file_reader.h"
@@ -53,7 +57,16 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
                       const uint32_t num_threads, const uint32_t recall_at, const uint32_t beamwidth,
                       const uint32_t num_nodes_to_cache, const uint32_t search_io_limit,
                       const std::vector<uint32_t> &Lvec, const float fail_if_recall_below,
-                      const std::vector<std::string> &query_filters, const bool use_reorder_data = false)
+                      const std::vector<std::string> &query_filters, const bool use_reorder_data = false,
+                      const std::string &io_backend = "libaio", const bool io_uring_sqpoll = false,
+                      const bool pipelined_search = false, const uint32_t batch_size = 0,
+                      const uint32_t sector_cache_mb = 0, const bool mmap_populate = false,
+                      const uint32_t early_stop_patience = 0, const float early_stop_ratio = 0,
+                      const bool huge_pages = false, const std::string &cache_file = "",
+                      const std::string &numa = "off", const std::string &visited_set = "auto",
+                      const uint32_t prefetch_nodes = 0, const float delete_fraction = 0,
+                      const uint32_t async_queue_depth = 0, const std::string &metrics_file = "",
+                      const bool trace_hops = false)
 {
     diskann::cout << "Search parameters: #threads: " << num_threads << ", ";
     if (beamwidth <= 0)
@@ -85,6 +98,11 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
                       << std::endl;
             return -1; // To return -1 or some other error handling?
         }
+        if (async_queue_depth > 0)
+        {
+            diskann::cerr << "Async search does not support filters" << std::endl;
+            return -1;
+        }
     }
 
     bool calc_recall_flag = false;
@@ -106,12 +124,42 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
     reader.reset(new diskann::BingAlignedFileReader());
 #endif
 #else
-    reader.reset(new LinuxAlignedFileReader());
+    if (io_backend == std::string("io_uring"))
+    {
+#ifdef USE_IO_URING
+        reader.reset(new IoUringAlignedFileReader(io_uring_sqpoll));
+#else
+        diskann::cerr << "io_uring backend requested, but DiskANN was built without liburing" << std::endl;
+        return -1;
+#endif
+    }
+    else if (io_backend == std::string("mmap"))
+    {
+        // with populate the whole index is read in up front, so readahead
+        // hints would only matter for a cold page cache
+        reader.reset(new MmapAlignedFileReader(mmap_populate, mmap_populate ? MADV_WILLNEED : MADV_RANDOM));
+    }
+    else
+    {
+        reader.reset(new LinuxAlignedFileReader());
+    }
+    diskann::cout << "Using " << io_backend << " IO backend" << (io_uring_sqpoll ? " with SQPOLL" : "")
+                  << (mmap_populate ? " populated at load" : "") << std::endl;
 #endif
 
     std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> _pFlashIndex(
         new diskann::PQFlashIndex<T, LabelT>(reader, metric));
 
+    if (huge_pages)
+        _pFlashIndex->set_huge_pages(true);
+    if (numa != std::string("off"))
+        _pFlashIndex->set_numa_mode(true, numa == std::string("replicate"));
+    if (visited_set == std::string("array"))
+        _pFlashIndex->set_visited_set_policy(diskann::VisitedSetPolicy::EPOCH_ARRAY);
+    else if (visited_set == std::string("bitset"))
+        _pFlashIndex->set_visited_set_policy(diskann::VisitedSetPolicy::BITSET);
+    else if (visited_set == std::string("hash"))
+        _pFlashIndex->set_visited_set_policy(diskann::VisitedSetPolicy::HASH_SET);
     int res = _pFlashIndex->load(num_threads, index_path_prefix.c_str());
 
     if (res != 0)
@@ -119,18 +167,119 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
         return res;
     }
 
-    std::vector<uint32_t> node_list;
-    diskann::cout << "Caching " << num_nodes_to_cache << " nodes around medoid(s)" << std::endl;
-    _pFlashIndex->cache_bfs_levels(num_nodes_to_cache, node_list);
-    // if (num_nodes_to_cache > 0)
-    //     _pFlashIndex->generate_cache_list_from_sample_queries(warmup_query_file, 15, 6, num_nodes_to_cache,
-    //     num_threads, node_list);
-    _pFlashIndex->load_cache_list(node_list);
-    node_list.clear();
-    node_list.shrink_to_fit();
+    if (cache_file.empty() || !_pFlashIndex->load_cache_list(cache_file))
+    {
+        std::vector<uint32_t> node_list;
+        diskann::cout << "Caching " << num_nodes_to_cache << " nodes around medoid(s)" << std::endl;
+        _pFlashIndex->cache_bfs_levels(num_nodes_to_cache, node_list);
+        // if (num_nodes_to_cache > 0)
+        //     _pFlashIndex->generate_cache_list_from_sample_queries(warmup_query_file, 15, 6, num_nodes_to_cache,
+        //     num_threads, node_list);
+        _pFlashIndex->load_cache_list(node_list);
+        if (!cache_file.empty())
+            _pFlashIndex->save_cache_list(cache_file, node_list);
+    }
+
+    float time_to_first_query = 0;
+    for (auto &phase : _pFlashIndex->get_load_phase_times())
+        time_to_first_query += phase.second;
+    diskann::cout << "Time to first query (load and cache fill): " << time_to_first_query << "s" << std::endl;
+
+    if (sector_cache_mb > 0)
+    {
+        diskann::cout << "Using a " << sector_cache_mb << "MB dynamic sector cache" << std::endl;
+        _pFlashIndex->enable_sector_cache((uint64_t)sector_cache_mb * 1024 * 1024);
+    }
+
+    if (pipelined_search)
+    {
+        diskann::cout << "Using pipelined beam search" << std::endl;
+        _pFlashIndex->set_pipelined_search(true);
+    }
+
+    if (prefetch_nodes > 0)
+    {
+        diskann::cout << "Prefetching up to " << prefetch_nodes << " candidates outside the beam" << std::endl;
+        _pFlashIndex->set_speculative_prefetch(prefetch_nodes);
+    }
+
+    if (delete_fraction > 0)
+    {
+        // tombstone a fixed random sample of the points, so that runs agree
+        uint64_t num_points = _pFlashIndex->get_num_points();
+        std::vector<uint32_t> ids(num_points);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::mt19937 gen(1729);
+        std::shuffle(ids.begin(), ids.end(), gen);
+        ids.resize((std::min)(num_points, (uint64_t)(delete_fraction * num_points)));
+
+        diskann::Timer delete_timer;
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+        for (int64_t i = 0; i < (int64_t)ids.size(); i++)
+            _pFlashIndex->lazy_delete(ids[i]);
+        float delete_secs = delete_timer.elapsed_seconds();
+        diskann::cout << "Deleted " << _pFlashIndex->get_num_deleted() << " points at "
+                      << (delete_secs > 0 ? ids.size() / delete_secs : 0) << " deletes/s, tombstones use "
+                      << _pFlashIndex->get_tombstone_memory() << " bytes" << std::endl;
+
+        if (calc_recall_flag)
+        {
+            // drop the deleted points from the ground truth, padding each row
+            // with its last live point
+            tsl::robin_set<uint32_t> deleted(ids.begin(), ids.end());
+            for (size_t q = 0; q < gt_num; q++)
+            {
+                uint32_t *row_ids = gt_ids + q * gt_dim;
+                float *row_dists = gt_dists == nullptr ? nullptr : gt_dists + q * gt_dim;
+                size_t live = 0;
+                for (size_t i = 0; i < gt_dim; i++)
+                {
+                    if (deleted.find(row_ids[i]) != deleted.end())
+                        continue;
+                    row_ids[live] = row_ids[i];
+                    if (row_dists != nullptr)
+                        row_dists[live] = row_dists[i];
+                    live++;
+                }
+                for (size_t i = live; live > 0 && i < gt_dim; i++)
+                {
+                    row_ids[i] = row_ids[live - 1];
+                    if (row_dists != nullptr)
+                        row_dists[i] = row_dists[live - 1];
+                }
+            }
+        }
+    }
+
+    const bool early_stop = early_stop_patience > 0 || early_stop_ratio > 0;
+    if (early_stop)
+    {
+        diskann::cout << "Using early termination with patience " << early_stop_patience << " hops and ratio "
+                      << early_stop_ratio << std::endl;
+        _pFlashIndex->set_early_termination(early_stop_patience, early_stop_ratio);
+    }
 
     omp_set_num_threads(num_threads);
 
+    if (numa != std::string("off"))
+    {
+        // pin the search threads to the nodes round robin, as load() spread
+        // the thread contexts
+        uint32_t num_nodes = (std::min)(diskann::numa::num_nodes(), num_threads);
+#pragma omp parallel num_threads(num_threads)
+        diskann::numa::bind_thread_to_node((uint32_t)omp_get_thread_num() % num_nodes);
+
+        auto usage = _pFlashIndex->get_numa_memory_usage();
+        for (uint32_t node = 0; node < usage.size(); node++)
+        {
+            uint64_t total_bytes, free_bytes;
+            diskann::numa::get_node_memory(node, total_bytes, free_bytes);
+            diskann::cout << "NUMA node " << node << ": " << usage[node] / (1024 * 1024)
+                          << "MB of PQ vectors and node cache, " << (total_bytes - free_bytes) / (1024 * 1024)
+                          << "MB of " << total_bytes / (1024 * 1024) << "MB in use" << std::endl;
+        }
+    }
+
     uint64_t warmup_L = 20;
     uint64_t warmup_num = 0, warmup_dim = 0, warmup_aligned_dim = 0;
     T *warmup = nullptr;
@@ -180,6 +329,22 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
     diskann::cout << std::setw(6) << "L" << std::setw(12) << "Beamwidth" << std::setw(16) << "QPS" << std::setw(16)
                   << "Mean Latency" << std::setw(16) << "99.9 Latency" << std::setw(16) << "Mean IOs" << std::setw(16)
                   << "Mean IO (us)" << std::setw(16) << "CPU (s)";
+    if (batch_size > 0)
+    {
+        diskann::cout << std::setw(16) << "Dedup Ratio";
+    }
+    if (sector_cache_mb > 0)
+    {
+        diskann::cout << std::setw(16) << "Sect. Cache Hit%" << std::setw(16) << "Evictions";
+    }
+    if (early_stop)
+    {
+        diskann::cout << std::setw(16) << "Mean Hops" << std::setw(16) << "Hops Saved";
+    }
+    if (prefetch_nodes > 0)
+    {
+        diskann::cout << std::setw(16) << "Prefetch Hit%" << std::setw(16) << "Wasted KB/Q";
+    }
     if (calc_recall_flag)
     {
         diskann::cout << std::setw(16) << recall_string << std::endl;
@@ -220,35 +385,82 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
         query_result_dists[test_id].resize(recall_at * query_num);
 
         auto stats = new diskann::QueryStats[query_num];
+        std::vector<std::vector<diskann::HopTrace>> hop_traces(trace_hops ? query_num : 0);
+        for (uint64_t i = 0; i < hop_traces.size(); i++)
+            stats[i].hop_trace = &hop_traces[i];
 
         std::vector<uint64_t> query_result_ids_64(recall_at * query_num);
         auto s = std::chrono::high_resolution_clock::now();
 
-#pragma omp parallel for schedule(dynamic, 1)
-        for (int64_t i = 0; i < (int64_t)query_num; i++)
+        if (async_queue_depth > 0)
         {
-            if (!filtered_search)
+            // -T workers, each with async_queue_depth queries in flight; all
+            // queries are queued at once and stop_async_search() waits for them
+            _pFlashIndex->start_async_search(num_threads, async_queue_depth);
+            for (uint64_t i = 0; i < query_num; i++)
             {
-                _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
-                                                 query_result_ids_64.data() + (i * recall_at),
-                                                 query_result_dists[test_id].data() + (i * recall_at),
-                                                 optimized_beamwidth, use_reorder_data, stats + i);
+                uint64_t *res_ids = query_result_ids_64.data() + (i * recall_at);
+                float *res_dists = query_result_dists[test_id].data() + (i * recall_at);
+                diskann::QueryStats *query_stats = stats + i;
+                _pFlashIndex->async_search(
+                    query + (i * query_aligned_dim), recall_at, L, optimized_beamwidth,
+                    [res_ids, res_dists, query_stats, recall_at](const uint64_t *ids, const float *dists,
+                                                                  const diskann::QueryStats &done_stats) {
+                        std::copy(ids, ids + recall_at, res_ids);
+                        std::copy(dists, dists + recall_at, res_dists);
+                        *query_stats = done_stats;
+                    },
+                    search_io_limit);
             }
-            else
+            _pFlashIndex->stop_async_search();
+        }
+        else if (batch_size > 0)
+        {
+            // batches with a filter or reranking fall back to searching their
+            // queries one at a time
+            LabelT label_for_search = filtered_search ? _pFlashIndex->get_converted_label(query_filters[0]) : (LabelT)0;
+            int64_t num_batches = (int64_t)DIV_ROUND_UP(query_num, batch_size);
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t b = 0; b < num_batches; b++)
             {
-                LabelT label_for_search;
-                if (query_filters.size() == 1)
-                { // one label for all queries
-                    label_for_search = _pFlashIndex->get_converted_label(query_filters[0]);
+                uint64_t start = (uint64_t)b * batch_size;
+                uint64_t cur_batch_size = (std::min)((uint64_t)batch_size, query_num - start);
+                _pFlashIndex->batch_cached_beam_search(
+                    query + (start * query_aligned_dim), cur_batch_size, query_aligned_dim, recall_at, L,
+                    query_result_ids_64.data() + (start * recall_at),
+                    query_result_dists[test_id].data() + (start * recall_at), optimized_beamwidth, filtered_search,
+                    label_for_search, use_reorder_data, search_io_limit, stats + start);
+            }
+        }
+        else
+        {
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t i = 0; i < (int64_t)query_num; i++)
+            {
+                if (!filtered_search)
+                {
+                    _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
+                                                     query_result_ids_64.data() + (i * recall_at),
+                                                     query_result_dists[test_id].data() + (i * recall_at),
+                                                     optimized_beamwidth, use_reorder_data, stats + i);
                 }
                 else
-                { // one label for each query
-                    label_for_search = _pFlashIndex->get_converted_label(query_filters[i]);
+                {
+                    LabelT label_for_search;
+                    if (query_filters.size() == 1)
+                    { // one label for all queries
+                        label_for_search = _pFlashIndex->get_converted_label(query_filters[0]);
+                    }
+                    else
+                    { // one label for each query
+                        label_for_search = _pFlashIndex->get_converted_label(query_filters[i]);
+                    }
+                    _pFlashIndex->cached_beam_search(query + (i * query_aligned_dim), recall_at, L,
+                                                     query_result_ids_64.data() + (i * recall_at),
+                                                     query_result_dists[test_id].data() + (i * recall_at),
+                                                     optimized_beamwidth, true, label_for_search, use_reorder_data,
+                                                     stats + i);
                 }
-                _pFlashIndex->cached_beam_search(
-                    query + (i * query_aligned_dim), recall_at, L, query_result_ids_64.data() + (i * recall_at),
-                    query_result_dists[test_id].data() + (i * recall_at), optimized_beamwidth, true, label_for_search,
-                    use_reorder_data, stats + i);
             }
         }
         auto e = std::chrono::high_resolution_clock::now();
@@ -284,12 +496,81 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
         diskann::cout << std::setw(6) << L << std::setw(12) << optimized_beamwidth << std::setw(16) << qps
                       << std::setw(16) << mean_latency << std::setw(16) << latency_999 << std::setw(16) << mean_ios
                       << std::setw(16) << mean_io_us << std::setw(16) << mean_cpuus;
+        if (batch_size > 0)
+        {
+            // reads the queries asked for / reads actually issued
+            uint64_t n_issued = 0, n_shared = 0;
+            for (uint64_t i = 0; i < query_num; i++)
+            {
+                n_issued += stats[i].n_ios;
+                n_shared += stats[i].n_shared_ios;
+            }
+            diskann::cout << std::setw(16) << (n_issued == 0 ? 1.0 : (double)(n_issued + n_shared) / n_issued);
+        }
+        if (sector_cache_mb > 0)
+        {
+            uint64_t n_hits = 0, n_misses = 0, n_evictions = 0;
+            for (uint64_t i = 0; i < query_num; i++)
+            {
+                n_hits += stats[i].n_sector_cache_hits;
+                n_misses += stats[i].n_sector_cache_misses;
+                n_evictions += stats[i].n_sector_cache_evictions;
+            }
+            diskann::cout << std::setw(16) << (n_hits + n_misses == 0 ? 0.0 : 100.0 * n_hits / (n_hits + n_misses))
+                          << std::setw(16) << n_evictions;
+        }
+        if (early_stop)
+        {
+            diskann::cout << std::setw(16)
+                          << diskann::get_mean_stats<uint32_t>(
+                                 stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_hops; })
+                          << std::setw(16)
+                          << diskann::get_mean_stats<uint32_t>(
+                                 stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_hops_saved; });
+        }
+        if (prefetch_nodes > 0)
+        {
+            uint64_t n_prefetched = 0, n_hits = 0, wasted_bytes = 0;
+            for (uint64_t i = 0; i < query_num; i++)
+            {
+                n_prefetched += stats[i].n_prefetch_ios;
+                n_hits += stats[i].n_prefetch_hits;
+                wasted_bytes += stats[i].prefetch_wasted_bytes;
+            }
+            diskann::cout << std::setw(16) << (n_prefetched == 0 ? 0.0 : 100.0 * n_hits / n_prefetched)
+                          << std::setw(16) << (double)wasted_bytes / 1024 / query_num;
+        }
         if (calc_recall_flag)
         {
             diskann::cout << std::setw(16) << recall << std::endl;
         }
         else
             diskann::cout << std::endl;
+
+        if (!metrics_file.empty())
+        {
+            diskann::QueryMetrics metrics;
+            for (uint64_t i = 0; i < query_num; i++)
+                metrics.record(stats[i]);
+            std::ofstream out(metrics_file + "_L" + std::to_string(L) + ".prom");
+            out << metrics.to_prometheus();
+        }
+        if (trace_hops && query_num > 0)
+        {
+            uint64_t slowest = 0;
+            for (uint64_t i = 1; i < query_num; i++)
+                if (stats[i].total_us > stats[slowest].total_us)
+                    slowest = i;
+            diskann::cout << "  slowest query " << slowest << " (" << stats[slowest].total_us
+                          << "us), hop: frontier, ios, io_us, cpu_us, retset inserts" << std::endl;
+            for (size_t h = 0; h < hop_traces[slowest].size(); h++)
+            {
+                const diskann::HopTrace &hop = hop_traces[slowest][h];
+                diskann::cout << "  " << std::setw(4) << h << ": " << std::setw(6) << hop.frontier_size
+                              << std::setw(6) << hop.n_ios << std::setw(10) << hop.io_us << std::setw(10)
+                              << hop.cpu_us << std::setw(6) << hop.n_retset_inserts << std::endl;
+            }
+        }
         delete[] stats;
     }
 
@@ -316,10 +597,26 @@ int search_disk_index(diskann::Metric &metric, const std::string &index_path_pre
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, result_path_prefix, query_file, gt_file, filter_label,
-        label_type, query_filters_file;
+        label_type, query_filters_file, io_backend;
     uint32_t num_threads, K, W, num_nodes_to_cache, search_io_limit;
     std::vector<uint32_t> Lvec;
     bool use_reorder_data = false;
+    bool io_uring_sqpoll = false;
+    bool mmap_populate = false;
+    bool pipelined_search = false;
+    uint32_t batch_size = 0;
+    uint32_t sector_cache_mb = 0;
+    uint32_t early_stop_patience = 0;
+    float early_stop_ratio = 0.0f;
+    bool huge_pages = false;
+    std::string cache_file;
+    std::string numa;
+    std::string visited_set;
+    uint32_t prefetch_nodes = 0;
+    float delete_fraction = 0;
+    uint32_t async_queue_depth = 0;
+    std::string metrics_file;
+    bool trace_hops = false;
     float fail_if_recall_below = 0.0f;
 
     po::options_description desc{
@@ -375,6 +672,68 @@ int main(int argc, char **argv)
         optional_configs.add_options()("fail_if_recall_below",
                                        po::value<float>(&fail_if_recall_below)->default_value(0.0f),
                                        program_options_utils::FAIL_IF_RECALL_BELOW);
+        optional_configs.add_options()("io_backend", po::value<std::string>(&io_backend)->default_value("libaio"),
+                                       "Linux IO backend used to read the disk index {libaio, io_uring, mmap}. "
+                                       "mmap maps the index into memory and expands nodes in place, for indexes "
+                                       "that fit in the page cache.  Default value: libaio");
+        optional_configs.add_options()("io_uring_sqpoll", po::bool_switch(&io_uring_sqpoll)->default_value(false),
+                                       "Use a kernel submission polling thread with the io_uring backend.  "
+                                       "Default value: false");
+        optional_configs.add_options()("mmap_populate", po::bool_switch(&mmap_populate)->default_value(false),
+                                       "Fault the whole index into memory at load with the mmap backend.  "
+                                       "Default value: false");
+        optional_configs.add_options()("pipelined_search", po::bool_switch(&pipelined_search)->default_value(false),
+                                       "Keep W reads in flight and issue the next one as soon as any completes, "
+                                       "instead of waiting for the whole beam (Linux only).  Default value: false");
+        optional_configs.add_options()("prefetch_nodes", po::value<uint32_t>(&prefetch_nodes)->default_value(0),
+                                       "While a beam is expanded, speculatively read the sectors of up to this many "
+                                       "of the closest candidates outside it (Linux only). 0 disables it.  Default "
+                                       "value: 0");
+        optional_configs.add_options()("delete_fraction", po::value<float>(&delete_fraction)->default_value(0),
+                                       "Tombstone this fraction of the points, chosen at random, before searching, "
+                                       "and measure recall against the live points only.  Default value: 0");
+        optional_configs.add_options()("async_queue_depth",
+                                       po::value<uint32_t>(&async_queue_depth)->default_value(0),
+                                       "Search with async_search instead, on -T workers that each keep this many "
+                                       "queries in flight and move on to another query while one waits for its "
+                                       "reads. Beamwidth times this may not exceed 128. 0 uses one thread per query "
+                                       "in flight.  Default value: 0");
+        optional_configs.add_options()("metrics_file", po::value<std::string>(&metrics_file)->default_value(""),
+                                       "Write the latency histograms and counters of each L, in the Prometheus text "
+                                       "format, to <metrics_file>_L<L>.prom");
+        optional_configs.add_options()("trace_hops", po::bool_switch(&trace_hops)->default_value(false),
+                                       "Trace every hop of every query and print the trace of the slowest query of "
+                                       "each L. Not traced with --async_queue_depth.  Default value: false");
+        optional_configs.add_options()("batch_size", po::value<uint32_t>(&batch_size)->default_value(0),
+                                       "Search queries in batches of this size on each thread, reading a sector "
+                                       "needed by several queries of a batch only once per hop. 0 searches queries "
+                                       "one at a time.  Default value: 0");
+        optional_configs.add_options()("sector_cache_mb", po::value<uint32_t>(&sector_cache_mb)->default_value(0),
+                                       "Memory budget in MB of a cache of the sectors read by searches, on top of "
+                                       "the static node cache (Linux only). 0 disables it.  Default value: 0");
+        optional_configs.add_options()("early_stop_patience",
+                                       po::value<uint32_t>(&early_stop_patience)->default_value(0),
+                                       "Stop a search once its top K has not improved for this many hops. 0 "
+                                       "disables it; see calibrate_early_termination.  Default value: 0");
+        optional_configs.add_options()("early_stop_ratio", po::value<float>(&early_stop_ratio)->default_value(0.0f),
+                                       "Stop a search once its closest unexpanded candidate is farther than this "
+                                       "times its K-th best distance. 0 disables it; see "
+                                       "calibrate_early_termination.  Default value: 0");
+        optional_configs.add_options()("huge_pages", po::bool_switch(&huge_pages)->default_value(false),
+                                       "Back the in-memory PQ vectors and node cache with transparent huge pages "
+                                       "(Linux only).  Default value: false");
+        optional_configs.add_options()("cache_file", po::value<std::string>(&cache_file)->default_value(""),
+                                       "Fill the node cache from this file, by convention "
+                                       "<index_path_prefix>_cache.bin, if it was saved for this index. Otherwise "
+                                       "cache --num_nodes_to_cache nodes as usual and save them to it.");
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value(std::string("off")),
+                                       "NUMA placement {off, local, replicate}. local gives each search thread "
+                                       "scratch on its own node and keeps the PQ vectors and node cache on node "
+                                       "0; replicate also copies them to every node (Linux only).  Default value: "
+                                       "off");
+        optional_configs.add_options()("visited_set",
+                                       po::value<std::string>(&visited_set)->default_value(std::string("auto")),
+                                       program_options_utils::VISITED_SET);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -431,6 +790,32 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    if (numa != std::string("off") && numa != std::string("local") && numa != std::string("replicate"))
+    {
+        std::cerr << "Unsupported numa mode. Use off, local or replicate" << std::endl;
+        return -1;
+    }
+
+    if (visited_set != std::string("auto") && visited_set != std::string("array") &&
+        visited_set != std::string("bitset") && visited_set != std::string("hash"))
+    {
+        std::cerr << "Unsupported visited_set. Use auto, array, bitset or hash" << std::endl;
+        return -1;
+    }
+
+    if (io_backend != std::string("libaio") && io_backend != std::string("io_uring") &&
+        io_backend != std::string("mmap"))
+    {
+        std::cerr << "Unsupported io_backend. Use libaio, io_uring or mmap" << std::endl;
+        return -1;
+    }
+
+    if (batch_size > 0 && query_filters_file != "")
+    {
+        std::cerr << "--batch_size can not be used with a query filters file." << std::endl;
+        return -1;
+    }
+
     if (filter_label != "" && query_filters_file != "")
     {
         std::cerr << "Only one of filter_label and query_filters_file should be provided" << std::endl;
@@ -454,15 +839,27 @@ int main(int argc, char **argv)
             if (data_type == std::string("float"))
                 return search_disk_index<float, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    io_backend, io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                    mmap_populate, early_stop_patience, early_stop_ratio, huge_pages, cache_file, numa, visited_set,
+                    prefetch_nodes, delete_fraction, async_queue_depth, metrics_file,
+                    trace_hops);
             else if (data_type == std::string("int8"))
                 return search_disk_index<int8_t, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    io_backend, io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                    mmap_populate, early_stop_patience, early_stop_ratio, huge_pages, cache_file, numa, visited_set,
+                    prefetch_nodes, delete_fraction, async_queue_depth, metrics_file,
+                    trace_hops);
             else if (data_type == std::string("uint8"))
                 return search_disk_index<uint8_t, uint16_t>(
                     metric, index_path_prefix, result_path_prefix, query_file, gt_file, num_threads, K, W,
-                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data);
+                    num_nodes_to_cache, search_io_limit, Lvec, fail_if_recall_below, query_filters, use_reorder_data,
+                    io_backend, io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                    mmap_populate, early_stop_patience, early_stop_ratio, huge_pages, cache_file, numa, visited_set,
+                    prefetch_nodes, delete_fraction, async_queue_depth, metrics_file,
+                    trace_hops);
             else
             {
                 std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
@@ -474,15 +871,28 @@ int main(int argc, char **argv)
             if (data_type == std::string("float"))
                 return search_disk_index<float>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                 num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                fail_if_recall_below, query_filters, use_reorder_data);
+                                                fail_if_recall_below, query_filters, use_reorder_data, io_backend,
+                                                io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                                                mmap_populate, early_stop_patience, early_stop_ratio, huge_pages,
+                                                cache_file, numa, visited_set, prefetch_nodes,
+                                                delete_fraction, async_queue_depth, metrics_file, trace_hops);
             else if (data_type == std::string("int8"))
                 return search_disk_index<int8_t>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                  num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                 fail_if_recall_below, query_filters, use_reorder_data);
+                                                 fail_if_recall_below, query_filters, use_reorder_data, io_backend,
+                                                 io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                                                 mmap_populate, early_stop_patience, early_stop_ratio, huge_pages,
+                                                 cache_file, numa, visited_set, prefetch_nodes,
+                                                 delete_fraction, async_queue_depth, metrics_file, trace_hops);
             else if (data_type == std::string("uint8"))
                 return search_disk_index<uint8_t>(metric, index_path_prefix, result_path_prefix, query_file, gt_file,
                                                   num_threads, K, W, num_nodes_to_cache, search_io_limit, Lvec,
-                                                  fail_if_recall_below, query_filters, use_reorder_data);
+                                                  fail_if_recall_below, query_filters, use_reorder_data, io_backend,
+                                                  io_uring_sqpoll, pipelined_search, batch_size, sector_cache_mb,
+                                                  mmap_populate, early_stop_patience, early_stop_ratio, huge_pages,
+                                                  cache_file, numa, visited_set, prefetch_nodes,
+                                                  delete_fraction, async_queue_depth, metrics_file,
+                                                  trace_hops);
             else
             {
                 std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
@@ -30,7 +30,9 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                         const std::string &query_file, const std::string &truthset_file, const uint32_t num_threads,
                         const uint32_t recall_at, const bool print_all_recalls, const std::vector<uint32_t> &Lvec,
                         const bool dynamic, const bool tags, const bool show_qps_per_thread,
-                        const std::vector<std::string> &query_filters, const float fail_if_recall_below)
+                        const std::vector<std::string> &query_filters, const float fail_if_recall_below,
+                        const diskann::GraphStoreStrategy graph_strategy = diskann::GraphStoreStrategy::MEMORY,
+                        const diskann::VisitedSetPolicy visited_policy = diskann::VisitedSetPolicy::AUTO)
 {
     using TagT = uint32_t;
     // Load the query file
@@ -75,7 +77,8 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                       .with_dimension(query_dim)
                       .with_max_points(0)
                       .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
-                      .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                      .with_graph_load_store_strategy(graph_strategy)
+                      .with_visited_set_policy(visited_policy)
                       .with_data_type(diskann_type_to_name<T>())
                       .with_label_type(diskann_type_to_name<LabelT>())
                       .with_tag_type(diskann_type_to_name<TagT>())
@@ -278,7 +281,7 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, result_path, query_file, gt_file, filter_label, label_type,
-        query_filters_file;
+        query_filters_file, graph_store, visited_set;
     uint32_t num_threads, K;
     std::vector<uint32_t> Lvec;
     bool print_all_recalls, dynamic, tags, show_qps_per_thread;
@@ -331,6 +334,10 @@ int main(int argc, char **argv)
         optional_configs.add_options()("fail_if_recall_below",
                                        po::value<float>(&fail_if_recall_below)->default_value(0.0f),
                                        program_options_utils::FAIL_IF_RECALL_BELOW);
+        optional_configs.add_options()("graph_store", po::value<std::string>(&graph_store)->default_value("vector"),
+                                       program_options_utils::GRAPH_STORE);
+        optional_configs.add_options()("visited_set", po::value<std::string>(&visited_set)->default_value("auto"),
+                                       program_options_utils::VISITED_SET);
 
         // Output controls
         po::options_description output_controls("Output controls");
@@ -391,6 +398,32 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    diskann::GraphStoreStrategy graph_strategy;
+    if (graph_store == std::string("vector"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY;
+    else if (graph_store == std::string("fixed_degree"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY_FIXED_DEGREE;
+    else
+    {
+        std::cerr << "Unsupported graph store. Use vector or fixed_degree." << std::endl;
+        return -1;
+    }
+
+    diskann::VisitedSetPolicy visited_policy;
+    if (visited_set == std::string("auto"))
+        visited_policy = diskann::VisitedSetPolicy::AUTO;
+    else if (visited_set == std::string("array"))
+        visited_policy = diskann::VisitedSetPolicy::EPOCH_ARRAY;
+    else if (visited_set == std::string("bitset"))
+        visited_policy = diskann::VisitedSetPolicy::BITSET;
+    else if (visited_set == std::string("hash"))
+        visited_policy = diskann::VisitedSetPolicy::HASH_SET;
+    else
+    {
+        std::cerr << "Unsupported visited_set. Use auto, array, bitset or hash." << std::endl;
+        return -1;
+    }
+
     if (fail_if_recall_below < 0.0 || fail_if_recall_below >= 100.0)
     {
         std::cerr << "fail_if_recall_below parameter must be between 0 and 100%" << std::endl;
@@ -421,19 +454,22 @@ int main(int argc, char **argv)
             {
                 return search_memory_index<int8_t, uint16_t>(
                     metric, index_path_prefix, result_path, query_file, gt_file, num_threads, K, print_all_recalls,
-                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below);
+                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below, graph_strategy,
+                    visited_policy);
             }
             else if (data_type == std::string("uint8"))
             {
                 return search_memory_index<uint8_t, uint16_t>(
                     metric, index_path_prefix, result_path, query_file, gt_file, num_threads, K, print_all_recalls,
-                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below);
+                    Lvec, dynamic, tags, show_qps_per_thread, query_filters, fail_if_recall_below, graph_strategy,
+                    visited_policy);
             }
             else if (data_type == std::string("float"))
             {
                 return search_memory_index<float, uint16_t>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                             num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                            show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                            show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                            graph_strategy, visited_policy);
             }
             else
             {
@@ -447,19 +483,22 @@ int main(int argc, char **argv)
             {
                 return search_memory_index<int8_t>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                    num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                   show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                   show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                   graph_strategy, visited_policy);
             }
             else if (data_type == std::string("uint8"))
             {
                 return search_memory_index<uint8_t>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                     num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                    show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                    show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                    graph_strategy, visited_policy);
             }
             else if (data_type == std::string("float"))
             {
                 return search_memory_index<float>(metric, index_path_prefix, result_path, query_file, gt_file,
                                                   num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                  show_qps_per_thread, query_filters, fail_if_recall_below);
+                                                  show_qps_per_thread, query_filters, fail_if_recall_below,
+                                                  graph_strategy, visited_policy);
             }
             else
             {
@@ -150,7 +150,7 @@ void build_incremental_index(const std::string &data_path, diskann::IndexWritePa
                              uint32_t num_start_pts, size_t points_per_checkpoint, size_t checkpoints_per_snapshot,
                              const std::string &save_path, size_t points_to_delete_from_beginning,
                              size_t start_deletes_after, bool concurrent, const std::string &label_file,
-                             const std::string &universal_label)
+                             const std::string &universal_label, diskann::GraphStoreStrategy graph_strategy)
 {
     size_t dim, aligned_dim;
     size_t num_points;
@@ -177,7 +177,7 @@ void build_incremental_index(const std::string &data_path, diskann::IndexWritePa
                                             .with_tag_type(diskann_type_to_name<TagT>())
                                             .with_label_type(diskann_type_to_name<LabelT>())
                                             .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
-                                            .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
+                                            .with_graph_load_store_strategy(graph_strategy)
                                             .is_enable_tags(enable_tags)
                                             .is_filtered(has_labels)
                                             .with_num_frozen_pts(num_start_pts)
@@ -382,6 +382,7 @@ int main(int argc, char **argv)
 
     // label options
     std::string label_file, label_type, universal_label;
+    std::string graph_store;
     std::uint32_t Lf, unique_labels_supported;
 
     po::options_description desc{program_options_utils::make_program_description("test_insert_deletes_consolidate",
@@ -455,6 +456,8 @@ int main(int argc, char **argv)
             po::value<uint32_t>(&num_start_pts)->default_value(diskann::defaults::NUM_FROZEN_POINTS_DYNAMIC),
             "Set the number of random start (frozen) points to use when "
             "inserting and searching");
+        optional_configs.add_options()("graph_store", po::value<std::string>(&graph_store)->default_value("vector"),
+                                       program_options_utils::GRAPH_STORE);
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -489,6 +492,17 @@ int main(int argc, char **argv)
         has_labels = true;
     }
 
+    diskann::GraphStoreStrategy graph_strategy;
+    if (graph_store == std::string("vector"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY;
+    else if (graph_store == std::string("fixed_degree"))
+        graph_strategy = diskann::GraphStoreStrategy::MEMORY_FIXED_DEGREE;
+    else
+    {
+        std::cerr << "Unsupported graph store. Use vector or fixed_degree." << std::endl;
+        return -1;
+    }
+
     if (num_start_pts < unique_labels_supported)
     {
         num_start_pts = unique_labels_supported;
@@ -507,17 +521,20 @@ int main(int argc, char **argv)
             build_incremental_index<int8_t>(
                 data_path, params, points_to_skip, max_points_to_insert, beginning_index_size, start_point_norm,
                 num_start_pts, points_per_checkpoint, checkpoints_per_snapshot, index_path_prefix,
-                points_to_delete_from_beginning, start_deletes_after, concurrent, label_file, universal_label);
+                points_to_delete_from_beginning, start_deletes_after, concurrent, label_file, universal_label,
+                graph_strategy);
         else if (data_type == std::string("uint8"))
             build_incremental_index<uint8_t>(
                 data_path, params, points_to_skip, max_points_to_insert, beginning_index_size, start_point_norm,
                 num_start_pts, points_per_checkpoint, checkpoints_per_snapshot, index_path_prefix,
-                points_to_delete_from_beginning, start_deletes_after, concurrent, label_file, universal_label);
+                points_to_delete_from_beginning, start_deletes_after, concurrent, label_file, universal_label,
+                graph_strategy);
         else if (data_type == std::string("float"))
             build_incremental_index<float>(data_path, params, points_to_skip, max_points_to_insert,
                                            beginning_index_size, start_point_norm, num_start_pts, points_per_checkpoint,
                                            checkpoints_per_snapshot, index_path_prefix, points_to_delete_from_beginning,
-                                           start_deletes_after, concurrent, label_file, universal_label);
+                                           start_deletes_after, concurrent, label_file, universal_label,
+                                           graph_strategy);
         else
             std::cout << "Unsupported type. Use float/int8/uint8" << std::endl;
     }
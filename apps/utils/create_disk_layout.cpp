@@ -6,39 +6,56 @@
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <sstream>
 #include <vector>
 
 #include "utils.h"
 #include "disk_utils.h"
 #include "cached_io.h"
 
-template <typename T> int create_disk_layout(char **argv)
+template <typename T> int create_disk_layout(int argc, char **argv)
 {
     std::string base_file(argv[2]);
     std::string vamana_file(argv[3]);
     std::string output_file(argv[4]);
-    diskann::create_disk_layout<T>(base_file, vamana_file, output_file);
+    bool locality_layout = argc > 5 && std::string(argv[5]) == std::string("1");
+    bool packed_nhoods = argc > 6 && std::string(argv[6]) == std::string("1");
+    bool decoupled_layout = argc > 7 && std::string(argv[7]) == std::string("1");
+    std::vector<std::string> stripe_dirs;
+    if (argc > 8)
+    {
+        std::istringstream iss(argv[8]);
+        std::string token;
+        while (std::getline(iss, token, ','))
+        {
+            if (!token.empty())
+                stripe_dirs.push_back(token);
+        }
+    }
+    diskann::create_disk_layout<T>(base_file, vamana_file, output_file, "", locality_layout, packed_nhoods,
+                                   decoupled_layout, stripe_dirs);
     return 0;
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 5)
+    if (argc < 5 || argc > 9)
     {
         std::cout << argv[0]
                   << " data_type <float/int8/uint8> data_bin "
-                     "vamana_index_file output_diskann_index_file"
+                     "vamana_index_file output_diskann_index_file [locality_layout <0/1>] "
+                     "[packed_nhoods <0/1>] [decoupled_layout <0/1>] [stripe_dirs <dir0,dir1,...>]"
                   << std::endl;
         exit(-1);
     }
 
     int ret_val = -1;
     if (std::string(argv[1]) == std::string("float"))
-        ret_val = create_disk_layout<float>(argv);
+        ret_val = create_disk_layout<float>(argc, argv);
     else if (std::string(argv[1]) == std::string("int8"))
-        ret_val = create_disk_layout<int8_t>(argv);
+        ret_val = create_disk_layout<int8_t>(argc, argv);
     else if (std::string(argv[1]) == std::string("uint8"))
-        ret_val = create_disk_layout<uint8_t>(argv);
+        ret_val = create_disk_layout<uint8_t>(argc, argv);
     else
     {
         std::cout << "unsupported type. use int8/uint8/float " << std::endl;
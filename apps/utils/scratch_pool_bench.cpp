@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+// Measures how fast threads can take and return search scratch, with the
+// ScratchPool used by the indices and with the ConcurrentQueue it replaced,
+// for 1 up to --max_threads threads in powers of two.
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "concurrent_queue.h"
+#include "scratch.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+struct BenchScratch
+{
+    std::vector<uint32_t> buf;
+    BenchScratch(uint32_t size) : buf(size, 0)
+    {
+    }
+    void clear()
+    {
+        buf[0] = 0;
+    }
+};
+
+// touches the scratch like a short query would, so acquisition is not the
+// only thing the threads do
+inline void use_scratch(BenchScratch *scratch, uint32_t work)
+{
+    for (uint32_t i = 0; i < work; i++)
+        scratch->buf[i % scratch->buf.size()] += i;
+}
+
+uint64_t run_queue(uint32_t nthreads, uint32_t nscratch, uint32_t work, uint32_t duration_ms)
+{
+    diskann::ConcurrentQueue<BenchScratch *> queue(nullptr);
+    for (uint32_t i = 0; i < nscratch; i++)
+    {
+        BenchScratch *scratch = new BenchScratch(1024);
+        queue.push(scratch);
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> ops(nthreads, 0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < nthreads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            uint64_t local_ops = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                // same protocol as ScratchStoreManager used before
+                BenchScratch *scratch = queue.pop();
+                while (scratch == nullptr)
+                {
+                    queue.wait_for_push_notify();
+                    scratch = queue.pop();
+                }
+                use_scratch(scratch, work);
+                scratch->clear();
+                queue.push(scratch);
+                queue.push_notify_all();
+                local_ops++;
+            }
+            ops[t] = local_ops;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    for (auto &thread : threads)
+        thread.join();
+
+    for (uint32_t i = 0; i < nscratch; i++)
+        delete queue.pop();
+    uint64_t total = 0;
+    for (auto n : ops)
+        total += n;
+    return total;
+}
+
+uint64_t run_pool(uint32_t nthreads, uint32_t nscratch, uint32_t work, uint32_t duration_ms)
+{
+    diskann::ScratchPool<BenchScratch *> pool(nullptr);
+    for (uint32_t i = 0; i < nscratch; i++)
+    {
+        BenchScratch *scratch = new BenchScratch(1024);
+        pool.push(scratch);
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> ops(nthreads, 0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < nthreads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            uint64_t local_ops = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                diskann::ScratchStoreManager<BenchScratch> manager(pool);
+                use_scratch(manager.scratch_space(), work);
+                local_ops++;
+            }
+            ops[t] = local_ops;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    for (auto &thread : threads)
+        thread.join();
+
+    {
+        diskann::ScratchStoreManager<BenchScratch> manager(pool);
+        manager.destroy();
+    }
+    uint64_t total = 0;
+    for (auto n : ops)
+        total += n;
+    return total;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t max_threads, num_scratch, work, duration_ms;
+    try
+    {
+        po::options_description desc{"Arguments"};
+
+        desc.add_options()("help,h", "Print information on arguments");
+        desc.add_options()("max_threads,T", po::value<uint32_t>(&max_threads)->default_value(128),
+                           "Largest number of threads to run with");
+        desc.add_options()("num_scratch", po::value<uint32_t>(&num_scratch)->default_value(0),
+                           "Number of scratch spaces in the pool. 0 uses one per thread; a smaller value "
+                           "measures an oversubscribed pool");
+        desc.add_options()("work", po::value<uint32_t>(&work)->default_value(64),
+                           "Scratch words written between taking and returning a scratch space");
+        desc.add_options()("duration_ms", po::value<uint32_t>(&duration_ms)->default_value(500),
+                           "Time to run each configuration for");
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    std::cout << std::setw(8) << "Threads" << std::setw(10) << "Scratch" << std::setw(16) << "Queue Mops/s"
+              << std::setw(16) << "Pool Mops/s" << std::setw(10) << "Speedup" << std::endl;
+    for (uint32_t nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+    {
+        uint32_t nscratch = num_scratch == 0 ? nthreads : num_scratch;
+        double secs = duration_ms / 1000.0;
+        double queue_mops = run_queue(nthreads, nscratch, work, duration_ms) / secs / 1e6;
+        double pool_mops = run_pool(nthreads, nscratch, work, duration_ms) / secs / 1e6;
+        std::cout << std::setw(8) << nthreads << std::setw(10) << nscratch << std::setw(16) << std::fixed
+                  << std::setprecision(3) << queue_mops << std::setw(16) << pool_mops << std::setw(10)
+                  << std::setprecision(2) << pool_mops / queue_mops << std::endl;
+    }
+    return 0;
+}
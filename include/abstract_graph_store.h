@@ -10,6 +10,50 @@
 namespace diskann
 {
 
+// Read-only view of the out-neighbours of a node, as returned by
+// get_neighbours. It points into the graph store, so it is only valid until
+// the neighbours of the node change or the graph is resized.
+class NeighbourList
+{
+  public:
+    NeighbourList(const location_t *data, size_t size) : _data(data), _size(size)
+    {
+    }
+
+    NeighbourList(const std::vector<location_t> &neighbours) : _data(neighbours.data()), _size(neighbours.size())
+    {
+    }
+
+    const location_t *begin() const
+    {
+        return _data;
+    }
+    const location_t *end() const
+    {
+        return _data + _size;
+    }
+    const location_t *data() const
+    {
+        return _data;
+    }
+    const location_t &operator[](size_t i) const
+    {
+        return _data[i];
+    }
+    size_t size() const
+    {
+        return _size;
+    }
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+  private:
+    const location_t *_data;
+    size_t _size;
+};
+
 class AbstractGraphStore
 {
   public:
@@ -27,7 +71,7 @@ class AbstractGraphStore
                       const uint32_t start) = 0;
 
     // not synchronised, user should use lock when necvessary.
-    virtual const std::vector<location_t> &get_neighbours(const location_t i) const = 0;
+    virtual NeighbourList get_neighbours(const location_t i) const = 0;
     virtual void add_neighbour(const location_t i, location_t neighbour_id) = 0;
     virtual void clear_neighbours(const location_t i) = 0;
     virtual void swap_neighbours(const location_t a, location_t b) = 0;
@@ -39,11 +83,29 @@ class AbstractGraphStore
 
     virtual uint32_t get_max_observed_degree() = 0;
 
+    // true if the neighbours of a node stay at the same address while they
+    // are changed, so that they can be copied without locking and validated
+    // afterwards: a racing reader may see stale or torn ids, but never freed
+    // memory. Not the case when each node has a vector that can reallocate.
+    virtual bool supports_lock_free_reads() const
+    {
+        return false;
+    }
+
+    // copies the neighbours of i into neighbours. Stores that support lock
+    // free reads do it with atomic loads, so that it is not a data race while
+    // a writer changes them; the copy may still be torn and must be validated.
+    virtual void copy_neighbours(const location_t i, std::vector<location_t> &neighbours) const
+    {
+        auto list = get_neighbours(i);
+        neighbours.assign(list.begin(), list.end());
+    }
+
     // set during load
     virtual size_t get_max_range_of_graph() = 0;
 
     // Total internal points _max_points + _num_frozen_points
-    size_t get_total_points()
+    size_t get_total_points() const
     {
         return _capacity;
     }
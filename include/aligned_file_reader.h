@@ -109,15 +109,41 @@ class AlignedFileReader
     virtual void deregister_thread() = 0;
     virtual void deregister_all_threads() = 0;
 
+    // hint that reads issued on ctx will target [buf, buf + len); readers that
+    // can pre-register memory with the kernel (io_uring) use it, others ignore it
+    virtual void register_buffer(IOContext &ctx, void *buf, uint64_t len)
+    {
+    }
+
     // Open & close ops
     // Blocking calls
     virtual void open(const std::string &fname) = 0;
     virtual void close() = 0;
 
+    // start of the open file if the reader maps it into memory, nullptr
+    // otherwise; callers may then use [offset, offset + len) of the mapping in
+    // place instead of reading it
+    virtual char *get_mapped_data()
+    {
+        return nullptr;
+    }
+
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     virtual void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false) = 0;
 
+#ifndef _WINDOWS
+    // issue a batch of aligned requests without waiting for them to complete;
+    // every request must have a distinct buf, which identifies it on completion
+    virtual void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx) = 0;
+
+    // wait until at least min_completions submitted requests have completed and
+    // append the bufs of all requests found complete to completed_bufs.
+    // returns the number of bufs appended
+    virtual uint64_t get_completed_reqs(IOContext &ctx, uint64_t min_completions,
+                                        std::vector<void *> &completed_bufs) = 0;
+#endif
+
 #ifdef USE_BING_INFRA
     // wait for completion of one request in a batch of requests
     virtual void wait(IOContext &ctx, int &completedIndex) = 0;
@@ -23,6 +23,34 @@ const float GRAPH_SLACK_FACTOR = 1.3f;
 const uint64_t MAX_GRAPH_DEGREE = 512;
 const uint64_t SECTOR_LEN = 4096;
 const uint64_t MAX_N_SECTOR_READS = 128;
+// staging sectors per query for the speculative prefetch of cached_beam_search
+const uint64_t MAX_N_PREFETCH_SECTORS = 16;
+// most memory a thread keeps in per-query scratch for batched search; larger
+// batches are searched in parts of the size that fits
+const uint64_t MAX_BATCH_SCRATCH_BYTES = 256 * 1024 * 1024;
+
+// bits of the layout flags stored after the file size in the SSD index header
+const uint64_t DISK_LAYOUT_PERMUTED = 1;      // nodes stored in locality order, see create_disk_layout
+const uint64_t DISK_LAYOUT_PACKED_NHOODS = 2; // neighbor lists packed as in nhood_codec.h; max degree follows flags
+const uint64_t DISK_LAYOUT_DECOUPLED = 4;     // graph-only nodes, vectors in a separate region described after flags
+
+// sectors of the SSD index written to one stripe before moving to the next,
+// see stripe_disk_index
+const uint64_t DISK_STRIPE_SECTORS = 1;
+
+// nodes read with one batched submission per thread by load_cache_list
+const uint64_t CACHE_LOAD_BATCH_SIZE = 1024;
+
+// most that searches scale l_search up by to make up for deleted points in
+// the candidate list, see PQFlashIndex::lazy_delete
+const uint64_t MAX_TOMBSTONE_L_SCALE = 4;
+
+// largest epoch array a search scratch keeps for its visited set, at 2 bytes
+// per point; larger indices use a bitset, see visited_set.h
+const uint64_t MAX_VISITED_ARRAY_BYTES = 16 * 1024 * 1024;
+// largest index whose search scratch keeps a visited bitset, at 1 bit per
+// point; larger indices use a hash set
+const uint64_t MAX_VISITED_BITSET_POINTS = 10000000;
 
 // following constants should always be specified, but are useful as a
 // sensible default at cli / python boundaries
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "abstract_index.h"
+#include "pq_flash_index.h"
+#include "tsl/robin_set.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+struct DiskMergeParameters
+{
+    uint32_t search_l = 75;  // candidate list used to place each inserted point
+    float alpha = 1.2f;      // pruning parameter, as for the build
+    uint32_t beam_width = 4; // beam width of the searches on the SSD index
+    uint32_t num_threads = 0;
+};
+
+// Writes the SSD index <output_prefix>_disk.index, with its PQ files, that
+// holds the points of the index <base_prefix> less deleted_ids, plus the
+// active points of the in-memory delta index, without rebuilding the graph:
+//
+// - each point of delta is placed by searching base and delta for it and
+//   pruning the candidates to the degree of base. Its id in the output is
+//   its tag, which must be at least base.get_num_points(); tags of the delta
+//   must be uint32_t.
+// - the nodes of base are then streamed in sector order. A node that pointed
+//   to deleted nodes takes their neighbors in their place, gets the reverse
+//   edges of the inserted points, and is pruned again if that is more than
+//   the degree allows. Deleted nodes are written empty, and the medoid is
+//   replaced if it was deleted.
+// - the inserted points are appended after the last node of base.
+//
+// Other ids keep their value, so results of the old and new index agree on
+// ids. Pruning uses the PQ vectors of base, so that no node is read twice.
+// base must be the loaded SSD index of base_prefix, with the L2 metric, 8-bit
+// PQ without OPQ, and the plain layout of create_disk_layout, with neither
+// reorder data, labels nor multiple medoids.
+template <typename T>
+DISKANN_DLLEXPORT void merge_disk_index(PQFlashIndex<T> &base, const std::string &base_prefix, AbstractIndex &delta,
+                                        const std::vector<uint32_t> &deleted_ids, const std::string &output_prefix,
+                                        const DiskMergeParameters &params);
+
+// An SSD index that takes inserts and deletes between merges. Inserts go to
+// the in-memory delta, deletes of points of the SSD index are recorded and
+// filtered from its results, and searches fan out over both indices.
+// merge() folds the changes into a new SSD index.
+template <typename T> class UpdatableDiskIndex
+{
+  public:
+    // delta must be a dynamic index with uint32_t tags and the same metric
+    // and dimension as base
+    DISKANN_DLLEXPORT UpdatableDiskIndex(PQFlashIndex<T> &base, AbstractIndex &delta);
+
+    // adds point with id, which must be at least the number of points of the
+    // SSD index; returns 0 on success
+    DISKANN_DLLEXPORT int insert(const T *point, const uint32_t id);
+
+    // deletes the point with id from either index, from the SSD index with
+    // PQFlashIndex::lazy_delete; returns 0 on success
+    DISKANN_DLLEXPORT int remove(const uint32_t id);
+
+    // the k_search closest live points of both indices, sorted by distance;
+    // returns their number. stats, if given, are those of the SSD index.
+    DISKANN_DLLEXPORT uint64_t search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                      uint64_t *res_ids, float *res_dists, const uint64_t beam_width,
+                                      QueryStats *stats = nullptr);
+
+    // the deleted points of the SSD index, in increasing order
+    DISKANN_DLLEXPORT std::vector<uint32_t> get_deleted_ids();
+
+    // writes the merged SSD index to output_prefix, see merge_disk_index.
+    // Inserts and deletes must not run concurrently with it.
+    DISKANN_DLLEXPORT void merge(const std::string &base_prefix, const std::string &output_prefix,
+                                 const DiskMergeParameters &params);
+
+  private:
+    PQFlashIndex<T> &_base;
+    AbstractIndex &_delta;
+    uint64_t _num_base_points;
+};
+} // namespace diskann
@@ -27,6 +27,7 @@ typedef int FileHandle;
 
 #include "cached_io.h"
 #include "common_includes.h"
+#include "defaults.h"
 
 #include "utils.h"
 #include "windows_customizations.h"
@@ -100,9 +101,41 @@ DISKANN_DLLEXPORT int build_disk_index(
     const std::string &universal_label = "", const uint32_t filter_threshold = 0,
     const uint32_t Lf = 0); // default is empty string for no universal label
 
+// Order in which to lay nodes out on disk so that graph neighbors share
+// sectors: a BFS from start over the graph in mem_index_file, visiting each
+// node's neighbors in adjacency order, restarted from the smallest unvisited
+// id for unreachable nodes. The graph is not loaded: only the order, a file
+// offset per node, and the neighbors of one batch of nodes at a time are kept
+// in memory. Returns position -> node id.
+DISKANN_DLLEXPORT std::vector<uint32_t> get_locality_layout_order(const std::string &mem_index_file, uint32_t start);
+
+// With locality_layout, nodes are written in get_locality_layout_order()
+// instead of id order, and the position of each node id is saved to
+// output_file + "_layout_perm.bin". Node ids, and so every other index file,
+// are unchanged.
+// With packed_nhoods, neighbor lists are stored sorted and delta encoded (see
+// nhood_codec.h), and the node length is set by the longest packed list.
+// With decoupled_layout, nodes hold only their neighbor lists and the full
+// precision vectors are written in id order to a region after the graph, to
+// be read only for the final rerank of a search. Not supported together with
+// reorder data.
+// With stripe_dirs, the index is then split with stripe_disk_index().
 template <typename T>
 DISKANN_DLLEXPORT void create_disk_layout(const std::string base_file, const std::string mem_index_file,
                                           const std::string output_file,
-                                          const std::string reorder_data_file = std::string(""));
+                                          const std::string reorder_data_file = std::string(""),
+                                          const bool locality_layout = false, const bool packed_nhoods = false,
+                                          const bool decoupled_layout = false,
+                                          const std::vector<std::string> &stripe_dirs = std::vector<std::string>());
+
+// Splits the SSD index disk_index_file into one stripe file per directory,
+// meant to be on different devices, so that searches can read from all of
+// them at once. Runs of stripe_sectors sectors go to the stripes round robin.
+// The stripe of directory i is dir_i/<file name of disk_index_file>.stripe<i>;
+// their list is saved to disk_index_file + "_stripes.txt", and
+// disk_index_file is cut down to its header sector. PQFlashIndex::load then
+// reads the index through a StripedAlignedFileReader.
+DISKANN_DLLEXPORT void stripe_disk_index(const std::string &disk_index_file, const std::vector<std::string> &stripe_dirs,
+                                         const uint64_t stripe_sectors = defaults::DISK_STRIPE_SECTORS);
 
 } // namespace diskann
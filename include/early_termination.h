@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "neighbor.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Decides when a disk search can stop before its candidate list runs out of
+// unexpanded nodes. The top k of the expanded nodes is tracked as the search
+// goes, and the search stops once either
+//  - the top k has not improved for patience_hops hops in a row, or
+//  - the closest unexpanded candidate is farther than converge_ratio times
+//    the current k-th best distance, i.e. the frontier has moved away from
+//    the results and further hops are unlikely to change them.
+// Either rule is disabled by a 0. Suitable values depend on the data and are
+// picked offline with apps/calibrate_early_termination.
+class EarlyTermination
+{
+  public:
+    DISKANN_DLLEXPORT EarlyTermination(uint64_t k, uint32_t patience_hops, float converge_ratio);
+
+    DISKANN_DLLEXPORT bool enabled() const;
+
+    // call once per hop: folds the nodes appended to full_retset since the
+    // last call into the top k, and returns true once the search should stop
+    DISKANN_DLLEXPORT bool should_stop(const std::vector<Neighbor> &full_retset, const NeighborPriorityQueue &retset);
+
+    // estimate of the hops the search would still have made, from the
+    // unexpanded candidates left in retset
+    DISKANN_DLLEXPORT static uint32_t estimate_hops_left(const NeighborPriorityQueue &retset, uint64_t beam_width);
+
+  private:
+    uint64_t _k;
+    uint32_t _patience_hops;
+    float _converge_ratio;
+
+    std::priority_queue<float> _topk; // k best distances, worst on top
+    uint64_t _num_folded = 0;         // prefix of full_retset already in _topk
+    uint32_t _stale_hops = 0;
+};
+} // namespace diskann
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "abstract_graph_store.h"
+
+namespace diskann
+{
+
+// Keeps the whole graph in one 64-byte aligned array with a row of
+// max_degree + 1 slots per node, rounded up to a multiple of 16 so that every
+// row starts on a cache line: the degree of the node followed by its
+// neighbours. Fetching the neighbours of a node reads one contiguous row
+// instead of following a pointer to a separate allocation, and there is no
+// per-node vector header or allocator overhead. The row size is fixed when
+// the store is created, from the reserved degree, and grows only on load, if
+// the graph file has nodes of a higher degree; adding more neighbours to a
+// node than its row holds throws.
+class InMemFixedDegreeGraphStore : public AbstractGraphStore
+{
+  public:
+    InMemFixedDegreeGraphStore(const size_t total_pts, const size_t reserve_graph_degree);
+    InMemFixedDegreeGraphStore(const InMemFixedDegreeGraphStore &) = delete;
+    InMemFixedDegreeGraphStore &operator=(const InMemFixedDegreeGraphStore &) = delete;
+    virtual ~InMemFixedDegreeGraphStore();
+
+    // returns tuple of <nodes_read, start, num_frozen_points>
+    virtual std::tuple<uint32_t, uint32_t, size_t> load(const std::string &index_path_prefix,
+                                                        const size_t num_points) override;
+    virtual int store(const std::string &index_path_prefix, const size_t num_points, const size_t num_frozen_points,
+                      const uint32_t start) override;
+
+    virtual NeighbourList get_neighbours(const location_t i) const override;
+    virtual void copy_neighbours(const location_t i, std::vector<location_t> &neighbours) const override;
+    virtual void add_neighbour(const location_t i, location_t neighbour_id) override;
+    virtual void clear_neighbours(const location_t i) override;
+    virtual void swap_neighbours(const location_t a, location_t b) override;
+
+    virtual void set_neighbours(const location_t i, std::vector<location_t> &neighbors) override;
+
+    virtual size_t resize_graph(const size_t new_size) override;
+    virtual void clear_graph() override;
+
+    virtual size_t get_max_range_of_graph() override;
+    virtual uint32_t get_max_observed_degree() override;
+
+    // rows only move when the graph is resized or reloaded, and the writes
+    // to a row and copy_neighbours() use atomic accesses
+    virtual bool supports_lock_free_reads() const override
+    {
+        return true;
+    }
+
+  private:
+    inline uint32_t *row(const location_t i) const
+    {
+        return _rows + (size_t)i * _row_slots;
+    }
+
+    // reallocates the array for num_points rows of max_degree neighbours,
+    // keeping the neighbours of the nodes below num_points
+    void reshape(const size_t num_points, const size_t max_degree);
+
+    size_t _max_degree = 0;
+    size_t _row_slots = 1;
+    uint32_t *_rows = nullptr;
+
+    size_t _max_range_of_graph = 0;
+    uint32_t _max_observed_degree = 0;
+};
+
+} // namespace diskann
@@ -32,14 +32,22 @@
 namespace diskann
 {
 
-inline double estimate_ram_usage(size_t size, uint32_t dim, uint32_t datasize, uint32_t degree)
+// num_threads query scratches are counted for their visited sets: with the
+// default policy each holds an epoch array of 2 bytes per point for indices of
+// up to 8M points (16MB at most), and a 1 bit per point bitset up to 10M
+// points, so on many threads they can outweigh the locks.
+inline double estimate_ram_usage(size_t size, uint32_t dim, uint32_t datasize, uint32_t degree,
+                                 uint32_t num_threads = 0)
 {
     double size_of_data = ((double)size) * ROUND_UP(dim, 8) * datasize;
     double size_of_graph = ((double)size) * degree * sizeof(uint32_t) * defaults::GRAPH_SLACK_FACTOR;
-    double size_of_locks = ((double)size) * sizeof(non_recursive_mutex);
+    double size_of_locks = ((double)size) * sizeof(versioned_spinlock);
     double size_of_outer_vector = ((double)size) * sizeof(ptrdiff_t);
+    double size_of_visited_sets =
+        ((double)num_threads) * VisitedSet::memory_usage(VisitedSetPolicy::AUTO, size, 20 * defaults::BUILD_LIST_SIZE);
 
-    return OVERHEAD_FACTOR * (size_of_data + size_of_graph + size_of_locks + size_of_outer_vector);
+    return OVERHEAD_FACTOR *
+           (size_of_data + size_of_graph + size_of_locks + size_of_outer_vector + size_of_visited_sets);
 }
 
 template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> class Index : public AbstractIndex
@@ -283,6 +291,10 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
 
     void inter_insert(uint32_t n, std::vector<uint32_t> &pruned_list, InMemQueryScratch<T> *scratch);
 
+    // copies the neighbours of n as they were at one point in time, while
+    // other threads may be changing them
+    void copy_neighbours(const location_t n, std::vector<uint32_t> &neighbours);
+
     // Acquire exclusive _update_lock before calling
     void link();
 
@@ -397,7 +409,7 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     uint32_t _indexingThreads;
 
     // Query scratch data structures
-    ConcurrentQueue<InMemQueryScratch<T> *> _query_scratch;
+    ScratchPool<InMemQueryScratch<T> *> _query_scratch;
 
     // Flags for PQ based distance calculation
     bool _pq_dist = false;
@@ -430,6 +442,9 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     bool _is_saved = false;         // Checking if the index is already saved.
     bool _conc_consolidate = false; // use _lock while searching
 
+    // how query scratch tracks visited nodes, see IndexConfig
+    VisitedSetPolicy _visited_policy = VisitedSetPolicy::AUTO;
+
     // Acquire locks in the order below when acquiring multiple locks
     std::shared_timed_mutex // RW mutex between save/load (exclusive lock) and
         _update_lock;       // search/inserts/deletes/consolidate (shared lock)
@@ -440,8 +455,11 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     std::shared_timed_mutex // RW Lock on _delete_set and _data_compacted
         _delete_lock;       // variable
 
-    // Per node lock, cardinality=_max_points + _num_frozen_points
-    std::vector<non_recursive_mutex> _locks;
+    // Per node lock, cardinality=_max_points + _num_frozen_points. Writers of
+    // the neighbours of a node lock it; readers lock it too unless
+    // _lock_free_reads, in which case they only check its version.
+    std::vector<versioned_spinlock> _locks;
+    bool _lock_free_reads = false;
 
     static const float INDEX_GROWTH_FACTOR;
 };
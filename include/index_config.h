@@ -2,6 +2,7 @@
 
 #include "common_includes.h"
 #include "parameters.h"
+#include "visited_set.h"
 
 namespace diskann
 {
@@ -12,7 +13,9 @@ enum class DataStoreStrategy
 
 enum class GraphStoreStrategy
 {
-    MEMORY
+    MEMORY,
+    // one 64-byte aligned array of fixed-size rows, see InMemFixedDegreeGraphStore
+    MEMORY_FIXED_DEGREE
 };
 
 struct IndexConfig
@@ -43,18 +46,22 @@ struct IndexConfig
     // Params for searching index
     std::shared_ptr<IndexSearchParams> index_search_params;
 
+    // how each query scratch tracks the nodes a search visited
+    VisitedSetPolicy visited_set_policy;
+
   private:
     IndexConfig(DataStoreStrategy data_strategy, GraphStoreStrategy graph_strategy, Metric metric, size_t dimension,
                 size_t max_points, size_t num_pq_chunks, size_t num_frozen_points, bool dynamic_index, bool enable_tags,
                 bool pq_dist_build, bool concurrent_consolidate, bool use_opq, bool filtered_index,
                 std::string &data_type, const std::string &tag_type, const std::string &label_type,
                 std::shared_ptr<IndexWriteParameters> index_write_params,
-                std::shared_ptr<IndexSearchParams> index_search_params)
+                std::shared_ptr<IndexSearchParams> index_search_params, VisitedSetPolicy visited_set_policy)
         : data_strategy(data_strategy), graph_strategy(graph_strategy), metric(metric), dimension(dimension),
           max_points(max_points), dynamic_index(dynamic_index), enable_tags(enable_tags), pq_dist_build(pq_dist_build),
           concurrent_consolidate(concurrent_consolidate), use_opq(use_opq), filtered_index(filtered_index),
           num_pq_chunks(num_pq_chunks), num_frozen_pts(num_frozen_points), label_type(label_type), tag_type(tag_type),
-          data_type(data_type), index_write_params(index_write_params), index_search_params(index_search_params)
+          data_type(data_type), index_write_params(index_write_params), index_search_params(index_search_params),
+          visited_set_policy(visited_set_policy)
     {
     }
 
@@ -78,6 +85,12 @@ class IndexConfigBuilder
         return *this;
     }
 
+    IndexConfigBuilder &with_visited_set_policy(VisitedSetPolicy visited_set_policy)
+    {
+        this->_visited_set_policy = visited_set_policy;
+        return *this;
+    }
+
     IndexConfigBuilder &with_data_load_store_strategy(DataStoreStrategy data_strategy)
     {
         this->_data_strategy = data_strategy;
@@ -222,7 +235,7 @@ class IndexConfigBuilder
         return IndexConfig(_data_strategy, _graph_strategy, _metric, _dimension, _max_points, _num_pq_chunks,
                            _num_frozen_pts, _dynamic_index, _enable_tags, _pq_dist_build, _concurrent_consolidate,
                            _use_opq, _filtered_index, _data_type, _tag_type, _label_type, _index_write_params,
-                           _index_search_params);
+                           _index_search_params, _visited_set_policy);
     }
 
     IndexConfigBuilder(const IndexConfigBuilder &) = delete;
@@ -252,5 +265,7 @@ class IndexConfigBuilder
 
     std::shared_ptr<IndexWriteParameters> _index_write_params;
     std::shared_ptr<IndexSearchParams> _index_search_params;
+
+    VisitedSetPolicy _visited_set_policy = VisitedSetPolicy::AUTO;
 };
 } // namespace diskann
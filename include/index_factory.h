@@ -3,6 +3,7 @@
 #include "index.h"
 #include "abstract_graph_store.h"
 #include "in_mem_graph_store.h"
+#include "in_mem_fixed_degree_graph_store.h"
 #include "pq_data_store.h"
 
 namespace diskann
@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#if !defined(_WINDOWS) && defined(USE_IO_URING)
+
+#include <liburing.h>
+
+#include "aligned_file_reader.h"
+
+// AlignedFileReader backed by io_uring. Each registered thread owns one ring.
+// The ring's file descriptor is registered with the kernel at open() time and
+// sector scratch buffers can be registered through register_buffer(), so that
+// reads into them are issued as IORING_OP_READ_FIXED and skip the per-IO
+// page pinning done for regular reads. With use_sqpoll, the rings share one
+// kernel submission thread and submitting a beam does not need a syscall.
+class IoUringAlignedFileReader : public AlignedFileReader
+{
+  private:
+    struct RingContext
+    {
+        struct io_uring ring;
+        bool fixed_file = false;
+        char *fixed_buf = nullptr;
+        uint64_t fixed_buf_len = 0;
+    };
+
+    FileHandle file_desc;
+    io_context_t bad_ctx = (io_context_t)-1;
+
+    bool _use_sqpoll;
+    uint32_t _queue_depth;
+    uint32_t _sqpoll_idle_ms;
+    // fd of the first ring created with SQPOLL; later rings attach to its
+    // kernel thread instead of spawning one each
+    int _sqpoll_wq_fd = -1;
+
+    // IOContext is io_context_t on Linux; this reader stores its RingContext
+    // pointer in it so that callers can keep passing contexts around unchanged
+    static RingContext *to_ring(IOContext &ctx)
+    {
+        return reinterpret_cast<RingContext *>(ctx);
+    }
+    // to_ring() that throws on bad_ctx, which get_ctx() hands to threads
+    // without a ring, instead of dereferencing it
+    RingContext *checked_ring(IOContext &ctx);
+    void destroy_ring(RingContext *rctx);
+    // queues one read on the ring without submitting it
+    void prep_read(RingContext *rctx, const AlignedRead &req, uint64_t user_data);
+
+  public:
+    IoUringAlignedFileReader(bool use_sqpoll = false, uint32_t queue_depth = MAX_IO_DEPTH,
+                             uint32_t sqpoll_idle_ms = 2000);
+    ~IoUringAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // reads into [buf, buf + len) issued on ctx use the registered buffer
+    void register_buffer(IOContext &ctx, void *buf, uint64_t len);
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous interface: submit now, reap completions later
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reqs(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+};
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// An HDR-style histogram of latencies in microseconds. Values below 128 are
+// counted exactly, and each power of two above is split into 64 buckets, so
+// a percentile is reported to within 1/64 of its value at any magnitude, from
+// a fixed array of counts. record() may be called from many threads at once.
+class LatencyHistogram
+{
+  public:
+    DISKANN_DLLEXPORT LatencyHistogram();
+
+    DISKANN_DLLEXPORT void record(uint64_t value_us);
+
+    DISKANN_DLLEXPORT void reset();
+
+    DISKANN_DLLEXPORT uint64_t count() const;
+
+    DISKANN_DLLEXPORT uint64_t max() const;
+
+    DISKANN_DLLEXPORT double mean() const;
+
+    DISKANN_DLLEXPORT uint64_t sum() const;
+
+    // number of recorded values at or below value, to the precision of the
+    // buckets: values in the bucket of value count as below it
+    DISKANN_DLLEXPORT uint64_t count_at_or_below(uint64_t value) const;
+
+    // the value that percentile (0-100) of the recorded values are at or
+    // below, rounded up to the end of its bucket; 0 if nothing was recorded
+    DISKANN_DLLEXPORT uint64_t value_at_percentile(double percentile) const;
+
+  private:
+    static uint64_t bucket_index(uint64_t value);
+    static uint64_t bucket_highest_value(uint64_t index);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> _counts;
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _sum{0};
+    std::atomic<uint64_t> _max{0};
+};
+} // namespace diskann
@@ -34,6 +34,10 @@ class LinuxAlignedFileReader : public AlignedFileReader
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous interface: submit now, reap completions later
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reqs(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
 };
 
 #endif
@@ -2,7 +2,10 @@
 // Licensed under the MIT license.
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <thread>
 
 #ifdef _WINDOWS
 #include "windows_slim_lock.h"
@@ -17,4 +20,97 @@ using LockGuard = windows_exclusive_slim_lock_guard;
 using non_recursive_mutex = std::mutex;
 using LockGuard = std::lock_guard<non_recursive_mutex>;
 #endif
+
+// A 4-byte spinlock that doubles as a sequence lock, for data that is read
+// far more often than it is written and that stays at the same address while
+// it is written. Writers lock it as usual; the counter is odd while a writer
+// holds it and goes up by two per write. Readers that do not lock take the
+// counter with read_begin(), copy the data, and retry while read_retry()
+// says a writer got in between, so they never wait for each other.
+class versioned_spinlock
+{
+  public:
+    versioned_spinlock() = default;
+
+    // The lock is non-copyable. This also disables move constructor/operator=.
+    versioned_spinlock(const versioned_spinlock &) = delete;
+    versioned_spinlock &operator=(const versioned_spinlock &) = delete;
+
+    void lock()
+    {
+        for (uint32_t spins = 0; !try_lock(); spins++)
+        {
+            if (spins >= MAX_SPINS)
+            {
+                std::this_thread::yield();
+                spins = 0;
+            }
+        }
+    }
+
+    bool try_lock()
+    {
+        uint32_t version = _version.load(std::memory_order_relaxed);
+        if ((version & 1) || !_version.compare_exchange_weak(version, version + 1, std::memory_order_acquire,
+                                                             std::memory_order_relaxed))
+            return false;
+        // keeps the writes of the holder from becoming visible before the
+        // counter turns odd
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    void unlock()
+    {
+        _version.fetch_add(1, std::memory_order_release);
+    }
+
+    uint32_t read_begin() const
+    {
+        uint32_t version;
+        for (uint32_t spins = 0; (version = _version.load(std::memory_order_acquire)) & 1; spins++)
+        {
+            if (spins >= MAX_SPINS)
+            {
+                std::this_thread::yield();
+                spins = 0;
+            }
+        }
+        return version;
+    }
+
+    // true if what was read since read_begin() returned version may be torn
+    bool read_retry(uint32_t version) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _version.load(std::memory_order_relaxed) != version;
+    }
+
+  private:
+    static const uint32_t MAX_SPINS = 64;
+    std::atomic<uint32_t> _version{0};
+};
+using VersionedLockGuard = std::lock_guard<versioned_spinlock>;
+
+// Relaxed atomic load and store of a word that is read without a lock while a
+// writer may change it, as the data of a versioned_spinlock is. They compile
+// to plain moves; std::atomic_ref would do, but is C++20.
+inline uint32_t relaxed_load(const uint32_t *p)
+{
+#ifdef _WINDOWS
+    // aligned volatile accesses are atomic with MSVC
+    return *(const volatile uint32_t *)p;
+#else
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+#endif
+}
+
+inline void relaxed_store(uint32_t *p, uint32_t value)
+{
+#ifdef _WINDOWS
+    *(volatile uint32_t *)p = value;
+#else
+    __atomic_store_n(p, value, __ATOMIC_RELAXED);
+#endif
+}
 } // namespace diskann
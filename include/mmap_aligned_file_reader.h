@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#ifndef _WINDOWS
+
+#include <sys/mman.h>
+
+#include "aligned_file_reader.h"
+
+// AlignedFileReader over a read-only mapping of the whole file, for hosts
+// where the disk index fits in the page cache. read() copies out of the
+// mapping with no IO context round-trip, and get_mapped_data() lets
+// PQFlashIndex expand nodes in place without copying their sectors at all.
+// With populate, the whole file is faulted in at open() (MAP_POPULATE);
+// advice is passed to madvise() for the mapping, e.g. MADV_RANDOM to avoid
+// readahead on a cold page cache or MADV_WILLNEED to start reading it in.
+class MmapAlignedFileReader : public AlignedFileReader
+{
+  private:
+    // reads submitted but not yet reaped on a thread; submit_reqs completes
+    // them right away, so this only remembers their bufs
+    struct MmapContext
+    {
+        std::vector<void *> completed_bufs;
+    };
+
+    FileHandle file_desc;
+    char *_mapped_data = nullptr;
+    uint64_t _file_sz = 0;
+    io_context_t bad_ctx = (io_context_t)-1;
+
+    bool _populate;
+    int _advice;
+
+    // IOContext is io_context_t on Linux; this reader stores its MmapContext
+    // pointer in it so that callers can keep passing contexts around unchanged
+    static MmapContext *to_mmap_ctx(IOContext &ctx)
+    {
+        return reinterpret_cast<MmapContext *>(ctx);
+    }
+    void copy_reqs(std::vector<AlignedRead> &read_reqs);
+
+  public:
+    MmapAlignedFileReader(bool populate = false, int advice = MADV_RANDOM);
+    ~MmapAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    char *get_mapped_data();
+
+    // copies each request out of the mapping
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous interface: requests complete at submission
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reqs(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+};
+
+#endif
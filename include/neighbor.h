@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <mutex>
 #include <vector>
@@ -93,6 +94,51 @@ class NeighborPriorityQueue
         }
     }
 
+    // Inserts as above; returns true if the queue was full and so a
+    // Neighbor fell out of it, either nbr or the former last item, which is
+    // then copied to dropped along with its expanded state
+    bool insert(const Neighbor &nbr, Neighbor &dropped)
+    {
+        if (_size < _capacity)
+        {
+            insert(nbr);
+            return false;
+        }
+        if (_data[_size - 1] < nbr)
+        {
+            dropped = nbr;
+            return true;
+        }
+        Neighbor last = _data[_size - 1];
+        insert(nbr);
+        // unchanged if nbr was already in the queue
+        if (_data[_size - 1].id == last.id)
+            return false;
+        dropped = last;
+        return true;
+    }
+
+    // Raises the capacity to `capacity` and takes back the closest of the
+    // items that fell out of the queue while it was smaller, keeping whether
+    // they were expanded, so that a search can continue with a longer list
+    // instead of starting over. Items that still do not fit are left in
+    // dropped.
+    void grow(size_t capacity, std::vector<Neighbor> &dropped)
+    {
+        reserve(capacity);
+        std::vector<Neighbor> merged(_data.begin(), _data.begin() + _size);
+        merged.insert(merged.end(), dropped.begin(), dropped.end());
+        std::sort(merged.begin(), merged.end());
+        _size = (std::min)(merged.size(), _capacity);
+        std::copy(merged.begin(), merged.begin() + _size, _data.begin());
+        dropped.assign(merged.begin() + _size, merged.end());
+        _cur = 0;
+        while (_cur < _size && _data[_cur].expanded)
+        {
+            _cur++;
+        }
+    }
+
     Neighbor closest_unexpanded()
     {
         _data[_cur].expanded = true;
@@ -109,6 +155,24 @@ class NeighborPriorityQueue
         return _cur < _size;
     }
 
+    // distance of the Neighbor closest_unexpanded() would return, without
+    // expanding it; requires has_unexpanded_node()
+    float closest_unexpanded_distance() const
+    {
+        return _data[_cur].distance;
+    }
+
+    size_t num_unexpanded() const
+    {
+        size_t n = 0;
+        for (size_t i = _cur; i < _size; i++)
+        {
+            if (!_data[i].expanded)
+                n++;
+        }
+        return n;
+    }
+
     size_t size() const
     {
         return _size;
@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Codec for the neighbor lists of SSD indices written with packed nhoods
+// (defaults::DISK_LAYOUT_PACKED_NHOODS). A list is stored sorted, as
+//   [nnbrs (uint16)][width (uint8)][unused (uint8)][first id (uint32)][deltas]
+// where the nnbrs - 1 gaps between consecutive ids are bit-packed with
+// `width` bits each, the least number of bits that holds the largest gap.
+// The packed form is followed by 8 bytes of padding so that the decoder can
+// use unaligned word loads without reading past it.
+
+// bytes taken by the packed form of nbrs[0..nnbrs); sorts nbrs in place
+DISKANN_DLLEXPORT uint64_t packed_nhood_size(uint32_t *nbrs, uint32_t nnbrs);
+
+// writes the packed form of nbrs[0..nnbrs) to dst and returns its size in
+// bytes; sorts nbrs in place
+DISKANN_DLLEXPORT uint64_t pack_nhood(uint32_t *nbrs, uint32_t nnbrs, char *dst);
+
+// decodes the packed list at src into nbrs, which must have room for all of
+// its ids, and returns their number. Uses AVX2 where available.
+DISKANN_DLLEXPORT uint32_t unpack_nhood(const char *src, uint32_t *nbrs);
+} // namespace diskann
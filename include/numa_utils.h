@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "windows_customizations.h"
+
+#ifndef _WINDOWS
+#include <sched.h>
+#endif
+
+namespace diskann
+{
+// NUMA topology and thread placement, read from /sys/devices/system/node
+// on Linux so that no NUMA library is needed. Memory is placed by first
+// touch: a buffer written by a thread bound to a node lands on that node.
+// Elsewhere, or if the topology can not be read, the machine is a single
+// node and binding is a no-op.
+//
+// Nodes are numbered densely from 0 in order of their kernel ids, skipping
+// nodes without CPUs.
+namespace numa
+{
+DISKANN_DLLEXPORT uint32_t num_nodes();
+
+// node of the CPU the calling thread is running on
+DISKANN_DLLEXPORT uint32_t current_node();
+
+// restricts the calling thread to the CPUs of node; returns false on failure
+DISKANN_DLLEXPORT bool bind_thread_to_node(uint32_t node);
+
+// total and free memory of node in bytes, both 0 if unknown
+DISKANN_DLLEXPORT void get_node_memory(uint32_t node, uint64_t &total_bytes, uint64_t &free_bytes);
+
+// binds the calling thread to a node for its lifetime and then restores
+// the CPUs the thread was allowed to run on before
+class ScopedNodeBinding
+{
+  public:
+    DISKANN_DLLEXPORT ScopedNodeBinding(uint32_t node);
+    DISKANN_DLLEXPORT ~ScopedNodeBinding();
+
+  private:
+#ifndef _WINDOWS
+    cpu_set_t _prev_mask;
+    bool _restore = false;
+#endif
+    ScopedNodeBinding(const ScopedNodeBinding &) = delete;
+    ScopedNodeBinding &operator=(const ScopedNodeBinding &) = delete;
+};
+} // namespace numa
+} // namespace diskann
@@ -18,6 +18,16 @@
 
 namespace diskann
 {
+// one hop of a traced search: the expansion of a beam of nodes
+struct HopTrace
+{
+    uint32_t frontier_size = 0;    // # nodes expanded in the hop
+    uint32_t n_ios = 0;            // # reads issued in the hop
+    float io_us = 0;               // time spent waiting for the reads
+    float cpu_us = 0;              // time spent computing distances
+    uint32_t n_retset_inserts = 0; // # candidates that made it into the search list
+};
+
 struct QueryStats
 {
     float total_us = 0; // total time to process query in micros
@@ -33,6 +43,19 @@ struct QueryStats
     unsigned n_cmps = 0;       // # cmps
     unsigned n_cache_hits = 0; // # cache_hits
     unsigned n_hops = 0;       // # search hops
+    unsigned n_hops_saved = 0; // # hops estimated to be left when early termination stopped the search
+    unsigned n_shared_ios = 0; // # reads served by a sector read for another query of a batch
+
+    unsigned n_sector_cache_hits = 0;      // # node reads served by the dynamic sector cache
+    unsigned n_sector_cache_misses = 0;    // # node reads that missed the dynamic sector cache
+    unsigned n_sector_cache_evictions = 0; // # sectors evicted to admit this query's reads
+
+    unsigned n_prefetch_ios = 0;        // # speculative reads of candidates outside the beam
+    unsigned n_prefetch_hits = 0;       // # of them that a later beam expanded instead of reading
+    unsigned prefetch_wasted_bytes = 0; // bytes of speculative reads never expanded
+
+    // if set, cached_beam_search appends a HopTrace per hop to it
+    std::vector<HopTrace> *hop_trace = nullptr;
 };
 
 template <typename T>
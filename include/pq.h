@@ -10,9 +10,10 @@ namespace diskann
 {
 class FixedChunkPQTable
 {
-    float *tables = nullptr; // pq_tables = float array of size [256 * ndims]
+    float *tables = nullptr; // pq_tables = float array of size [num_centers * ndims]
     uint64_t ndims = 0;      // ndims = true dimension of vectors
     uint64_t n_chunks = 0;
+    uint64_t num_centers = NUM_PQ_CENTROIDS; // 256, or 16 for 4-bit PQ
     bool use_rotation = false;
     uint32_t *chunk_offsets = nullptr;
     float *centroid = nullptr;
@@ -32,9 +33,11 @@ class FixedChunkPQTable
 
     uint32_t get_num_chunks();
 
+    uint32_t get_num_centers();
+
     void preprocess_query(float *query_vec);
 
-    // assumes pre-processed query
+    // assumes pre-processed query; dist_vec is [num_centers * n_chunks]
     void populate_chunk_distances(const float *query_vec, float *dist_vec);
 
     float l2_distance(const float *query_vec, uint8_t *base_vec);
@@ -59,6 +62,26 @@ void aggregate_coords(const unsigned *ids, const uint64_t n_ids, const uint8_t *
 void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_nchunks, const float *pq_dists,
                     float *dists_out);
 
+// 4-bit PQ fast-scan. Codes are stored two chunks per byte, chunk 2i in the
+// low nibble. To score a list of points, their codes are transposed into
+// blocks of PQ_FAST_SCAN_BLOCK points: per chunk, 16 bytes holding the codes
+// of points 0-15 of the block in the low nibbles and of points 16-31 in the
+// high nibbles, with the number of chunks rounded up to even. The float
+// distance table is quantized to uint8 once per query, so that a pair of
+// chunks of a whole block is looked up with one pshufb per nibble.
+
+// out is [ROUND_UP(n_ids, PQ_FAST_SCAN_BLOCK) * ROUND_UP(pq_nchunks, 2) / 2]
+void aggregate_coords_fast_scan(const uint32_t *ids, const uint64_t n_ids, const uint8_t *all_coords,
+                                const uint64_t pq_nchunks, uint8_t *out);
+
+// pq_dists is [16 * pq_nchunks], lut_out is [16 * ROUND_UP(pq_nchunks, 2)];
+// the distance of a point is then bias + (sum of its lut entries) / scale
+void quantize_fast_scan_lut(const float *pq_dists, const size_t pq_nchunks, uint8_t *lut_out, float &scale,
+                            float &bias);
+
+void pq_fast_scan_lookup(const uint8_t *block_codes, const size_t n_pts, const size_t pq_nchunks, const uint8_t *lut,
+                         const float scale, const float bias, float *dists_out);
+
 DISKANN_DLLEXPORT int generate_pq_pivots(const float *const train_data, size_t num_train, unsigned dim,
                                          unsigned num_centers, unsigned num_pq_chunks, unsigned max_k_means_reps,
                                          std::string pq_pivots_path, bool make_zero_mean = false);
@@ -89,5 +112,6 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, const diskann::Metric compareMetric,
                              const double p_val, const uint64_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix = "");
+                             const std::string &codebook_prefix = "",
+                             const uint32_t num_pq_centers = NUM_PQ_CENTROIDS);
 } // namespace diskann
@@ -5,6 +5,10 @@
 
 #define NUM_PQ_BITS 8
 #define NUM_PQ_CENTROIDS (1 << NUM_PQ_BITS)
+// 4-bit PQ, scored with the fast-scan kernels in pq.h
+#define NUM_PQ_BITS_4BIT 4
+#define NUM_PQ_CENTROIDS_4BIT (1 << NUM_PQ_BITS_4BIT)
+#define PQ_FAST_SCAN_BLOCK 32
 #define MAX_OPQ_ITERS 20
 #define NUM_KMEANS_REPS_PQ 12
 #define MAX_PQ_TRAINING_SET_SIZE 256000
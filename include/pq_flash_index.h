@@ -3,9 +3,15 @@
 
 #pragma once
 #include "common_includes.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
 
 #include "aligned_file_reader.h"
 #include "concurrent_queue.h"
+#include "scratch_pool.h"
+#include "early_termination.h"
 #include "neighbor.h"
 #include "parameters.h"
 #include "percentile_stats.h"
@@ -13,6 +19,9 @@
 #include "utils.h"
 #include "windows_customizations.h"
 #include "scratch.h"
+#include "sector_cache.h"
+#include "tombstone_bitmap.h"
+#include "timer.h"
 #include "tsl/robin_map.h"
 #include "tsl/robin_set.h"
 
@@ -21,6 +30,14 @@
 namespace diskann
 {
 
+// receives the results of a range search one at a time, as (id, distance);
+// returning false ends the search
+typedef std::function<bool(uint64_t, float)> RangeSearchCallback;
+
+// receives the k_search results of an async search, sorted by distance, and
+// its stats; the buffers are only valid during the call
+typedef std::function<void(const uint64_t *, const float *, const QueryStats &)> AsyncSearchCallback;
+
 template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 {
   public:
@@ -46,6 +63,20 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
 
     DISKANN_DLLEXPORT void load_cache_list(std::vector<uint32_t> &node_list);
 
+#ifndef EXEC_ENV_OLS
+    // persists node_list as a warmup artifact, by convention
+    // <index_prefix>_cache.bin, so later processes can skip generating it.
+    // With pack_nodes the contents of the nodes are stored too, and loading
+    // is a single sequential read of the file instead of random index reads.
+    DISKANN_DLLEXPORT void save_cache_list(const std::string &cache_file, const std::vector<uint32_t> &node_list,
+                                           bool pack_nodes = true);
+
+    // fills the node cache from a file written by save_cache_list. Returns
+    // false, leaving the cache empty, if the file is missing, of another
+    // version, or was made for a different index file.
+    DISKANN_DLLEXPORT bool load_cache_list(const std::string &cache_file);
+#endif
+
 #ifdef EXEC_ENV_OLS
     DISKANN_DLLEXPORT void generate_cache_list_from_sample_queries(MemoryMappedFiles &files, std::string sample_bin,
                                                                    uint64_t l_search, uint64_t beamwidth,
@@ -81,13 +112,80 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                               const uint32_t io_limit, const bool use_reorder_data = false,
                                               QueryStats *stats = nullptr);
 
+    // Searches num_queries queries (stored query_aligned_dim apart) on the
+    // calling thread in lock-step hops. Within a hop, a sector needed by
+    // several queries is read once and shared by all of them. Results and
+    // stats are laid out per query as in cached_beam_search. The overload
+    // with a filter and use_reorder_data searches the queries one at a time
+    // with cached_beam_search when either is set, since the lock-step hops
+    // support neither.
+    //
+    // Every query of a batch has a scratch of its own, kept by the thread
+    // context until the index is unloaded: about 1.5MB of sector and PQ
+    // buffers, plus its visited set, whose total for a batch stays within
+    // the budgets of the visited set of one query (see reserve_batch_scratch).
+    // Batches are searched in parts small enough for the scratch of a part to
+    // fit in defaults::MAX_BATCH_SCRATCH_BYTES.
+    DISKANN_DLLEXPORT void batch_cached_beam_search(const T *queries, const uint64_t num_queries,
+                                                    const uint64_t query_aligned_dim, const uint64_t k_search,
+                                                    const uint64_t l_search, uint64_t *res_ids, float *res_dists,
+                                                    const uint64_t beam_width,
+                                                    const uint32_t io_limit = std::numeric_limits<uint32_t>::max(),
+                                                    QueryStats *stats = nullptr);
+
+    DISKANN_DLLEXPORT void batch_cached_beam_search(const T *queries, const uint64_t num_queries,
+                                                    const uint64_t query_aligned_dim, const uint64_t k_search,
+                                                    const uint64_t l_search, uint64_t *res_ids, float *res_dists,
+                                                    const uint64_t beam_width, const bool use_filter,
+                                                    const LabelT &filter_label, const bool use_reorder_data,
+                                                    const uint32_t io_limit = std::numeric_limits<uint32_t>::max(),
+                                                    QueryStats *stats = nullptr);
+
+    // Starts num_workers threads that search the queries of async_search().
+    // Each worker keeps up to queue_depth queries in flight: when a query
+    // has issued the reads of its beam, the worker moves on to another one
+    // and resumes it once all of them have completed, so a few workers keep
+    // the drive as busy as many threads of cached_beam_search. Workers hold
+    // a thread context of load() each until stop_async_search(), so there
+    // may be no more of them than threads passed to load(). Each query in
+    // flight has a scratch of its own, as in batch_cached_beam_search, which
+    // the thread context keeps until the index is unloaded: about 1.5MB times
+    // queue_depth per worker, with the visited sets of all of them within the
+    // budget of one.
+    DISKANN_DLLEXPORT void start_async_search(const uint32_t num_workers, const uint32_t queue_depth);
+
+    // Queues a search for query, which is copied, and returns at once.
+    // on_done is called on the worker that ran it once it is done; it must
+    // not throw. queue_depth * beam_width may not exceed MAX_IO_DEPTH.
+    // Filters, reorder data, pipelined search and prefetch do not apply, and
+    // total_us of the stats starts when a worker takes the query.
+    DISKANN_DLLEXPORT void async_search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                        const uint64_t beam_width, AsyncSearchCallback on_done,
+                                        const uint32_t io_limit = std::numeric_limits<uint32_t>::max());
+
+    // waits until all queued queries are done and stops the workers
+    DISKANN_DLLEXPORT void stop_async_search();
+
     DISKANN_DLLEXPORT LabelT get_converted_label(const std::string &filter_label);
 
+    // Finds the points within distance range of the query: searches with a
+    // list of min_l_search candidates and, as long as at least half of the
+    // list is in range, doubles it up to max_l_search. The list grows in place
+    // and the search carries on from where it stopped, so no sector is read
+    // twice. Results are sorted by distance; returns their number.
     DISKANN_DLLEXPORT uint32_t range_search(const T *query1, const double range, const uint64_t min_l_search,
                                             const uint64_t max_l_search, std::vector<uint64_t> &indices,
                                             std::vector<float> &distances, const uint64_t min_beam_width,
                                             QueryStats *stats = nullptr);
 
+    // As above, but streams each result to callback as soon as the node is
+    // expanded, in no particular order, instead of collecting them; with a
+    // decoupled layout, results come once reranked at the end. The search
+    // ends early if callback returns false.
+    DISKANN_DLLEXPORT uint32_t range_search(const T *query1, const double range, const uint64_t min_l_search,
+                                            const uint64_t max_l_search, const RangeSearchCallback &callback,
+                                            const uint64_t min_beam_width, QueryStats *stats = nullptr);
+
     DISKANN_DLLEXPORT uint64_t get_data_dim();
 
     std::shared_ptr<AlignedFileReader> &reader;
@@ -108,6 +206,83 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     DISKANN_DLLEXPORT std::vector<std::uint8_t> get_pq_vector(std::uint64_t vid);
     DISKANN_DLLEXPORT uint64_t get_num_points();
 
+    // hides the point id from search results from now on, without changing
+    // the index file. Searches still route through deleted nodes, so that the
+    // graph stays connected, and scale l_search by the inverse of the share
+    // of live points, up to defaults::MAX_TOMBSTONE_L_SCALE times, so that
+    // about as many live candidates are ranked as before. Call after load();
+    // safe to call while searches run. Returns false if id is out of range or
+    // already deleted.
+    DISKANN_DLLEXPORT bool lazy_delete(uint32_t id);
+
+    DISKANN_DLLEXPORT uint64_t get_num_deleted() const;
+
+    // the points deleted with lazy_delete(), in increasing order
+    DISKANN_DLLEXPORT std::vector<uint32_t> get_deleted_ids() const;
+
+    // bytes of the bitmap of deleted points, one bit per point
+    DISKANN_DLLEXPORT uint64_t get_tombstone_memory() const;
+
+#ifndef EXEC_ENV_OLS
+    // persists the deleted points, by convention to
+    // <index_prefix>_tombstones.bin
+    DISKANN_DLLEXPORT void save_tombstones(const std::string &tombstone_file);
+
+    // restores the deleted points saved for this index file. Returns false,
+    // leaving the deletes as they are, if the file is missing or was saved
+    // for a different index file.
+    DISKANN_DLLEXPORT bool load_tombstones(const std::string &tombstone_file);
+#endif
+
+    // Linux only: keep beam_width reads in flight during cached_beam_search
+    // and refill as each completes, instead of reading the beam in lock-step
+    DISKANN_DLLEXPORT void set_pipelined_search(bool enable);
+
+    // Linux only: while the nodes of a hop are expanded, read the sectors of
+    // up to num_nodes of the closest unexpanded candidates outside the beam
+    // into a per-query staging area, so that the next beam finds them there
+    // instead of waiting for the drive. Trades read bandwidth for latency;
+    // see the prefetch counters of QueryStats. 0 disables it. Has no effect
+    // with pipelined search or a memory-mapped index.
+    DISKANN_DLLEXPORT void set_speculative_prefetch(uint32_t num_nodes);
+
+    // Linux only: cache up to budget_bytes of the sectors read by searches,
+    // alongside the static cache from load_cache_list(). 0 disables it.
+    // Ignored when the reader maps the index into memory.
+    DISKANN_DLLEXPORT void enable_sector_cache(uint64_t budget_bytes);
+
+    // stop searches before the candidate list runs out of unexpanded nodes,
+    // per the rules of EarlyTermination; 0 disables a rule. The hops saved
+    // are reported in QueryStats::n_hops_saved.
+    DISKANN_DLLEXPORT void set_early_termination(uint32_t patience_hops, float converge_ratio);
+
+    // back the in-memory compressed vectors and the node cache with
+    // (transparent) huge pages; call before load()
+    DISKANN_DLLEXPORT void set_huge_pages(bool enable);
+
+    // seconds spent in each phase of the last load(), followed by
+    // load_cache_list() if it was called; their sum is the time to first query
+    DISKANN_DLLEXPORT const std::vector<std::pair<std::string, float>> &get_load_phase_times() const;
+
+    // spread the thread contexts over the NUMA nodes, with their scratch
+    // allocated on their node, and have each search use a context of the
+    // node it runs on. The PQ compressed vectors and the node cache are
+    // placed on node 0, or with replicate copied to every node. Bind the
+    // search threads to nodes, e.g. with numa::bind_thread_to_node(), so
+    // that they stay next to their copies. Call before load().
+    DISKANN_DLLEXPORT void set_numa_mode(bool enable, bool replicate);
+
+    // bytes of PQ compressed vectors and node cache on each NUMA node;
+    // empty unless NUMA mode is on
+    DISKANN_DLLEXPORT std::vector<uint64_t> get_numa_memory_usage() const;
+
+    // how searches track the nodes they visited, see visited_set.h. AUTO
+    // uses an epoch array per thread context when the index is small enough
+    // for defaults::MAX_VISITED_ARRAY_BYTES, a bitset up to
+    // defaults::MAX_VISITED_BITSET_POINTS, and a hash set otherwise. Call
+    // before load().
+    DISKANN_DLLEXPORT void set_visited_set_policy(VisitedSetPolicy policy);
+
   protected:
     DISKANN_DLLEXPORT void use_medoids_data_as_centroids();
     DISKANN_DLLEXPORT void setup_thread_data(uint64_t nthreads, uint64_t visited_reserve = 4096);
@@ -124,18 +299,135 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                                   const uint32_t nthreads);
     void reset_stream_for_reading(std::basic_istream<char> &infile);
 
+    // copies (and normalizes, for cosine/mips) query into the scratch and
+    // prepares its PQ distance table; returns the query norm
+    DISKANN_DLLEXPORT float preprocess_query(const T *query, SSDQueryScratch<T> *query_scratch);
+
+    // appends the time since timer was last reset to _load_phase_times
+    void record_load_phase(const std::string &phase, Timer &timer);
+
+    // helpers of load_cache_list: read_cache_nodes reads the nodes of
+    // node_list into buffers laid out like _coord_cache_buf and
+    // _nhood_cache_buf, fill_cache_maps indexes those buffers
+    void alloc_cache_bufs(size_t num_cached_nodes);
+    void read_cache_nodes(const std::vector<uint32_t> &node_list, T *coord_buf, uint32_t *nhood_buf,
+                          std::vector<uint32_t> &nhood_sizes, std::vector<bool> &read_status);
+    void fill_cache_maps(const std::vector<uint32_t> &node_list, const std::vector<uint32_t> &nhood_sizes,
+                         const std::vector<bool> &read_status);
+
+    // hash of the header and a sample of the sectors of the disk index, the
+    // sizes of the index files, the PQ pivots and the PQ codes of the sampled
+    // nodes, which ties a cache or tombstone file to the index it was saved
+    // from
+    uint64_t get_index_checksum();
+
+    // frees the thread contexts of setup_thread_data() and deregisters their
+    // threads from the reader
+    void destroy_thread_data();
+
+    // NUMA mode: the scratch pool of the node the caller runs on, or of
+    // another node if that one has no free context, and the copies of the PQ
+    // vectors and node cache of a node
+    ScratchPool<SSDThreadData<T> *> &thread_data_pool();
+    const uint8_t *local_pq_data(uint32_t numa_node) const;
+    const tsl::robin_map<uint32_t, std::pair<uint32_t, uint32_t *>> &local_nhood_cache(uint32_t numa_node) const;
+    const tsl::robin_map<uint32_t, T *> &local_coord_cache(uint32_t numa_node) const;
+    void place_pq_data_on_numa_nodes();
+    void place_node_cache_on_numa_nodes();
+
+    inline bool is_deleted(uint32_t id) const
+    {
+        return _tombstones.count() > 0 && _tombstones.test(id);
+    }
+
+    // l_search scaled up for the deleted points, see lazy_delete()
+    uint64_t tombstone_l_search(const uint64_t l_search) const;
+
+    // closest medoid to the preprocessed query, for unfiltered search
+    DISKANN_DLLEXPORT uint32_t get_best_medoid(const float *query_float);
+
+    // copies the first k_search entries of the sorted full_retset out,
+    // mapping dummy points and undoing the mips transform
+    DISKANN_DLLEXPORT void copy_results(const std::vector<Neighbor> &full_retset, const uint64_t k_search,
+                                        uint64_t *res_ids, float *res_dists, const float query_norm);
+
+    // the id and distance copy_results() reports for a search result
+    DISKANN_DLLEXPORT uint64_t result_id(const uint32_t id);
+    DISKANN_DLLEXPORT float result_distance(const float distance, const float query_norm);
+
+    // a query queued by async_search()
+    struct AsyncSearchRequest
+    {
+        std::vector<T> query;
+        uint64_t k_search = 0;
+        uint64_t l_search = 0;
+        uint64_t beam_width = 0;
+        uint32_t io_limit = 0;
+        AsyncSearchCallback on_done;
+    };
+
+    // body of the threads of start_async_search(); in NUMA mode, worker w
+    // runs on node w % #nodes, as setup_thread_data() spreads the contexts
+    void async_search_worker(uint32_t worker);
+
+    // grows the per-query scratch of data for batched or async search to
+    // count queries, and sets how they track visited nodes: unless the
+    // policy was set to something else, AUTO is resolved against the points
+    // of all count queries, so that they take no more memory for it than one
+    // query would at count times the index size
+    void reserve_batch_scratch(SSDThreadData<T> *data, uint64_t count);
+
+    // an incremental range search in progress, see range_search()
+    struct RangeSearchState
+    {
+        float range = 0;
+        uint64_t max_l_search = 0;
+        uint64_t min_beam_width = 0;
+        const RangeSearchCallback *callback = nullptr;
+        // candidates that fell out of retset, taken back when it grows
+        std::vector<Neighbor> dropped;
+        // full_retset entries already checked against range
+        uint64_t num_checked = 0;
+        uint32_t num_results = 0;
+    };
+
+    // beam width range_search() uses with a list of l_search candidates
+    DISKANN_DLLEXPORT uint64_t range_search_beam_width(const uint64_t l_search, const uint64_t min_beam_width);
+
+    // cached_beam_search(); with range_state, runs an incremental range
+    // search instead, and passes results to its callback rather than res_ids
+    DISKANN_DLLEXPORT void cached_beam_search_impl(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                                   uint64_t *res_ids, float *res_dists, uint64_t beam_width,
+                                                   const bool use_filter, const LabelT &filter_label,
+                                                   const uint32_t io_limit, const bool use_reorder_data,
+                                                   QueryStats *stats, RangeSearchState *range_state);
+
     // sector # on disk where node_id is present with in the graph part
     DISKANN_DLLEXPORT uint64_t get_node_sector(uint64_t node_id);
 
     // ptr to start of the node
     DISKANN_DLLEXPORT char *offset_to_node(char *sector_buf, uint64_t node_id);
 
-    // returns region of `node_buf` containing [NNBRS][NBR_ID(uint32_t)]
-    DISKANN_DLLEXPORT uint32_t *offset_to_node_nhood(char *node_buf);
+    // returns region of `node_buf` containing [NNBRS][NBR_ID(uint32_t)]; with
+    // packed nhoods, the list is decoded into `nhood_buf` [_max_degree + 1]
+    DISKANN_DLLEXPORT uint32_t *offset_to_node_nhood(char *node_buf, uint32_t *nhood_buf);
 
     // returns region of `node_buf` containing [COORD(T)]
     DISKANN_DLLEXPORT T *offset_to_node_coords(char *node_buf);
 
+    // sector # where the full precision vector of node_id is present in the
+    // vector region (reorder data, or the vectors of a decoupled layout)
+    DISKANN_DLLEXPORT uint64_t get_vector_sector(uint64_t node_id);
+
+    // ptr to the full precision vector of node_id in its sector(s)
+    DISKANN_DLLEXPORT char *offset_to_vector(char *sector_buf, uint64_t node_id);
+
+    // re-ranks the closest candidates of the sorted full_retset by full
+    // precision distance, reading their vectors from the vector region in
+    // batches, and truncates full_retset to them
+    DISKANN_DLLEXPORT void rerank_full_precision(SSDQueryScratch<T> *query_scratch, IOContext &ctx,
+                                                 const uint64_t num_rerank, QueryStats *stats);
+
     // index info for multi-node sectors
     // nhood of node `i` is in sector: [i / nnodes_per_sector]
     // offset in sector: [(i % nnodes_per_sector) * max_node_len]
@@ -148,15 +440,33 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // coords start at ofsset
     // #nbrs of node `i`: *(unsigned*) (offset + disk_bytes_per_point)
     // nbrs of node `i` : (unsigned*) (offset + disk_bytes_per_point + 1)
+    //
+    // with a locality-aware layout, `i` above is the position _node_pos[i] of
+    // node i on disk instead of i itself
+    //
+    // with packed nhoods, the nbrs are stored as in nhood_codec.h from
+    // (offset + disk_bytes_per_point) and _max_degree is read from the header
+    //
+    // with a decoupled layout, disk_bytes_per_point is 0: nodes hold only the
+    // nbrs and the coords are in the vector region after the graph
 
     uint64_t _max_node_len = 0;
     uint64_t _nnodes_per_sector = 0; // 0 for multi-sector nodes, >0 for multi-node sectors
     uint64_t _max_degree = 0;
 
-    // Data used for searching with re-order vectors
+    // position of each node on disk, nullptr for id order layouts
+    std::unique_ptr<uint32_t[]> _node_pos;
+    // expand neighbors stored in an already read sector along with the node
+    bool _use_coresident_nbrs = false;
+    bool _packed_nhoods = false;
+
+    // Data used for searching with re-order vectors, or with the vector
+    // region of a decoupled layout
     uint64_t _ndims_reorder_vecs = 0;
     uint64_t _reorder_data_start_sector = 0;
-    uint64_t _nvecs_per_sector = 0;
+    uint64_t _nvecs_per_sector = 0; // 0 if a vector spans several sectors
+    uint64_t _vector_len = 0;       // bytes per vector in the vector region
+    bool _decoupled_vectors = false;
 
     diskann::Metric metric = diskann::Metric::L2;
 
@@ -173,15 +483,21 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     uint64_t _disk_bytes_per_point = 0; // Number of bytes
 
     std::string _disk_index_file;
+    std::string _pq_pivots_file;
+    std::string _pq_compressed_file;
     std::vector<std::pair<uint32_t, uint32_t>> _node_visit_counter;
 
     // PQ data
     // _n_chunks = # of chunks ndims is split into
-    // data: char * _n_chunks
+    // data: char * _pq_code_len
     // chunk_size = chunk size of each dimension chunk
     // pq_tables = float* [[2^8 * [chunk_size]] * _n_chunks]
+    // with 4-bit PQ (16 centers in the pivots file) two chunks are packed per
+    // byte of data and scored with the fast-scan kernels
     uint8_t *data = nullptr;
     uint64_t _n_chunks;
+    uint64_t _pq_code_len = 0;
+    bool _use_pq_fast_scan = false;
     FixedChunkPQTable _pq_table;
 
     // distance comparator
@@ -212,12 +528,53 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // coord_cache; The T* in coord_cache are offsets into coord_cache_buf
     T *_coord_cache_buf = nullptr;
     tsl::robin_map<uint32_t, T *> _coord_cache;
+    size_t _num_cached_nodes = 0;
+
+    // NUMA mode: one scratch pool per node, and the copies of data and the
+    // node cache on nodes other than 0, which uses the ones above
+    struct NumaReplica
+    {
+        uint8_t *pq_data = nullptr;
+        uint32_t *nhood_cache_buf = nullptr;
+        T *coord_cache_buf = nullptr;
+        tsl::robin_map<uint32_t, std::pair<uint32_t, uint32_t *>> nhood_cache;
+        tsl::robin_map<uint32_t, T *> coord_cache;
+    };
+    bool _numa_aware = false;
+    bool _numa_replicate = false;
+    std::vector<std::unique_ptr<ScratchPool<SSDThreadData<T> *>>> _numa_thread_data;
+    std::vector<NumaReplica> _numa_replicas;
 
     // thread-specific scratch
-    ConcurrentQueue<SSDThreadData<T> *> _thread_data;
+    ScratchPool<SSDThreadData<T> *> _thread_data;
     uint64_t _max_nthreads;
     bool _load_flag = false;
     bool _count_visited_nodes = false;
+    bool _use_pipelined_search = false;
+    uint32_t _prefetch_nodes = 0;
+    bool _use_huge_pages = false;
+    VisitedSetPolicy _visited_policy = VisitedSetPolicy::AUTO;
+    std::vector<std::pair<std::string, float>> _load_phase_times;
+    uint32_t _early_stop_patience = 0;
+    float _early_stop_ratio = 0;
+
+    // dynamic cache of sectors read by searches, nullptr unless enabled
+    std::unique_ptr<SectorCache> _sector_cache;
+
+    // points deleted with lazy_delete(), sized at load
+    TombstoneBitmap _tombstones;
+
+    // async_search() workers and the queries waiting for them
+    std::vector<std::thread> _async_workers;
+    std::deque<AsyncSearchRequest> _async_queue;
+    std::mutex _async_mutex;
+    std::condition_variable _async_cv;
+    uint32_t _async_queue_depth = 0;
+    bool _async_stopping = false;
+
+    // the index file, if the reader maps it into memory; nodes are then
+    // expanded in place instead of being read into the sector scratch
+    char *_mapped_index = nullptr;
     bool _reorder_data_exists = false;
     uint64_t _reoreder_data_offset = 0;
 
@@ -12,6 +12,9 @@ template <typename T> class PQScratch
     float *aligned_pqtable_dist_scratch = nullptr; // MUST BE AT LEAST [256 * NCHUNKS]
     float *aligned_dist_scratch = nullptr;         // MUST BE AT LEAST diskann MAX_DEGREE
     uint8_t *aligned_pq_coord_scratch = nullptr;   // AT LEAST  [N_CHUNKS * MAX_DEGREE]
+    uint8_t *aligned_pq_lut_scratch = nullptr;     // [16 * MAX_PQ_CHUNKS], quantized table for 4-bit PQ
+    float pq_lut_scale = 1.0f;
+    float pq_lut_bias = 0.0f;
     float *rotated_query = nullptr;
     float *aligned_query_float = nullptr;
 
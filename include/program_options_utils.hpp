@@ -77,5 +77,12 @@ const char *UNIVERSAL_LABEL =
     "in the labels file instead of listing all labels for a node.  DiskANN will not automatically assign a "
     "universal label to a node.";
 const char *FILTERED_LBUILD = "Build complexity for filtered points, higher value results in better graphs";
+const char *GRAPH_STORE = "How the in-memory graph is kept, one of {vector, fixed_degree}: a vector of neighbours per "
+                          "point, or one aligned array with a row of max degree + 1 slots per point, padded to a "
+                          "multiple of 64 bytes.  Default value: vector";
+const char *VISITED_SET = "How searches track visited nodes {auto, array, bitset, hash}. array keeps a 2-byte stamp "
+                          "per point per thread, bitset a bit per point that is zeroed after every query, hash a "
+                          "hash set; auto uses the array for indices of up to 8M points and the bitset up to 10M.  "
+                          "Default value: auto";
 
 } // namespace program_options_utils
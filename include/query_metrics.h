@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "percentile_stats.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// While in scope, searches of in-memory indices on the thread that created it
+// append a HopTrace per expanded node to trace; the in-memory search has no
+// QueryStats to carry it. Scopes nest, and the innermost one gets the hops.
+class HopTraceScope
+{
+  public:
+    DISKANN_DLLEXPORT explicit HopTraceScope(std::vector<HopTrace> &trace);
+    DISKANN_DLLEXPORT ~HopTraceScope();
+
+    // the trace of the innermost scope of the calling thread, or nullptr
+    DISKANN_DLLEXPORT static std::vector<HopTrace> *current();
+
+  private:
+    std::vector<HopTrace> *_previous;
+};
+
+// Aggregates the QueryStats of any number of searches into histograms and
+// counters, without locks, so that searches on all threads can record into
+// one instance while another thread exports it. Unlike the helpers above, it
+// keeps no per-query copy, and percentiles are read off the histograms.
+class QueryMetrics
+{
+  public:
+    // folds in stats, and the hops of stats.hop_trace if it is set
+    DISKANN_DLLEXPORT void record(const QueryStats &stats);
+
+    DISKANN_DLLEXPORT void reset();
+
+    DISKANN_DLLEXPORT uint64_t num_queries() const;
+
+    // total_us of the recorded queries
+    DISKANN_DLLEXPORT const LatencyHistogram &latency() const;
+
+    // the metrics in the Prometheus text exposition format, each named
+    // <prefix>_<metric>, with times in seconds
+    DISKANN_DLLEXPORT std::string to_prometheus(const std::string &prefix = "diskann_search") const;
+
+  private:
+    LatencyHistogram _total_us;
+    LatencyHistogram _io_us;
+    LatencyHistogram _cpu_us;
+    LatencyHistogram _hop_io_us;
+
+    std::atomic<uint64_t> _n_ios{0};
+    std::atomic<uint64_t> _n_hops{0};
+    std::atomic<uint64_t> _n_cmps{0};
+    std::atomic<uint64_t> _n_cache_hits{0};
+    std::atomic<uint64_t> _n_sector_cache_hits{0};
+    std::atomic<uint64_t> _n_sector_cache_misses{0};
+};
+} // namespace diskann
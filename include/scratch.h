@@ -16,6 +16,8 @@
 #include "neighbor.h"
 #include "defaults.h"
 #include "concurrent_queue.h"
+#include "scratch_pool.h"
+#include "visited_set.h"
 
 namespace diskann
 {
@@ -65,13 +67,9 @@ template <typename T> class InMemQueryScratch : public AbstractScratch<T>
     {
         return _occlude_factor;
     }
-    inline tsl::robin_set<uint32_t> &inserted_into_pool_rs()
+    inline VisitedSet &inserted_into_pool()
     {
-        return _inserted_into_pool_rs;
-    }
-    inline boost::dynamic_bitset<> &inserted_into_pool_bs()
-    {
-        return *_inserted_into_pool_bs;
+        return _inserted_into_pool;
     }
     inline std::vector<uint32_t> &id_scratch()
     {
@@ -113,13 +111,8 @@ template <typename T> class InMemQueryScratch : public AbstractScratch<T>
     // _occlude_factor is initialized to maxc size
     std::vector<float> _occlude_factor;
 
-    // Capacity initialized to 20L
-    tsl::robin_set<uint32_t> _inserted_into_pool_rs;
-
-    // Use a pointer here to allow for forward declaration of dynamic_bitset
-    // in public headers to avoid making boost a dependency for clients
-    // of DiskANN.
-    boost::dynamic_bitset<> *_inserted_into_pool_bs;
+    // Epoch array sized to the index, or a hash set of capacity 20L
+    VisitedSet _inserted_into_pool;
 
     // _id_scratch.size() must be > R*GRAPH_SLACK_FACTOR for iterate_to_fp
     std::vector<uint32_t> _id_scratch;
@@ -146,13 +139,25 @@ template <typename T> class SSDQueryScratch : public AbstractScratch<T>
     char *sector_scratch = nullptr; // MUST BE AT LEAST [MAX_N_SECTOR_READS * SECTOR_LEN]
     size_t sector_idx = 0;          // index of next [SECTOR_LEN] scratch to use
 
-    tsl::robin_set<size_t> visited;
+    char *prefetch_scratch = nullptr; // [MAX_N_PREFETCH_SECTORS * SECTOR_LEN], staging for speculative reads
+
+    uint32_t *nhood_scratch = nullptr; // [MAX_GRAPH_DEGREE + 1], for decoding packed neighbor lists
+
+    VisitedSet visited;
     NeighborPriorityQueue retset;
     std::vector<Neighbor> full_retset;
 
-    SSDQueryScratch(size_t aligned_dim, size_t visited_reserve);
+    // visited tracks the ids of an index of num_points points the way
+    // visited_policy selects, with a hash set of capacity visited_reserve
+    SSDQueryScratch(size_t aligned_dim, size_t visited_reserve,
+                    VisitedSetPolicy visited_policy = VisitedSetPolicy::HASH_SET, uint64_t num_points = 0);
     ~SSDQueryScratch();
 
+    // approximate bytes held by a scratch built with the same arguments
+    static uint64_t memory_usage(size_t aligned_dim, size_t visited_reserve,
+                                 VisitedSetPolicy visited_policy = VisitedSetPolicy::HASH_SET,
+                                 uint64_t num_points = 0);
+
     void reset();
 };
 
@@ -161,8 +166,14 @@ template <typename T> class SSDThreadData
   public:
     SSDQueryScratch<T> scratch;
     IOContext ctx;
+    uint32_t numa_node = 0; // node the scratch was allocated on in NUMA mode
+
+    // per-query scratch for batched search, allocated on first use
+    std::vector<SSDQueryScratch<T> *> batch_scratch;
 
-    SSDThreadData(size_t aligned_dim, size_t visited_reserve);
+    SSDThreadData(size_t aligned_dim, size_t visited_reserve,
+                  VisitedSetPolicy visited_policy = VisitedSetPolicy::HASH_SET, uint64_t num_points = 0);
+    ~SSDThreadData();
     void clear();
 };
 
@@ -172,7 +183,7 @@ template <typename T> class SSDThreadData
 template <typename T> class ScratchStoreManager
 {
   public:
-    ScratchStoreManager(ConcurrentQueue<T *> &query_scratch) : _scratch_pool(query_scratch)
+    ScratchStoreManager(ScratchPool<T *> &query_scratch) : _scratch_pool(query_scratch)
     {
         _scratch = query_scratch.pop();
         while (_scratch == nullptr)
@@ -209,7 +220,7 @@ template <typename T> class ScratchStoreManager
 
   private:
     T *_scratch;
-    ConcurrentQueue<T *> &_scratch_pool;
+    ScratchPool<T *> &_scratch_pool;
     ScratchStoreManager(const ScratchStoreManager<T> &);
     ScratchStoreManager &operator=(const ScratchStoreManager<T> &);
 };
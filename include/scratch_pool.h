@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace diskann
+{
+// dense index of the calling thread, shared by all pools
+inline uint64_t scratch_pool_thread_index()
+{
+    static std::atomic<uint64_t> next_index{0};
+    thread_local uint64_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+// A pool of scratch pointers with the push/pop interface of ConcurrentQueue,
+// for ScratchStoreManager. Items are kept in cache-line sized slots, and a
+// thread pushes into and pops from the slot of its own thread index first,
+// so that with no more threads than items each thread takes back the scratch
+// it returned last, without touching memory that other threads write. Only
+// when that slot is empty or taken does it look at the others, with a
+// compare-and-swap per slot. Slots are fixed at construction; when more items
+// are pushed than fit, the rest go to an overflow list under a mutex.
+//
+// pop() returns the null value when the pool is empty; the caller then waits
+// with wait_for_push_notify() until an item is pushed back, as with
+// ConcurrentQueue. Pushes only signal when someone is waiting.
+template <typename T> class ScratchPool
+{
+    typedef std::chrono::microseconds chrono_us_t;
+    typedef std::unique_lock<std::mutex> mutex_locker;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<T> item;
+    };
+
+    T null_T;
+    uint64_t _num_slots;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<uint64_t> _size{0};
+
+    std::mutex _overflow_mut;
+    std::vector<T> _overflow;
+    std::atomic<uint64_t> _overflow_size{0};
+
+    std::atomic<uint32_t> _num_waiters{0};
+    std::mutex _push_mut;
+    std::condition_variable _push_cv;
+
+  public:
+    ScratchPool(T nullT, uint64_t num_slots = 256) : null_T(nullT), _num_slots(num_slots), _slots(new Slot[num_slots])
+    {
+        for (uint64_t i = 0; i < _num_slots; i++)
+            _slots[i].item.store(null_T, std::memory_order_relaxed);
+    }
+
+    ~ScratchPool()
+    {
+        _push_cv.notify_all();
+    }
+
+    uint64_t size()
+    {
+        return _size.load(std::memory_order_acquire);
+    }
+
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+    void push(T &new_val)
+    {
+        // counted before it is visible, so that _size never drops below 0
+        _size.fetch_add(1, std::memory_order_acq_rel);
+        uint64_t home = scratch_pool_thread_index() % _num_slots;
+        bool placed = false;
+        for (uint64_t i = 0; i < _num_slots && !placed; i++)
+        {
+            Slot &slot = _slots[(home + i) % _num_slots];
+            T expected = null_T;
+            placed = slot.item.load(std::memory_order_relaxed) == null_T &&
+                     slot.item.compare_exchange_strong(expected, new_val, std::memory_order_release,
+                                                       std::memory_order_relaxed);
+        }
+        if (!placed)
+        {
+            mutex_locker lk(_overflow_mut);
+            _overflow.push_back(new_val);
+            _overflow_size.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    template <class Iterator> void insert(Iterator iter_begin, Iterator iter_end)
+    {
+        for (Iterator it = iter_begin; it != iter_end; it++)
+        {
+            T val = *it;
+            push(val);
+        }
+    }
+
+    T pop()
+    {
+        if (_size.load(std::memory_order_acquire) == 0)
+            return null_T;
+        uint64_t home = scratch_pool_thread_index() % _num_slots;
+        for (uint64_t i = 0; i < _num_slots; i++)
+        {
+            Slot &slot = _slots[(home + i) % _num_slots];
+            T val = slot.item.load(std::memory_order_relaxed);
+            if (val != null_T &&
+                slot.item.compare_exchange_strong(val, null_T, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                _size.fetch_sub(1, std::memory_order_acq_rel);
+                return val;
+            }
+        }
+        if (_overflow_size.load(std::memory_order_acquire) > 0)
+        {
+            mutex_locker lk(_overflow_mut);
+            if (!_overflow.empty())
+            {
+                T val = _overflow.back();
+                _overflow.pop_back();
+                _overflow_size.fetch_sub(1, std::memory_order_release);
+                _size.fetch_sub(1, std::memory_order_acq_rel);
+                return val;
+            }
+        }
+        return null_T;
+    }
+
+    // blocks until a push or the timeout; pop() again afterwards
+    void wait_for_push_notify(chrono_us_t wait_time = chrono_us_t{10})
+    {
+        mutex_locker lk(_push_mut);
+        _num_waiters.fetch_add(1, std::memory_order_acq_rel);
+        if (_size.load(std::memory_order_acquire) == 0)
+            _push_cv.wait_for(lk, wait_time);
+        _num_waiters.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void push_notify_one()
+    {
+        if (_num_waiters.load(std::memory_order_acquire) > 0)
+        {
+            mutex_locker lk(_push_mut);
+            _push_cv.notify_one();
+        }
+    }
+
+    void push_notify_all()
+    {
+        if (_num_waiters.load(std::memory_order_acquire) > 0)
+        {
+            mutex_locker lk(_push_mut);
+            _push_cv.notify_all();
+        }
+    }
+};
+} // namespace diskann
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "tsl/robin_map.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// A bounded, thread-safe cache of disk index sectors, filled with the sectors
+// that searches read. Unlike the static node cache built by load_cache_list(),
+// it follows the query distribution as it drifts.
+//
+// Entries are all entry_len bytes (the read size of one node) and keyed by
+// their first sector #. The cache is split into shards, each with its own
+// lock and CLOCK (second chance) eviction: a hit sets the entry's reference
+// bit, and the clock hand evicts the first entry whose bit is clear, clearing
+// bits as it goes.
+class SectorCache
+{
+  public:
+    DISKANN_DLLEXPORT SectorCache(uint64_t budget_bytes, uint64_t entry_len, uint32_t num_shards = 16);
+    DISKANN_DLLEXPORT ~SectorCache();
+
+    // copies the cached sector into buf and returns true on hit
+    DISKANN_DLLEXPORT bool lookup(uint64_t sector, char *buf);
+
+    // admits a sector just read into buf; returns true if an entry had to
+    // be evicted to make room for it
+    DISKANN_DLLEXPORT bool insert(uint64_t sector, const char *buf);
+
+    DISKANN_DLLEXPORT uint64_t capacity() const;
+
+  private:
+    struct Shard
+    {
+        std::mutex mut;
+        tsl::robin_map<uint64_t, uint32_t> slot_of; // sector # -> slot
+        std::vector<uint64_t> sector_of;            // slot -> sector #
+        std::vector<uint8_t> referenced;            // slot -> CLOCK reference bit
+        char *buf = nullptr;                        // [num_slots * entry_len]
+        uint32_t num_slots = 0;
+        uint32_t num_used = 0;
+        uint32_t hand = 0;
+    };
+
+    Shard &shard_of(uint64_t sector)
+    {
+        return _shards[sector % _shards.size()];
+    }
+
+    uint64_t _entry_len;
+    uint64_t _capacity = 0;
+    std::vector<Shard> _shards;
+};
+} // namespace diskann
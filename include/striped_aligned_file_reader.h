@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#ifndef _WINDOWS
+
+#include <string>
+
+#include "aligned_file_reader.h"
+
+// AlignedFileReader over a disk index split into stripe files, typically one
+// per NVMe device, by diskann::stripe_disk_index(). open() takes the path of
+// the original disk index and reads the list of stripes from
+// fname + "_stripes.txt". Consecutive runs of stripe_sectors sectors of the
+// original file go to the stripes round robin, so that the random reads of a
+// search spread evenly over the devices. Each request is routed by its offset
+// to the file descriptor of its stripe, and one that crosses a stripe
+// boundary is split into a read per stripe; it completes when all its pieces
+// have. Reads go through libaio like LinuxAlignedFileReader.
+class StripedAlignedFileReader : public AlignedFileReader
+{
+  private:
+    // per thread: the aio context, and the number of pieces still in flight
+    // for each submitted request that was split across stripes
+    struct StripeContext
+    {
+        io_context_t aio_ctx = 0;
+        tsl::robin_map<void *, uint32_t> pending_pieces;
+    };
+
+    std::vector<FileHandle> _stripe_fds;
+    uint64_t _stripe_len = 0; // bytes in one run of sectors on a stripe
+    io_context_t bad_ctx = (io_context_t)-1;
+
+    // IOContext is io_context_t on Linux; this reader stores its
+    // StripeContext pointer in it, as MmapAlignedFileReader does
+    static StripeContext *to_stripe_ctx(IOContext &ctx)
+    {
+        return reinterpret_cast<StripeContext *>(ctx);
+    }
+
+    // appends one iocb per stripe touched by each request; the iocb data
+    // field holds the buf of the request. When pending is given, the number
+    // of pieces of each split request is recorded in it
+    void prep_reqs(std::vector<AlignedRead> &read_reqs, std::vector<struct iocb> &cbs,
+                   tsl::robin_map<void *, uint32_t> *pending);
+
+  public:
+    StripedAlignedFileReader();
+    ~StripedAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    uint64_t get_num_stripes() const
+    {
+        return _stripe_fds.size();
+    }
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // asynchronous interface: submit now, reap completions later
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    uint64_t get_completed_reqs(IOContext &ctx, uint64_t min_completions, std::vector<void *> &completed_bufs);
+};
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// One bit per id of an index, set for the ids that have been deleted. Bits
+// are set with atomic ORs and tested without locks, so that searches can run
+// while deletes come in. Bits are never cleared one at a time: deleted ids
+// stay deleted until the bitmap is cleared or reloaded.
+//
+// On disk: magic, version, the checksum of the index it was saved for, the
+// number of ids and of deleted ids, followed by the 64-bit words.
+class TombstoneBitmap
+{
+  public:
+    // clears the bitmap and sizes it for ids below num_ids
+    DISKANN_DLLEXPORT void resize(uint64_t num_ids);
+
+    DISKANN_DLLEXPORT void clear();
+
+    // marks id deleted; returns false if it is out of range or already
+    // deleted
+    DISKANN_DLLEXPORT bool set(uint64_t id);
+
+    inline bool test(uint64_t id) const
+    {
+        return (_words[id >> 6].load(std::memory_order_relaxed) >> (id & 63)) & 1;
+    }
+
+    // number of deleted ids
+    inline uint64_t count() const
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t size() const
+    {
+        return _num_ids;
+    }
+
+    DISKANN_DLLEXPORT uint64_t memory_bytes() const;
+
+    DISKANN_DLLEXPORT void save(const std::string &file, uint64_t index_checksum) const;
+
+    // replaces the bitmap with the one saved in file. Returns false, leaving
+    // the bitmap unchanged, if the file is missing, of another version, or
+    // was saved for an index with another checksum or number of ids.
+    DISKANN_DLLEXPORT bool load(const std::string &file, uint64_t index_checksum);
+
+  private:
+    uint64_t num_words() const
+    {
+        return (_num_ids + 63) / 64;
+    }
+
+    uint64_t _num_ids = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> _words;
+    std::atomic<uint64_t> _count{0};
+};
+} // namespace diskann
@@ -472,6 +472,32 @@ inline void load_bin(const std::string &bin_file, T *&data, size_t &npts, size_t
     diskann::cout << "done." << std::endl;
 }
 
+// Allocates size bytes (rounded up to a multiple of align). With huge_pages,
+// the buffer is aligned to 2MB and, on Linux, marked for transparent huge
+// pages so that large in-memory arrays take fewer TLB misses. Free with
+// aligned_free().
+DISKANN_DLLEXPORT void alloc_aligned_large(void **ptr, size_t size, size_t align, bool huge_pages);
+
+// Same as load_bin, but the payload is read in large chunks by num_threads
+// threads, with O_DIRECT where the file system supports it, so that loading
+// is bound by the device rather than by a single reader. data is allocated
+// with alloc_aligned_large() and must be freed with aligned_free().
+template <typename T>
+DISKANN_DLLEXPORT void load_bin_parallel(const std::string &bin_file, T *&data, size_t &npts, size_t &dim,
+                                         uint32_t num_threads, bool huge_pages = false);
+
+// 64-bit FNV-1a hash of len bytes; pass a previous result as hash to chain
+inline uint64_t fnv1a_hash64(const void *data, size_t len, uint64_t hash = 14695981039346656037ULL)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 inline void wait_for_keystroke()
 {
     int a;
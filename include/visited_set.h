@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "tsl/robin_set.h"
+#include "defaults.h"
+
+namespace diskann
+{
+enum class VisitedSetPolicy
+{
+    AUTO,        // epoch array if it fits in defaults::MAX_VISITED_ARRAY_BYTES, else bitset
+                 // up to defaults::MAX_VISITED_BITSET_POINTS, else hash set
+    EPOCH_ARRAY, // always the epoch array
+    BITSET,      // always the bitset
+    HASH_SET     // always the hash set
+};
+
+// Ids visited by one search, kept in one of three ways:
+//
+// - an epoch array with a stamp per id of the index. An id is visited if its
+//   stamp equals the current epoch, so insert and lookup are a single load
+//   and store, and clear() just moves to the next epoch. Only when the
+//   16-bit epoch wraps around, once every 65535 searches, are the stamps
+//   zeroed again. It costs 2 bytes per point per scratch.
+// - a bitset with a bit per id, zeroed in full by every clear(). It costs
+//   16 times less memory than the epoch array, but clearing it touches the
+//   whole index.
+// - a hash set, for indices too large to hold either per scratch.
+class VisitedSet
+{
+  public:
+    typedef uint16_t stamp_t;
+
+    // the way policy tracks ids for an index of num_ids points: EPOCH_ARRAY,
+    // BITSET or HASH_SET, never AUTO
+    static VisitedSetPolicy resolve(VisitedSetPolicy policy, uint64_t num_ids)
+    {
+        if (policy != VisitedSetPolicy::AUTO)
+            return policy;
+        if (num_ids * sizeof(stamp_t) <= defaults::MAX_VISITED_ARRAY_BYTES)
+            return VisitedSetPolicy::EPOCH_ARRAY;
+        if (num_ids <= defaults::MAX_VISITED_BITSET_POINTS)
+            return VisitedSetPolicy::BITSET;
+        return VisitedSetPolicy::HASH_SET;
+    }
+
+    // bytes one scratch holds for the ids visited in an index of num_ids
+    // points, with a hash set reserved for reserve ids
+    static uint64_t memory_usage(VisitedSetPolicy policy, uint64_t num_ids, size_t reserve)
+    {
+        switch (resolve(policy, num_ids))
+        {
+        case VisitedSetPolicy::EPOCH_ARRAY:
+            return num_ids * sizeof(stamp_t);
+        case VisitedSetPolicy::BITSET:
+            return ((num_ids + 63) / 64) * sizeof(uint64_t);
+        default:
+            // robin_set keeps its buckets at most half full
+            return 2 * reserve * (sizeof(uint64_t) + sizeof(uint64_t));
+        }
+    }
+
+    static const char *name(VisitedSetPolicy policy)
+    {
+        switch (policy)
+        {
+        case VisitedSetPolicy::EPOCH_ARRAY:
+            return "epoch array";
+        case VisitedSetPolicy::BITSET:
+            return "bitset";
+        case VisitedSetPolicy::HASH_SET:
+            return "hash set";
+        default:
+            return "auto";
+        }
+    }
+
+    // switches to the way policy tracks ids for an index of num_ids points,
+    // growing the array, bitset or hash set if needed and freeing the
+    // others. Cheap enough to call before every search.
+    void init(VisitedSetPolicy policy, uint64_t num_ids, size_t reserve)
+    {
+        policy = resolve(policy, num_ids);
+        if (policy != _mode)
+        {
+            std::vector<stamp_t>().swap(_stamps);
+            _epoch = 1;
+            std::vector<uint64_t>().swap(_bits);
+            tsl::robin_set<uint64_t>().swap(_hash);
+            _mode = policy;
+        }
+
+        if (policy == VisitedSetPolicy::EPOCH_ARRAY && _stamps.size() < num_ids)
+            _stamps.resize(num_ids, 0);
+        else if (policy == VisitedSetPolicy::BITSET && _bits.size() * 64 < num_ids)
+            _bits.resize((num_ids + 63) / 64, 0);
+        else if (policy == VisitedSetPolicy::HASH_SET && _hash.bucket_count() * _hash.max_load_factor() < reserve)
+            _hash.reserve(reserve);
+    }
+
+    // EPOCH_ARRAY, BITSET or HASH_SET
+    inline VisitedSetPolicy mode() const
+    {
+        return _mode;
+    }
+
+    inline bool contains(uint64_t id) const
+    {
+        switch (_mode)
+        {
+        case VisitedSetPolicy::EPOCH_ARRAY:
+            assert(id < _stamps.size());
+            return _stamps[id] == _epoch;
+        case VisitedSetPolicy::BITSET:
+            assert(id / 64 < _bits.size());
+            return (_bits[id / 64] >> (id % 64)) & 1;
+        default:
+            return _hash.find(id) != _hash.end();
+        }
+    }
+
+    // marks id visited; returns true if it was not visited before
+    inline bool insert(uint64_t id)
+    {
+        switch (_mode)
+        {
+        case VisitedSetPolicy::EPOCH_ARRAY:
+            assert(id < _stamps.size());
+            if (_stamps[id] == _epoch)
+                return false;
+            _stamps[id] = _epoch;
+            return true;
+        case VisitedSetPolicy::BITSET: {
+            assert(id / 64 < _bits.size());
+            uint64_t bit = (uint64_t)1 << (id % 64);
+            if (_bits[id / 64] & bit)
+                return false;
+            _bits[id / 64] |= bit;
+            return true;
+        }
+        default:
+            return _hash.insert(id).second;
+        }
+    }
+
+    void clear()
+    {
+        switch (_mode)
+        {
+        case VisitedSetPolicy::EPOCH_ARRAY:
+            if (++_epoch == 0)
+            {
+                std::fill(_stamps.begin(), _stamps.end(), (stamp_t)0);
+                _epoch = 1;
+            }
+            break;
+        case VisitedSetPolicy::BITSET:
+            std::fill(_bits.begin(), _bits.end(), (uint64_t)0);
+            break;
+        default:
+            _hash.clear();
+        }
+    }
+
+  private:
+    VisitedSetPolicy _mode = VisitedSetPolicy::HASH_SET;
+    stamp_t _epoch = 1;
+    std::vector<stamp_t> _stamps;
+    std::vector<uint64_t> _bits;
+    tsl::robin_set<uint64_t> _hash;
+};
+} // namespace diskann
@@ -0,0 +1,580 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#include "common_includes.h"
+#include "disk_merge.h"
+#include "logger.h"
+#include "omp.h"
+#include "pq.h"
+#include "timer.h"
+#include "tsl/robin_map.h"
+#include "utils.h"
+
+namespace diskann
+{
+namespace
+{
+// nodes whose neighbor lists are read by one read_nodes() call
+const uint64_t MERGE_READ_BATCH = 1024;
+// bytes of sectors streamed per block while writing the merged index
+const uint64_t MERGE_BLOCK_SIZE = 64 * 1024 * 1024;
+
+struct DiskIndexHeader
+{
+    uint64_t npts = 0;
+    uint64_t ndims = 0;
+    uint64_t medoid = 0;
+    uint64_t max_node_len = 0;
+    uint64_t nnodes_per_sector = 0;
+};
+
+// reads the header of an SSD index and rejects the layouts merge_disk_index
+// can not stream
+DiskIndexHeader read_disk_index_header(const std::string &disk_index_file)
+{
+    std::ifstream reader(disk_index_file, std::ios::binary);
+    uint32_t nr = 0, nc = 0;
+    reader.read((char *)&nr, sizeof(uint32_t));
+    reader.read((char *)&nc, sizeof(uint32_t));
+    std::vector<uint64_t> meta(nr);
+    reader.read((char *)meta.data(), nr * sizeof(uint64_t));
+    if (!reader || nr < 9)
+        throw ANNException("Could not read the header of " + disk_index_file, -1, __FUNCSIG__, __FILE__, __LINE__);
+
+    DiskIndexHeader header;
+    header.npts = meta[0];
+    header.ndims = meta[1];
+    header.medoid = meta[2];
+    header.max_node_len = meta[3];
+    header.nnodes_per_sector = meta[4];
+    if (meta[5] != 0)
+        throw ANNException("Merging an SSD index with frozen points is not supported", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    if (meta[7] != 0)
+        throw ANNException("Merging an SSD index with reorder data is not supported", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    if (nr > 9 && meta[9] != 0)
+        throw ANNException("Merging an SSD index with a locality, packed or decoupled layout is not supported", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+    if (get_file_size(disk_index_file) != meta[8])
+        throw ANNException("Size of " + disk_index_file +
+                               " does not match its header; striped indices can not be merged",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    return header;
+}
+
+inline float l2_distance(const float *a, const float *b, uint64_t dim)
+{
+    float dist = 0;
+    for (uint64_t d = 0; d < dim; d++)
+        dist += (a[d] - b[d]) * (a[d] - b[d]);
+    return dist;
+}
+
+// vectors and pruning used by a merge: points of the SSD index are
+// represented by their PQ vectors, inserted points by their exact vectors
+template <typename T> class MergeGraph
+{
+  public:
+    uint64_t dim = 0;
+    uint64_t num_base = 0;
+    uint32_t degree = 0;
+    float alpha = 1.2f;
+
+    FixedChunkPQTable pq_table;
+    std::unique_ptr<uint8_t[]> pq_codes; // [num_base * n_chunks]
+    uint64_t n_chunks = 0;
+
+    std::vector<uint32_t> delta_ids; // sorted
+    std::unique_ptr<T[]> delta_data;
+    std::unique_ptr<float[]> delta_float;
+    tsl::robin_map<uint32_t, uint64_t> delta_pos;
+
+    tsl::robin_set<uint32_t> deleted;
+
+    void get_vector(uint32_t id, float *out)
+    {
+        if (id < num_base)
+            pq_table.inflate_vector(pq_codes.get() + id * n_chunks, out);
+        else
+            memcpy(out, delta_float.get() + delta_pos.find(id)->second * dim, dim * sizeof(float));
+    }
+
+    // keeps at most degree of candidates, by the rule of Index::occlude_list,
+    // as the neighbors of the node with vector node_vec and id self
+    void prune(uint32_t self, const float *node_vec, std::vector<uint32_t> &candidates, std::vector<uint32_t> &result)
+    {
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<float> vec(dim);
+        std::vector<Neighbor> pool;
+        pool.reserve(candidates.size());
+        for (auto id : candidates)
+        {
+            if (id == self)
+                continue;
+            get_vector(id, vec.data());
+            pool.emplace_back(id, l2_distance(node_vec, vec.data(), dim));
+        }
+        std::sort(pool.begin(), pool.end());
+        if (pool.size() > defaults::MAX_OCCLUSION_SIZE)
+            pool.resize(defaults::MAX_OCCLUSION_SIZE);
+
+        std::vector<float> pool_vecs(pool.size() * dim);
+        for (size_t i = 0; i < pool.size(); i++)
+            get_vector(pool[i].id, pool_vecs.data() + i * dim);
+
+        result.clear();
+        std::vector<float> occlude_factor(pool.size(), 0.0f);
+        float cur_alpha = 1;
+        while (cur_alpha <= alpha && result.size() < degree)
+        {
+            for (size_t i = 0; result.size() < degree && i < pool.size(); i++)
+            {
+                if (occlude_factor[i] > cur_alpha)
+                    continue;
+                occlude_factor[i] = std::numeric_limits<float>::max();
+                result.push_back(pool[i].id);
+                for (size_t j = i + 1; j < pool.size(); j++)
+                {
+                    if (occlude_factor[j] > alpha)
+                        continue;
+                    float djk = l2_distance(pool_vecs.data() + i * dim, pool_vecs.data() + j * dim, dim);
+                    occlude_factor[j] = (djk == 0) ? std::numeric_limits<float>::max()
+                                                   : std::max(occlude_factor[j], pool[j].distance / djk);
+                }
+            }
+            cur_alpha *= 1.2f;
+        }
+    }
+};
+} // namespace
+
+template <typename T>
+void merge_disk_index(PQFlashIndex<T> &base, const std::string &base_prefix, AbstractIndex &delta,
+                      const std::vector<uint32_t> &deleted_ids, const std::string &output_prefix,
+                      const DiskMergeParameters &params)
+{
+    const std::string base_disk_file = base_prefix + "_disk.index";
+    const std::string base_pivots_file = base_prefix + "_pq_pivots.bin";
+    const std::string output_disk_file = output_prefix + "_disk.index";
+    if (output_prefix == base_prefix)
+        throw ANNException("The merged index must not overwrite the index it is merged from", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    if (base.get_metric() != Metric::L2)
+        throw ANNException("Only SSD indices with the L2 metric can be merged", -1, __FUNCSIG__, __FILE__, __LINE__);
+    if (file_exists(base_disk_file + "_pq_pivots.bin") || file_exists(base_pivots_file + "_rotation_matrix.bin"))
+        throw ANNException("Merging an SSD index with disk PQ or OPQ is not supported", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    if (file_exists(base_disk_file + "_labels.txt") || file_exists(base_disk_file + "_medoids.bin"))
+        throw ANNException("Merging an SSD index with labels or multiple medoids is not supported", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+
+    const DiskIndexHeader header = read_disk_index_header(base_disk_file);
+    const uint64_t dim = header.ndims;
+    const uint64_t coords_len = dim * sizeof(T);
+    const uint32_t num_threads = params.num_threads == 0 ? omp_get_num_procs() : params.num_threads;
+    omp_set_num_threads(num_threads);
+    Timer timer;
+
+    MergeGraph<T> graph;
+    graph.dim = dim;
+    graph.num_base = header.npts;
+    graph.degree = (uint32_t)((header.max_node_len - coords_len) / sizeof(uint32_t) - 1);
+    graph.alpha = params.alpha;
+
+    size_t npts, ncols;
+    load_bin<uint8_t>(base_prefix + "_pq_compressed.bin", graph.pq_codes, npts, ncols);
+    graph.pq_table.load_pq_centroid_bin(base_pivots_file.c_str(), 0);
+    if (graph.pq_table.get_num_centers() != NUM_PQ_CENTROIDS || graph.pq_table.get_num_chunks() != ncols ||
+        npts != header.npts)
+        throw ANNException("Merging needs the 8-bit PQ vectors of every point of the SSD index", -1, __FUNCSIG__,
+                           __FILE__, __LINE__);
+    graph.n_chunks = ncols;
+
+    for (auto id : deleted_ids)
+    {
+        if (id < header.npts)
+            graph.deleted.insert(id);
+    }
+
+    // exact vectors of the points to insert, in id order
+    tsl::robin_set<uint32_t> active_tags;
+    delta.get_active_tags<uint32_t>(active_tags);
+    for (auto tag : active_tags)
+    {
+        if (tag < header.npts)
+            throw ANNException("Tag " + std::to_string(tag) +
+                                   " of the delta index collides with a point of the SSD index",
+                               -1, __FUNCSIG__, __FILE__, __LINE__);
+        graph.delta_ids.push_back(tag);
+    }
+    std::sort(graph.delta_ids.begin(), graph.delta_ids.end());
+    const uint64_t num_delta = graph.delta_ids.size();
+    graph.delta_data = std::make_unique<T[]>(num_delta * dim);
+    graph.delta_float = std::make_unique<float[]>(num_delta * dim);
+    for (uint64_t pos = 0; pos < num_delta; pos++)
+    {
+        T *vec = graph.delta_data.get() + pos * dim;
+        delta.get_vector_by_tag<uint32_t, T>(graph.delta_ids[pos], vec);
+        for (uint64_t d = 0; d < dim; d++)
+            graph.delta_float[pos * dim + d] = (float)vec[d];
+        graph.delta_pos[graph.delta_ids[pos]] = pos;
+    }
+    const uint64_t num_out =
+        num_delta > 0 ? (std::max)(header.npts, (uint64_t)graph.delta_ids.back() + 1) : header.npts;
+    diskann::cout << "Merging " << header.npts << " points less " << graph.deleted.size() << " deleted with "
+                  << num_delta << " inserted, degree " << graph.degree << std::endl;
+
+    // neighbors of the deleted points, which take their place in the lists
+    // that point to them
+    tsl::robin_map<uint32_t, std::vector<uint32_t>> deleted_nhoods;
+    {
+        std::vector<uint32_t> ids(graph.deleted.begin(), graph.deleted.end());
+        std::vector<uint32_t> nbr_data(MERGE_READ_BATCH * graph.degree);
+        for (size_t start = 0; start < ids.size(); start += MERGE_READ_BATCH)
+        {
+            size_t end = (std::min)(ids.size(), start + MERGE_READ_BATCH);
+            std::vector<uint32_t> batch(ids.begin() + start, ids.begin() + end);
+            std::vector<T *> coord_buffers(batch.size(), nullptr);
+            std::vector<std::pair<uint32_t, uint32_t *>> nbr_buffers;
+            for (size_t i = 0; i < batch.size(); i++)
+                nbr_buffers.emplace_back(0, nbr_data.data() + i * graph.degree);
+            auto read_ok = base.read_nodes(batch, coord_buffers, nbr_buffers);
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                if (!read_ok[i])
+                    throw ANNException("Could not read node " + std::to_string(batch[i]), -1, __FUNCSIG__, __FILE__,
+                                       __LINE__);
+                deleted_nhoods[batch[i]].assign(nbr_buffers[i].second, nbr_buffers[i].second + nbr_buffers[i].first);
+            }
+        }
+    }
+
+    // the surviving neighbors of a list, with deleted ones replaced by their
+    // own surviving neighbors; returns false if no neighbor was deleted
+    auto repair_nhood = [&](uint32_t id, const uint32_t *nbrs, uint32_t nnbrs, std::vector<uint32_t> &out) {
+        bool repaired = false;
+        out.clear();
+        for (uint32_t j = 0; j < nnbrs; j++)
+        {
+            auto iter = deleted_nhoods.find(nbrs[j]);
+            if (iter == deleted_nhoods.end())
+            {
+                out.push_back(nbrs[j]);
+                continue;
+            }
+            repaired = true;
+            for (auto nbr : iter->second)
+            {
+                if (nbr != id && graph.deleted.find(nbr) == graph.deleted.end())
+                    out.push_back(nbr);
+            }
+        }
+        return repaired;
+    };
+
+    uint64_t medoid = header.medoid;
+    if (graph.deleted.find((uint32_t)medoid) != graph.deleted.end())
+    {
+        std::vector<uint32_t> candidates;
+        const auto &nhood = deleted_nhoods[(uint32_t)medoid];
+        repair_nhood((uint32_t)medoid, nhood.data(), (uint32_t)nhood.size(), candidates);
+        if (candidates.empty())
+            throw ANNException("The medoid and all its neighbors are deleted", -1, __FUNCSIG__, __FILE__, __LINE__);
+        std::vector<float> medoid_vec(dim), vec(dim);
+        graph.get_vector((uint32_t)medoid, medoid_vec.data());
+        float best = std::numeric_limits<float>::max();
+        for (auto id : candidates)
+        {
+            graph.get_vector(id, vec.data());
+            float dist = l2_distance(medoid_vec.data(), vec.data(), dim);
+            if (dist < best)
+            {
+                best = dist;
+                medoid = id;
+            }
+        }
+        diskann::cout << "Medoid " << header.medoid << " is deleted, replaced by " << medoid << std::endl;
+    }
+
+    // place the inserted points: search both indices for each, prune the
+    // candidates to its neighbors and collect the reverse edges
+    std::vector<std::vector<uint32_t>> delta_nhoods(num_delta);
+    std::vector<std::pair<uint32_t, uint32_t>> reverse_edges;
+    std::mutex reverse_edges_lock;
+    const uint64_t l_search = (std::max)(params.search_l, graph.degree);
+#pragma omp parallel
+    {
+        std::vector<uint64_t> base_ids(l_search);
+        std::vector<float> base_dists(l_search);
+        std::vector<uint32_t> delta_tags(l_search);
+        std::vector<float> delta_dists(l_search);
+        std::vector<T *> res_vectors;
+        std::vector<uint32_t> candidates;
+        std::vector<std::pair<uint32_t, uint32_t>> local_edges;
+
+#pragma omp for schedule(dynamic, 64)
+        for (int64_t pos = 0; pos < (int64_t)num_delta; pos++)
+        {
+            const uint32_t id = graph.delta_ids[pos];
+            const T *point = graph.delta_data.get() + pos * dim;
+            candidates.clear();
+            base.cached_beam_search(point, l_search, l_search, base_ids.data(), base_dists.data(), params.beam_width);
+            for (auto base_id : base_ids)
+            {
+                if (base_id < header.npts && graph.deleted.find((uint32_t)base_id) == graph.deleted.end())
+                    candidates.push_back((uint32_t)base_id);
+            }
+            size_t n_found = delta.search_with_tags<T, uint32_t>(point, l_search, (uint32_t)l_search, delta_tags.data(),
+                                                                 delta_dists.data(), res_vectors);
+            for (size_t i = 0; i < n_found; i++)
+            {
+                if (graph.delta_pos.find(delta_tags[i]) != graph.delta_pos.end())
+                    candidates.push_back(delta_tags[i]);
+            }
+            graph.prune(id, graph.delta_float.get() + pos * dim, candidates, delta_nhoods[pos]);
+            for (auto nbr : delta_nhoods[pos])
+                local_edges.emplace_back(nbr, id);
+        }
+
+        std::lock_guard<std::mutex> guard(reverse_edges_lock);
+        reverse_edges.insert(reverse_edges.end(), local_edges.begin(), local_edges.end());
+    }
+    std::sort(reverse_edges.begin(), reverse_edges.end());
+    diskann::cout << "Placed " << num_delta << " points with " << reverse_edges.size() << " reverse edges in "
+                  << timer.elapsed_seconds() << "s" << std::endl;
+
+    // stream the nodes of the SSD index in blocks of sectors, and write each
+    // block of the merged index in the same layout
+    const uint64_t nodes_per_group = header.nnodes_per_sector > 0 ? header.nnodes_per_sector : 1;
+    const uint64_t group_len = header.nnodes_per_sector > 0
+                                   ? defaults::SECTOR_LEN
+                                   : DIV_ROUND_UP(header.max_node_len, defaults::SECTOR_LEN) * defaults::SECTOR_LEN;
+    const uint64_t groups_per_block = (std::max)((uint64_t)1, MERGE_BLOCK_SIZE / group_len);
+    const uint64_t nodes_per_block = groups_per_block * nodes_per_group;
+    auto node_offset = [&](uint64_t i) {
+        return (i / nodes_per_group) * group_len + (i % nodes_per_group) * header.max_node_len;
+    };
+
+    std::ifstream base_reader(base_disk_file, std::ios::binary);
+    std::ofstream output_writer(output_disk_file, std::ios::binary);
+    std::vector<char> in_block(groups_per_block * group_len), out_block(groups_per_block * group_len);
+    base_reader.seekg(defaults::SECTOR_LEN, std::ios::beg);
+    memset(out_block.data(), 0, defaults::SECTOR_LEN);
+    output_writer.write(out_block.data(), defaults::SECTOR_LEN);
+
+    uint64_t num_repaired = 0, num_pruned = 0;
+    for (uint64_t first = 0; first < num_out; first += nodes_per_block)
+    {
+        const uint64_t n_nodes = (std::min)(nodes_per_block, num_out - first);
+        const uint64_t n_groups = DIV_ROUND_UP(n_nodes, nodes_per_group);
+        if (first < header.npts)
+        {
+            uint64_t n_base_groups = DIV_ROUND_UP((std::min)(n_nodes, header.npts - first), nodes_per_group);
+            base_reader.read(in_block.data(), n_base_groups * group_len);
+        }
+        memset(out_block.data(), 0, n_groups * group_len);
+
+#pragma omp parallel reduction(+ : num_repaired, num_pruned)
+        {
+            std::vector<uint32_t> nhood, candidates;
+            std::vector<float> node_vec(dim);
+
+#pragma omp for schedule(dynamic, 64)
+            for (int64_t i = 0; i < (int64_t)n_nodes; i++)
+            {
+                const uint32_t id = (uint32_t)(first + i);
+                char *out_node = out_block.data() + node_offset(i);
+                const T *coords = nullptr;
+                nhood.clear();
+                if (id < header.npts)
+                {
+                    if (graph.deleted.find(id) != graph.deleted.end())
+                        continue;
+                    const char *in_node = in_block.data() + node_offset(i);
+                    coords = (const T *)in_node;
+                    const uint32_t *in_nhood = (const uint32_t *)(in_node + coords_len);
+                    for (uint64_t d = 0; d < dim; d++)
+                        node_vec[d] = (float)coords[d];
+                    if (repair_nhood(id, in_nhood + 1, in_nhood[0], candidates))
+                    {
+                        graph.prune(id, node_vec.data(), candidates, nhood);
+                        num_repaired++;
+                    }
+                    else
+                    {
+                        nhood.swap(candidates);
+                    }
+                }
+                else
+                {
+                    auto iter = graph.delta_pos.find(id);
+                    if (iter == graph.delta_pos.end())
+                        continue;
+                    coords = graph.delta_data.get() + iter->second * dim;
+                    memcpy(node_vec.data(), graph.delta_float.get() + iter->second * dim, dim * sizeof(float));
+                    nhood = delta_nhoods[iter->second];
+                }
+
+                auto edges = std::lower_bound(reverse_edges.begin(), reverse_edges.end(), std::make_pair(id, 0u));
+                for (; edges != reverse_edges.end() && edges->first == id; edges++)
+                {
+                    if (std::find(nhood.begin(), nhood.end(), edges->second) == nhood.end())
+                        nhood.push_back(edges->second);
+                }
+                if (nhood.size() > graph.degree)
+                {
+                    candidates.swap(nhood);
+                    graph.prune(id, node_vec.data(), candidates, nhood);
+                    num_pruned++;
+                }
+
+                memcpy(out_node, coords, coords_len);
+                uint32_t *out_nhood = (uint32_t *)(out_node + coords_len);
+                out_nhood[0] = (uint32_t)nhood.size();
+                memcpy(out_nhood + 1, nhood.data(), nhood.size() * sizeof(uint32_t));
+            }
+        }
+        output_writer.write(out_block.data(), n_groups * group_len);
+    }
+    output_writer.close();
+    diskann::cout << "Wrote " << num_out << " nodes, " << num_repaired << " repaired and " << num_pruned
+                  << " pruned for inserts, in " << timer.elapsed_seconds() << "s"
+                  << std::endl;
+
+    const uint64_t n_sectors = DIV_ROUND_UP(num_out, nodes_per_group) * (group_len / defaults::SECTOR_LEN);
+    std::vector<uint64_t> output_file_meta = {num_out,
+                                              dim,
+                                              medoid,
+                                              header.max_node_len,
+                                              header.nnodes_per_sector,
+                                              0,
+                                              0,
+                                              0,
+                                              (n_sectors + 1) * defaults::SECTOR_LEN,
+                                              0};
+    save_bin<uint64_t>(output_disk_file, output_file_meta.data(), output_file_meta.size(), 1, 0);
+
+    // PQ vectors: those of the SSD index, followed by the inserted points
+    // encoded with its pivots
+    std::unique_ptr<uint8_t[]> out_codes = std::make_unique<uint8_t[]>(num_out * graph.n_chunks);
+    memset(out_codes.get(), 0, num_out * graph.n_chunks);
+    memcpy(out_codes.get(), graph.pq_codes.get(), header.npts * graph.n_chunks);
+    if (num_delta > 0)
+    {
+        const std::string delta_data_file = output_prefix + "_merge_delta_data.bin";
+        const std::string delta_codes_file = output_prefix + "_merge_delta_pq_compressed.bin";
+        save_bin<T>(delta_data_file, graph.delta_data.get(), num_delta, dim);
+        generate_pq_data_from_pivots<T>(delta_data_file, NUM_PQ_CENTROIDS, (uint32_t)graph.n_chunks, base_pivots_file,
+                                        delta_codes_file, false);
+        std::unique_ptr<uint8_t[]> delta_codes;
+        load_bin<uint8_t>(delta_codes_file, delta_codes, npts, ncols);
+        for (uint64_t pos = 0; pos < num_delta; pos++)
+            memcpy(out_codes.get() + graph.delta_ids[pos] * graph.n_chunks, delta_codes.get() + pos * graph.n_chunks,
+                   graph.n_chunks);
+        std::remove(delta_data_file.c_str());
+        std::remove(delta_codes_file.c_str());
+    }
+    save_bin<uint8_t>(output_prefix + "_pq_compressed.bin", out_codes.get(), num_out, graph.n_chunks);
+    copy_file(base_pivots_file, output_prefix + "_pq_pivots.bin");
+    diskann::cout << "Merged index written to " << output_disk_file << std::endl;
+}
+
+template <typename T>
+UpdatableDiskIndex<T>::UpdatableDiskIndex(PQFlashIndex<T> &base, AbstractIndex &delta)
+    : _base(base), _delta(delta), _num_base_points(base.get_num_points())
+{
+}
+
+template <typename T> int UpdatableDiskIndex<T>::insert(const T *point, const uint32_t id)
+{
+    if (id < _num_base_points)
+    {
+        diskann::cerr << "Id " << id << " of an inserted point must be at least " << _num_base_points << std::endl;
+        return -1;
+    }
+    return _delta.insert_point<T, uint32_t>(point, id);
+}
+
+template <typename T> int UpdatableDiskIndex<T>::remove(const uint32_t id)
+{
+    if (id >= _num_base_points)
+        return _delta.lazy_delete<uint32_t>(id);
+    return _base.lazy_delete(id) ? 0 : -1;
+}
+
+template <typename T>
+uint64_t UpdatableDiskIndex<T>::search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                       uint64_t *res_ids, float *res_dists, const uint64_t beam_width,
+                                       QueryStats *stats)
+{
+    // the SSD index leaves its deleted points out itself, and pads its
+    // results with the largest id and distance if fewer than k_search live
+    // points were found
+    std::vector<uint64_t> base_ids(k_search);
+    std::vector<float> base_dists(k_search);
+    _base.cached_beam_search(query, k_search, l_search, base_ids.data(), base_dists.data(), beam_width, false, stats);
+
+    std::vector<uint32_t> delta_tags(k_search);
+    std::vector<float> delta_dists(k_search);
+    std::vector<T *> res_vectors;
+    size_t n_delta = _delta.search_with_tags<T, uint32_t>(query, k_search, (uint32_t)l_search, delta_tags.data(),
+                                                          delta_dists.data(), res_vectors);
+
+    std::vector<std::pair<float, uint64_t>> results;
+    for (uint64_t i = 0; i < k_search; i++)
+    {
+        if (base_ids[i] != std::numeric_limits<uint64_t>::max() &&
+            base_dists[i] != std::numeric_limits<float>::max())
+            results.emplace_back(base_dists[i], base_ids[i]);
+    }
+    for (size_t i = 0; i < n_delta; i++)
+        results.emplace_back(delta_dists[i], delta_tags[i]);
+
+    const uint64_t n_results = (std::min)((uint64_t)results.size(), k_search);
+    std::partial_sort(results.begin(), results.begin() + n_results, results.end());
+    for (uint64_t i = 0; i < n_results; i++)
+    {
+        res_dists[i] = results[i].first;
+        res_ids[i] = results[i].second;
+    }
+    return n_results;
+}
+
+template <typename T> std::vector<uint32_t> UpdatableDiskIndex<T>::get_deleted_ids()
+{
+    return _base.get_deleted_ids();
+}
+
+template <typename T>
+void UpdatableDiskIndex<T>::merge(const std::string &base_prefix, const std::string &output_prefix,
+                                  const DiskMergeParameters &params)
+{
+    merge_disk_index<T>(_base, base_prefix, _delta, get_deleted_ids(), output_prefix, params);
+}
+
+template DISKANN_DLLEXPORT void merge_disk_index<float>(PQFlashIndex<float> &base, const std::string &base_prefix,
+                                                        AbstractIndex &delta, const std::vector<uint32_t> &deleted_ids,
+                                                        const std::string &output_prefix,
+                                                        const DiskMergeParameters &params);
+template DISKANN_DLLEXPORT void merge_disk_index<int8_t>(PQFlashIndex<int8_t> &base, const std::string &base_prefix,
+                                                         AbstractIndex &delta, const std::vector<uint32_t> &deleted_ids,
+                                                         const std::string &output_prefix,
+                                                         const DiskMergeParameters &params);
+template DISKANN_DLLEXPORT void merge_disk_index<uint8_t>(PQFlashIndex<uint8_t> &base, const std::string &base_prefix,
+                                                          AbstractIndex &delta,
+                                                          const std::vector<uint32_t> &deleted_ids,
+                                                          const std::string &output_prefix,
+                                                          const DiskMergeParameters &params);
+
+template DISKANN_DLLEXPORT class UpdatableDiskIndex<float>;
+template DISKANN_DLLEXPORT class UpdatableDiskIndex<int8_t>;
+template DISKANN_DLLEXPORT class UpdatableDiskIndex<uint8_t>;
+} // namespace diskann
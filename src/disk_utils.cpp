@@ -12,6 +12,7 @@
 #include "cached_io.h"
 #include "index.h"
 #include "mkl.h"
+#include "nhood_codec.h"
 #include "omp.h"
 #include "percentile_stats.h"
 #include "partition.h"
@@ -635,7 +636,7 @@ int build_merged_vamana_index(std::string base_file, diskann::Metric compareMetr
     size_t base_num, base_dim;
     diskann::get_bin_metadata(base_file, base_num, base_dim);
 
-    double full_index_ram = estimate_ram_usage(base_num, (uint32_t)base_dim, sizeof(T), R);
+    double full_index_ram = estimate_ram_usage(base_num, (uint32_t)base_dim, sizeof(T), R, num_threads);
 
     // TODO: Make this honest when there is filter support
     if (full_index_ram < ram_budget * 1024 * 1024 * 1024)
@@ -843,9 +844,157 @@ uint32_t optimize_beamwidth(std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> &p
     return best_bw;
 }
 
+std::vector<uint32_t> get_locality_layout_order(const std::string &mem_index_file, uint32_t start)
+{
+    uint64_t index_file_size, frozen_num;
+    uint32_t width, medoid;
+    std::vector<uint64_t> nhood_offsets;
+    {
+        // one sequential pass to find where the neighbors of each node start
+        cached_ifstream index_reader(mem_index_file, 64 * 1024 * 1024);
+        index_reader.read((char *)&index_file_size, sizeof(uint64_t));
+        index_reader.read((char *)&width, sizeof(uint32_t));
+        index_reader.read((char *)&medoid, sizeof(uint32_t));
+        index_reader.read((char *)&frozen_num, sizeof(uint64_t));
+        std::vector<uint32_t> skip_buf;
+        for (uint64_t offset = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t); offset < index_file_size;)
+        {
+            nhood_offsets.push_back(offset);
+            uint32_t nnbrs;
+            index_reader.read((char *)&nnbrs, sizeof(uint32_t));
+            skip_buf.resize(nnbrs);
+            if (nnbrs > 0)
+                index_reader.read((char *)skip_buf.data(), nnbrs * sizeof(uint32_t));
+            offset += ((uint64_t)nnbrs + 1) * sizeof(uint32_t);
+        }
+    }
+    size_t npts = nhood_offsets.size();
+
+    // unbuffered, so that each read fetches one neighbor list only
+    std::ifstream nhood_reader;
+    nhood_reader.rdbuf()->pubsetbuf(nullptr, 0);
+    nhood_reader.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    nhood_reader.open(mem_index_file, std::ios::binary);
+
+    std::vector<uint32_t> order;
+    order.reserve(npts);
+    std::vector<bool> placed(npts, false);
+
+    // BFS places a node's neighbors right after the nodes placed before them,
+    // so that nodes expanded one after the other by a search tend to share a
+    // sector or sit in adjacent ones. The queue is the tail of order; its
+    // nodes are expanded a batch at a time, reading their neighbors in file
+    // order, which visits them in the same order as one at a time would.
+    size_t batch_size = (std::max)((size_t)1, (size_t)(64 * 1024 * 1024) / (((size_t)width + 1) * sizeof(uint32_t)));
+    std::vector<uint32_t> batch_nbrs(batch_size * width);
+    std::vector<uint32_t> batch_nnbrs(batch_size);
+    std::vector<size_t> batch_by_offset;
+    size_t head = 0;
+    uint32_t next_unplaced = 0;
+    while (order.size() < npts)
+    {
+        if (head == order.size())
+        {
+            if (placed[start])
+            {
+                while (placed[next_unplaced])
+                    next_unplaced++;
+                start = next_unplaced;
+            }
+            order.push_back(start);
+            placed[start] = true;
+        }
+
+        size_t batch_len = (std::min)(batch_size, order.size() - head);
+        batch_by_offset.resize(batch_len);
+        std::iota(batch_by_offset.begin(), batch_by_offset.end(), (size_t)0);
+        std::sort(batch_by_offset.begin(), batch_by_offset.end(), [&](size_t a, size_t b) {
+            return nhood_offsets[order[head + a]] < nhood_offsets[order[head + b]];
+        });
+        for (auto i : batch_by_offset)
+        {
+            uint32_t nnbrs;
+            nhood_reader.seekg(nhood_offsets[order[head + i]], std::ios::beg);
+            nhood_reader.read((char *)&nnbrs, sizeof(uint32_t));
+            batch_nnbrs[i] = (std::min)(nnbrs, width);
+            nhood_reader.read((char *)(batch_nbrs.data() + i * width), batch_nnbrs[i] * sizeof(uint32_t));
+        }
+
+        for (size_t i = 0; i < batch_len; i++)
+        {
+            for (uint32_t j = 0; j < batch_nnbrs[i]; j++)
+            {
+                uint32_t nbr = batch_nbrs[i * width + j];
+                if (!placed[nbr])
+                {
+                    placed[nbr] = true;
+                    order.push_back(nbr);
+                }
+            }
+        }
+        head += batch_len;
+    }
+    return order;
+}
+
+void stripe_disk_index(const std::string &disk_index_file, const std::vector<std::string> &stripe_dirs,
+                       const uint64_t stripe_sectors)
+{
+    if (stripe_dirs.empty() || stripe_sectors == 0)
+    {
+        throw ANNException("Striping needs at least one directory and one sector per run", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+    std::string file_name = disk_index_file.substr(disk_index_file.find_last_of("/\\") + 1);
+    std::vector<std::string> stripe_files;
+    for (size_t i = 0; i < stripe_dirs.size(); i++)
+    {
+        stripe_files.push_back(stripe_dirs[i] + "/" + file_name + ".stripe" + std::to_string(i));
+    }
+
+    uint64_t file_size = get_file_size(disk_index_file);
+    uint64_t run_len = stripe_sectors * defaults::SECTOR_LEN;
+    {
+        size_t read_blk_size = 64 * 1024 * 1024;
+        size_t write_blk_size = ROUND_UP(read_blk_size / stripe_files.size(), run_len);
+        cached_ifstream index_reader(disk_index_file, read_blk_size);
+        std::vector<std::unique_ptr<cached_ofstream>> stripe_writers;
+        for (auto &stripe_file : stripe_files)
+            stripe_writers.emplace_back(new cached_ofstream(stripe_file, write_blk_size));
+
+        std::unique_ptr<char[]> run_buf = std::make_unique<char[]>(run_len);
+        uint64_t run = 0;
+        for (uint64_t offset = 0; offset < file_size; offset += run_len, run++)
+        {
+            uint64_t len = (std::min)(run_len, file_size - offset);
+            index_reader.read(run_buf.get(), len);
+            stripe_writers[run % stripe_files.size()]->write(run_buf.get(), len);
+        }
+    }
+
+    std::ofstream manifest_writer(disk_index_file + "_stripes.txt");
+    manifest_writer << stripe_sectors << std::endl;
+    for (auto &stripe_file : stripe_files)
+        manifest_writer << stripe_file << std::endl;
+    manifest_writer.close();
+
+    // only the header is left in place, for the metadata read at load
+    std::unique_ptr<char[]> header = std::make_unique<char[]>(defaults::SECTOR_LEN);
+    {
+        std::ifstream header_reader(disk_index_file, std::ios::binary);
+        header_reader.read(header.get(), defaults::SECTOR_LEN);
+    }
+    std::ofstream header_writer(disk_index_file, std::ios::binary | std::ios::trunc);
+    header_writer.write(header.get(), defaults::SECTOR_LEN);
+    header_writer.close();
+    diskann::cout << "Disk index striped over " << stripe_files.size() << " files, " << stripe_sectors
+                  << " sector(s) at a time; stripes listed in " << disk_index_file << "_stripes.txt" << std::endl;
+}
+
 template <typename T>
 void create_disk_layout(const std::string base_file, const std::string mem_index_file, const std::string output_file,
-                        const std::string reorder_data_file)
+                        const std::string reorder_data_file, const bool locality_layout, const bool packed_nhoods,
+                        const bool decoupled_layout, const std::vector<std::string> &stripe_dirs)
 {
     uint32_t npts, ndims;
 
@@ -867,6 +1016,9 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     uint32_t npts_reorder_file = 0, ndims_reorder_file = 0;
     if (reorder_data_file != std::string(""))
     {
+        if (decoupled_layout)
+            throw ANNException("Reorder data can not be appended to a decoupled layout", -1, __FUNCSIG__, __FILE__,
+                               __LINE__);
         append_reorder_data = true;
         size_t reorder_data_file_size = get_file_size(reorder_data_file);
         reorder_data_reader.exceptions(std::ofstream::failbit | std::ofstream::badbit);
@@ -920,7 +1072,30 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     medoid = (uint64_t)medoid_u32;
     if (vamana_frozen_num == 1)
         vamana_frozen_loc = medoid;
-    max_node_len = (((uint64_t)width_u32 + 1) * sizeof(uint32_t)) + (ndims_64 * sizeof(T));
+    uint64_t max_nhood_len = ((uint64_t)width_u32 + 1) * sizeof(uint32_t);
+    std::unique_ptr<uint32_t[]> nhood_buf = std::make_unique<uint32_t[]>(width_u32);
+    if (packed_nhoods)
+    {
+        // one pass over the graph to size nodes by their longest packed list
+        auto graph_start = vamana_reader.tellg();
+        max_nhood_len = 0;
+        for (uint64_t i = 0; i < npts_64; i++)
+        {
+            uint32_t nnbrs;
+            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
+            vamana_reader.read((char *)nhood_buf.get(), (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+            if (nnbrs > width_u32)
+            {
+                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
+            }
+            max_nhood_len =
+                (std::max)(max_nhood_len, packed_nhood_size(nhood_buf.get(), (std::min)(nnbrs, width_u32)));
+        }
+        vamana_reader.seekg(graph_start);
+    }
+    // with a decoupled layout the coords go to the vector region instead
+    uint64_t node_coords_len = decoupled_layout ? 0 : ndims_64 * sizeof(T);
+    max_node_len = max_nhood_len + node_coords_len;
     nnodes_per_sector = defaults::SECTOR_LEN / max_node_len; // 0 if max_node_len > SECTOR_LEN
 
     diskann::cout << "medoid: " << medoid << "B" << std::endl;
@@ -931,8 +1106,7 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     std::unique_ptr<char[]> sector_buf = std::make_unique<char[]>(defaults::SECTOR_LEN);
     std::unique_ptr<char[]> multisector_buf = std::make_unique<char[]>(ROUND_UP(max_node_len, defaults::SECTOR_LEN));
     std::unique_ptr<char[]> node_buf = std::make_unique<char[]>(max_node_len);
-    uint32_t &nnbrs = *(uint32_t *)(node_buf.get() + ndims_64 * sizeof(T));
-    uint32_t *nhood_buf = (uint32_t *)(node_buf.get() + (ndims_64 * sizeof(T)) + sizeof(uint32_t));
+    uint32_t nnbrs = 0;
 
     // number of sectors (1 for meta data)
     uint64_t n_sectors = nnodes_per_sector > 0 ? ROUND_UP(npts_64, nnodes_per_sector) / nnodes_per_sector
@@ -945,7 +1119,20 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
         n_data_nodes_per_sector = defaults::SECTOR_LEN / (ndims_reorder_file * sizeof(float));
         n_reorder_sectors = ROUND_UP(npts_64, n_data_nodes_per_sector) / n_data_nodes_per_sector;
     }
-    uint64_t disk_index_file_size = (n_sectors + n_reorder_sectors + 1) * defaults::SECTOR_LEN;
+
+    // vector region of a decoupled layout; a vector longer than a sector
+    // takes whole sectors of its own, as nodes do
+    uint64_t vec_len = ndims_64 * sizeof(T);
+    uint64_t nvecs_per_sector = 0, n_vector_sectors = 0;
+    if (decoupled_layout)
+    {
+        nvecs_per_sector = defaults::SECTOR_LEN / vec_len;
+        n_vector_sectors = nvecs_per_sector > 0 ? ROUND_UP(npts_64, nvecs_per_sector) / nvecs_per_sector
+                                                : npts_64 * DIV_ROUND_UP(vec_len, defaults::SECTOR_LEN);
+        diskann::cout << "nvecs_per_sector: " << nvecs_per_sector << ", # vector sectors: " << n_vector_sectors
+                      << std::endl;
+    }
+    uint64_t disk_index_file_size = (n_sectors + n_reorder_sectors + n_vector_sectors + 1) * defaults::SECTOR_LEN;
 
     std::vector<uint64_t> output_file_meta;
     output_file_meta.push_back(npts_64);
@@ -963,10 +1150,146 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
         output_file_meta.push_back(n_data_nodes_per_sector);
     }
     output_file_meta.push_back(disk_index_file_size);
+    output_file_meta.push_back((locality_layout ? defaults::DISK_LAYOUT_PERMUTED : 0) |
+                               (packed_nhoods ? defaults::DISK_LAYOUT_PACKED_NHOODS : 0) |
+                               (decoupled_layout ? defaults::DISK_LAYOUT_DECOUPLED : 0));
+    if (packed_nhoods)
+    {
+        output_file_meta.push_back(width_u32);
+    }
+    if (decoupled_layout)
+    {
+        output_file_meta.push_back(n_sectors + 1);
+        output_file_meta.push_back(nvecs_per_sector);
+    }
 
-    diskann_writer.write(sector_buf.get(), defaults::SECTOR_LEN);
+    // with a locality-aware layout only the order and the permutation are
+    // kept in memory; the nodes of each batch of positions are read by id,
+    // in id order, from the graph and base files
+    std::vector<uint32_t> layout_order;
+    std::vector<uint64_t> layout_nhood_offsets;
+    std::ifstream layout_nhood_reader, layout_base_reader;
+    uint64_t layout_batch_size = 0, layout_batch_start = 0, layout_batch_end = 0;
+    std::vector<uint32_t> layout_batch_nbrs, layout_batch_nnbrs;
+    std::vector<T> layout_batch_coords;
+    std::vector<uint64_t> layout_batch_by_id;
+    if (locality_layout)
+    {
+        layout_order = get_locality_layout_order(mem_index_file, medoid_u32);
+        {
+            std::vector<uint32_t> layout_perm(npts_64);
+            for (uint64_t pos = 0; pos < npts_64; pos++)
+            {
+                layout_perm[layout_order[pos]] = (uint32_t)pos;
+            }
+            diskann::save_bin<uint32_t>(output_file + "_layout_perm.bin", layout_perm.data(), npts_64, 1);
+        }
+
+        layout_nhood_offsets.resize(npts_64);
+        uint64_t offset = vamana_reader.tellg();
+        for (uint64_t i = 0; i < npts_64; i++)
+        {
+            layout_nhood_offsets[i] = offset;
+            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
+            vamana_reader.seekg(nnbrs * sizeof(uint32_t), vamana_reader.cur);
+            offset += ((uint64_t)nnbrs + 1) * sizeof(uint32_t);
+        }
+
+        // unbuffered, so that each read fetches one node only
+        for (auto reader : {&layout_nhood_reader, &layout_base_reader})
+        {
+            reader->rdbuf()->pubsetbuf(nullptr, 0);
+            reader->exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        }
+        layout_nhood_reader.open(mem_index_file, std::ios::binary);
+        layout_base_reader.open(base_file, std::ios::binary);
+        layout_batch_size = (std::max)((uint64_t)1, (uint64_t)read_blk_size / (ndims_64 * sizeof(T) +
+                                                                             (width_u32 + 1) * sizeof(uint32_t)));
+        layout_batch_nbrs.resize(layout_batch_size * width_u32);
+        layout_batch_nnbrs.resize(layout_batch_size);
+        layout_batch_coords.resize(decoupled_layout ? 0 : layout_batch_size * ndims_64);
+    }
+
+    // reads the neighbors, and the coords unless the layout is decoupled, of
+    // the nodes at positions [start, start + layout_batch_size)
+    auto read_layout_batch = [&](uint64_t start) {
+        layout_batch_start = start;
+        layout_batch_end = (std::min)(npts_64, start + layout_batch_size);
+        layout_batch_by_id.resize(layout_batch_end - start);
+        std::iota(layout_batch_by_id.begin(), layout_batch_by_id.end(), (uint64_t)0);
+        std::sort(layout_batch_by_id.begin(), layout_batch_by_id.end(),
+                  [&](uint64_t a, uint64_t b) { return layout_order[start + a] < layout_order[start + b]; });
+        for (auto i : layout_batch_by_id)
+        {
+            uint64_t id = layout_order[start + i];
+            uint32_t id_nnbrs;
+            layout_nhood_reader.seekg(layout_nhood_offsets[id], std::ios::beg);
+            layout_nhood_reader.read((char *)&id_nnbrs, sizeof(uint32_t));
+            layout_batch_nnbrs[i] = (std::min)(id_nnbrs, width_u32);
+            layout_nhood_reader.read((char *)(layout_batch_nbrs.data() + i * width_u32),
+                                     layout_batch_nnbrs[i] * sizeof(uint32_t));
+            if (!decoupled_layout)
+            {
+                layout_base_reader.seekg(2 * sizeof(uint32_t) + id * ndims_64 * sizeof(T), std::ios::beg);
+                layout_base_reader.read((char *)(layout_batch_coords.data() + i * ndims_64), ndims_64 * sizeof(T));
+            }
+        }
+    };
 
+    // fills node_dst with [coords][nnbrs][nbrs] of the node at position pos
+    // of the layout, or just [nnbrs][nbrs] with a decoupled layout; with the
+    // id order layout nodes are streamed in
     std::unique_ptr<T[]> cur_node_coords = std::make_unique<T[]>(ndims_64);
+    auto fill_node = [&](uint64_t pos, char *node_dst) {
+        if (locality_layout)
+        {
+            if (pos >= layout_batch_end)
+                read_layout_batch(pos);
+            uint64_t i = pos - layout_batch_start;
+            nnbrs = layout_batch_nnbrs[i];
+            memcpy(nhood_buf.get(), layout_batch_nbrs.data() + i * width_u32, nnbrs * sizeof(uint32_t));
+            if (!decoupled_layout)
+                memcpy(cur_node_coords.get(), layout_batch_coords.data() + i * ndims_64, ndims_64 * sizeof(T));
+        }
+        else
+        {
+            // read cur node's nnbrs
+            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
+
+            // sanity checks on nnbrs
+            assert(nnbrs > 0);
+            assert(nnbrs <= width_u32);
+
+            // read node's nhood
+            vamana_reader.read((char *)nhood_buf.get(), (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+            if (nnbrs > width_u32)
+            {
+                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
+            }
+
+            // write coords of node first
+            //  T *node_coords = data + ((uint64_t) ndims_64 * cur_node_id);
+            if (!decoupled_layout)
+                base_reader.read((char *)cur_node_coords.get(), sizeof(T) * ndims_64);
+        }
+        memcpy(node_dst, cur_node_coords.get(), node_coords_len);
+
+        char *nhood_dst = node_dst + node_coords_len;
+        if (packed_nhoods)
+        {
+            pack_nhood(nhood_buf.get(), (std::min)(nnbrs, width_u32), nhood_dst);
+            return;
+        }
+
+        // write nnbrs
+        *(uint32_t *)nhood_dst = (std::min)(nnbrs, width_u32);
+
+        // write nhood next
+        memcpy(nhood_dst + sizeof(uint32_t), nhood_buf.get(), (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+    };
+
+    diskann_writer.write(sector_buf.get(), defaults::SECTOR_LEN);
+
     diskann::cout << "# sectors: " << n_sectors << std::endl;
     uint64_t cur_node_id = 0;
 
@@ -983,31 +1306,7 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
                  sector_node_id++)
             {
                 memset(node_buf.get(), 0, max_node_len);
-                // read cur node's nnbrs
-                vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
-
-                // sanity checks on nnbrs
-                assert(nnbrs > 0);
-                assert(nnbrs <= width_u32);
-
-                // read node's nhood
-                vamana_reader.read((char *)nhood_buf, (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
-                if (nnbrs > width_u32)
-                {
-                    vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
-                }
-
-                // write coords of node first
-                //  T *node_coords = data + ((uint64_t) ndims_64 * cur_node_id);
-                base_reader.read((char *)cur_node_coords.get(), sizeof(T) * ndims_64);
-                memcpy(node_buf.get(), cur_node_coords.get(), ndims_64 * sizeof(T));
-
-                // write nnbrs
-                *(uint32_t *)(node_buf.get() + ndims_64 * sizeof(T)) = (std::min)(nnbrs, width_u32);
-
-                // write nhood next
-                memcpy(node_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
-                       (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+                fill_node(cur_node_id, node_buf.get());
 
                 // get offset into sector_buf
                 char *sector_node_buf = sector_buf.get() + (sector_node_id * max_node_len);
@@ -1032,31 +1331,7 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
             memset(multisector_buf.get(), 0, nsectors_per_node * defaults::SECTOR_LEN);
 
             memset(node_buf.get(), 0, max_node_len);
-            // read cur node's nnbrs
-            vamana_reader.read((char *)&nnbrs, sizeof(uint32_t));
-
-            // sanity checks on nnbrs
-            assert(nnbrs > 0);
-            assert(nnbrs <= width_u32);
-
-            // read node's nhood
-            vamana_reader.read((char *)nhood_buf, (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
-            if (nnbrs > width_u32)
-            {
-                vamana_reader.seekg((nnbrs - width_u32) * sizeof(uint32_t), vamana_reader.cur);
-            }
-
-            // write coords of node first
-            //  T *node_coords = data + ((uint64_t) ndims_64 * cur_node_id);
-            base_reader.read((char *)cur_node_coords.get(), sizeof(T) * ndims_64);
-            memcpy(multisector_buf.get(), cur_node_coords.get(), ndims_64 * sizeof(T));
-
-            // write nnbrs
-            *(uint32_t *)(multisector_buf.get() + ndims_64 * sizeof(T)) = (std::min)(nnbrs, width_u32);
-
-            // write nhood next
-            memcpy(multisector_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
-                   (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
+            fill_node(i, multisector_buf.get());
 
             // flush sector to disk
             diskann_writer.write(multisector_buf.get(), nsectors_per_node * defaults::SECTOR_LEN);
@@ -1092,9 +1367,30 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
             diskann_writer.write(sector_buf.get(), defaults::SECTOR_LEN);
         }
     }
+
+    if (decoupled_layout)
+    {
+        diskann::cout << "Graph written. Writing vectors..." << std::endl;
+
+        // base_reader is still at the first vector, since the nodes of a
+        // decoupled layout hold no coords
+        uint64_t vecs_per_write = nvecs_per_sector > 0 ? nvecs_per_sector : 1;
+        uint64_t write_len = nvecs_per_sector > 0 ? defaults::SECTOR_LEN : ROUND_UP(vec_len, defaults::SECTOR_LEN);
+        std::unique_ptr<char[]> vec_sector_buf = std::make_unique<char[]>(write_len);
+        for (uint64_t id = 0; id < npts_64; id += vecs_per_write)
+        {
+            memset(vec_sector_buf.get(), 0, write_len);
+            uint64_t n_vecs = (std::min)(vecs_per_write, npts_64 - id);
+            base_reader.read(vec_sector_buf.get(), n_vecs * vec_len);
+            diskann_writer.write(vec_sector_buf.get(), write_len);
+        }
+    }
     diskann_writer.close();
     diskann::save_bin<uint64_t>(output_file, output_file_meta.data(), output_file_meta.size(), 1, 0);
     diskann::cout << "Output disk index file written to " << output_file << std::endl;
+
+    if (!stripe_dirs.empty())
+        stripe_disk_index(output_file, stripe_dirs);
 }
 
 template <typename T, typename LabelT>
@@ -1111,7 +1407,7 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
     {
         param_list.push_back(cur_param);
     }
-    if (param_list.size() < 5 || param_list.size() > 9)
+    if (param_list.size() < 5 || param_list.size() > 14)
     {
         diskann::cout << "Correct usage of parameters is R (max degree)\n"
                          "L (indexing list size, better if >= R)\n"
@@ -1125,6 +1421,16 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
                          "build_PQ_byte (number of PQ bytes for inde build; set 0 to use "
                          "full precision vectors)\n"
                          "QD Quantized Dimension to overwrite the derived dim from B "
+                         "\nlocality_layout (set 1 to write nodes in BFS order so that "
+                         "neighbors share sectors: optional parameter)"
+                         "\npacked_nhoods (set 1 to store neighbor lists sorted and "
+                         "delta encoded: optional parameter)"
+                         "\ndecoupled_layout (set 1 to store the graph and the full precision "
+                         "vectors in separate regions: optional parameter)"
+                         "\npq_4bit (set 1 to use 16 centers per PQ chunk, two chunks per "
+                         "byte: optional parameter)"
+                         "\nstripe_dirs (comma separated directories to split the disk index "
+                         "file over, one per device: optional parameter)"
                       << std::endl;
         return -1;
     }
@@ -1168,6 +1474,48 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
         build_pq_bytes = atoi(param_list[7].c_str());
     }
 
+    bool locality_layout = false;
+    if (param_list.size() >= 10 && 1 == atoi(param_list[9].c_str()))
+    {
+        locality_layout = true;
+    }
+
+    bool packed_nhoods = false;
+    if (param_list.size() >= 11 && 1 == atoi(param_list[10].c_str()))
+    {
+        packed_nhoods = true;
+    }
+
+    bool decoupled_layout = false;
+    if (param_list.size() >= 12 && 1 == atoi(param_list[11].c_str()))
+    {
+        decoupled_layout = true;
+    }
+    bool pq_4bit = false;
+    if (param_list.size() >= 13 && 1 == atoi(param_list[12].c_str()))
+    {
+        pq_4bit = true;
+    }
+    std::vector<std::string> stripe_dirs;
+    if (param_list.size() >= 14)
+    {
+        std::istringstream iss(param_list[13]);
+        std::string token;
+        while (std::getline(iss, token, ','))
+        {
+            if (!token.empty())
+                stripe_dirs.push_back(token);
+        }
+    }
+
+    if (decoupled_layout && use_disk_pq)
+    {
+        diskann::cerr << "A decoupled layout stores full precision vectors and can not be used with disk PQ; use "
+                         "reorder data instead."
+                      << std::endl;
+        return -1;
+    }
+
     std::string base_file(dataFilePath);
     std::string data_file_to_use = base_file;
     std::string labels_file_original = label_file;
@@ -1295,6 +1643,8 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
                                         compareMetric, p_val, disk_pq_dims);
     }
     size_t num_pq_chunks = (size_t)(std::floor)(uint64_t(final_index_ram_limit / points_num));
+    if (pq_4bit)
+        num_pq_chunks *= 2;
 
     num_pq_chunks = num_pq_chunks <= 0 ? 1 : num_pq_chunks;
     num_pq_chunks = num_pq_chunks > dim ? dim : num_pq_chunks;
@@ -1308,11 +1658,12 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
         num_pq_chunks = atoi(param_list[8].c_str());
     }
 
-    diskann::cout << "Compressing " << dim << "-dimensional data into " << num_pq_chunks << " bytes per vector."
-                  << std::endl;
+    diskann::cout << "Compressing " << dim << "-dimensional data into " << num_pq_chunks
+                  << (pq_4bit ? " 4-bit chunks per vector." : " bytes per vector.") << std::endl;
 
     generate_quantized_data<T>(data_file_to_use, pq_pivots_path, pq_compressed_vectors_path, compareMetric, p_val,
-                               num_pq_chunks, use_opq, codebook_prefix);
+                               num_pq_chunks, use_opq, codebook_prefix,
+                               pq_4bit ? NUM_PQ_CENTROIDS_4BIT : NUM_PQ_CENTROIDS);
     diskann::cout << timer.elapsed_seconds_for_step("generating quantized data") << std::endl;
 
 // Gopal. Splitting diskann_dll into separate DLLs for search and build.
@@ -1331,15 +1682,18 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
     timer.reset();
     if (!use_disk_pq)
     {
-        diskann::create_disk_layout<T>(data_file_to_use.c_str(), mem_index_path, disk_index_path);
+        diskann::create_disk_layout<T>(data_file_to_use.c_str(), mem_index_path, disk_index_path, "",
+                                       locality_layout, packed_nhoods, decoupled_layout, stripe_dirs);
     }
     else
     {
         if (!reorder_data)
-            diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path);
+            diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path, "",
+                                                 locality_layout, packed_nhoods, false, stripe_dirs);
         else
             diskann::create_disk_layout<uint8_t>(disk_pq_compressed_vectors_path, mem_index_path, disk_index_path,
-                                                 data_file_to_use.c_str());
+                                                 data_file_to_use.c_str(), locality_layout, packed_nhoods, false,
+                                                 stripe_dirs);
     }
     diskann::cout << timer.elapsed_seconds_for_step("generating disk layout") << std::endl;
 
@@ -1379,14 +1733,23 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
 template DISKANN_DLLEXPORT void create_disk_layout<int8_t>(const std::string base_file,
                                                            const std::string mem_index_file,
                                                            const std::string output_file,
-                                                           const std::string reorder_data_file);
+                                                           const std::string reorder_data_file,
+                                                           const bool locality_layout, const bool packed_nhoods,
+                                                           const bool decoupled_layout,
+                                                           const std::vector<std::string> &stripe_dirs);
 template DISKANN_DLLEXPORT void create_disk_layout<uint8_t>(const std::string base_file,
                                                             const std::string mem_index_file,
                                                             const std::string output_file,
-                                                            const std::string reorder_data_file);
+                                                            const std::string reorder_data_file,
+                                                            const bool locality_layout, const bool packed_nhoods,
+                                                            const bool decoupled_layout,
+                                                            const std::vector<std::string> &stripe_dirs);
 template DISKANN_DLLEXPORT void create_disk_layout<float>(const std::string base_file, const std::string mem_index_file,
                                                           const std::string output_file,
-                                                          const std::string reorder_data_file);
+                                                          const std::string reorder_data_file,
+                                                          const bool locality_layout, const bool packed_nhoods,
+                                                          const bool decoupled_layout,
+                                                          const std::vector<std::string> &stripe_dirs);
 
 template DISKANN_DLLEXPORT int8_t *load_warmup<int8_t>(const std::string &cache_warmup_file, uint64_t &warmup_num,
                                                        uint64_t warmup_dim, uint64_t warmup_aligned_dim);
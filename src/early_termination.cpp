@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "early_termination.h"
+#include "utils.h"
+
+namespace diskann
+{
+EarlyTermination::EarlyTermination(uint64_t k, uint32_t patience_hops, float converge_ratio)
+    : _k(k), _patience_hops(patience_hops), _converge_ratio(converge_ratio)
+{
+}
+
+bool EarlyTermination::enabled() const
+{
+    return _patience_hops > 0 || _converge_ratio > 0;
+}
+
+bool EarlyTermination::should_stop(const std::vector<Neighbor> &full_retset, const NeighborPriorityQueue &retset)
+{
+    bool improved = false;
+    for (; _num_folded < full_retset.size(); _num_folded++)
+    {
+        float dist = full_retset[_num_folded].distance;
+        if (_topk.size() < _k)
+        {
+            _topk.push(dist);
+            improved = true;
+        }
+        else if (dist < _topk.top())
+        {
+            _topk.pop();
+            _topk.push(dist);
+            improved = true;
+        }
+    }
+    _stale_hops = improved ? 0 : _stale_hops + 1;
+
+    // nothing to judge convergence by until there are k results
+    if (_topk.size() < _k)
+        return false;
+
+    if (_patience_hops > 0 && _stale_hops >= _patience_hops)
+        return true;
+
+    // the ratio only makes sense for non-negative (L2-like) distances
+    float kth_dist = _topk.top();
+    return _converge_ratio > 0 && kth_dist > 0 && retset.has_unexpanded_node() &&
+           retset.closest_unexpanded_distance() > _converge_ratio * kth_dist;
+}
+
+uint32_t EarlyTermination::estimate_hops_left(const NeighborPriorityQueue &retset, uint64_t beam_width)
+{
+    return (uint32_t)DIV_ROUND_UP(retset.num_unexpanded(), beam_width);
+}
+} // namespace diskann
@@ -0,0 +1,246 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "in_mem_fixed_degree_graph_store.h"
+#include "locking.h"
+#include "utils.h"
+
+namespace diskann
+{
+InMemFixedDegreeGraphStore::InMemFixedDegreeGraphStore(const size_t total_pts, const size_t reserve_graph_degree)
+    : AbstractGraphStore(total_pts, reserve_graph_degree)
+{
+    reshape(total_pts, reserve_graph_degree);
+}
+
+InMemFixedDegreeGraphStore::~InMemFixedDegreeGraphStore()
+{
+    aligned_free(_rows);
+}
+
+void InMemFixedDegreeGraphStore::reshape(const size_t num_points, const size_t max_degree)
+{
+    assert(max_degree >= _max_degree || _rows == nullptr);
+    // rows are padded to a multiple of 64 bytes, so that each starts on a
+    // cache line
+    size_t row_slots = ROUND_UP(max_degree + 1, 64 / sizeof(uint32_t));
+    size_t num_bytes = (std::max)((size_t)ROUND_UP(num_points * row_slots * sizeof(uint32_t), 64), (size_t)64);
+
+    uint32_t *rows = nullptr;
+    alloc_aligned((void **)&rows, num_bytes, 64);
+    std::memset(rows, 0, num_bytes);
+    if (_rows != nullptr)
+    {
+        size_t num_kept = (std::min)(num_points, get_total_points());
+        if (row_slots == _row_slots)
+            std::memcpy(rows, _rows, num_kept * row_slots * sizeof(uint32_t));
+        else
+            for (size_t i = 0; i < num_kept; i++)
+                std::memcpy(rows + i * row_slots, row((location_t)i), (row((location_t)i)[0] + 1) * sizeof(uint32_t));
+        aligned_free(_rows);
+    }
+
+    _rows = rows;
+    _max_degree = max_degree;
+    _row_slots = row_slots;
+    set_total_points(num_points);
+}
+
+std::tuple<uint32_t, uint32_t, size_t> InMemFixedDegreeGraphStore::load(const std::string &index_path_prefix,
+                                                                        const size_t num_points)
+{
+    size_t expected_file_size;
+    size_t file_frozen_pts;
+    uint32_t start;
+
+    std::ifstream in;
+    in.exceptions(std::ios::badbit | std::ios::failbit);
+    in.open(index_path_prefix, std::ios::binary);
+    in.read((char *)&expected_file_size, sizeof(size_t));
+    in.read((char *)&_max_observed_degree, sizeof(uint32_t));
+    in.read((char *)&start, sizeof(uint32_t));
+    in.read((char *)&file_frozen_pts, sizeof(size_t));
+    size_t vamana_metadata_size = sizeof(size_t) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(size_t);
+
+    diskann::cout << "From graph header, expected_file_size: " << expected_file_size
+                  << ", _max_observed_degree: " << _max_observed_degree << ", _start: " << start
+                  << ", file_frozen_pts: " << file_frozen_pts << std::endl;
+
+    // the header holds the largest degree in the file, so the rows can be
+    // sized before reading them
+    if (get_total_points() < num_points || _max_degree < _max_observed_degree)
+    {
+        diskann::cout << "resizing graph to " << (std::max)(get_total_points(), num_points) << " rows of "
+                      << (std::max)(_max_degree, (size_t)_max_observed_degree) << " neighbours" << std::endl;
+        reshape((std::max)(get_total_points(), num_points), (std::max)(_max_degree, (size_t)_max_observed_degree));
+    }
+
+    diskann::cout << "Loading vamana graph " << index_path_prefix << "..." << std::flush;
+
+    size_t bytes_read = vamana_metadata_size;
+    size_t cc = 0;
+    uint32_t nodes_read = 0;
+    while (bytes_read != expected_file_size)
+    {
+        uint32_t k;
+        in.read((char *)&k, sizeof(uint32_t));
+        if (k > _max_degree || nodes_read >= get_total_points())
+        {
+            std::stringstream stream;
+            stream << "Graph file " << index_path_prefix << " has more nodes or a higher degree than its header "
+                   << "allows, at point#" << nodes_read << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+
+        if (k == 0)
+        {
+            diskann::cerr << "ERROR: Point found with no out-neighbours, point#" << nodes_read << std::endl;
+        }
+
+        uint32_t *r = row(nodes_read);
+        r[0] = k;
+        in.read((char *)(r + 1), k * sizeof(uint32_t));
+        cc += k;
+        ++nodes_read;
+        bytes_read += sizeof(uint32_t) * ((size_t)k + 1);
+        if (nodes_read % 10000000 == 0)
+            diskann::cout << "." << std::flush;
+        if (k > _max_range_of_graph)
+        {
+            _max_range_of_graph = k;
+        }
+    }
+
+    diskann::cout << "done. Index has " << nodes_read << " nodes and " << cc << " out-edges, _start is set to " << start
+                  << std::endl;
+    diskann::cout << "Graph rows take " << (get_total_points() * _row_slots * sizeof(uint32_t)) / (1024 * 1024)
+                  << "MB" << std::endl;
+    return std::make_tuple(nodes_read, start, file_frozen_pts);
+}
+
+int InMemFixedDegreeGraphStore::store(const std::string &index_path_prefix, const size_t num_points,
+                                      const size_t num_frozen_points, const uint32_t start)
+{
+    std::ofstream out;
+    open_file_to_write(out, index_path_prefix);
+
+    size_t file_offset = 0;
+    out.seekp(file_offset, out.beg);
+    size_t index_size = 24;
+    uint32_t max_degree = 0;
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&_max_observed_degree, sizeof(uint32_t));
+    uint32_t ep_u32 = start;
+    out.write((char *)&ep_u32, sizeof(uint32_t));
+    out.write((char *)&num_frozen_points, sizeof(size_t));
+
+    // the file has the layout of InMemGraphStore: the degree of each node
+    // followed by its neighbours, which is a row without its unused slots
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        const uint32_t *r = row(i);
+        out.write((char *)r, (r[0] + 1) * sizeof(uint32_t));
+        max_degree = r[0] > max_degree ? r[0] : max_degree;
+        index_size += (size_t)(sizeof(uint32_t) * (r[0] + 1));
+    }
+    out.seekp(file_offset, out.beg);
+    out.write((char *)&index_size, sizeof(uint64_t));
+    out.write((char *)&max_degree, sizeof(uint32_t));
+    out.close();
+    return (int)index_size;
+}
+
+NeighbourList InMemFixedDegreeGraphStore::get_neighbours(const location_t i) const
+{
+    assert(i < get_total_points());
+    const uint32_t *r = row(i);
+    return NeighbourList(r + 1, r[0]);
+}
+
+// A reader may copy a row while the writer holding its lock changes it. Both
+// sides access the row with atomic loads and stores, which cost the same as
+// plain ones, so that this is not undefined behaviour; the reader detects
+// a torn copy through the version of the lock.
+void InMemFixedDegreeGraphStore::copy_neighbours(const location_t i, std::vector<location_t> &neighbours) const
+{
+    assert(i < get_total_points());
+    const uint32_t *r = row(i);
+    size_t degree = (std::min)((size_t)relaxed_load(r), _max_degree);
+    neighbours.resize(degree);
+    for (size_t j = 0; j < degree; j++)
+        neighbours[j] = relaxed_load(r + 1 + j);
+}
+
+void InMemFixedDegreeGraphStore::add_neighbour(const location_t i, location_t neighbour_id)
+{
+    uint32_t *r = row(i);
+    uint32_t degree = r[0];
+    if (degree >= _max_degree)
+        throw diskann::ANNException("Cannot add a neighbour to point " + std::to_string(i) + ", which already has " +
+                                        std::to_string(_max_degree) + ", the most its row holds",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+    relaxed_store(r + degree + 1, neighbour_id);
+    relaxed_store(r, degree + 1);
+    if (_max_observed_degree < degree + 1)
+    {
+        _max_observed_degree = degree + 1;
+    }
+}
+
+void InMemFixedDegreeGraphStore::clear_neighbours(const location_t i)
+{
+    relaxed_store(row(i), 0);
+}
+
+void InMemFixedDegreeGraphStore::swap_neighbours(const location_t a, location_t b)
+{
+    uint32_t *ra = row(a), *rb = row(b);
+    uint32_t slots = (std::max)(ra[0], rb[0]) + 1;
+    for (uint32_t j = 0; j < slots; j++)
+    {
+        uint32_t tmp = ra[j];
+        relaxed_store(ra + j, rb[j]);
+        relaxed_store(rb + j, tmp);
+    }
+}
+
+void InMemFixedDegreeGraphStore::set_neighbours(const location_t i, std::vector<location_t> &neighbours)
+{
+    if (neighbours.size() > _max_degree)
+        throw diskann::ANNException("Cannot set " + std::to_string(neighbours.size()) + " neighbours of point " +
+                                        std::to_string(i) + ", whose row holds " + std::to_string(_max_degree),
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+    uint32_t *r = row(i);
+    for (size_t j = 0; j < neighbours.size(); j++)
+        relaxed_store(r + 1 + j, neighbours[j]);
+    relaxed_store(r, (uint32_t)neighbours.size());
+    if (_max_observed_degree < neighbours.size())
+    {
+        _max_observed_degree = (uint32_t)(neighbours.size());
+    }
+}
+
+size_t InMemFixedDegreeGraphStore::resize_graph(const size_t new_size)
+{
+    reshape(new_size, _max_degree);
+    return new_size;
+}
+
+void InMemFixedDegreeGraphStore::clear_graph()
+{
+    aligned_free(_rows);
+    _rows = nullptr;
+    set_total_points(0);
+}
+
+size_t InMemFixedDegreeGraphStore::get_max_range_of_graph()
+{
+    return _max_range_of_graph;
+}
+
+uint32_t InMemFixedDegreeGraphStore::get_max_observed_degree()
+{
+    return _max_observed_degree;
+}
+
+} // namespace diskann
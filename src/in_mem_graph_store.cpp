@@ -26,7 +26,7 @@ int InMemGraphStore::store(const std::string &index_path_prefix, const size_t nu
 {
     return save_graph(index_path_prefix, num_points, num_frozen_points, start);
 }
-const std::vector<location_t> &InMemGraphStore::get_neighbours(const location_t i) const
+NeighbourList InMemGraphStore::get_neighbours(const location_t i) const
 {
     return _graph.at(i);
 }
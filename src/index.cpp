@@ -8,6 +8,7 @@
 #include "boost/dynamic_bitset.hpp"
 #include "index_factory.h"
 #include "memory_mapper.h"
+#include "query_metrics.h"
 #include "timer.h"
 #include "tsl/robin_map.h"
 #include "tsl/robin_set.h"
@@ -23,8 +24,6 @@
 
 #include "index.h"
 
-#define MAX_POINTS_FOR_USING_BITSET 10000000
-
 namespace diskann
 {
 // Initialize an index with metric m, load the data of type T with filename
@@ -38,7 +37,8 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::shared_ptr<A
       _enable_tags(index_config.enable_tags), _indexingMaxC(DEFAULT_MAXC), _query_scratch(nullptr),
       _pq_dist(index_config.pq_dist_build), _use_opq(index_config.use_opq),
       _filtered_index(index_config.filtered_index), _num_pq_chunks(index_config.num_pq_chunks),
-      _delete_set(new tsl::robin_set<uint32_t>), _conc_consolidate(index_config.concurrent_consolidate)
+      _delete_set(new tsl::robin_set<uint32_t>), _conc_consolidate(index_config.concurrent_consolidate),
+      _visited_policy(index_config.visited_set_policy)
 {
     if (_dynamic_index && !_enable_tags)
     {
@@ -76,7 +76,8 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::shared_ptr<A
     _pq_data_store = pq_data_store;
     _graph_store = std::move(graph_store);
 
-    _locks = std::vector<non_recursive_mutex>(total_internal_points);
+    _locks = std::vector<versioned_spinlock>(total_internal_points);
+    _lock_free_reads = _graph_store->supports_lock_free_reads();
     if (_enable_tags)
     {
         _location_to_tag.reserve(total_internal_points);
@@ -166,7 +167,7 @@ template <typename T, typename TagT, typename LabelT> Index<T, TagT, LabelT>::~I
 
     for (auto &lock : _locks)
     {
-        LockGuard lg(lock);
+        VersionedLockGuard lg(lock);
     }
 
     if (_opt_graph != nullptr)
@@ -811,8 +812,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     std::vector<Neighbor> &expanded_nodes = scratch->pool();
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
     best_L_nodes.reserve(Lsize);
-    tsl::robin_set<uint32_t> &inserted_into_pool_rs = scratch->inserted_into_pool_rs();
-    boost::dynamic_bitset<> &inserted_into_pool_bs = scratch->inserted_into_pool_bs();
+    VisitedSet &inserted_into_pool = scratch->inserted_into_pool();
     std::vector<uint32_t> &id_scratch = scratch->id_scratch();
     std::vector<float> &dist_scratch = scratch->dist_scratch();
     assert(id_scratch.size() == 0);
@@ -828,26 +828,13 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
         throw ANNException("ERROR: Clear scratch space before passing.", -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    // Decide whether to use bitset or robin set to mark visited nodes
+    // Decide whether to use an epoch array, bitset or robin set to mark
+    // visited nodes. The index may have grown, so check it on every call.
     auto total_num_points = _max_points + _num_frozen_pts;
-    bool fast_iterate = total_num_points <= MAX_POINTS_FOR_USING_BITSET;
-
-    if (fast_iterate)
-    {
-        if (inserted_into_pool_bs.size() < total_num_points)
-        {
-            // hopefully using 2X will reduce the number of allocations.
-            auto resize_size =
-                2 * total_num_points > MAX_POINTS_FOR_USING_BITSET ? MAX_POINTS_FOR_USING_BITSET : 2 * total_num_points;
-            inserted_into_pool_bs.resize(resize_size);
-        }
-    }
+    inserted_into_pool.init(_visited_policy, total_num_points, 20 * (size_t)Lsize);
 
     // Lambda to determine if a node has been visited
-    auto is_not_visited = [this, fast_iterate, &inserted_into_pool_bs, &inserted_into_pool_rs](const uint32_t id) {
-        return fast_iterate ? inserted_into_pool_bs[id] == 0
-                            : inserted_into_pool_rs.find(id) == inserted_into_pool_rs.end();
-    };
+    auto is_not_visited = [&inserted_into_pool](const uint32_t id) { return !inserted_into_pool.contains(id); };
 
     // Lambda to batch compute query<-> node distances in PQ space
     auto compute_dists = [this, scratch, pq_dists](const std::vector<uint32_t> &ids, std::vector<float> &dists_out) {
@@ -872,14 +859,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
 
         if (is_not_visited(id))
         {
-            if (fast_iterate)
-            {
-                inserted_into_pool_bs[id] = 1;
-            }
-            else
-            {
-                inserted_into_pool_rs.insert(id);
-            }
+            inserted_into_pool.insert(id);
 
             float distance;
             uint32_t ids[] = {id};
@@ -895,6 +875,13 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     uint32_t hops = 0;
     uint32_t cmps = 0;
 
+    // a hop per expanded node, if the search is traced
+    std::vector<HopTrace> *hop_trace = search_invocation ? HopTraceScope::current() : nullptr;
+    Timer cpu_timer;
+
+    // copy of the neighbours of the expanded node
+    std::vector<location_t> nbrs;
+
     while (best_L_nodes.has_unexpanded_node())
     {
         auto nbr = best_L_nodes.closest_unexpanded();
@@ -921,71 +908,53 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
         // Find which of the nodes in des have not been visited before
         id_scratch.clear();
         dist_scratch.clear();
-        if (_dynamic_index)
+        copy_neighbours(n, nbrs);
+        for (auto id : nbrs)
         {
-            LockGuard guard(_locks[n]);
-            for (auto id : _graph_store->get_neighbours(n))
-            {
-                assert(id < _max_points + _num_frozen_pts);
-
-                if (use_filter)
-                {
-                    // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
-                    if (!detect_common_filters(id, search_invocation, filter_labels))
-                        continue;
-                }
+            assert(id < _max_points + _num_frozen_pts);
 
-                if (is_not_visited(id))
-                {
-                    id_scratch.push_back(id);
-                }
-            }
-        }
-        else
-        {
-            _locks[n].lock();
-            auto nbrs = _graph_store->get_neighbours(n);
-            _locks[n].unlock();
-            for (auto id : nbrs)
+            if (use_filter)
             {
-                assert(id < _max_points + _num_frozen_pts);
-
-                if (use_filter)
-                {
-                    // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
-                    if (!detect_common_filters(id, search_invocation, filter_labels))
-                        continue;
-                }
+                // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
+                if (!detect_common_filters(id, search_invocation, filter_labels))
+                    continue;
+            }
 
-                if (is_not_visited(id))
-                {
-                    id_scratch.push_back(id);
-                }
+            if (is_not_visited(id))
+            {
+                id_scratch.push_back(id);
             }
         }
 
         // Mark nodes visited
         for (auto id : id_scratch)
         {
-            if (fast_iterate)
-            {
-                inserted_into_pool_bs[id] = 1;
-            }
-            else
-            {
-                inserted_into_pool_rs.insert(id);
-            }
+            inserted_into_pool.insert(id);
         }
 
         assert(dist_scratch.capacity() >= id_scratch.size());
+        if (hop_trace != nullptr)
+            cpu_timer.reset();
         compute_dists(id_scratch, dist_scratch);
         cmps += (uint32_t)id_scratch.size();
 
+        HopTrace hop;
+        if (hop_trace != nullptr)
+        {
+            hop.frontier_size = 1;
+            hop.cpu_us = (float)cpu_timer.elapsed();
+        }
+
         // Insert <id, dist> pairs into the pool of candidates
         for (size_t m = 0; m < id_scratch.size(); ++m)
         {
+            if (hop_trace != nullptr && (best_L_nodes.size() < best_L_nodes.capacity() ||
+                                         dist_scratch[m] < best_L_nodes[best_L_nodes.size() - 1].distance))
+                hop.n_retset_inserts++;
             best_L_nodes.insert(Neighbor(id_scratch[m], dist_scratch[m]));
         }
+        if (hop_trace != nullptr)
+            hop_trace->push_back(hop);
     }
     return std::make_pair(hops, cmps);
 }
@@ -1212,6 +1181,28 @@ void Index<T, TagT, LabelT>::prune_neighbors(const uint32_t location, std::vecto
     }
 }
 
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::copy_neighbours(const location_t n, std::vector<uint32_t> &neighbours)
+{
+    if (!_lock_free_reads)
+    {
+        VersionedLockGuard guard(_locks[n]);
+        auto list = _graph_store->get_neighbours(n);
+        neighbours.assign(list.begin(), list.end());
+        return;
+    }
+
+    // the row of n does not move, so a writer can at worst make this copy
+    // torn, which the version check catches. The graph store copies it with
+    // atomic loads, as the writer may be storing to it meanwhile.
+    uint32_t version;
+    do
+    {
+        version = _locks[n].read_begin();
+        _graph_store->copy_neighbours(n, neighbours);
+    } while (_locks[n].read_retry(version));
+}
+
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pruned_list, const uint32_t range,
                                           InMemQueryScratch<T> *scratch)
@@ -1228,8 +1219,8 @@ void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pru
         std::vector<uint32_t> copy_of_neighbors;
         bool prune_needed = false;
         {
-            LockGuard guard(_locks[des]);
-            auto &des_pool = _graph_store->get_neighbours(des);
+            VersionedLockGuard guard(_locks[des]);
+            auto des_pool = _graph_store->get_neighbours(des);
             if (std::find(des_pool.begin(), des_pool.end(), n) == des_pool.end())
             {
                 if (des_pool.size() < (uint64_t)(defaults::GRAPH_SLACK_FACTOR * range))
@@ -1241,7 +1232,7 @@ void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pru
                 else
                 {
                     copy_of_neighbors.reserve(des_pool.size() + 1);
-                    copy_of_neighbors = des_pool;
+                    copy_of_neighbors.assign(des_pool.begin(), des_pool.end());
                     copy_of_neighbors.push_back(n);
                     prune_needed = true;
                 }
@@ -1269,7 +1260,7 @@ void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pru
             std::vector<uint32_t> new_out_neighbors;
             prune_neighbors(des, dummy_pool, new_out_neighbors, scratch);
             {
-                LockGuard guard(_locks[des]);
+                VersionedLockGuard guard(_locks[des]);
 
                 _graph_store->set_neighbours(des, new_out_neighbors);
             }
@@ -1333,7 +1324,7 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
         assert(pruned_list.size() > 0);
 
         {
-            LockGuard guard(_locks[node]);
+            VersionedLockGuard guard(_locks[node]);
 
             _graph_store->set_neighbours(node, pruned_list);
             assert(_graph_store->get_neighbours((location_t)node).size() <= _indexingRange);
@@ -1433,7 +1424,7 @@ void Index<T, TagT, LabelT>::prune_all_neighbors(const uint32_t max_degree, cons
     {
         if (i < _nd || i >= _max_points)
         {
-            const std::vector<uint32_t> &pool = _graph_store->get_neighbours((location_t)i);
+            auto pool = _graph_store->get_neighbours((location_t)i);
             max = (std::max)(max, pool.size());
             min = (std::min)(min, pool.size());
             total += pool.size();
@@ -1562,7 +1553,7 @@ void Index<T, TagT, LabelT>::build_with_data_populated(const std::vector<TagT> &
     size_t max = 0, min = SIZE_MAX, total = 0, cnt = 0;
     for (size_t i = 0; i < _nd; i++)
     {
-        auto &pool = _graph_store->get_neighbours((location_t)i);
+        auto pool = _graph_store->get_neighbours((location_t)i);
         max = std::max(max, pool.size());
         min = std::min(min, pool.size());
         total += pool.size();
@@ -2324,10 +2315,11 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
     std::vector<uint32_t> adj_list;
     {
         // Acquire and release lock[loc] before acquiring locks for neighbors
-        std::unique_lock<non_recursive_mutex> adj_list_lock;
+        std::unique_lock<versioned_spinlock> adj_list_lock;
         if (_conc_consolidate)
-            adj_list_lock = std::unique_lock<non_recursive_mutex>(_locks[loc]);
-        adj_list = _graph_store->get_neighbours((location_t)loc);
+            adj_list_lock = std::unique_lock<versioned_spinlock>(_locks[loc]);
+        auto neighbours = _graph_store->get_neighbours((location_t)loc);
+        adj_list.assign(neighbours.begin(), neighbours.end());
     }
 
     bool modify = false;
@@ -2341,9 +2333,9 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
         {
             modify = true;
 
-            std::unique_lock<non_recursive_mutex> ngh_lock;
+            std::unique_lock<versioned_spinlock> ngh_lock;
             if (_conc_consolidate)
-                ngh_lock = std::unique_lock<non_recursive_mutex>(_locks[ngh]);
+                ngh_lock = std::unique_lock<versioned_spinlock>(_locks[ngh]);
             for (auto j : _graph_store->get_neighbours((location_t)ngh))
                 if (j != loc && old_delete_set.find(j) == old_delete_set.end())
                     expanded_nodes_set.insert(j);
@@ -2354,7 +2346,7 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
     {
         if (expanded_nodes_set.size() <= range)
         {
-            std::unique_lock<non_recursive_mutex> adj_list_lock(_locks[loc]);
+            std::unique_lock<versioned_spinlock> adj_list_lock(_locks[loc]);
             _graph_store->clear_neighbours((location_t)loc);
             for (auto &ngh : expanded_nodes_set)
                 _graph_store->add_neighbour((location_t)loc, ngh);
@@ -2371,7 +2363,7 @@ inline void Index<T, TagT, LabelT>::process_delete(const tsl::robin_set<uint32_t
             std::vector<uint32_t> &occlude_list_output = scratch->occlude_list_output();
             occlude_list((uint32_t)loc, expanded_nghrs_vec, alpha, range, maxc, occlude_list_output, scratch,
                          &old_delete_set);
-            std::unique_lock<non_recursive_mutex> adj_list_lock(_locks[loc]);
+            std::unique_lock<versioned_spinlock> adj_list_lock(_locks[loc]);
             _graph_store->set_neighbours((location_t)loc, occlude_list_output);
         }
     }
@@ -2709,7 +2701,7 @@ void Index<T, TagT, LabelT>::reposition_points(uint32_t old_location_start, uint
     std::vector<location_t> updated_neighbours_location;
     for (uint32_t i = 0; i < _max_points + _num_frozen_pts; i++)
     {
-        auto &i_neighbours = _graph_store->get_neighbours((location_t)i);
+        auto i_neighbours = _graph_store->get_neighbours((location_t)i);
         std::vector<location_t> i_neighbours_copy(i_neighbours.begin(), i_neighbours.end());
         for (auto &loc : i_neighbours_copy)
         {
@@ -2808,7 +2800,7 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
 
     _data_store->resize((location_t)new_internal_points);
     _graph_store->resize_graph(new_internal_points);
-    _locks = std::vector<non_recursive_mutex>(new_internal_points);
+    _locks = std::vector<versioned_spinlock>(new_internal_points);
 
     if (_num_frozen_pts != 0)
     {
@@ -2999,7 +2991,7 @@ int Index<T, TagT, LabelT>::insert_point(const T *point, const TagT tag, const s
         if (_conc_consolidate)
             tlock.lock();
 
-        LockGuard guard(_locks[location]);
+        VersionedLockGuard guard(_locks[location]);
         _graph_store->clear_neighbours(location);
 
         std::vector<uint32_t> neighbor_links;
@@ -88,6 +88,8 @@ std::unique_ptr<AbstractGraphStore> IndexFactory::construct_graphstore(const Gra
     {
     case GraphStoreStrategy::MEMORY:
         return std::make_unique<InMemGraphStore>(size, reserve_graph_degree);
+    case GraphStoreStrategy::MEMORY_FIXED_DEGREE:
+        return std::make_unique<InMemFixedDegreeGraphStore>(size, reserve_graph_degree);
     default:
         throw ANNException("Error : Current GraphStoreStratagy is not supported.", -1);
     }
@@ -0,0 +1,374 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#if defined(USE_IO_URING)
+
+#include "io_uring_aligned_file_reader.h"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include "ann_exception.h"
+#include "tsl/robin_map.h"
+#include "utils.h"
+
+IoUringAlignedFileReader::IoUringAlignedFileReader(bool use_sqpoll, uint32_t queue_depth, uint32_t sqpoll_idle_ms)
+    : _use_sqpoll(use_sqpoll), _queue_depth(queue_depth), _sqpoll_idle_ms(sqpoll_idle_ms)
+{
+    this->file_desc = -1;
+}
+
+IoUringAlignedFileReader::~IoUringAlignedFileReader()
+{
+    int64_t ret;
+    // check to make sure file_desc is closed
+    ret = ::fcntl(this->file_desc, F_GETFD);
+    if (ret == -1)
+    {
+        if (errno != EBADF)
+        {
+            std::cerr << "close() not called" << std::endl;
+            // close file desc
+            ret = ::close(this->file_desc);
+            // error checks
+            if (ret == -1)
+            {
+                std::cerr << "close() failed; returned " << ret << ", errno=" << errno << ":" << ::strerror(errno)
+                          << std::endl;
+            }
+        }
+    }
+}
+
+io_context_t &IoUringAlignedFileReader::get_ctx()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    else
+    {
+        return ctx_map[std::this_thread::get_id()];
+    }
+}
+
+void IoUringAlignedFileReader::register_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(my_id) != ctx_map.end())
+    {
+        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
+        return;
+    }
+
+    RingContext *rctx = new RingContext();
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (_use_sqpoll)
+    {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = _sqpoll_idle_ms;
+        if (_sqpoll_wq_fd != -1)
+        {
+            params.flags |= IORING_SETUP_ATTACH_WQ;
+            params.wq_fd = (uint32_t)_sqpoll_wq_fd;
+        }
+    }
+
+    int ret = io_uring_queue_init_params(_queue_depth, &rctx->ring, &params);
+    if (ret != 0)
+    {
+        lk.unlock();
+        delete rctx;
+        // without a ring the thread would be handed bad_ctx by get_ctx()
+        std::stringstream stream;
+        stream << "io_uring_queue_init_params() failed; returned " << ret << ": " << ::strerror(-ret);
+        if (_use_sqpoll)
+            stream << ". SQPOLL may need CAP_SYS_NICE or a newer kernel; retry without it.";
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    if (_use_sqpoll && _sqpoll_wq_fd == -1)
+    {
+        _sqpoll_wq_fd = rctx->ring.ring_fd;
+    }
+
+    if (this->file_desc != -1)
+    {
+        rctx->fixed_file = (io_uring_register_files(&rctx->ring, &this->file_desc, 1) == 0);
+    }
+
+    diskann::cout << "allocating io_uring ctx: " << rctx << " to thread-id:" << my_id << std::endl;
+    ctx_map[my_id] = reinterpret_cast<io_context_t>(rctx);
+    lk.unlock();
+}
+
+IoUringAlignedFileReader::RingContext *IoUringAlignedFileReader::checked_ring(IOContext &ctx)
+{
+    if (ctx == this->bad_ctx)
+    {
+        throw diskann::ANNException("io_uring context used by a thread that has no registered ring", -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return to_ring(ctx);
+}
+
+void IoUringAlignedFileReader::destroy_ring(RingContext *rctx)
+{
+    if (rctx->fixed_buf != nullptr)
+        io_uring_unregister_buffers(&rctx->ring);
+    if (rctx->fixed_file)
+        io_uring_unregister_files(&rctx->ring);
+    io_uring_queue_exit(&rctx->ring);
+    delete rctx;
+}
+
+void IoUringAlignedFileReader::deregister_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    auto iter = ctx_map.find(my_id);
+    if (iter == ctx_map.end())
+    {
+        std::cerr << "deregister_thread called from an unregistered thread" << std::endl;
+        return;
+    }
+
+    RingContext *rctx = to_ring(iter.value());
+    int ring_fd = rctx->ring.ring_fd;
+    ctx_map.erase(iter);
+    destroy_ring(rctx);
+
+    // the SQPOLL thread lives on while other rings are attached to it, so
+    // rings created later attach through one of those instead
+    if (ring_fd == _sqpoll_wq_fd)
+    {
+        _sqpoll_wq_fd = ctx_map.empty() ? -1 : to_ring(ctx_map.begin().value())->ring.ring_fd;
+    }
+    std::cerr << "returned ctx from thread-id:" << my_id << std::endl;
+    lk.unlock();
+}
+
+void IoUringAlignedFileReader::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        io_context_t ctx = x.value();
+        destroy_ring(to_ring(ctx));
+    }
+    ctx_map.clear();
+    _sqpoll_wq_fd = -1;
+}
+
+void IoUringAlignedFileReader::register_buffer(IOContext &ctx, void *buf, uint64_t len)
+{
+    RingContext *rctx = checked_ring(ctx);
+    if (rctx->fixed_buf != nullptr)
+    {
+        io_uring_unregister_buffers(&rctx->ring);
+        rctx->fixed_buf = nullptr;
+        rctx->fixed_buf_len = 0;
+    }
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    int ret = io_uring_register_buffers(&rctx->ring, &iov, 1);
+    if (ret != 0)
+    {
+        // not fatal: reads into buf fall back to IORING_OP_READ
+        std::cerr << "io_uring_register_buffers() failed; returned " << ret << ": " << ::strerror(-ret)
+                  << ". Consider raising RLIMIT_MEMLOCK." << std::endl;
+        return;
+    }
+    rctx->fixed_buf = (char *)buf;
+    rctx->fixed_buf_len = len;
+}
+
+void IoUringAlignedFileReader::open(const std::string &fname)
+{
+    int flags = O_DIRECT | O_RDONLY | O_LARGEFILE;
+    this->file_desc = ::open(fname.c_str(), flags);
+    // error checks
+    assert(this->file_desc != -1);
+    std::cerr << "Opened file : " << fname << std::endl;
+
+    // rings created before open() get the new descriptor registered too
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        RingContext *rctx = to_ring(x.value());
+        if (rctx->fixed_file)
+            io_uring_unregister_files(&rctx->ring);
+        rctx->fixed_file = (io_uring_register_files(&rctx->ring, &this->file_desc, 1) == 0);
+    }
+}
+
+void IoUringAlignedFileReader::close()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        RingContext *rctx = to_ring(x.value());
+        if (rctx->fixed_file)
+            io_uring_unregister_files(&rctx->ring);
+        rctx->fixed_file = false;
+    }
+    lk.unlock();
+
+    ::fcntl(this->file_desc, F_GETFD);
+    ::close(this->file_desc);
+}
+
+void IoUringAlignedFileReader::prep_read(RingContext *rctx, const AlignedRead &req, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&rctx->ring);
+    if (sqe == nullptr)
+    {
+        throw diskann::ANNException("io_uring_get_sqe() returned no entry", -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    int fd = rctx->fixed_file ? 0 : this->file_desc;
+    char *buf = (char *)req.buf;
+    if (rctx->fixed_buf != nullptr && buf >= rctx->fixed_buf && buf + req.len <= rctx->fixed_buf + rctx->fixed_buf_len)
+    {
+        io_uring_prep_read_fixed(sqe, fd, buf, (unsigned)req.len, req.offset, 0);
+    }
+    else
+    {
+        io_uring_prep_read(sqe, fd, buf, (unsigned)req.len, req.offset);
+    }
+    if (rctx->fixed_file)
+    {
+        io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+    }
+    io_uring_sqe_set_data64(sqe, user_data);
+}
+
+void IoUringAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_context_t &ctx, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    assert(this->file_desc != -1);
+
+    RingContext *rctx = checked_ring(ctx);
+    struct io_uring *ring = &rctx->ring;
+
+    // break-up requests into chunks of at most queue depth each
+    uint64_t n_iters = ROUND_UP(read_reqs.size(), _queue_depth) / _queue_depth;
+    for (uint64_t iter = 0; iter < n_iters; iter++)
+    {
+        uint64_t start = iter * _queue_depth;
+        uint64_t n_ops = std::min((uint64_t)read_reqs.size() - start, (uint64_t)_queue_depth);
+
+        for (uint64_t j = 0; j < n_ops; j++)
+        {
+            prep_read(rctx, read_reqs[start + j], start + j);
+        }
+
+        int ret = io_uring_submit_and_wait(ring, (unsigned)n_ops);
+        if (ret < 0)
+        {
+            std::stringstream stream;
+            stream << "io_uring_submit_and_wait() failed; returned " << ret << ": " << ::strerror(-ret);
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+
+        // reap all completions of this chunk before reporting a failure so
+        // that the ring is left empty for the next call
+        std::stringstream err;
+        for (uint64_t j = 0; j < n_ops; j++)
+        {
+            struct io_uring_cqe *cqe = nullptr;
+            ret = io_uring_wait_cqe(ring, &cqe);
+            if (ret < 0)
+            {
+                std::stringstream stream;
+                stream << "io_uring_wait_cqe() failed; returned " << ret << ": " << ::strerror(-ret);
+                throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+            }
+            uint64_t idx = io_uring_cqe_get_data64(cqe);
+            int32_t res = cqe->res;
+            io_uring_cqe_seen(ring, cqe);
+            if ((res < 0 || (uint64_t)res != read_reqs[idx].len) && err.tellp() == 0)
+            {
+                err << "io_uring read failed at offset " << read_reqs[idx].offset << "; returned " << res;
+                if (res < 0)
+                    err << ": " << ::strerror(-res);
+            }
+        }
+        if (err.tellp() != 0)
+        {
+            throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+    }
+}
+
+void IoUringAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    RingContext *rctx = checked_ring(ctx);
+    for (auto &req : read_reqs)
+    {
+        // buf is handed back as the completion's user data
+        prep_read(rctx, req, (uint64_t)req.buf);
+    }
+
+    int ret = io_uring_submit(&rctx->ring);
+    if (ret < 0)
+    {
+        std::stringstream stream;
+        stream << "io_uring_submit() failed; returned " << ret << ": " << ::strerror(-ret);
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
+uint64_t IoUringAlignedFileReader::get_completed_reqs(io_context_t &ctx, uint64_t min_completions,
+                                                      std::vector<void *> &completed_bufs)
+{
+    RingContext *rctx = checked_ring(ctx);
+    struct io_uring *ring = &rctx->ring;
+
+    uint64_t n_completed = 0;
+    std::stringstream err;
+    while (true)
+    {
+        struct io_uring_cqe *cqe = nullptr;
+        int ret;
+        if (n_completed < min_completions)
+            ret = io_uring_wait_cqe(ring, &cqe);
+        else
+            ret = io_uring_peek_cqe(ring, &cqe);
+
+        if (ret == -EAGAIN && n_completed >= min_completions)
+            break;
+        if (ret < 0)
+        {
+            std::stringstream stream;
+            stream << "io_uring_wait_cqe() failed; returned " << ret << ": " << ::strerror(-ret);
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+
+        int32_t res = cqe->res;
+        completed_bufs.push_back((void *)io_uring_cqe_get_data64(cqe));
+        io_uring_cqe_seen(ring, cqe);
+        n_completed++;
+        if (res < 0 && err.tellp() == 0)
+        {
+            err << "io_uring read failed; returned " << res << ": " << ::strerror(-res);
+        }
+    }
+    if (err.tellp() != 0)
+    {
+        throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return n_completed;
+}
+
+#endif
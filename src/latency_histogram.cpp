@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cmath>
+
+#include "latency_histogram.h"
+
+namespace diskann
+{
+namespace
+{
+// values below 2^SUB_BUCKET_BITS get a bucket each; above, the top
+// SUB_BUCKET_BITS bits of a value select its bucket within its power of two
+const uint32_t SUB_BUCKET_BITS = 7;
+const uint64_t SUB_BUCKET_COUNT = (uint64_t)1 << SUB_BUCKET_BITS;
+const uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+// enough for any uint64_t, the largest of which shifts by 64 - SUB_BUCKET_BITS
+const uint64_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : _counts(new std::atomic<uint64_t>[NUM_BUCKETS])
+{
+    reset();
+}
+
+uint64_t LatencyHistogram::bucket_index(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+        return value;
+    uint32_t shift = 0;
+    while ((value >> shift) >= SUB_BUCKET_COUNT)
+        shift++;
+    // value >> shift is in [SUB_BUCKET_HALF, SUB_BUCKET_COUNT)
+    return shift * SUB_BUCKET_HALF + (value >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_highest_value(uint64_t index)
+{
+    if (index < SUB_BUCKET_COUNT)
+        return index;
+    uint64_t shift = index / SUB_BUCKET_HALF - 1;
+    uint64_t lowest = (index % SUB_BUCKET_HALF + SUB_BUCKET_HALF) << shift;
+    return lowest + (((uint64_t)1 << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value_us)
+{
+    _counts[bucket_index(value_us)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value_us, std::memory_order_relaxed);
+    uint64_t cur_max = _max.load(std::memory_order_relaxed);
+    while (value_us > cur_max && !_max.compare_exchange_weak(cur_max, value_us, std::memory_order_relaxed))
+        ;
+}
+
+void LatencyHistogram::reset()
+{
+    for (uint64_t b = 0; b < NUM_BUCKETS; b++)
+        _counts[b].store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return _count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return _max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    uint64_t n = count();
+    return n == 0 ? 0 : (double)_sum.load(std::memory_order_relaxed) / n;
+}
+
+uint64_t LatencyHistogram::sum() const
+{
+    return _sum.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count_at_or_below(uint64_t value) const
+{
+    uint64_t last = bucket_index(value), n = 0;
+    for (uint64_t b = 0; b <= last; b++)
+        n += _counts[b].load(std::memory_order_relaxed);
+    return n;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const
+{
+    uint64_t n = count();
+    if (n == 0)
+        return 0;
+    percentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+    uint64_t target = (std::max)((uint64_t)1, (uint64_t)std::ceil(percentile / 100.0 * n));
+    uint64_t seen = 0;
+    for (uint64_t b = 0; b < NUM_BUCKETS; b++)
+    {
+        seen += _counts[b].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return (std::min)(bucket_highest_value(b), max());
+    }
+    return max();
+}
+} // namespace diskann
@@ -226,3 +226,64 @@ void LinuxAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_contex
     assert(this->file_desc != -1);
     execute_io(ctx, this->file_desc, read_reqs);
 }
+
+void LinuxAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    uint64_t n_ops = read_reqs.size();
+    if (n_ops == 0)
+        return;
+
+    std::vector<iocb_t *> cbs(n_ops, nullptr);
+    std::vector<struct iocb> cb(n_ops);
+    for (uint64_t j = 0; j < n_ops; j++)
+    {
+        io_prep_pread(cb.data() + j, this->file_desc, read_reqs[j].buf, read_reqs[j].len, read_reqs[j].offset);
+        // buf is handed back in io_event::data on completion
+        cb[j].data = read_reqs[j].buf;
+        cbs[j] = cb.data() + j;
+    }
+
+    // the kernel copies each iocb at submission, so cb can go out of scope
+    // while the reads are still in flight
+    uint64_t n_submitted = 0;
+    while (n_submitted < n_ops)
+    {
+        int64_t ret = io_submit(ctx, (int64_t)(n_ops - n_submitted), cbs.data() + n_submitted);
+        if (ret <= 0)
+        {
+            std::cerr << "io_submit() failed; returned " << ret << ", expected=" << n_ops - n_submitted
+                      << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+            std::cout << "ctx: " << ctx << "\n";
+            exit(-1);
+        }
+        n_submitted += (uint64_t)ret;
+    }
+}
+
+uint64_t LinuxAlignedFileReader::get_completed_reqs(io_context_t &ctx, uint64_t min_completions,
+                                                    std::vector<void *> &completed_bufs)
+{
+    io_event_t evts[MAX_IO_DEPTH];
+    int64_t ret = io_getevents(ctx, (int64_t)(std::min)(min_completions, (uint64_t)MAX_IO_DEPTH), MAX_IO_DEPTH,
+                               evts, nullptr);
+    if (ret < 0 || (uint64_t)ret < (std::min)(min_completions, (uint64_t)MAX_IO_DEPTH))
+    {
+        std::cerr << "io_getevents() failed; returned " << ret << ", expected at least " << min_completions
+                  << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+        exit(-1);
+    }
+    for (int64_t i = 0; i < ret; i++)
+    {
+        // the submitting iocb may be gone by now, so only failures are
+        // detected here and not short reads
+        if ((int64_t)evts[i].res < 0)
+        {
+            std::cerr << "aio read failed; returned " << (int64_t)evts[i].res << "="
+                      << ::strerror(-(int64_t)evts[i].res) << std::endl;
+            exit(-1);
+        }
+        completed_bufs.push_back(evts[i].data);
+    }
+    return (uint64_t)ret;
+}
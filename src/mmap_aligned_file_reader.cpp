@@ -0,0 +1,178 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef _WINDOWS
+
+#include "mmap_aligned_file_reader.h"
+
+#include <sys/stat.h>
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include "ann_exception.h"
+#include "tsl/robin_map.h"
+#include "utils.h"
+
+MmapAlignedFileReader::MmapAlignedFileReader(bool populate, int advice) : _populate(populate), _advice(advice)
+{
+    this->file_desc = -1;
+}
+
+MmapAlignedFileReader::~MmapAlignedFileReader()
+{
+    if (_mapped_data != nullptr)
+    {
+        std::cerr << "close() not called" << std::endl;
+        close();
+    }
+    deregister_all_threads();
+}
+
+io_context_t &MmapAlignedFileReader::get_ctx()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    else
+    {
+        return ctx_map[std::this_thread::get_id()];
+    }
+}
+
+void MmapAlignedFileReader::register_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(my_id) != ctx_map.end())
+    {
+        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
+        return;
+    }
+    MmapContext *mctx = new MmapContext();
+    mctx->completed_bufs.reserve(MAX_IO_DEPTH);
+    ctx_map[my_id] = reinterpret_cast<io_context_t>(mctx);
+}
+
+void MmapAlignedFileReader::deregister_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    auto iter = ctx_map.find(my_id);
+    assert(iter != ctx_map.end());
+    delete to_mmap_ctx(iter.value());
+    ctx_map.erase(my_id);
+}
+
+void MmapAlignedFileReader::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        delete to_mmap_ctx(x.value());
+    }
+    ctx_map.clear();
+}
+
+void MmapAlignedFileReader::open(const std::string &fname)
+{
+    this->file_desc = ::open(fname.c_str(), O_RDONLY | O_LARGEFILE);
+    if (this->file_desc == -1)
+    {
+        throw diskann::ANNException("Failed to open " + fname + ": " + ::strerror(errno), -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
+    struct stat sb;
+    if (::fstat(this->file_desc, &sb) != 0)
+    {
+        throw diskann::ANNException("fstat() failed on " + fname + ": " + ::strerror(errno), -1, __FUNCSIG__,
+                                    __FILE__, __LINE__);
+    }
+    _file_sz = (uint64_t)sb.st_size;
+
+    int flags = MAP_SHARED | (_populate ? MAP_POPULATE : 0);
+    void *addr = ::mmap(nullptr, _file_sz, PROT_READ, flags, this->file_desc, 0);
+    if (addr == MAP_FAILED)
+    {
+        throw diskann::ANNException("mmap() failed on " + fname + ": " + ::strerror(errno), -1, __FUNCSIG__,
+                                    __FILE__, __LINE__);
+    }
+    _mapped_data = (char *)addr;
+
+    // only a hint, a failure just leaves the kernel default
+    if (::madvise(_mapped_data, _file_sz, _advice) != 0)
+    {
+        std::cerr << "madvise(" << _advice << ") failed, errno=" << errno << ":" << ::strerror(errno) << std::endl;
+    }
+    std::cerr << "Mapped file : " << fname << " (" << _file_sz << " bytes" << (_populate ? ", populated" : "") << ")"
+              << std::endl;
+}
+
+void MmapAlignedFileReader::close()
+{
+    if (_mapped_data != nullptr)
+    {
+        ::munmap(_mapped_data, _file_sz);
+        _mapped_data = nullptr;
+        _file_sz = 0;
+    }
+    if (this->file_desc != -1)
+    {
+        ::close(this->file_desc);
+        this->file_desc = -1;
+    }
+}
+
+char *MmapAlignedFileReader::get_mapped_data()
+{
+    return _mapped_data;
+}
+
+void MmapAlignedFileReader::copy_reqs(std::vector<AlignedRead> &read_reqs)
+{
+    assert(_mapped_data != nullptr);
+    for (auto &req : read_reqs)
+    {
+        // the tail of the last sector may be past the end of the file
+        uint64_t len = req.offset >= _file_sz ? 0 : (std::min)(req.len, _file_sz - req.offset);
+        memcpy(req.buf, _mapped_data + req.offset, len);
+        if (len < req.len)
+            memset((char *)req.buf + len, 0, req.len - len);
+    }
+}
+
+void MmapAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_context_t &ctx, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    copy_reqs(read_reqs);
+}
+
+void MmapAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    copy_reqs(read_reqs);
+    MmapContext *mctx = to_mmap_ctx(ctx);
+    for (auto &req : read_reqs)
+    {
+        mctx->completed_bufs.push_back(req.buf);
+    }
+}
+
+uint64_t MmapAlignedFileReader::get_completed_reqs(io_context_t &ctx, uint64_t min_completions,
+                                                   std::vector<void *> &completed_bufs)
+{
+    MmapContext *mctx = to_mmap_ctx(ctx);
+    assert(mctx->completed_bufs.size() >= min_completions);
+    uint64_t n_completed = mctx->completed_bufs.size();
+    completed_bufs.insert(completed_bufs.end(), mctx->completed_bufs.begin(), mctx->completed_bufs.end());
+    mctx->completed_bufs.clear();
+    return n_completed;
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+#include "nhood_codec.h"
+#include "utils.h"
+
+namespace diskann
+{
+namespace
+{
+const uint64_t PACKED_NHOOD_HEADER_LEN = 8;
+const uint64_t PACKED_NHOOD_PADDING = 8;
+
+// sorts nbrs and returns the number of bits needed for the largest gap
+uint32_t sort_and_get_width(uint32_t *nbrs, uint32_t nnbrs)
+{
+    std::sort(nbrs, nbrs + nnbrs);
+    uint32_t max_gap = 0;
+    for (uint32_t i = 1; i < nnbrs; i++)
+    {
+        max_gap = (std::max)(max_gap, nbrs[i] - nbrs[i - 1]);
+    }
+    uint32_t width = 0;
+    while (width < 32 && (max_gap >> width) != 0)
+    {
+        width++;
+    }
+    return width;
+}
+
+// rounded up to keep the coords of the next node 4 byte aligned
+uint64_t get_packed_size(uint32_t nnbrs, uint32_t width)
+{
+    uint64_t num_gaps = nnbrs > 0 ? nnbrs - 1 : 0;
+    return ROUND_UP(PACKED_NHOOD_HEADER_LEN + DIV_ROUND_UP(num_gaps * width, 8) + PACKED_NHOOD_PADDING,
+                    sizeof(uint32_t));
+}
+
+inline uint32_t get_gap(const char *gaps, uint64_t idx, uint32_t width, uint64_t mask)
+{
+    uint64_t bit_pos = idx * width;
+    uint64_t word;
+    memcpy(&word, gaps + (bit_pos >> 3), sizeof(uint64_t));
+    return (uint32_t)((word >> (bit_pos & 7)) & mask);
+}
+} // namespace
+
+uint64_t packed_nhood_size(uint32_t *nbrs, uint32_t nnbrs)
+{
+    return get_packed_size(nnbrs, sort_and_get_width(nbrs, nnbrs));
+}
+
+uint64_t pack_nhood(uint32_t *nbrs, uint32_t nnbrs, char *dst)
+{
+    uint32_t width = sort_and_get_width(nbrs, nnbrs);
+    uint64_t size = get_packed_size(nnbrs, width);
+    memset(dst, 0, size);
+
+    uint16_t nnbrs_u16 = (uint16_t)nnbrs;
+    uint32_t first_id = nnbrs > 0 ? nbrs[0] : 0;
+    memcpy(dst, &nnbrs_u16, sizeof(uint16_t));
+    dst[2] = (char)width;
+    memcpy(dst + 4, &first_id, sizeof(uint32_t));
+
+    char *gaps = dst + PACKED_NHOOD_HEADER_LEN;
+    for (uint32_t i = 1; i < nnbrs; i++)
+    {
+        uint64_t bit_pos = (uint64_t)(i - 1) * width;
+        uint64_t word;
+        memcpy(&word, gaps + (bit_pos >> 3), sizeof(uint64_t));
+        word |= (uint64_t)(nbrs[i] - nbrs[i - 1]) << (bit_pos & 7);
+        memcpy(gaps + (bit_pos >> 3), &word, sizeof(uint64_t));
+    }
+    return size;
+}
+
+uint32_t unpack_nhood(const char *src, uint32_t *nbrs)
+{
+    uint16_t nnbrs_u16;
+    memcpy(&nnbrs_u16, src, sizeof(uint16_t));
+    uint32_t nnbrs = nnbrs_u16;
+    uint32_t width = (uint8_t)src[2];
+    if (nnbrs == 0)
+        return 0;
+
+    memcpy(nbrs, src + 4, sizeof(uint32_t));
+    const char *gaps = src + PACKED_NHOOD_HEADER_LEN;
+    const uint64_t mask = (1ULL << width) - 1;
+    const uint32_t num_gaps = nnbrs - 1;
+    uint32_t i = 0;
+
+#ifdef USE_AVX2
+    // 8 gaps at a time: each is gathered with a 4 byte load from the byte it
+    // starts in, which holds all of its bits as long as width + 7 <= 32
+    if (width <= 25)
+    {
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i widths = _mm256_set1_epi32((int)width);
+        const __m256i masks = _mm256_set1_epi32((int)mask);
+        const __m256i sevens = _mm256_set1_epi32(7);
+        const __m256i threes = _mm256_set1_epi32(3);
+        __m256i prev = _mm256_set1_epi32((int)nbrs[0]);
+        for (; i + 8 <= num_gaps; i += 8)
+        {
+            __m256i bit_pos = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32((int)i), lanes), widths);
+            __m256i v = _mm256_i32gather_epi32((const int *)gaps, _mm256_srli_epi32(bit_pos, 3), 1);
+            v = _mm256_and_si256(_mm256_srlv_epi32(v, _mm256_and_si256(bit_pos, sevens)), masks);
+
+            // prefix sum within each 128-bit half, then carry the lower half
+            // into the upper one and add the last id decoded so far
+            v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+            v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+            v = _mm256_add_epi32(
+                v, _mm256_blend_epi32(_mm256_setzero_si256(), _mm256_permutevar8x32_epi32(v, threes), 0xF0));
+            v = _mm256_add_epi32(v, prev);
+
+            _mm256_storeu_si256((__m256i *)(nbrs + 1 + i), v);
+            prev = _mm256_permutevar8x32_epi32(v, sevens);
+        }
+    }
+#endif
+
+    for (; i < num_gaps; i++)
+    {
+        nbrs[i + 1] = nbrs[i] + get_gap(gaps, i, width, mask);
+    }
+    return nnbrs;
+}
+} // namespace diskann
@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "numa_utils.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifndef _WINDOWS
+#include <unistd.h>
+#endif
+
+namespace diskann
+{
+namespace numa
+{
+namespace
+{
+struct Topology
+{
+    std::vector<uint32_t> kernel_ids;   // kernel id of each dense node
+    std::vector<std::vector<int>> cpus; // CPUs of each dense node
+    std::vector<int32_t> node_of_cpu;   // dense node of each CPU, -1 if none
+};
+
+// parses a kernel cpu/node list such as "0-15,32-47"
+std::vector<int> parse_list(const std::string &list)
+{
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty() || range == "\n")
+            continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int id = first; id <= last; id++)
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+Topology read_topology()
+{
+    Topology topo;
+#ifndef _WINDOWS
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string line;
+    if (online && std::getline(online, line))
+    {
+        try
+        {
+            for (int kernel_id : parse_list(line))
+            {
+                std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(kernel_id) + "/cpulist");
+                std::string cpus;
+                if (!cpulist || !std::getline(cpulist, cpus))
+                    continue;
+                std::vector<int> node_cpus = parse_list(cpus);
+                if (node_cpus.empty())
+                    continue;
+                for (int cpu : node_cpus)
+                {
+                    if (cpu >= (int)topo.node_of_cpu.size())
+                        topo.node_of_cpu.resize(cpu + 1, -1);
+                    topo.node_of_cpu[cpu] = (int32_t)topo.kernel_ids.size();
+                }
+                topo.kernel_ids.push_back((uint32_t)kernel_id);
+                topo.cpus.push_back(node_cpus);
+            }
+        }
+        catch (const std::exception &)
+        {
+            topo = Topology();
+        }
+    }
+#endif
+    if (topo.kernel_ids.empty())
+    {
+        topo.kernel_ids.push_back(0);
+        topo.cpus.emplace_back();
+    }
+    return topo;
+}
+
+const Topology &topology()
+{
+    static const Topology topo = read_topology();
+    return topo;
+}
+} // namespace
+
+uint32_t num_nodes()
+{
+    return (uint32_t)topology().kernel_ids.size();
+}
+
+uint32_t current_node()
+{
+#ifndef _WINDOWS
+    const Topology &topo = topology();
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < (int)topo.node_of_cpu.size() && topo.node_of_cpu[cpu] >= 0)
+        return (uint32_t)topo.node_of_cpu[cpu];
+#endif
+    return 0;
+}
+
+bool bind_thread_to_node(uint32_t node)
+{
+#ifndef _WINDOWS
+    const Topology &topo = topology();
+    if (node >= topo.cpus.size() || topo.cpus[node].empty())
+        return false;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : topo.cpus[node])
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &mask);
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+    return false;
+#endif
+}
+
+void get_node_memory(uint32_t node, uint64_t &total_bytes, uint64_t &free_bytes)
+{
+    total_bytes = 0;
+    free_bytes = 0;
+#ifndef _WINDOWS
+    const Topology &topo = topology();
+    if (node >= topo.kernel_ids.size())
+        return;
+    // lines look like "Node 0 MemTotal:       131923476 kB"
+    std::ifstream meminfo("/sys/devices/system/node/node" + std::to_string(topo.kernel_ids[node]) + "/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line))
+    {
+        std::stringstream ss(line);
+        std::string word, id, key;
+        uint64_t kb = 0;
+        if (!(ss >> word >> id >> key >> kb))
+            continue;
+        if (key == "MemTotal:")
+            total_bytes = kb * 1024;
+        else if (key == "MemFree:")
+            free_bytes = kb * 1024;
+    }
+#endif
+}
+
+ScopedNodeBinding::ScopedNodeBinding(uint32_t node)
+{
+#ifndef _WINDOWS
+    if (num_nodes() > 1 && sched_getaffinity(0, sizeof(_prev_mask), &_prev_mask) == 0)
+        _restore = bind_thread_to_node(node);
+#endif
+}
+
+ScopedNodeBinding::~ScopedNodeBinding()
+{
+#ifndef _WINDOWS
+    if (_restore)
+        sched_setaffinity(0, sizeof(_prev_mask), &_prev_mask);
+#endif
+}
+} // namespace numa
+} // namespace diskann
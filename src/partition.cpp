@@ -576,7 +576,8 @@ int partition_with_ram_budget(const std::string data_file, const double sampling
             // testing sample.
             p = (uint64_t)(p / sampling_rate);
             double cur_shard_ram_estimate =
-                diskann::estimate_ram_usage(p, (uint32_t)train_dim, sizeof(T), (uint32_t)graph_degree);
+                diskann::estimate_ram_usage(p, (uint32_t)train_dim, sizeof(T), (uint32_t)graph_degree,
+                                            (uint32_t)omp_get_max_threads());
 
             if (cur_shard_ram_estimate > max_ram_usage)
                 max_ram_usage = cur_shard_ram_estimate;
@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT license.
 
+#include <immintrin.h>
+
 #include "mkl.h"
 #if defined(DISKANN_RELEASE_UNUSED_TCMALLOC_MEMORY_AT_CHECKPOINTS) && defined(DISKANN_BUILD)
 #include "gperftools/malloc_extension.h"
@@ -89,14 +91,15 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     diskann::load_bin<float>(pq_table_file, tables, nr, nc, file_offset_data[0]);
 #endif
 
-    if ((nr != NUM_PQ_CENTROIDS))
+    if (nr != NUM_PQ_CENTROIDS && nr != NUM_PQ_CENTROIDS_4BIT)
     {
         diskann::cout << "Error reading pq_pivots file " << pq_table_file << ". file_num_centers  = " << nr
-                      << " but expecting " << NUM_PQ_CENTROIDS << " centers";
+                      << " but expecting " << NUM_PQ_CENTROIDS << " or " << NUM_PQ_CENTROIDS_4BIT << " centers";
         throw diskann::ANNException("Error reading pq_pivots file at pivots data.", -1, __FUNCSIG__, __FILE__,
                                     __LINE__);
     }
 
+    this->num_centers = nr;
     this->ndims = nc;
 
 #ifdef EXEC_ENV_OLS
@@ -132,7 +135,7 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     }
 
     this->n_chunks = nr - 1;
-    diskann::cout << "Loaded PQ Pivots: #ctrs: " << NUM_PQ_CENTROIDS << ", #dims: " << this->ndims
+    diskann::cout << "Loaded PQ Pivots: #ctrs: " << this->num_centers << ", #dims: " << this->ndims
                   << ", #chunks: " << this->n_chunks << std::endl;
 
 #ifdef EXEC_ENV_OLS
@@ -153,12 +156,12 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     }
 
     // alloc and compute transpose
-    tables_tr = new float[256 * this->ndims];
-    for (size_t i = 0; i < 256; i++)
+    tables_tr = new float[num_centers * this->ndims];
+    for (size_t i = 0; i < num_centers; i++)
     {
         for (size_t j = 0; j < this->ndims; j++)
         {
-            tables_tr[j * 256 + i] = tables[i * this->ndims + j];
+            tables_tr[j * num_centers + i] = tables[i * this->ndims + j];
         }
     }
 }
@@ -168,6 +171,11 @@ uint32_t FixedChunkPQTable::get_num_chunks()
     return static_cast<uint32_t>(n_chunks);
 }
 
+uint32_t FixedChunkPQTable::get_num_centers()
+{
+    return static_cast<uint32_t>(num_centers);
+}
+
 void FixedChunkPQTable::preprocess_query(float *query_vec)
 {
     for (uint32_t d = 0; d < ndims; d++)
@@ -191,16 +199,16 @@ void FixedChunkPQTable::preprocess_query(float *query_vec)
 // assumes pre-processed query
 void FixedChunkPQTable::populate_chunk_distances(const float *query_vec, float *dist_vec)
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double diff = centers_dim_vec[idx] - (query_vec[j]);
                 chunk_dists[idx] += (float)(diff * diff);
@@ -216,7 +224,7 @@ float FixedChunkPQTable::l2_distance(const float *query_vec, uint8_t *base_vec)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] - (query_vec[j]);
             res += diff * diff;
         }
@@ -231,7 +239,7 @@ float FixedChunkPQTable::inner_product(const float *query_vec, uint8_t *base_vec
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] * query_vec[j]; // assumes centroid is 0 to
                                                                           // prevent translation errors
             res += diff;
@@ -248,7 +256,7 @@ void FixedChunkPQTable::inflate_vector(uint8_t *base_vec, float *out_vec)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             out_vec[j] = centers_dim_vec[base_vec[chunk]] + centroid[j];
         }
     }
@@ -256,16 +264,16 @@ void FixedChunkPQTable::inflate_vector(uint8_t *base_vec, float *out_vec)
 
 void FixedChunkPQTable::populate_chunk_inner_products(const float *query_vec, float *dist_vec)
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double prod = centers_dim_vec[idx] * query_vec[j]; // assumes that we are not
                                                                    // shifting the vectors to
@@ -344,6 +352,131 @@ void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_n
     }
 }
 
+void aggregate_coords_fast_scan(const uint32_t *ids, const uint64_t n_ids, const uint8_t *all_coords,
+                                const uint64_t pq_nchunks, uint8_t *out)
+{
+    const uint64_t code_len = DIV_ROUND_UP(pq_nchunks, 2);
+    const uint64_t block_len = PQ_FAST_SCAN_BLOCK / 2 * ROUND_UP(pq_nchunks, 2);
+    memset(out, 0, DIV_ROUND_UP(n_ids, PQ_FAST_SCAN_BLOCK) * block_len);
+    for (uint64_t i = 0; i < n_ids; i++)
+    {
+        const uint8_t *code = all_coords + ids[i] * code_len;
+        uint8_t *block = out + (i / PQ_FAST_SCAN_BLOCK) * block_len + (i % 16);
+        const uint32_t shift = (i % PQ_FAST_SCAN_BLOCK) < 16 ? 0 : 4;
+        for (uint64_t b = 0; b < code_len; b++)
+        {
+            // a missing odd chunk reads as code 0 of the zero padding table
+            block[(2 * b) * 16] |= (uint8_t)((code[b] & 0x0f) << shift);
+            block[(2 * b + 1) * 16] |= (uint8_t)((code[b] >> 4) << shift);
+        }
+    }
+}
+
+void quantize_fast_scan_lut(const float *pq_dists, const size_t pq_nchunks, uint8_t *lut_out, float &scale,
+                            float &bias)
+{
+    const size_t nchunks_even = ROUND_UP(pq_nchunks, 2);
+    float max_range = 0;
+    bias = 0;
+    for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
+    {
+        const float *chunk_dists = pq_dists + NUM_PQ_CENTROIDS_4BIT * chunk;
+        float lo = *std::min_element(chunk_dists, chunk_dists + NUM_PQ_CENTROIDS_4BIT);
+        float hi = *std::max_element(chunk_dists, chunk_dists + NUM_PQ_CENTROIDS_4BIT);
+        bias += lo;
+        max_range = (std::max)(max_range, hi - lo);
+    }
+
+    // one scale for all chunks so that the entries can be summed as
+    // integers, small enough that the uint16 sums of all chunks fit
+    const float max_entry = (float)(std::min)((size_t)255, (size_t)65535 / nchunks_even);
+    scale = max_range > 0 ? max_entry / max_range : 1.0f;
+
+    memset(lut_out, 0, nchunks_even * NUM_PQ_CENTROIDS_4BIT);
+    for (size_t chunk = 0; chunk < pq_nchunks; chunk++)
+    {
+        const float *chunk_dists = pq_dists + NUM_PQ_CENTROIDS_4BIT * chunk;
+        float lo = *std::min_element(chunk_dists, chunk_dists + NUM_PQ_CENTROIDS_4BIT);
+        for (size_t idx = 0; idx < NUM_PQ_CENTROIDS_4BIT; idx++)
+        {
+            lut_out[chunk * NUM_PQ_CENTROIDS_4BIT + idx] =
+                (uint8_t)(std::min)(max_entry, std::round((chunk_dists[idx] - lo) * scale));
+        }
+    }
+}
+
+void pq_fast_scan_lookup(const uint8_t *block_codes, const size_t n_pts, const size_t pq_nchunks, const uint8_t *lut,
+                         const float scale, const float bias, float *dists_out)
+{
+    const size_t nchunks_even = ROUND_UP(pq_nchunks, 2);
+    const size_t block_len = PQ_FAST_SCAN_BLOCK / 2 * nchunks_even;
+    const float inv_scale = 1.0f / scale;
+    uint16_t sums[PQ_FAST_SCAN_BLOCK];
+
+    for (size_t start = 0; start < n_pts; start += PQ_FAST_SCAN_BLOCK)
+    {
+        const uint8_t *block = block_codes + (start / PQ_FAST_SCAN_BLOCK) * block_len;
+#ifdef USE_AVX2
+        // accumulators hold the sums of points 0-15 and 16-31 of the block
+        __m256i acc_lo = _mm256_setzero_si256();
+        __m256i acc_hi = _mm256_setzero_si256();
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+        size_t chunk = 0;
+#ifdef __AVX512BW__
+        const __m512i nibble_mask_512 = _mm512_set1_epi8(0x0f);
+        __m512i acc_lo_512 = _mm512_setzero_si512();
+        __m512i acc_hi_512 = _mm512_setzero_si512();
+        for (; chunk + 4 <= nchunks_even; chunk += 4)
+        {
+            __m512i codes = _mm512_loadu_si512((const void *)(block + chunk * 16));
+            __m512i tables = _mm512_loadu_si512((const void *)(lut + chunk * NUM_PQ_CENTROIDS_4BIT));
+            __m512i d_lo = _mm512_shuffle_epi8(tables, _mm512_and_si512(codes, nibble_mask_512));
+            __m512i d_hi =
+                _mm512_shuffle_epi8(tables, _mm512_and_si512(_mm512_srli_epi16(codes, 4), nibble_mask_512));
+            acc_lo_512 = _mm512_add_epi16(acc_lo_512, _mm512_cvtepu8_epi16(_mm512_castsi512_si256(d_lo)));
+            acc_lo_512 = _mm512_add_epi16(acc_lo_512, _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(d_lo, 1)));
+            acc_hi_512 = _mm512_add_epi16(acc_hi_512, _mm512_cvtepu8_epi16(_mm512_castsi512_si256(d_hi)));
+            acc_hi_512 = _mm512_add_epi16(acc_hi_512, _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(d_hi, 1)));
+        }
+        acc_lo = _mm256_add_epi16(_mm512_castsi512_si256(acc_lo_512), _mm512_extracti64x4_epi64(acc_lo_512, 1));
+        acc_hi = _mm256_add_epi16(_mm512_castsi512_si256(acc_hi_512), _mm512_extracti64x4_epi64(acc_hi_512, 1));
+#endif
+        for (; chunk < nchunks_even; chunk += 2)
+        {
+            // 128-bit lane 0 is chunk, lane 1 is chunk + 1, and pshufb looks
+            // up within each lane
+            __m256i codes = _mm256_loadu_si256((const __m256i *)(block + chunk * 16));
+            __m256i tables = _mm256_loadu_si256((const __m256i *)(lut + chunk * NUM_PQ_CENTROIDS_4BIT));
+            __m256i d_lo = _mm256_shuffle_epi8(tables, _mm256_and_si256(codes, nibble_mask));
+            __m256i d_hi = _mm256_shuffle_epi8(tables, _mm256_and_si256(_mm256_srli_epi16(codes, 4), nibble_mask));
+            acc_lo = _mm256_add_epi16(acc_lo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d_lo)));
+            acc_lo = _mm256_add_epi16(acc_lo, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d_lo, 1)));
+            acc_hi = _mm256_add_epi16(acc_hi, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d_hi)));
+            acc_hi = _mm256_add_epi16(acc_hi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d_hi, 1)));
+        }
+        _mm256_storeu_si256((__m256i *)sums, acc_lo);
+        _mm256_storeu_si256((__m256i *)(sums + 16), acc_hi);
+#else
+        memset(sums, 0, sizeof(sums));
+        for (size_t chunk = 0; chunk < nchunks_even; chunk++)
+        {
+            const uint8_t *chunk_lut = lut + chunk * NUM_PQ_CENTROIDS_4BIT;
+            for (size_t j = 0; j < 16; j++)
+            {
+                uint8_t codes = block[chunk * 16 + j];
+                sums[j] += chunk_lut[codes & 0x0f];
+                sums[j + 16] += chunk_lut[codes >> 4];
+            }
+        }
+#endif
+        const size_t n_block_pts = (std::min)((size_t)PQ_FAST_SCAN_BLOCK, n_pts - start);
+        for (size_t j = 0; j < n_block_pts; j++)
+        {
+            dists_out[start + j] = bias + sums[j] * inv_scale;
+        }
+    }
+}
+
 // generate_pq_pivots_simplified is a simplified version of generate_pq_pivots.
 // Input is provided in the in-memory buffer train_data.
 // Output is stored in the in-memory buffer pivot_data_vector.
@@ -844,7 +977,8 @@ int generate_pq_data_from_pivots_simplified(const float *data, const size_t num,
 // chunk to generate the compressed data_file and stores it in
 // pq_compressed_vectors_path.
 // If the numbber of centers is < 256, it stores as byte vector, else as
-// 4-byte vector in binary format.
+// 4-byte vector in binary format. With 16 centers (4-bit PQ), two chunks are
+// packed per byte and the file header holds the packed length in bytes.
 template <typename T>
 int generate_pq_data_from_pivots(const std::string &data_file, uint32_t num_centers, uint32_t num_pq_chunks,
                                  const std::string &pq_pivots_path, const std::string &pq_compressed_vectors_path,
@@ -932,7 +1066,8 @@ int generate_pq_data_from_pivots(const std::string &data_file, uint32_t num_cent
     }
 
     std::ofstream compressed_file_writer(pq_compressed_vectors_path, std::ios::binary);
-    uint32_t num_pq_chunks_u32 = num_pq_chunks;
+    const bool pack_4bit = num_centers == NUM_PQ_CENTROIDS_4BIT;
+    uint32_t num_pq_chunks_u32 = pack_4bit ? DIV_ROUND_UP(num_pq_chunks, 2) : num_pq_chunks;
 
     compressed_file_writer.write((char *)&num_points, sizeof(uint32_t));
     compressed_file_writer.write((char *)&num_pq_chunks_u32, sizeof(uint32_t));
@@ -1039,6 +1174,20 @@ int generate_pq_data_from_pivots(const std::string &data_file, uint32_t num_cent
             compressed_file_writer.write((char *)(block_compressed_base.get()),
                                          cur_blk_size * num_pq_chunks * sizeof(uint32_t));
         }
+        else if (pack_4bit)
+        {
+            std::unique_ptr<uint8_t[]> pVec = std::make_unique<uint8_t[]>(cur_blk_size * num_pq_chunks_u32);
+            std::memset(pVec.get(), 0, cur_blk_size * num_pq_chunks_u32);
+            for (size_t j = 0; j < cur_blk_size; j++)
+            {
+                for (size_t i = 0; i < num_pq_chunks; i++)
+                {
+                    pVec[j * num_pq_chunks_u32 + i / 2] |=
+                        (uint8_t)(block_compressed_base[j * num_pq_chunks + i] << (4 * (i % 2)));
+                }
+            }
+            compressed_file_writer.write((char *)(pVec.get()), cur_blk_size * num_pq_chunks_u32 * sizeof(uint8_t));
+        }
         else
         {
             std::unique_ptr<uint8_t[]> pVec = std::make_unique<uint8_t[]>(cur_blk_size * num_pq_chunks);
@@ -1095,7 +1244,7 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, diskann::Metric compareMetric,
                              const double p_val, const size_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix)
+                             const std::string &codebook_prefix, const uint32_t num_pq_centers)
 {
     size_t train_size, train_dim;
     float *train_data;
@@ -1113,12 +1262,12 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
 
         if (!use_opq)
         {
-            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, num_pq_centers, (uint32_t)num_pq_chunks,
                                NUM_KMEANS_REPS_PQ, pq_pivots_path, make_zero_mean);
         }
         else
         {
-            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, num_pq_centers, (uint32_t)num_pq_chunks,
                                 pq_pivots_path, make_zero_mean);
         }
         delete[] train_data;
@@ -1127,7 +1276,7 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
     {
         diskann::cout << "Skip Training with predefined pivots in: " << pq_pivots_path << std::endl;
     }
-    generate_pq_data_from_pivots<T>(data_file_to_use, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks, pq_pivots_path,
+    generate_pq_data_from_pivots<T>(data_file_to_use, num_pq_centers, (uint32_t)num_pq_chunks, pq_pivots_path,
                                     pq_compressed_vectors_path, use_opq);
 }
 
@@ -1171,19 +1320,22 @@ template DISKANN_DLLEXPORT void generate_quantized_data<int8_t>(const std::strin
                                                                 const std::string &pq_compressed_vectors_path,
                                                                 diskann::Metric compareMetric, const double p_val,
                                                                 const size_t num_pq_chunks, const bool use_opq,
-                                                                const std::string &codebook_prefix);
+                                                                const std::string &codebook_prefix,
+                                                                const uint32_t num_pq_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<uint8_t>(const std::string &data_file_to_use,
                                                                  const std::string &pq_pivots_path,
                                                                  const std::string &pq_compressed_vectors_path,
                                                                  diskann::Metric compareMetric, const double p_val,
                                                                  const size_t num_pq_chunks, const bool use_opq,
-                                                                 const std::string &codebook_prefix);
+                                                                 const std::string &codebook_prefix,
+                                                                 const uint32_t num_pq_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<float>(const std::string &data_file_to_use,
                                                                const std::string &pq_pivots_path,
                                                                const std::string &pq_compressed_vectors_path,
                                                                diskann::Metric compareMetric, const double p_val,
                                                                const size_t num_pq_chunks, const bool use_opq,
-                                                               const std::string &codebook_prefix);
+                                                               const std::string &codebook_prefix,
+                                                               const uint32_t num_pq_centers);
 } // namespace diskann
@@ -2,31 +2,38 @@
 // Licensed under the MIT license.
 
 #include "common_includes.h"
+#include <exception>
 
 #include "timer.h"
 #include "pq.h"
 #include "pq_scratch.h"
 #include "pq_flash_index.h"
 #include "cosine_similarity.h"
+#include "nhood_codec.h"
+#include "numa_utils.h"
 
 #ifdef _WINDOWS
 #include "windows_aligned_file_reader.h"
 #else
 #include "linux_aligned_file_reader.h"
+#include "striped_aligned_file_reader.h"
 #endif
 
 #define READ_U64(stream, val) stream.read((char *)&val, sizeof(uint64_t))
 #define READ_U32(stream, val) stream.read((char *)&val, sizeof(uint32_t))
 #define READ_UNSIGNED(stream, val) stream.read((char *)&val, sizeof(unsigned))
 
-// sector # beyond the end of graph where data for id is present for reordering
-#define VECTOR_SECTOR_NO(id) (((uint64_t)(id)) / _nvecs_per_sector + _reorder_data_start_sector)
-
-// sector # beyond the end of graph where data for id is present for reordering
-#define VECTOR_SECTOR_OFFSET(id) ((((uint64_t)(id)) % _nvecs_per_sector) * _data_dim * sizeof(float))
-
 namespace diskann
 {
+// layout of the cache files of save_cache_list: magic, version, flags,
+// index checksum, #nodes, max degree, aligned dim and sizeof(T), then the
+// node ids and, if packed, the neighbor counts, neighbor lists and coords of
+// the nodes as load_cache_list lays them out in memory
+const uint64_t CACHE_FILE_MAGIC = 0x484341434e4e4144; // "DANNCACH"
+const uint32_t CACHE_FILE_VERSION = 1;
+const uint32_t CACHE_FILE_PACKED = 1;
+const uint64_t CACHE_FILE_HEADER_SIZE = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + 4 * sizeof(uint64_t);
+const uint64_t CACHE_FILE_CHECKSUM_SECTORS = 64;
 
 template <typename T, typename LabelT>
 PQFlashIndex<T, LabelT>::PQFlashIndex(std::shared_ptr<AlignedFileReader> &fileReader, diskann::Metric m)
@@ -57,10 +64,13 @@ PQFlashIndex<T, LabelT>::PQFlashIndex(std::shared_ptr<AlignedFileReader> &fileRe
 
 template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
 {
+    if (!_async_workers.empty())
+        stop_async_search();
+
 #ifndef EXEC_ENV_OLS
     if (data != nullptr)
     {
-        delete[] data;
+        aligned_free(data);
     }
 #endif
 
@@ -69,16 +79,21 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
     // delete backing bufs for nhood and coord cache
     if (_nhood_cache_buf != nullptr)
     {
-        delete[] _nhood_cache_buf;
+        diskann::aligned_free(_nhood_cache_buf);
         diskann::aligned_free(_coord_cache_buf);
     }
 
+    for (auto &replica : _numa_replicas)
+    {
+        aligned_free(replica.pq_data);
+        aligned_free(replica.nhood_cache_buf);
+        aligned_free(replica.coord_cache_buf);
+    }
+
     if (_load_flag)
     {
         diskann::cout << "Clearing scratch" << std::endl;
-        ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
-        manager.destroy();
-        this->reader->deregister_all_threads();
+        destroy_thread_data();
         reader->close();
     }
     if (_pts_to_label_offsets != nullptr)
@@ -101,18 +116,26 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
 
 template <typename T, typename LabelT> inline uint64_t PQFlashIndex<T, LabelT>::get_node_sector(uint64_t node_id)
 {
-    return 1 + (_nnodes_per_sector > 0 ? node_id / _nnodes_per_sector
-                                       : node_id * DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN));
+    uint64_t node_pos = _node_pos == nullptr ? node_id : _node_pos[node_id];
+    return 1 + (_nnodes_per_sector > 0 ? node_pos / _nnodes_per_sector
+                                       : node_pos * DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN));
 }
 
 template <typename T, typename LabelT>
 inline char *PQFlashIndex<T, LabelT>::offset_to_node(char *sector_buf, uint64_t node_id)
 {
-    return sector_buf + (_nnodes_per_sector == 0 ? 0 : (node_id % _nnodes_per_sector) * _max_node_len);
+    uint64_t node_pos = _node_pos == nullptr ? node_id : _node_pos[node_id];
+    return sector_buf + (_nnodes_per_sector == 0 ? 0 : (node_pos % _nnodes_per_sector) * _max_node_len);
 }
 
-template <typename T, typename LabelT> inline uint32_t *PQFlashIndex<T, LabelT>::offset_to_node_nhood(char *node_buf)
+template <typename T, typename LabelT>
+inline uint32_t *PQFlashIndex<T, LabelT>::offset_to_node_nhood(char *node_buf, uint32_t *nhood_buf)
 {
+    if (_packed_nhoods)
+    {
+        nhood_buf[0] = unpack_nhood(node_buf + _disk_bytes_per_point, nhood_buf + 1);
+        return nhood_buf;
+    }
     return (unsigned *)(node_buf + _disk_bytes_per_point);
 }
 
@@ -121,25 +144,251 @@ template <typename T, typename LabelT> inline T *PQFlashIndex<T, LabelT>::offset
     return (T *)(node_buf);
 }
 
+template <typename T, typename LabelT> inline uint64_t PQFlashIndex<T, LabelT>::get_vector_sector(uint64_t node_id)
+{
+    return _reorder_data_start_sector +
+           (_nvecs_per_sector > 0 ? node_id / _nvecs_per_sector
+                                  : node_id * DIV_ROUND_UP(_vector_len, defaults::SECTOR_LEN));
+}
+
+template <typename T, typename LabelT>
+inline char *PQFlashIndex<T, LabelT>::offset_to_vector(char *sector_buf, uint64_t node_id)
+{
+    return sector_buf + (_nvecs_per_sector == 0 ? 0 : (node_id % _nvecs_per_sector) * _vector_len);
+}
+
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::setup_thread_data(uint64_t nthreads, uint64_t visited_reserve)
 {
     diskann::cout << "Setting up thread-specific contexts for nthreads: " << nthreads << std::endl;
+    // in NUMA mode, a pool of scratch per node, with the threads spread
+    // evenly over the nodes
+    uint32_t num_pools = _numa_aware ? (uint32_t)(std::min)((uint64_t)numa::num_nodes(), nthreads) : 0;
+    for (uint32_t node = 0; node < num_pools; node++)
+        _numa_thread_data.emplace_back(new ScratchPool<SSDThreadData<T> *>(nullptr));
+    if (num_pools > 0)
+        diskann::cout << "Spreading the thread contexts over " << num_pools << " NUMA node(s)" << std::endl;
+    VisitedSetPolicy visited_mode = VisitedSet::resolve(_visited_policy, _num_points);
+    diskann::cout << "Tracking visited nodes with a " << VisitedSet::name(visited_mode) << " of "
+                  << VisitedSet::memory_usage(visited_mode, _num_points, visited_reserve) / 1024
+                  << "KB per thread context" << std::endl;
+
+    // an exception cannot leave the parallel region, so the first failure to
+    // set up a reader context is kept and rethrown after it
+    std::exception_ptr setup_error;
+
 // omp parallel for to generate unique thread IDs
 #pragma omp parallel for num_threads((int)nthreads)
     for (int64_t thread = 0; thread < (int64_t)nthreads; thread++)
     {
 #pragma omp critical
+        if (!setup_error)
         {
-            SSDThreadData<T> *data = new SSDThreadData<T>(this->_aligned_dim, visited_reserve);
-            this->reader->register_thread();
-            data->ctx = this->reader->get_ctx();
-            this->_thread_data.push(data);
+            // allocate while bound to the node, so the scratch is local to it
+            uint32_t node = num_pools > 0 ? (uint32_t)(thread % num_pools) : 0;
+            std::unique_ptr<numa::ScopedNodeBinding> binding(num_pools > 0 ? new numa::ScopedNodeBinding(node)
+                                                                            : nullptr);
+            SSDThreadData<T> *data =
+                new SSDThreadData<T>(this->_aligned_dim, visited_reserve, _visited_policy, _num_points);
+            data->numa_node = node;
+            try
+            {
+                this->reader->register_thread();
+                data->ctx = this->reader->get_ctx();
+                this->reader->register_buffer(data->ctx, data->scratch.sector_scratch,
+                                              defaults::MAX_N_SECTOR_READS * defaults::SECTOR_LEN);
+                if (num_pools > 0)
+                    this->_numa_thread_data[node]->push(data);
+                else
+                    this->_thread_data.push(data);
+            }
+            catch (...)
+            {
+                delete data;
+                setup_error = std::current_exception();
+            }
         }
     }
+    if (setup_error)
+    {
+        // the destructor only frees the contexts of a loaded index
+        destroy_thread_data();
+        std::rethrow_exception(setup_error);
+    }
     _load_flag = true;
 }
 
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::destroy_thread_data()
+{
+    // no search holds a context by now, and a pool that setup_thread_data()
+    // left empty must not be waited on
+    auto destroy_pool = [](ScratchPool<SSDThreadData<T> *> &pool) {
+        for (SSDThreadData<T> *data = pool.pop(); data != nullptr; data = pool.pop())
+            delete data;
+    };
+    destroy_pool(_thread_data);
+    for (auto &pool : _numa_thread_data)
+        destroy_pool(*pool);
+    _numa_thread_data.clear();
+    this->reader->deregister_all_threads();
+}
+
+template <typename T, typename LabelT>
+ScratchPool<SSDThreadData<T> *> &PQFlashIndex<T, LabelT>::thread_data_pool()
+{
+    if (_numa_thread_data.empty())
+        return _thread_data;
+    // a node holds only its share of the contexts, so a caller that is not
+    // bound to the nodes evenly takes a free context of another node rather
+    // than wait for one of its own
+    size_t local = numa::current_node() % _numa_thread_data.size();
+    for (size_t i = 0; i < _numa_thread_data.size(); i++)
+    {
+        auto &pool = *_numa_thread_data[(local + i) % _numa_thread_data.size()];
+        if (!pool.empty())
+            return pool;
+    }
+    return *_numa_thread_data[local];
+}
+
+template <typename T, typename LabelT> const uint8_t *PQFlashIndex<T, LabelT>::local_pq_data(uint32_t numa_node) const
+{
+    if (numa_node < _numa_replicas.size() && _numa_replicas[numa_node].pq_data != nullptr)
+        return _numa_replicas[numa_node].pq_data;
+    return data;
+}
+
+template <typename T, typename LabelT>
+const tsl::robin_map<uint32_t, std::pair<uint32_t, uint32_t *>> &PQFlashIndex<T, LabelT>::local_nhood_cache(
+    uint32_t numa_node) const
+{
+    if (numa_node < _numa_replicas.size() && _numa_replicas[numa_node].nhood_cache_buf != nullptr)
+        return _numa_replicas[numa_node].nhood_cache;
+    return _nhood_cache;
+}
+
+template <typename T, typename LabelT>
+const tsl::robin_map<uint32_t, T *> &PQFlashIndex<T, LabelT>::local_coord_cache(uint32_t numa_node) const
+{
+    if (numa_node < _numa_replicas.size() && _numa_replicas[numa_node].coord_cache_buf != nullptr)
+        return _numa_replicas[numa_node].coord_cache;
+    return _coord_cache;
+}
+
+namespace
+{
+// copies len bytes with threads bound to node, so that the pages of dst are
+// first touched, and so placed, on that node
+void copy_to_numa_node(char *dst, const char *src, size_t len, uint32_t node, uint64_t nthreads)
+{
+    const size_t CHUNK_SIZE = 64 * 1024 * 1024;
+    int64_t num_chunks = (int64_t)DIV_ROUND_UP(len, CHUNK_SIZE);
+#pragma omp parallel num_threads((int)(std::max)(nthreads, (uint64_t)1))
+    {
+        numa::ScopedNodeBinding binding(node);
+#pragma omp for schedule(dynamic, 1)
+        for (int64_t c = 0; c < num_chunks; c++)
+        {
+            size_t start = (size_t)c * CHUNK_SIZE;
+            memcpy(dst + start, src + start, (std::min)(CHUNK_SIZE, len - start));
+        }
+    }
+}
+} // namespace
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::place_pq_data_on_numa_nodes()
+{
+    if (_numa_thread_data.empty() || data == nullptr)
+        return;
+    size_t len = _num_points * _pq_code_len;
+    uint32_t num_copies = _numa_replicate ? (uint32_t)_numa_thread_data.size() : 1;
+    _numa_replicas.resize(_numa_thread_data.size());
+    // node 0 last, as its copy replaces the array the others copy from
+    for (uint32_t node = num_copies; node-- > 0;)
+    {
+        uint8_t *copy = nullptr;
+        alloc_aligned_large((void **)&copy, len, 64, _use_huge_pages);
+        copy_to_numa_node((char *)copy, (const char *)data, len, node, _max_nthreads);
+        if (node > 0)
+        {
+            _numa_replicas[node].pq_data = copy;
+            continue;
+        }
+        aligned_free(data);
+        data = copy;
+    }
+    diskann::cout << "Placed " << num_copies << " cop" << (num_copies > 1 ? "ies" : "y")
+                  << " of the PQ compressed vectors on NUMA nodes" << std::endl;
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::place_node_cache_on_numa_nodes()
+{
+    if (_numa_thread_data.empty() || _num_cached_nodes == 0)
+        return;
+    size_t nhood_len = _num_cached_nodes * (_max_degree + 1) * sizeof(uint32_t);
+    size_t coord_len = _num_cached_nodes * _aligned_dim * sizeof(T);
+    uint32_t num_copies = _numa_replicate ? (uint32_t)_numa_thread_data.size() : 1;
+    _numa_replicas.resize(_numa_thread_data.size());
+    for (uint32_t node = num_copies; node-- > 0;)
+    {
+        NumaReplica &replica = _numa_replicas[node];
+        alloc_aligned_large((void **)&replica.nhood_cache_buf, nhood_len, sizeof(uint32_t), _use_huge_pages);
+        alloc_aligned_large((void **)&replica.coord_cache_buf, coord_len, 8 * sizeof(T), _use_huge_pages);
+        copy_to_numa_node((char *)replica.nhood_cache_buf, (const char *)_nhood_cache_buf, nhood_len, node,
+                          _max_nthreads);
+        copy_to_numa_node((char *)replica.coord_cache_buf, (const char *)_coord_cache_buf, coord_len, node,
+                          _max_nthreads);
+        {
+            // the maps point into the buffers of their node
+            numa::ScopedNodeBinding binding(node);
+            replica.nhood_cache.reserve(_nhood_cache.size());
+            for (auto &entry : _nhood_cache)
+                replica.nhood_cache.insert(std::make_pair(
+                    entry.first, std::make_pair(entry.second.first,
+                                                replica.nhood_cache_buf + (entry.second.second - _nhood_cache_buf))));
+            replica.coord_cache.reserve(_coord_cache.size());
+            for (auto &entry : _coord_cache)
+                replica.coord_cache.insert(
+                    std::make_pair(entry.first, replica.coord_cache_buf + (entry.second - _coord_cache_buf)));
+        }
+        if (node > 0)
+            continue;
+        aligned_free(_nhood_cache_buf);
+        aligned_free(_coord_cache_buf);
+        _nhood_cache_buf = replica.nhood_cache_buf;
+        _coord_cache_buf = replica.coord_cache_buf;
+        _nhood_cache = std::move(replica.nhood_cache);
+        _coord_cache = std::move(replica.coord_cache);
+        replica = NumaReplica();
+    }
+    diskann::cout << "Placed " << num_copies << " cop" << (num_copies > 1 ? "ies" : "y")
+                  << " of the node cache on NUMA nodes" << std::endl;
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::set_numa_mode(bool enable, bool replicate)
+{
+    _numa_aware = enable;
+    _numa_replicate = enable && replicate;
+}
+
+template <typename T, typename LabelT> std::vector<uint64_t> PQFlashIndex<T, LabelT>::get_numa_memory_usage() const
+{
+    std::vector<uint64_t> usage(_numa_thread_data.size(), 0);
+    if (usage.empty())
+        return usage;
+    uint64_t pq_len = data != nullptr ? _num_points * _pq_code_len : 0;
+    uint64_t cache_len = _num_cached_nodes * ((_max_degree + 1) * sizeof(uint32_t) + _aligned_dim * sizeof(T));
+    usage[0] = pq_len + cache_len;
+    for (size_t node = 1; node < _numa_replicas.size(); node++)
+    {
+        if (_numa_replicas[node].pq_data != nullptr)
+            usage[node] += pq_len;
+        if (_numa_replicas[node].nhood_cache_buf != nullptr)
+            usage[node] += cache_len;
+    }
+    return usage;
+}
+
 template <typename T, typename LabelT>
 std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t> &node_ids,
                                                       std::vector<T *> &coord_buffers,
@@ -164,13 +413,35 @@ std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t
         read_reqs.push_back(read);
     }
 
+    // with a decoupled layout the coords are read from the vector region
+    std::vector<AlignedRead> vec_read_reqs;
+    std::vector<char *> vec_bufs(node_ids.size(), nullptr);
+    char *vec_buf = nullptr;
+    auto num_vec_sectors = _nvecs_per_sector > 0 ? 1 : DIV_ROUND_UP(_vector_len, defaults::SECTOR_LEN);
+    if (_decoupled_vectors)
+    {
+        alloc_aligned((void **)&vec_buf, node_ids.size() * num_vec_sectors * defaults::SECTOR_LEN,
+                      defaults::SECTOR_LEN);
+        for (size_t i = 0; i < node_ids.size(); ++i)
+        {
+            if (coord_buffers[i] == nullptr)
+                continue;
+            vec_bufs[i] = vec_buf + vec_read_reqs.size() * num_vec_sectors * defaults::SECTOR_LEN;
+            vec_read_reqs.emplace_back(get_vector_sector(node_ids[i]) * defaults::SECTOR_LEN,
+                                       num_vec_sectors * defaults::SECTOR_LEN, vec_bufs[i]);
+        }
+    }
+
     // borrow thread data and issue reads
-    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
+    ScratchStoreManager<SSDThreadData<T>> manager(thread_data_pool());
     auto this_thread_data = manager.scratch_space();
     IOContext &ctx = this_thread_data->ctx;
     reader->read(read_reqs, ctx);
+    if (!vec_read_reqs.empty())
+        reader->read(vec_read_reqs, ctx);
 
     // copy reads into buffers
+    std::vector<uint32_t> nhood_buf(_max_degree + 1);
     for (uint32_t i = 0; i < read_reqs.size(); i++)
     {
 #if defined(_WINDOWS) && defined(USE_BING_INFRA) // this block is to handle failed reads in
@@ -184,7 +455,11 @@ std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t
 
         char *node_buf = offset_to_node((char *)read_reqs[i].buf, node_ids[i]);
 
-        if (coord_buffers[i] != nullptr)
+        if (coord_buffers[i] != nullptr && _decoupled_vectors)
+        {
+            memcpy(coord_buffers[i], offset_to_vector(vec_bufs[i], node_ids[i]), _vector_len);
+        }
+        else if (coord_buffers[i] != nullptr)
         {
             T *node_coords = offset_to_node_coords(node_buf);
             memcpy(coord_buffers[i], node_coords, _disk_bytes_per_point);
@@ -192,7 +467,7 @@ std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t
 
         if (nbr_buffers[i].second != nullptr)
         {
-            uint32_t *node_nhood = offset_to_node_nhood(node_buf);
+            uint32_t *node_nhood = offset_to_node_nhood(node_buf, nhood_buf.data());
             auto num_nbrs = *node_nhood;
             nbr_buffers[i].first = num_nbrs;
             memcpy(nbr_buffers[i].second, node_nhood + 1, num_nbrs * sizeof(uint32_t));
@@ -200,30 +475,74 @@ std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t
     }
 
     aligned_free(buf);
+    if (vec_buf != nullptr)
+        aligned_free(vec_buf);
 
     return retval;
 }
 
-template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_list(std::vector<uint32_t> &node_list)
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::record_load_phase(const std::string &phase, Timer &timer)
 {
-    diskann::cout << "Loading the cache list into memory.." << std::flush;
-    size_t num_cached_nodes = node_list.size();
+    _load_phase_times.emplace_back(phase, timer.elapsed_seconds());
+    diskann::cout << "Load phase '" << phase << "' took " << _load_phase_times.back().second << "s" << std::endl;
+    timer.reset();
+}
+
+template <typename T, typename LabelT>
+const std::vector<std::pair<std::string, float>> &PQFlashIndex<T, LabelT>::get_load_phase_times() const
+{
+    return _load_phase_times;
+}
 
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::set_huge_pages(bool enable)
+{
+    _use_huge_pages = enable;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_visited_set_policy(VisitedSetPolicy policy)
+{
+    _visited_policy = policy;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::alloc_cache_bufs(size_t num_cached_nodes)
+{
     // Allocate space for neighborhood cache
-    _nhood_cache_buf = new uint32_t[num_cached_nodes * (_max_degree + 1)];
-    memset(_nhood_cache_buf, 0, num_cached_nodes * (_max_degree + 1));
+    size_t nhood_cache_buf_size = num_cached_nodes * (_max_degree + 1) * sizeof(uint32_t);
+    diskann::alloc_aligned_large((void **)&_nhood_cache_buf, nhood_cache_buf_size, sizeof(uint32_t),
+                                 _use_huge_pages);
+    memset(_nhood_cache_buf, 0, nhood_cache_buf_size);
 
     // Allocate space for coordinate cache
     size_t coord_cache_buf_len = num_cached_nodes * _aligned_dim;
-    diskann::alloc_aligned((void **)&_coord_cache_buf, coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
+    diskann::alloc_aligned_large((void **)&_coord_cache_buf, coord_cache_buf_len * sizeof(T), 8 * sizeof(T),
+                                 _use_huge_pages);
     memset(_coord_cache_buf, 0, coord_cache_buf_len * sizeof(T));
+    _num_cached_nodes = num_cached_nodes;
+}
 
-    size_t BLOCK_SIZE = 8;
-    size_t num_blocks = DIV_ROUND_UP(num_cached_nodes, BLOCK_SIZE);
-    for (size_t block = 0; block < num_blocks; block++)
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::read_cache_nodes(const std::vector<uint32_t> &node_list, T *coord_buf,
+                                               uint32_t *nhood_buf, std::vector<uint32_t> &nhood_sizes,
+                                               std::vector<bool> &read_status)
+{
+    size_t num_nodes = node_list.size();
+    nhood_sizes.assign(num_nodes, 0);
+    read_status.assign(num_nodes, false);
+
+    // each block is read by one thread with a single batched submission
+    // through read_nodes; the blocks are spread over all the thread contexts
+    // set up by load() so that many submissions are in flight at once
+    size_t BLOCK_SIZE = defaults::CACHE_LOAD_BATCH_SIZE;
+    size_t num_blocks = DIV_ROUND_UP(num_nodes, BLOCK_SIZE);
+    std::vector<std::vector<bool>> block_status(num_blocks);
+#pragma omp parallel for schedule(dynamic, 1) num_threads((int)(std::max)(_max_nthreads, (uint64_t)1))
+    for (int64_t block = 0; block < (int64_t)num_blocks; block++)
     {
         size_t start_idx = block * BLOCK_SIZE;
-        size_t end_idx = (std::min)(num_cached_nodes, (block + 1) * BLOCK_SIZE);
+        size_t end_idx = (std::min)(num_nodes, (block + 1) * BLOCK_SIZE);
 
         // Copy offset into buffers to read into
         std::vector<uint32_t> nodes_to_read;
@@ -232,26 +551,241 @@ template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_
         for (size_t node_idx = start_idx; node_idx < end_idx; node_idx++)
         {
             nodes_to_read.push_back(node_list[node_idx]);
-            coord_buffers.push_back(_coord_cache_buf + node_idx * _aligned_dim);
-            nbr_buffers.emplace_back(0, _nhood_cache_buf + node_idx * (_max_degree + 1));
+            coord_buffers.push_back(coord_buf + node_idx * _aligned_dim);
+            nbr_buffers.emplace_back(0, nhood_buf + node_idx * (_max_degree + 1));
         }
 
         // issue the reads
-        auto read_status = read_nodes(nodes_to_read, coord_buffers, nbr_buffers);
+        block_status[block] = read_nodes(nodes_to_read, coord_buffers, nbr_buffers);
+        for (size_t i = 0; i < nbr_buffers.size(); i++)
+            nhood_sizes[start_idx + i] = nbr_buffers[i].first;
+    }
+
+    // std::vector<bool> packs bits, so it is only written to here
+    for (size_t block = 0; block < num_blocks; block++)
+    {
+        for (size_t i = 0; i < block_status[block].size(); i++)
+            read_status[block * BLOCK_SIZE + i] = block_status[block][i];
+    }
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::fill_cache_maps(const std::vector<uint32_t> &node_list,
+                                              const std::vector<uint32_t> &nhood_sizes,
+                                              const std::vector<bool> &read_status)
+{
+    // check for success and insert into the cache; the maps are not
+    // thread-safe, so this is done once all the reads are in
+    for (size_t node_idx = 0; node_idx < node_list.size(); node_idx++)
+    {
+        if (read_status[node_idx] == true)
+        {
+            _coord_cache.insert(std::make_pair(node_list[node_idx], _coord_cache_buf + node_idx * _aligned_dim));
+            _nhood_cache.insert(std::make_pair(
+                node_list[node_idx],
+                std::make_pair(nhood_sizes[node_idx], _nhood_cache_buf + node_idx * (_max_degree + 1))));
+        }
+    }
+    place_node_cache_on_numa_nodes();
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_list(std::vector<uint32_t> &node_list)
+{
+    diskann::cout << "Loading the cache list into memory.." << std::flush;
+    Timer cache_timer;
+    alloc_cache_bufs(node_list.size());
+
+    std::vector<uint32_t> nhood_sizes;
+    std::vector<bool> read_status;
+    read_cache_nodes(node_list, _coord_cache_buf, _nhood_cache_buf, nhood_sizes, read_status);
+    fill_cache_maps(node_list, nhood_sizes, read_status);
+    diskann::cout << "..done." << std::endl;
+    record_load_phase("cache list", cache_timer);
+}
+
+#ifndef EXEC_ENV_OLS
+template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::get_index_checksum()
+{
+    // the header sector and the sectors of evenly spaced nodes; reading the
+    // whole index would take longer than regenerating the cache
+    std::vector<uint64_t> sample_nodes, sectors{0};
+    uint64_t num_samples = (std::min)((uint64_t)_num_points, (uint64_t)CACHE_FILE_CHECKSUM_SECTORS);
+    for (uint64_t i = 0; i < num_samples; i++)
+    {
+        sample_nodes.push_back(i * _num_points / num_samples);
+        sectors.push_back(get_node_sector(sample_nodes.back()));
+    }
+
+    char *buf = nullptr;
+    alloc_aligned((void **)&buf, sectors.size() * defaults::SECTOR_LEN, defaults::SECTOR_LEN);
+    std::vector<AlignedRead> read_reqs;
+    for (size_t i = 0; i < sectors.size(); i++)
+        read_reqs.emplace_back(sectors[i] * defaults::SECTOR_LEN, defaults::SECTOR_LEN,
+                               buf + i * defaults::SECTOR_LEN);
+    {
+        ScratchStoreManager<SSDThreadData<T>> manager(thread_data_pool());
+        reader->read(read_reqs, manager.scratch_space()->ctx);
+    }
+    uint64_t checksum = fnv1a_hash64(buf, sectors.size() * defaults::SECTOR_LEN);
+    aligned_free(buf);
+
+    // the sampled sectors can match after the index is rebuilt, or the PQ
+    // files alone are replaced, so the file sizes, the PQ pivots, which are
+    // small, and the PQ codes of the sampled nodes go into the hash too
+    uint64_t file_sizes[3] = {get_file_size(_disk_index_file), get_file_size(_pq_pivots_file),
+                              get_file_size(_pq_compressed_file)};
+    checksum = fnv1a_hash64(file_sizes, sizeof(file_sizes), checksum);
+    std::vector<char> pivots(file_sizes[1]);
+    std::ifstream pivots_reader(_pq_pivots_file, std::ios::binary);
+    pivots_reader.read(pivots.data(), pivots.size());
+    checksum = fnv1a_hash64(pivots.data(), pivots.size(), checksum);
+    for (auto node : sample_nodes)
+        checksum = fnv1a_hash64(data + node * _pq_code_len, _pq_code_len, checksum);
+    return checksum;
+}
 
-        // check for success and insert into the cache.
-        for (size_t i = 0; i < read_status.size(); i++)
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::save_cache_list(const std::string &cache_file, const std::vector<uint32_t> &node_list,
+                                              bool pack_nodes)
+{
+    diskann::cout << "Saving " << node_list.size() << " cache nodes to " << cache_file
+                  << (pack_nodes ? " with their contents" : "") << ".." << std::flush;
+    uint64_t num_nodes = node_list.size();
+    uint32_t flags = pack_nodes ? CACHE_FILE_PACKED : 0;
+    uint64_t checksum = get_index_checksum();
+    uint64_t max_degree = _max_degree, aligned_dim = _aligned_dim, coord_size = sizeof(T);
+
+    std::ofstream writer;
+    writer.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    try
+    {
+        writer.open(cache_file, std::ios::binary | std::ios::out | std::ios::trunc);
+        writer.write((const char *)&CACHE_FILE_MAGIC, sizeof(uint64_t));
+        writer.write((const char *)&CACHE_FILE_VERSION, sizeof(uint32_t));
+        writer.write((char *)&flags, sizeof(uint32_t));
+        writer.write((char *)&checksum, sizeof(uint64_t));
+        writer.write((char *)&num_nodes, sizeof(uint64_t));
+        writer.write((char *)&max_degree, sizeof(uint64_t));
+        writer.write((char *)&aligned_dim, sizeof(uint64_t));
+        writer.write((char *)&coord_size, sizeof(uint64_t));
+        writer.write((char *)node_list.data(), num_nodes * sizeof(uint32_t));
+
+        if (pack_nodes)
         {
-            if (read_status[i] == true)
+            // laid out exactly as load_cache_list keeps them in memory
+            std::vector<uint32_t> nhood_buf(num_nodes * (_max_degree + 1), 0);
+            std::vector<T> coord_buf(num_nodes * _aligned_dim, 0);
+            std::vector<uint32_t> nhood_sizes;
+            std::vector<bool> read_status;
+            read_cache_nodes(node_list, coord_buf.data(), nhood_buf.data(), nhood_sizes, read_status);
+            if (std::find(read_status.begin(), read_status.end(), false) != read_status.end())
             {
-                _coord_cache.insert(std::make_pair(nodes_to_read[i], coord_buffers[i]));
-                _nhood_cache.insert(std::make_pair(nodes_to_read[i], nbr_buffers[i]));
+                throw ANNException("Failed to read the nodes to cache from the disk index", -1, __FUNCSIG__,
+                                   __FILE__, __LINE__);
             }
+            writer.write((char *)nhood_sizes.data(), num_nodes * sizeof(uint32_t));
+            writer.write((char *)nhood_buf.data(), nhood_buf.size() * sizeof(uint32_t));
+            writer.write((char *)coord_buf.data(), coord_buf.size() * sizeof(T));
+        }
+        writer.close();
+    }
+    catch (std::system_error &e)
+    {
+        throw FileException(cache_file, e, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    diskann::cout << "done." << std::endl;
+}
+
+template <typename T, typename LabelT> bool PQFlashIndex<T, LabelT>::load_cache_list(const std::string &cache_file)
+{
+    if (!file_exists(cache_file))
+        return false;
+    Timer cache_timer;
+
+    std::ifstream cache_reader(cache_file, std::ios::binary | std::ios::ate);
+    uint64_t file_size = cache_reader.tellg();
+    cache_reader.seekg(0, cache_reader.beg);
+
+    uint64_t magic = 0, checksum = 0, num_nodes = 0, max_degree = 0, aligned_dim = 0, coord_size = 0;
+    uint32_t version = 0, flags = 0;
+    cache_reader.read((char *)&magic, sizeof(uint64_t));
+    cache_reader.read((char *)&version, sizeof(uint32_t));
+    cache_reader.read((char *)&flags, sizeof(uint32_t));
+    cache_reader.read((char *)&checksum, sizeof(uint64_t));
+    cache_reader.read((char *)&num_nodes, sizeof(uint64_t));
+    cache_reader.read((char *)&max_degree, sizeof(uint64_t));
+    cache_reader.read((char *)&aligned_dim, sizeof(uint64_t));
+    cache_reader.read((char *)&coord_size, sizeof(uint64_t));
+
+    bool packed = (flags & CACHE_FILE_PACKED) != 0;
+    uint64_t expected_size = CACHE_FILE_HEADER_SIZE + num_nodes * sizeof(uint32_t);
+    if (packed)
+        expected_size += num_nodes * (sizeof(uint32_t) + (max_degree + 1) * sizeof(uint32_t) +
+                                      aligned_dim * coord_size);
+
+    std::string reason;
+    if (!cache_reader || magic != CACHE_FILE_MAGIC)
+        reason = "not a cache file";
+    else if (version != CACHE_FILE_VERSION)
+        reason = "unsupported version " + std::to_string(version);
+    else if (file_size != expected_size)
+        reason = "truncated";
+    else if (max_degree != _max_degree || aligned_dim != _aligned_dim || coord_size != sizeof(T))
+        reason = "node format differs from the index";
+    else if (checksum != get_index_checksum())
+        reason = "built for a different index file";
+    if (!reason.empty())
+    {
+        diskann::cerr << "Ignoring cache file " << cache_file << ": " << reason << std::endl;
+        return false;
+    }
+
+    diskann::cout << "Loading " << num_nodes << " cache nodes from " << cache_file << ".." << std::flush;
+    std::vector<uint32_t> node_list(num_nodes);
+    cache_reader.read((char *)node_list.data(), num_nodes * sizeof(uint32_t));
+    alloc_cache_bufs(num_nodes);
+
+    std::vector<uint32_t> nhood_sizes;
+    std::vector<bool> read_status;
+    if (packed)
+    {
+        nhood_sizes.resize(num_nodes);
+        read_status.assign(num_nodes, true);
+        cache_reader.read((char *)nhood_sizes.data(), num_nodes * sizeof(uint32_t));
+        cache_reader.read((char *)_nhood_cache_buf, num_nodes * (_max_degree + 1) * sizeof(uint32_t));
+        cache_reader.read((char *)_coord_cache_buf, num_nodes * _aligned_dim * sizeof(T));
+        if (!cache_reader)
+        {
+            throw ANNException("Failed to read cache file " + cache_file, -1, __FUNCSIG__, __FILE__, __LINE__);
         }
     }
+    else
+    {
+        read_cache_nodes(node_list, _coord_cache_buf, _nhood_cache_buf, nhood_sizes, read_status);
+    }
+    fill_cache_maps(node_list, nhood_sizes, read_status);
     diskann::cout << "..done." << std::endl;
+    record_load_phase("cache file", cache_timer);
+    return true;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::save_tombstones(const std::string &tombstone_file)
+{
+    diskann::cout << "Saving " << _tombstones.count() << " deleted points to " << tombstone_file << std::endl;
+    _tombstones.save(tombstone_file, get_index_checksum());
 }
 
+template <typename T, typename LabelT>
+bool PQFlashIndex<T, LabelT>::load_tombstones(const std::string &tombstone_file)
+{
+    if (!_tombstones.load(tombstone_file, get_index_checksum()))
+        return false;
+    diskann::cout << "Loaded " << _tombstones.count() << " deleted points from " << tombstone_file << std::endl;
+    return true;
+}
+#endif
+
 #ifdef EXEC_ENV_OLS
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::generate_cache_list_from_sample_queries(MemoryMappedFiles &files, std::string sample_bin,
@@ -785,6 +1319,8 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
                                                       const char *pivots_filepath, const char *compressed_filepath)
 {
 #endif
+    Timer phase_timer;
+    _load_phase_times.clear();
     std::string pq_table_bin = pivots_filepath;
     std::string pq_compressed_vectors = compressed_filepath;
     std::string _disk_index_file = index_filepath;
@@ -805,12 +1341,16 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 #endif
 
     this->_disk_index_file = _disk_index_file;
+    this->_pq_pivots_file = pq_table_bin;
+    this->_pq_compressed_file = pq_compressed_vectors;
 
-    if (pq_file_num_centroids != 256)
+    if (pq_file_num_centroids != NUM_PQ_CENTROIDS && pq_file_num_centroids != NUM_PQ_CENTROIDS_4BIT)
     {
-        diskann::cout << "Error. Number of PQ centroids is not 256. Exiting." << std::endl;
+        diskann::cout << "Error. Number of PQ centroids is not " << NUM_PQ_CENTROIDS << " or "
+                      << NUM_PQ_CENTROIDS_4BIT << ". Exiting." << std::endl;
         return -1;
     }
+    this->_use_pq_fast_scan = pq_file_num_centroids == NUM_PQ_CENTROIDS_4BIT;
 
     this->_data_dim = pq_file_dim;
     // will change later if we use PQ on disk or if we are using
@@ -822,11 +1362,15 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 #ifdef EXEC_ENV_OLS
     diskann::load_bin<uint8_t>(files, pq_compressed_vectors, this->data, npts_u64, nchunks_u64);
 #else
-    diskann::load_bin<uint8_t>(pq_compressed_vectors, this->data, npts_u64, nchunks_u64);
+    diskann::load_bin_parallel<uint8_t>(pq_compressed_vectors, this->data, npts_u64, nchunks_u64, num_threads,
+                                        _use_huge_pages);
 #endif
+    record_load_phase("compressed vectors", phase_timer);
 
     this->_num_points = npts_u64;
+    _tombstones.resize(npts_u64);
     this->_n_chunks = nchunks_u64;
+    this->_pq_code_len = nchunks_u64;
 #ifdef EXEC_ENV_OLS
     if (files.fileExists(labels_file))
     {
@@ -966,11 +1510,26 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
         }
     }
 
+    // the compressed file of 4-bit PQ holds packed bytes, so the number of
+    // chunks comes from the chunk offsets of the pivots file
+    const uint64_t pq_table_nchunks = _use_pq_fast_scan ? 0 : nchunks_u64;
 #ifdef EXEC_ENV_OLS
-    _pq_table.load_pq_centroid_bin(files, pq_table_bin.c_str(), nchunks_u64);
+    _pq_table.load_pq_centroid_bin(files, pq_table_bin.c_str(), pq_table_nchunks);
 #else
-    _pq_table.load_pq_centroid_bin(pq_table_bin.c_str(), nchunks_u64);
+    _pq_table.load_pq_centroid_bin(pq_table_bin.c_str(), pq_table_nchunks);
 #endif
+    if (_use_pq_fast_scan)
+    {
+        _n_chunks = _pq_table.get_num_chunks();
+        if (DIV_ROUND_UP(_n_chunks, 2) != _pq_code_len)
+        {
+            std::stringstream stream;
+            stream << "4-bit PQ pivots have " << _n_chunks << " chunks but the compressed vectors have "
+                   << _pq_code_len << " bytes per point" << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        diskann::cout << "Using 4-bit PQ with fast-scan distance lookups" << std::endl;
+    }
 
     diskann::cout << "Loaded PQ centroids and in-memory compressed vectors. #points: " << _num_points
                   << " #dim: " << _data_dim << " #aligned_dim: " << _aligned_dim << " #chunks: " << _n_chunks
@@ -1007,6 +1566,7 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
         diskann::cout << "Disk index uses PQ data compressed down to " << _disk_pq_n_chunks << " bytes per point."
                       << std::endl;
     }
+    record_load_phase("labels and PQ pivots", phase_timer);
 
 // read index metadata
 #ifdef EXEC_ENV_OLS
@@ -1050,15 +1610,6 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
     READ_U64(index_metadata, _nnodes_per_sector);
     _max_degree = ((_max_node_len - _disk_bytes_per_point) / sizeof(uint32_t)) - 1;
 
-    if (_max_degree > defaults::MAX_GRAPH_DEGREE)
-    {
-        std::stringstream stream;
-        stream << "Error loading index. Ensure that max graph degree (R) does "
-                  "not exceed "
-               << defaults::MAX_GRAPH_DEGREE << std::endl;
-        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
-    }
-
     // setting up concept of frozen points in disk index for streaming-DiskANN
     READ_U64(index_metadata, this->_num_frozen_points);
     uint64_t file_frozen_id;
@@ -1083,12 +1634,78 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
         READ_U64(index_metadata, this->_reorder_data_start_sector);
         READ_U64(index_metadata, this->_ndims_reorder_vecs);
         READ_U64(index_metadata, this->_nvecs_per_sector);
+        this->_vector_len = this->_data_dim * sizeof(float);
+    }
+
+    // layout flags follow the file size in indices written since they were
+    // introduced
+    uint64_t layout_flags = 0;
+    if (nr > (this->_reorder_data_exists ? 12 : 9))
+    {
+        uint64_t disk_index_file_size;
+        READ_U64(index_metadata, disk_index_file_size);
+        READ_U64(index_metadata, layout_flags);
+    }
+    if (layout_flags & defaults::DISK_LAYOUT_PACKED_NHOODS)
+    {
+        // node length no longer gives the degree
+        READ_U64(index_metadata, _max_degree);
+        _packed_nhoods = true;
+    }
+    if (layout_flags & defaults::DISK_LAYOUT_DECOUPLED)
+    {
+        if (_use_disk_index_pq)
+        {
+            throw ANNException("A decoupled layout can not be used with disk PQ", -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        READ_U64(index_metadata, _reorder_data_start_sector);
+        READ_U64(index_metadata, _nvecs_per_sector);
+        _vector_len = _disk_bytes_per_point;
+        _ndims_reorder_vecs = _data_dim;
+        // nodes hold only the nhood
+        _disk_bytes_per_point = 0;
+        if (!_packed_nhoods)
+            _max_degree = (_max_node_len / sizeof(uint32_t)) - 1;
+        _decoupled_vectors = true;
+    }
+
+    if (_max_degree > defaults::MAX_GRAPH_DEGREE)
+    {
+        std::stringstream stream;
+        stream << "Error loading index. Ensure that max graph degree (R) does "
+                  "not exceed "
+               << defaults::MAX_GRAPH_DEGREE << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
     diskann::cout << "Disk-Index File Meta-data: ";
     diskann::cout << "# nodes per sector: " << _nnodes_per_sector;
     diskann::cout << ", max node len (bytes): " << _max_node_len;
     diskann::cout << ", max node degree: " << _max_degree << std::endl;
+    if (_packed_nhoods)
+        diskann::cout << "Disk index stores packed neighbor lists" << std::endl;
+    if (_decoupled_vectors)
+        diskann::cout << "Disk index stores vectors apart from the graph, from sector " << _reorder_data_start_sector
+                      << ", # vectors per sector: " << _nvecs_per_sector << std::endl;
+
+    if (layout_flags & defaults::DISK_LAYOUT_PERMUTED)
+    {
+        std::string layout_perm_file = _disk_index_file + "_layout_perm.bin";
+        size_t num_pos, pos_dim;
+#ifdef EXEC_ENV_OLS
+        diskann::load_bin<uint32_t>(files, layout_perm_file, _node_pos, num_pos, pos_dim);
+#else
+        diskann::load_bin<uint32_t>(layout_perm_file, _node_pos, num_pos, pos_dim);
+#endif
+        if (num_pos != _num_points || pos_dim != 1)
+        {
+            std::stringstream stream;
+            stream << "Error loading " << layout_perm_file << ". Expected " << _num_points << " x 1 uint32_t.";
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        _use_coresident_nbrs = _nnodes_per_sector > 1;
+        diskann::cout << "Disk index uses a locality-aware layout" << std::endl;
+    }
 
 #ifdef EXEC_ENV_OLS
     delete[] bytes;
@@ -1099,11 +1716,32 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 #ifndef EXEC_ENV_OLS
     // open AlignedFileReader handle to index_file
     std::string index_fname(_disk_index_file);
+    // a striped index keeps only its header in index_fname, and its sectors in
+    // the stripes listed next to it, which only a StripedAlignedFileReader
+    // can read; it replaces the reader given to the constructor
+    if (file_exists(index_fname + "_stripes.txt"))
+    {
+#ifdef _WINDOWS
+        throw ANNException("Striped disk indices are only supported on Linux", -1, __FUNCSIG__, __FILE__, __LINE__);
+#else
+        if (dynamic_cast<StripedAlignedFileReader *>(reader.get()) == nullptr)
+        {
+            diskann::cout << "Disk index is striped, reading it with a StripedAlignedFileReader" << std::endl;
+            reader.reset(new StripedAlignedFileReader());
+        }
+#endif
+    }
     reader->open(index_fname);
     this->setup_thread_data(num_threads);
     this->_max_nthreads = num_threads;
 
 #endif
+    _mapped_index = reader->get_mapped_data();
+    if (_mapped_index != nullptr)
+    {
+        diskann::cout << "Disk index is memory mapped, searches expand nodes in place" << std::endl;
+    }
+    record_load_phase("disk index header and reader", phase_timer);
 
 #ifdef EXEC_ENV_OLS
     if (files.fileExists(medoids_file))
@@ -1186,6 +1824,14 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
         diskann::cout << "Setting re-scaling factor of base vectors to " << this->_max_base_norm << std::endl;
         delete[] norm_val;
     }
+    record_load_phase("medoids and centroids", phase_timer);
+#ifndef EXEC_ENV_OLS
+    if (!_numa_thread_data.empty())
+    {
+        place_pq_data_on_numa_nodes();
+        record_load_phase("NUMA placement", phase_timer);
+    }
+#endif
     diskann::cout << "done.." << std::endl;
     return 0;
 }
@@ -1235,63 +1881,12 @@ bool getNextCompletedRequest(std::shared_ptr<AlignedFileReader> &reader, IOConte
 #endif
 
 template <typename T, typename LabelT>
-void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
-                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
-                                                 const bool use_reorder_data, QueryStats *stats)
-{
-    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, std::numeric_limits<uint32_t>::max(),
-                       use_reorder_data, stats);
-}
-
-template <typename T, typename LabelT>
-void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
-                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
-                                                 const bool use_filter, const LabelT &filter_label,
-                                                 const bool use_reorder_data, QueryStats *stats)
+float PQFlashIndex<T, LabelT>::preprocess_query(const T *query1, SSDQueryScratch<T> *query_scratch)
 {
-    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, use_filter, filter_label,
-                       std::numeric_limits<uint32_t>::max(), use_reorder_data, stats);
-}
-
-template <typename T, typename LabelT>
-void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
-                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
-                                                 const uint32_t io_limit, const bool use_reorder_data,
-                                                 QueryStats *stats)
-{
-    LabelT dummy_filter = 0;
-    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, false, dummy_filter, io_limit,
-                       use_reorder_data, stats);
-}
-
-template <typename T, typename LabelT>
-void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
-                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
-                                                 const bool use_filter, const LabelT &filter_label,
-                                                 const uint32_t io_limit, const bool use_reorder_data,
-                                                 QueryStats *stats)
-{
-
-    uint64_t num_sector_per_nodes = DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
-    if (beam_width > num_sector_per_nodes * defaults::MAX_N_SECTOR_READS)
-        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
-                           __LINE__);
-
-    ScratchStoreManager<SSDThreadData<T>> manager(this->_thread_data);
-    auto data = manager.scratch_space();
-    IOContext &ctx = data->ctx;
-    auto query_scratch = &(data->scratch);
-    auto pq_query_scratch = query_scratch->pq_scratch();
-
-    // reset query scratch
-    query_scratch->reset();
-
-    // copy query to thread specific aligned and allocated memory (for distance
-    // calculations we need aligned data)
-    float query_norm = 0;
-    T *aligned_query_T = query_scratch->aligned_query_T();
-    float *query_float = pq_query_scratch->aligned_query_float;
-    float *query_rotated = pq_query_scratch->rotated_query;
+    auto pq_query_scratch = query_scratch->pq_scratch();
+    float query_norm = 0;
+    T *aligned_query_T = query_scratch->aligned_query_T();
+    float *query_rotated = pq_query_scratch->rotated_query;
 
     // normalization step. for cosine, we simply normalize the query
     // for mips, we normalize the first d-1 dims, and add a 0 for last dim, since an extra coordinate was used to
@@ -1324,6 +1919,247 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
         pq_query_scratch->initialize(this->_data_dim, aligned_query_T);
     }
 
+    // query <-> PQ chunk centers distances
+    _pq_table.preprocess_query(query_rotated); // center the query and rotate if
+                                               // we have a rotation matrix
+    _pq_table.populate_chunk_distances(query_rotated, pq_query_scratch->aligned_pqtable_dist_scratch);
+    if (_use_pq_fast_scan)
+    {
+        diskann::quantize_fast_scan_lut(pq_query_scratch->aligned_pqtable_dist_scratch, _n_chunks,
+                                        pq_query_scratch->aligned_pq_lut_scratch, pq_query_scratch->pq_lut_scale,
+                                        pq_query_scratch->pq_lut_bias);
+    }
+
+    return query_norm;
+}
+
+template <typename T, typename LabelT> uint32_t PQFlashIndex<T, LabelT>::get_best_medoid(const float *query_float)
+{
+    uint32_t best_medoid = 0;
+    float best_dist = (std::numeric_limits<float>::max)();
+    for (uint64_t cur_m = 0; cur_m < _num_medoids; cur_m++)
+    {
+        float cur_expanded_dist =
+            _dist_cmp_float->compare(query_float, _centroid_data + _aligned_dim * cur_m, (uint32_t)_aligned_dim);
+        if (cur_expanded_dist < best_dist)
+        {
+            best_medoid = _medoids[cur_m];
+            best_dist = cur_expanded_dist;
+        }
+    }
+    return best_medoid;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::copy_results(const std::vector<Neighbor> &full_retset, const uint64_t k_search,
+                                           uint64_t *indices, float *distances, const float query_norm)
+{
+    // copy k_search values; with deleted points there may be fewer
+    for (uint64_t i = 0; i < k_search; i++)
+    {
+        if (i >= full_retset.size())
+        {
+            indices[i] = std::numeric_limits<uint64_t>::max();
+            if (distances != nullptr)
+                distances[i] = std::numeric_limits<float>::max();
+            continue;
+        }
+        indices[i] = result_id(full_retset[i].id);
+        if (distances != nullptr)
+        {
+            distances[i] = result_distance(full_retset[i].distance, query_norm);
+        }
+    }
+}
+
+template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::result_id(const uint32_t id)
+{
+    if (_dummy_pts.find(id) != _dummy_pts.end())
+    {
+        return _dummy_to_real_map[id];
+    }
+    return id;
+}
+
+template <typename T, typename LabelT>
+float PQFlashIndex<T, LabelT>::result_distance(const float distance, const float query_norm)
+{
+    if (metric != diskann::Metric::INNER_PRODUCT)
+        return distance;
+    // flip the sign to convert min to max
+    float result = -distance;
+    // rescale to revert back to original norms (cancelling the
+    // effect of base and query pre-processing)
+    if (_max_base_norm != 0)
+        result *= (_max_base_norm * query_norm);
+    return result;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::rerank_full_precision(SSDQueryScratch<T> *query_scratch, IOContext &ctx,
+                                                    const uint64_t num_rerank, QueryStats *stats)
+{
+    std::vector<Neighbor> &full_retset = query_scratch->full_retset;
+    T *aligned_query_T = query_scratch->aligned_query_T();
+    T *data_buf = query_scratch->coord_scratch;
+    char *sector_scratch = query_scratch->sector_scratch;
+
+    if (full_retset.size() > num_rerank)
+        full_retset.erase(full_retset.begin() + num_rerank, full_retset.end());
+
+    const uint64_t num_sectors_per_vec = _nvecs_per_sector > 0 ? 1 : DIV_ROUND_UP(_vector_len, defaults::SECTOR_LEN);
+    const uint64_t max_vecs_per_read = defaults::MAX_N_SECTOR_READS / num_sectors_per_vec;
+    std::vector<AlignedRead> vec_read_reqs;
+    std::vector<std::pair<size_t, char *>> vec_locations;
+    Timer io_timer;
+
+    // fill the sector scratch with as many vectors as fit, then rerank them;
+    // vectors in the coord cache of a decoupled layout are not read
+    for (size_t start = 0; start < full_retset.size();)
+    {
+        vec_read_reqs.clear();
+        vec_locations.clear();
+        size_t i = start;
+        for (; i < full_retset.size() && vec_read_reqs.size() < max_vecs_per_read; i++)
+        {
+            uint32_t id = full_retset[i].id;
+            if (_mapped_index != nullptr)
+            {
+                vec_locations.emplace_back(
+                    i, offset_to_vector(_mapped_index + get_vector_sector(id) * defaults::SECTOR_LEN, id));
+                continue;
+            }
+            if (_decoupled_vectors)
+            {
+                auto iter = _coord_cache.find(id);
+                if (iter != _coord_cache.end())
+                {
+                    vec_locations.emplace_back(i, (char *)iter->second);
+                    if (stats != nullptr)
+                        stats->n_cache_hits++;
+                    continue;
+                }
+            }
+            char *buf = sector_scratch + vec_read_reqs.size() * num_sectors_per_vec * defaults::SECTOR_LEN;
+            vec_read_reqs.emplace_back(get_vector_sector(id) * defaults::SECTOR_LEN,
+                                       num_sectors_per_vec * defaults::SECTOR_LEN, buf);
+            vec_locations.emplace_back(i, offset_to_vector(buf, id));
+            if (stats != nullptr)
+            {
+                stats->n_4k += num_sectors_per_vec;
+                stats->n_ios++;
+            }
+        }
+        start = i;
+
+        if (!vec_read_reqs.empty())
+        {
+            io_timer.reset();
+#ifdef USE_BING_INFRA
+            reader->read(vec_read_reqs, ctx, true); // async reader windows.
+#else
+            reader->read(vec_read_reqs, ctx); // synchronous IO linux
+#endif
+            if (stats != nullptr)
+            {
+                stats->io_us += io_timer.elapsed();
+            }
+        }
+
+        for (auto &location : vec_locations)
+        {
+            if (_decoupled_vectors)
+            {
+                // copied to the aligned, zero padded coord scratch as in search
+                memcpy(data_buf, location.second, _vector_len);
+                full_retset[location.first].distance =
+                    _dist_cmp->compare(aligned_query_T, data_buf, (uint32_t)this->_aligned_dim);
+            }
+            else
+            {
+                full_retset[location.first].distance =
+                    _dist_cmp->compare(aligned_query_T, (T *)location.second, (uint32_t)this->_data_dim);
+            }
+        }
+    }
+
+    std::sort(full_retset.begin(), full_retset.end());
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const bool use_reorder_data, QueryStats *stats)
+{
+    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, std::numeric_limits<uint32_t>::max(),
+                       use_reorder_data, stats);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const bool use_filter, const LabelT &filter_label,
+                                                 const bool use_reorder_data, QueryStats *stats)
+{
+    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, use_filter, filter_label,
+                       std::numeric_limits<uint32_t>::max(), use_reorder_data, stats);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const uint32_t io_limit, const bool use_reorder_data,
+                                                 QueryStats *stats)
+{
+    LabelT dummy_filter = 0;
+    cached_beam_search(query1, k_search, l_search, indices, distances, beam_width, false, dummy_filter, io_limit,
+                       use_reorder_data, stats);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t k_search, const uint64_t l_search,
+                                                 uint64_t *indices, float *distances, const uint64_t beam_width,
+                                                 const bool use_filter, const LabelT &filter_label,
+                                                 const uint32_t io_limit, const bool use_reorder_data,
+                                                 QueryStats *stats)
+{
+    cached_beam_search_impl(query1, k_search, l_search, indices, distances, beam_width, use_filter, filter_label,
+                            io_limit, use_reorder_data, stats, nullptr);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search_impl(const T *query1, const uint64_t k_search,
+                                                      const uint64_t l_search, uint64_t *indices, float *distances,
+                                                      uint64_t beam_width, const bool use_filter,
+                                                      const LabelT &filter_label, const uint32_t io_limit,
+                                                      const bool use_reorder_data, QueryStats *stats,
+                                                      RangeSearchState *range_state)
+{
+
+    uint64_t num_sector_per_nodes = DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    if (beam_width > num_sector_per_nodes * defaults::MAX_N_SECTOR_READS)
+        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+
+    ScratchStoreManager<SSDThreadData<T>> manager(thread_data_pool());
+    auto data = manager.scratch_space();
+    // the copies of the PQ vectors and node cache on the NUMA node of data
+    const uint8_t *pq_data = local_pq_data(data->numa_node);
+    auto &nhood_cache = local_nhood_cache(data->numa_node);
+    auto &coord_cache = local_coord_cache(data->numa_node);
+    IOContext &ctx = data->ctx;
+    auto query_scratch = &(data->scratch);
+    auto pq_query_scratch = query_scratch->pq_scratch();
+
+    // reset query scratch
+    query_scratch->reset();
+
+    // copy query to thread specific aligned and allocated memory (for distance
+    // calculations we need aligned data)
+    float query_norm = preprocess_query(query1, query_scratch);
+    T *aligned_query_T = query_scratch->aligned_query_T();
+    float *query_float = pq_query_scratch->aligned_query_float;
+
     // pointers to buffers for data
     T *data_buf = query_scratch->coord_scratch;
     _mm_prefetch((char *)data_buf, _MM_HINT_T1);
@@ -1334,43 +2170,40 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     const uint64_t num_sectors_per_node =
         _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
 
-    // query <-> PQ chunk centers distances
-    _pq_table.preprocess_query(query_rotated); // center the query and rotate if
-                                               // we have a rotation matrix
+    // query <-> PQ chunk centers distances, filled in by preprocess_query
     float *pq_dists = pq_query_scratch->aligned_pqtable_dist_scratch;
-    _pq_table.populate_chunk_distances(query_rotated, pq_dists);
 
     // query <-> neighbor list
     float *dist_scratch = pq_query_scratch->aligned_dist_scratch;
     uint8_t *pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
 
     // lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const uint32_t *ids, const uint64_t n_ids,
-                                                            float *dists_out) {
-        diskann::aggregate_coords(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
+    auto compute_dists = [this, pq_data, pq_query_scratch, pq_coord_scratch, pq_dists](
+                             const uint32_t *ids, const uint64_t n_ids, float *dists_out) {
+        if (this->_use_pq_fast_scan)
+        {
+            diskann::aggregate_coords_fast_scan(ids, n_ids, pq_data, this->_n_chunks, pq_coord_scratch);
+            diskann::pq_fast_scan_lookup(pq_coord_scratch, n_ids, this->_n_chunks,
+                                         pq_query_scratch->aligned_pq_lut_scratch, pq_query_scratch->pq_lut_scale,
+                                         pq_query_scratch->pq_lut_bias, dists_out);
+            return;
+        }
+        diskann::aggregate_coords(ids, n_ids, pq_data, this->_n_chunks, pq_coord_scratch);
         diskann::pq_dist_lookup(pq_coord_scratch, n_ids, this->_n_chunks, pq_dists, dists_out);
     };
     Timer query_timer, io_timer, cpu_timer;
 
-    tsl::robin_set<uint64_t> &visited = query_scratch->visited;
+    VisitedSet &visited = query_scratch->visited;
     NeighborPriorityQueue &retset = query_scratch->retset;
-    retset.reserve(l_search);
+    // a range search sizes its list by the results in range instead
+    retset.reserve(range_state == nullptr ? tombstone_l_search(l_search) : l_search);
     std::vector<Neighbor> &full_retset = query_scratch->full_retset;
 
     uint32_t best_medoid = 0;
     float best_dist = (std::numeric_limits<float>::max)();
     if (!use_filter)
     {
-        for (uint64_t cur_m = 0; cur_m < _num_medoids; cur_m++)
-        {
-            float cur_expanded_dist =
-                _dist_cmp_float->compare(query_float, _centroid_data + _aligned_dim * cur_m, (uint32_t)_aligned_dim);
-            if (cur_expanded_dist < best_dist)
-            {
-                best_medoid = _medoids[cur_m];
-                best_dist = cur_expanded_dist;
-            }
-        }
+        best_medoid = get_best_medoid(query_float);
     }
     else
     {
@@ -1404,62 +2237,573 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     uint32_t hops = 0;
     uint32_t num_ios = 0;
 
-    // cleared every iteration
-    std::vector<uint32_t> frontier;
-    frontier.reserve(2 * beam_width);
-    std::vector<std::pair<uint32_t, char *>> frontier_nhoods;
-    frontier_nhoods.reserve(2 * beam_width);
-    std::vector<AlignedRead> frontier_read_reqs;
-    frontier_read_reqs.reserve(2 * beam_width);
-    std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>> cached_nhoods;
-    cached_nhoods.reserve(2 * beam_width);
+    // the rules of early termination are about the top k, which a range
+    // search does not have
+    EarlyTermination early_stop(k_search, range_state == nullptr ? _early_stop_patience : 0,
+                                range_state == nullptr ? _early_stop_ratio : 0);
+    bool stopped = false;
+
+    // in a range search, candidates that fall out of retset are kept so that
+    // they can be taken back when it grows
+    Neighbor dropped_nbr;
+
+    // per-hop tracing, if the caller passed a trace in stats; hop holds the
+    // counts of the hop in progress, and the totals of stats at its start
+    std::vector<HopTrace> *hop_trace = stats == nullptr ? nullptr : stats->hop_trace;
+    HopTrace hop;
+    auto begin_hop = [&]() {
+        if (hop_trace == nullptr)
+            return;
+        hop = HopTrace();
+        hop.n_ios = stats->n_ios;
+        hop.io_us = stats->io_us;
+        hop.cpu_us = stats->cpu_us;
+    };
+    auto end_hop = [&]() {
+        if (hop_trace == nullptr || hop.frontier_size == 0)
+            return;
+        hop.n_ios = stats->n_ios - hop.n_ios;
+        hop.io_us = stats->io_us - hop.io_us;
+        hop.cpu_us = stats->cpu_us - hop.cpu_us;
+        hop_trace->push_back(hop);
+    };
 
-    while (retset.has_unexpanded_node() && num_ios < io_limit)
-    {
-        // clear iteration state
-        frontier.clear();
-        frontier_nhoods.clear();
-        frontier_read_reqs.clear();
-        cached_nhoods.clear();
-        sector_scratch_idx = 0;
-        // find new beam
-        uint32_t num_seen = 0;
-        while (retset.has_unexpanded_node() && frontier.size() < beam_width && num_seen < beam_width)
+    auto insert_candidate = [&](const Neighbor &nn) {
+        if (hop_trace != nullptr &&
+            (retset.size() < retset.capacity() || nn.distance < retset[retset.size() - 1].distance))
+            hop.n_retset_inserts++;
+        if (range_state == nullptr)
+            retset.insert(nn);
+        else if (retset.insert(nn, dropped_nbr))
+            range_state->dropped.push_back(dropped_nbr);
+    };
+
+    // expands a node whose neighborhood and coordinates are in the cache
+    auto expand_cached_node = [&](const uint32_t id, const std::pair<uint32_t, uint32_t *> &nhood) {
+        hop.frontier_size++;
+        auto global_cache_iter = coord_cache.find(id);
+        T *node_fp_coords_copy = global_cache_iter->second;
+        float cur_expanded_dist;
+        if (_decoupled_vectors)
         {
-            auto nbr = retset.closest_unexpanded();
-            num_seen++;
-            auto iter = _nhood_cache.find(nbr.id);
-            if (iter != _nhood_cache.end())
-            {
-                cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
-                if (stats != nullptr)
-                {
-                    stats->n_cache_hits++;
-                }
-            }
+            // ranked by PQ distance until the final rerank
+            compute_dists(&id, 1, dist_scratch);
+            cur_expanded_dist = dist_scratch[0];
+        }
+        else if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist = _dist_cmp->compare(aligned_query_T, node_fp_coords_copy, (uint32_t)_aligned_dim);
+        }
+        else
+        {
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords_copy);
             else
+                cur_expanded_dist = _disk_pq_table.l2_distance( // disk_pq does not support OPQ yet
+                    query_float, (uint8_t *)node_fp_coords_copy);
+        }
+        if (!is_deleted(id))
+            full_retset.push_back(Neighbor(id, cur_expanded_dist));
+
+        uint64_t nnbrs = nhood.first;
+        uint32_t *node_nbrs = nhood.second;
+
+        // compute node_nbrs <-> query dists in PQ space
+        cpu_timer.reset();
+        compute_dists(node_nbrs, nnbrs, dist_scratch);
+        if (stats != nullptr)
+        {
+            stats->n_cmps += (uint32_t)nnbrs;
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+
+        // process prefetched nhood
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t nbr_id = node_nbrs[m];
+            if (visited.insert(nbr_id))
             {
-                frontier.push_back(nbr.id);
-            }
-            if (this->_count_visited_nodes)
-            {
-                reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                if (!use_filter && _dummy_pts.find(nbr_id) != _dummy_pts.end())
+                    continue;
+
+                if (use_filter && !(point_has_label(nbr_id, filter_label)) &&
+                    (!_use_universal_label || !point_has_label(nbr_id, _universal_filter_label)))
+                    continue;
+                cmps++;
+                float dist = dist_scratch[m];
+                Neighbor nn(nbr_id, dist);
+                insert_candidate(nn);
             }
         }
+    };
 
-        // read nhoods of frontier ids
-        if (!frontier.empty())
+    // with a locality-aware layout, unvisited neighbors stored in the sector
+    // of the node being expanded are expanded right away, and skipped when
+    // they later come up in retset
+    std::vector<uint32_t> coresident_nbrs;
+    tsl::robin_set<uint32_t> coresident_expanded;
+
+    // expands a single node whose sector(s) have been read into sector_buf
+    auto expand_sector_node = [&](const uint32_t id, char *sector_buf) {
+        hop.frontier_size++;
+        const uint64_t node_sector = _use_coresident_nbrs ? get_node_sector(id) : 0;
+        char *node_disk_buf = offset_to_node(sector_buf, id);
+        uint32_t *node_buf = offset_to_node_nhood(node_disk_buf, query_scratch->nhood_scratch);
+        uint64_t nnbrs = (uint64_t)(*node_buf);
+        T *node_fp_coords = offset_to_node_coords(node_disk_buf);
+        memcpy(data_buf, node_fp_coords, _disk_bytes_per_point);
+        float cur_expanded_dist;
+        if (_decoupled_vectors)
         {
-            if (stats != nullptr)
-                stats->n_hops++;
-            for (uint64_t i = 0; i < frontier.size(); i++)
-            {
-                auto id = frontier[i];
-                std::pair<uint32_t, char *> fnhood;
-                fnhood.first = id;
-                fnhood.second = sector_scratch + num_sectors_per_node * sector_scratch_idx * defaults::SECTOR_LEN;
-                sector_scratch_idx++;
+            compute_dists(&id, 1, dist_scratch);
+            cur_expanded_dist = dist_scratch[0];
+        }
+        else if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist = _dist_cmp->compare(aligned_query_T, data_buf, (uint32_t)_aligned_dim);
+        }
+        else
+        {
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)data_buf);
+            else
+                cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)data_buf);
+        }
+        if (!is_deleted(id))
+            full_retset.push_back(Neighbor(id, cur_expanded_dist));
+        uint32_t *node_nbrs = (node_buf + 1);
+        // compute node_nbrs <-> query dist in PQ space
+        cpu_timer.reset();
+        compute_dists(node_nbrs, nnbrs, dist_scratch);
+        if (stats != nullptr)
+        {
+            stats->n_cmps += (uint32_t)nnbrs;
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+
+        cpu_timer.reset();
+        // process prefetch-ed nhood
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t nbr_id = node_nbrs[m];
+            if (visited.insert(nbr_id))
+            {
+                if (!use_filter && _dummy_pts.find(nbr_id) != _dummy_pts.end())
+                    continue;
+
+                if (use_filter && !(point_has_label(nbr_id, filter_label)) &&
+                    (!_use_universal_label || !point_has_label(nbr_id, _universal_filter_label)))
+                    continue;
+                cmps++;
+                float dist = dist_scratch[m];
+                if (stats != nullptr)
+                {
+                    stats->n_cmps++;
+                }
+
+                Neighbor nn(nbr_id, dist);
+                insert_candidate(nn);
+                if (_use_coresident_nbrs && get_node_sector(nbr_id) == node_sector)
+                    coresident_nbrs.push_back(nbr_id);
+            }
+        }
+
+        if (stats != nullptr)
+        {
+            stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+    };
+
+    // expands a node whose sector(s) have been read into sector_buf, along
+    // with its co-resident neighbors
+    auto expand_disk_node = [&](const uint32_t id, char *sector_buf) {
+        expand_sector_node(id, sector_buf);
+        while (!coresident_nbrs.empty())
+        {
+            uint32_t nbr_id = coresident_nbrs.back();
+            coresident_nbrs.pop_back();
+            coresident_expanded.insert(nbr_id);
+            expand_sector_node(nbr_id, sector_buf);
+        }
+    };
+
+    // passes the nodes expanded since the last call that are within range to
+    // the callback of a range search; false once the callback asks to stop
+    auto check_range_results = [&]() {
+        for (; range_state->num_checked < full_retset.size(); range_state->num_checked++)
+        {
+            const Neighbor &nbr = full_retset[range_state->num_checked];
+            float dist = result_distance(nbr.distance, query_norm);
+            if (dist > range_state->range)
+                continue;
+            range_state->num_results++;
+            if (!(*range_state->callback)(result_id(nbr.id), dist))
+                return false;
+        }
+        return true;
+    };
+    // with a decoupled layout, distances are PQ estimates until the rerank
+    const bool stream_range_results = range_state != nullptr && !_decoupled_vectors;
+
+    // called once retset has no unexpanded node left: in a range search with
+    // at least half the list in range, doubles the list up to max_l_search
+    // and takes back the candidates that fell out of it, so that the search
+    // goes on from here instead of starting over with the longer list
+    auto grow_range_search = [&]() {
+        if (range_state == nullptr || stopped)
+            return false;
+        uint64_t cur_l_search = retset.capacity();
+        uint64_t num_in_range = 0;
+        for (auto &nbr : full_retset)
+        {
+            if (result_distance(nbr.distance, query_norm) <= range_state->range)
+                num_in_range++;
+        }
+        if ((std::min)(num_in_range, cur_l_search) < (uint64_t)(cur_l_search / 2.0) ||
+            cur_l_search * 2 > range_state->max_l_search)
+            return false;
+        retset.grow(cur_l_search * 2, range_state->dropped);
+        beam_width = range_search_beam_width(cur_l_search * 2, range_state->min_beam_width);
+        return retset.has_unexpanded_node();
+    };
+
+    // speculative prefetch: once the reads of a hop are in, the sectors of
+    // the closest unexpanded candidates outside the beam are read into
+    // staging slots while the hop is expanded. A later beam expands a staged
+    // node in place instead of reading it. Slots that no beam takes are
+    // reused for closer candidates, and reads still in flight at the end are
+    // drained. All reads of the query then go through submit_reqs, so that
+    // no blocking read() can reap a speculative completion.
+    struct PrefetchSlot
+    {
+        uint32_t id = 0;
+        char *buf = nullptr;
+        bool valid = false;   // holds, or is reading, the sector(s) of id
+        bool pending = false; // read still in flight
+        bool claimed = false; // taken by the current beam
+    };
+    const uint64_t slot_len = num_sectors_per_node * defaults::SECTOR_LEN;
+    const uint64_t num_slots =
+        (_prefetch_nodes == 0 || _mapped_index != nullptr || _use_pipelined_search)
+            ? 0
+            : (std::min)((uint64_t)_prefetch_nodes, defaults::MAX_N_PREFETCH_SECTORS / num_sectors_per_node);
+    std::vector<PrefetchSlot> prefetch_slots(num_slots);
+    for (uint64_t i = 0; i < num_slots; i++)
+        prefetch_slots[i].buf = query_scratch->prefetch_scratch + i * slot_len;
+    std::vector<uint32_t> prefetch_ids;
+    std::vector<AlignedRead> prefetch_reqs;
+    std::vector<void *> completed_reads;
+
+    auto find_prefetch_slot = [&](const uint32_t id) -> PrefetchSlot * {
+        for (auto &slot : prefetch_slots)
+        {
+            if (slot.valid && slot.id == id)
+                return &slot;
+        }
+        return nullptr;
+    };
+
+    // submits read_reqs and waits for them and for the staged slots claimed
+    // by the beam; with drain, waits for every speculative read instead
+    auto submit_and_wait = [&](std::vector<AlignedRead> &read_reqs, bool drain) {
+#if !defined(_WINDOWS) && !defined(USE_BING_INFRA)
+        if (!read_reqs.empty())
+            reader->submit_reqs(read_reqs, ctx);
+        uint64_t num_reads = read_reqs.size();
+        auto must_wait = [&]() {
+            if (num_reads > 0)
+                return true;
+            for (auto &slot : prefetch_slots)
+            {
+                if (slot.pending && (drain || slot.claimed))
+                    return true;
+            }
+            return false;
+        };
+        while (must_wait())
+        {
+            completed_reads.clear();
+            reader->get_completed_reqs(ctx, 1, completed_reads);
+            for (void *completed : completed_reads)
+            {
+                char *buf = (char *)completed;
+                char *staging = query_scratch->prefetch_scratch;
+                if (buf >= staging && buf < staging + num_slots * slot_len)
+                    prefetch_slots[(buf - staging) / slot_len].pending = false;
+                else
+                    num_reads--;
+            }
+        }
+#endif
+    };
+
+    // stages the num_slots closest unexpanded candidates that are neither
+    // cached nor staged yet
+    auto issue_prefetches = [&]() {
+        prefetch_ids.clear();
+        for (size_t i = 0; i < retset.size() && prefetch_ids.size() < num_slots; i++)
+        {
+            const Neighbor &nbr = retset[i];
+            if (nbr.expanded || nhood_cache.find(nbr.id) != nhood_cache.end())
+                continue;
+            if (_use_coresident_nbrs && coresident_expanded.find(nbr.id) != coresident_expanded.end())
+                continue;
+            prefetch_ids.push_back(nbr.id);
+        }
+        prefetch_reqs.clear();
+        for (uint32_t id : prefetch_ids)
+        {
+            if (num_ios + prefetch_reqs.size() >= io_limit)
+                break;
+            if (find_prefetch_slot(id) != nullptr)
+                continue;
+            // an empty slot, or else one staged for a node no longer wanted
+            PrefetchSlot *free_slot = nullptr;
+            for (auto &slot : prefetch_slots)
+            {
+                if (slot.pending || slot.claimed)
+                    continue;
+                if (!slot.valid)
+                {
+                    free_slot = &slot;
+                    break;
+                }
+                if (free_slot == nullptr &&
+                    std::find(prefetch_ids.begin(), prefetch_ids.end(), slot.id) == prefetch_ids.end())
+                    free_slot = &slot;
+            }
+            if (free_slot == nullptr)
+                break;
+            if (free_slot->valid && stats != nullptr)
+                stats->prefetch_wasted_bytes += (unsigned)slot_len;
+            free_slot->id = id;
+            free_slot->valid = true;
+            free_slot->pending = true;
+            prefetch_reqs.emplace_back(get_node_sector((size_t)id) * defaults::SECTOR_LEN, slot_len, free_slot->buf);
+        }
+        if (prefetch_reqs.empty())
+            return;
+#if !defined(_WINDOWS) && !defined(USE_BING_INFRA)
+        reader->submit_reqs(prefetch_reqs, ctx);
+#endif
+        if (stats != nullptr)
+        {
+            stats->n_prefetch_ios += (unsigned)prefetch_reqs.size();
+            stats->n_4k += (unsigned)prefetch_reqs.size();
+            stats->n_ios += (unsigned)prefetch_reqs.size();
+        }
+    };
+
+    // cleared every iteration
+    std::vector<uint32_t> frontier;
+    frontier.reserve(2 * beam_width);
+    std::vector<std::pair<uint32_t, char *>> frontier_nhoods;
+    frontier_nhoods.reserve(2 * beam_width);
+    std::vector<AlignedRead> frontier_read_reqs;
+    frontier_read_reqs.reserve(2 * beam_width);
+    std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>> cached_nhoods;
+    cached_nhoods.reserve(2 * beam_width);
+
+#if !defined(_WINDOWS) && !defined(USE_BING_INFRA)
+    // pipelined search: instead of waiting for the whole beam, a new read is
+    // issued for the closest unexpanded node as soon as any read completes,
+    // keeping up to beam_width reads in flight. It returns only once no
+    // unexpanded node is left or io_limit is hit, so the beam loop below
+    // then has nothing left to do.
+    if (_use_pipelined_search && _mapped_index == nullptr)
+    {
+        const uint64_t max_slots =
+            (std::min)(beam_width, (uint64_t)(defaults::MAX_N_SECTOR_READS / num_sectors_per_node));
+        std::vector<char *> free_slots;
+        free_slots.reserve(max_slots);
+        for (uint64_t i = 0; i < max_slots; i++)
+        {
+            free_slots.push_back(sector_scratch + i * num_sectors_per_node * defaults::SECTOR_LEN);
+        }
+        // (id, buf) of every read in flight; at most beam_width entries
+        std::vector<std::pair<uint32_t, char *>> inflight;
+        inflight.reserve(max_slots);
+        std::vector<void *> completed_bufs;
+        completed_bufs.reserve(max_slots);
+
+        while (true)
+        {
+            begin_hop();
+            // top up the pipeline with the closest unexpanded nodes
+            frontier_read_reqs.clear();
+            while (!stopped && retset.has_unexpanded_node() && !free_slots.empty() && num_ios < io_limit)
+            {
+                auto nbr = retset.closest_unexpanded();
+                if (_use_coresident_nbrs && coresident_expanded.find(nbr.id) != coresident_expanded.end())
+                    continue;
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+                auto iter = nhood_cache.find(nbr.id);
+                if (iter != nhood_cache.end())
+                {
+                    if (stats != nullptr)
+                    {
+                        stats->n_cache_hits++;
+                    }
+                    expand_cached_node(nbr.id, iter->second);
+                    continue;
+                }
+
+                char *buf = free_slots.back();
+                if (_sector_cache != nullptr)
+                {
+                    if (_sector_cache->lookup(get_node_sector((size_t)nbr.id), buf))
+                    {
+                        if (stats != nullptr)
+                            stats->n_sector_cache_hits++;
+                        expand_disk_node(nbr.id, buf);
+                        continue;
+                    }
+                    if (stats != nullptr)
+                        stats->n_sector_cache_misses++;
+                }
+                free_slots.pop_back();
+                inflight.push_back(std::make_pair(nbr.id, buf));
+                frontier_read_reqs.emplace_back(get_node_sector((size_t)nbr.id) * defaults::SECTOR_LEN,
+                                                num_sectors_per_node * defaults::SECTOR_LEN, buf);
+                if (stats != nullptr)
+                {
+                    stats->n_4k++;
+                    stats->n_ios++;
+                }
+                num_ios++;
+            }
+
+            io_timer.reset();
+            if (!frontier_read_reqs.empty())
+            {
+                reader->submit_reqs(frontier_read_reqs, ctx);
+                if (stats != nullptr)
+                    stats->n_hops++;
+                hops++;
+            }
+            if (inflight.empty())
+            {
+                end_hop();
+                break;
+            }
+
+            completed_bufs.clear();
+            reader->get_completed_reqs(ctx, 1, completed_bufs);
+            if (stats != nullptr)
+            {
+                stats->io_us += (float)io_timer.elapsed();
+            }
+
+            for (void *completed : completed_bufs)
+            {
+                auto iter = std::find_if(inflight.begin(), inflight.end(),
+                                         [completed](const std::pair<uint32_t, char *> &p) {
+                                             return p.second == (char *)completed;
+                                         });
+                assert(iter != inflight.end());
+                uint32_t id = iter->first;
+                *iter = inflight.back();
+                inflight.pop_back();
+
+                if (_sector_cache != nullptr &&
+                    _sector_cache->insert(get_node_sector((size_t)id), (char *)completed) && stats != nullptr)
+                    stats->n_sector_cache_evictions++;
+                expand_disk_node(id, (char *)completed);
+                free_slots.push_back((char *)completed);
+            }
+            // a round of completions counts as a hop; once stopped, the
+            // reads still in flight are drained without issuing new ones
+            if (early_stop.enabled() && !stopped)
+                stopped = early_stop.should_stop(full_retset, retset);
+            if (stream_range_results && !stopped && !check_range_results())
+                stopped = true;
+            end_hop();
+        }
+    }
+#endif
+
+    while (!stopped && num_ios < io_limit && (retset.has_unexpanded_node() || grow_range_search()))
+    {
+        // clear iteration state
+        begin_hop();
+        frontier.clear();
+        frontier_nhoods.clear();
+        frontier_read_reqs.clear();
+        cached_nhoods.clear();
+        sector_scratch_idx = 0;
+        // find new beam
+        uint32_t num_seen = 0;
+        while (retset.has_unexpanded_node() && frontier.size() < beam_width && num_seen < beam_width)
+        {
+            auto nbr = retset.closest_unexpanded();
+            if (_use_coresident_nbrs && coresident_expanded.find(nbr.id) != coresident_expanded.end())
+                continue;
+            num_seen++;
+            auto iter = nhood_cache.find(nbr.id);
+            if (iter != nhood_cache.end())
+            {
+                cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
+                if (stats != nullptr)
+                {
+                    stats->n_cache_hits++;
+                }
+            }
+            else
+            {
+                frontier.push_back(nbr.id);
+            }
+            if (this->_count_visited_nodes)
+            {
+                reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+            }
+        }
+
+        // read nhoods of frontier ids
+        if (!frontier.empty())
+        {
+            if (stats != nullptr)
+                stats->n_hops++;
+            for (uint64_t i = 0; i < frontier.size(); i++)
+            {
+                auto id = frontier[i];
+                std::pair<uint32_t, char *> fnhood;
+                fnhood.first = id;
+                if (_mapped_index != nullptr)
+                {
+                    // zero-copy: the node is expanded in place in the mapping
+                    fnhood.second = _mapped_index + get_node_sector((size_t)id) * defaults::SECTOR_LEN;
+                    frontier_nhoods.push_back(fnhood);
+                    continue;
+                }
+                PrefetchSlot *staged = num_slots > 0 ? find_prefetch_slot(id) : nullptr;
+                if (staged != nullptr)
+                {
+                    // read, or being read, by an earlier speculative prefetch
+                    staged->claimed = true;
+                    fnhood.second = staged->buf;
+                    frontier_nhoods.push_back(fnhood);
+                    if (stats != nullptr)
+                        stats->n_prefetch_hits++;
+                    num_ios++;
+                    continue;
+                }
+                fnhood.second = sector_scratch + num_sectors_per_node * sector_scratch_idx * defaults::SECTOR_LEN;
+                sector_scratch_idx++;
                 frontier_nhoods.push_back(fnhood);
+                if (_sector_cache != nullptr)
+                {
+                    if (_sector_cache->lookup(get_node_sector((size_t)id), fnhood.second))
+                    {
+                        if (stats != nullptr)
+                            stats->n_sector_cache_hits++;
+                        continue;
+                    }
+                    if (stats != nullptr)
+                        stats->n_sector_cache_misses++;
+                }
                 frontier_read_reqs.emplace_back(get_node_sector((size_t)id) * defaults::SECTOR_LEN,
                                                 num_sectors_per_node * defaults::SECTOR_LEN, fnhood.second);
                 if (stats != nullptr)
@@ -1469,279 +2813,934 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                 }
                 num_ios++;
             }
+            if (num_slots > 0)
+            {
+                io_timer.reset();
+                submit_and_wait(frontier_read_reqs, false);
+                if (stats != nullptr)
+                {
+                    stats->io_us += (float)io_timer.elapsed();
+                }
+            }
+            else if (!frontier_read_reqs.empty())
+            {
+                io_timer.reset();
+#ifdef USE_BING_INFRA
+                reader->read(frontier_read_reqs, ctx,
+                             true); // asynhronous reader for Bing.
+#else
+                reader->read(frontier_read_reqs, ctx); // synchronous IO linux
+#endif
+                if (stats != nullptr)
+                {
+                    stats->io_us += (float)io_timer.elapsed();
+                }
+            }
+        }
+
+        // keep the drive busy while this hop is expanded
+        if (num_slots > 0)
+            issue_prefetches();
+
+        // process cached nhoods
+        for (auto &cached_nhood : cached_nhoods)
+        {
+            expand_cached_node(cached_nhood.first, cached_nhood.second);
+        }
+#ifdef USE_BING_INFRA
+        // process each frontier nhood - compute distances to unvisited nodes
+        int completedIndex = -1;
+        long requestCount = static_cast<long>(frontier_read_reqs.size());
+        // If we issued read requests and if a read is complete or there are
+        // reads in wait state, then enter the while loop.
+        while (requestCount > 0 && getNextCompletedRequest(reader, ctx, requestCount, completedIndex))
+        {
+            assert(completedIndex >= 0);
+            auto &frontier_nhood = frontier_nhoods[completedIndex];
+            (*ctx.m_pRequestsStatus)[completedIndex] = IOContext::PROCESS_COMPLETE;
+#else
+        for (auto &frontier_nhood : frontier_nhoods)
+        {
+#endif
+            expand_disk_node(frontier_nhood.first, frontier_nhood.second);
+        }
+
+        // admit the sectors read in this hop to the dynamic cache
+        if (_sector_cache != nullptr)
+        {
+            for (auto &req : frontier_read_reqs)
+            {
+                if (_sector_cache->insert(req.offset / defaults::SECTOR_LEN, (char *)req.buf) && stats != nullptr)
+                    stats->n_sector_cache_evictions++;
+            }
+        }
+
+        // staged nodes expanded in this hop free their slots
+        for (auto &slot : prefetch_slots)
+        {
+            if (!slot.claimed)
+                continue;
+            if (_sector_cache != nullptr && _sector_cache->insert(get_node_sector((size_t)slot.id), slot.buf) &&
+                stats != nullptr)
+                stats->n_sector_cache_evictions++;
+            slot.claimed = false;
+            slot.valid = false;
+        }
+
+        hops++;
+        if (early_stop.enabled())
+            stopped = early_stop.should_stop(full_retset, retset);
+        if (stream_range_results && !check_range_results())
+            stopped = true;
+        end_hop();
+    }
+
+    if (stopped && early_stop.enabled() && stats != nullptr)
+    {
+        stats->n_hops_saved = EarlyTermination::estimate_hops_left(retset, beam_width);
+    }
+
+    // wait for the speculative reads still in flight, which no beam used
+    if (num_slots > 0)
+    {
+        std::vector<AlignedRead> no_reads;
+        submit_and_wait(no_reads, true);
+        for (auto &slot : prefetch_slots)
+        {
+            if (slot.valid && stats != nullptr)
+                stats->prefetch_wasted_bytes += (unsigned)slot_len;
+        }
+    }
+
+    // re-sort by distance
+    std::sort(full_retset.begin(), full_retset.end());
+
+    if (use_reorder_data && !(this->_reorder_data_exists))
+    {
+        throw ANNException("Requested use of reordering data which does "
+                           "not exist in index "
+                           "file",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    // a decoupled layout is always reranked, since nodes were ranked by PQ
+    // distance during the search
+    // a range search reranks as many candidates as its final list holds
+    if (use_reorder_data || _decoupled_vectors)
+    {
+        uint64_t num_rerank = range_state != nullptr ? retset.capacity() : k_search;
+        rerank_full_precision(query_scratch, ctx, num_rerank * FULL_PRECISION_REORDER_MULTIPLIER, stats);
+    }
+
+    if (range_state == nullptr)
+    {
+        copy_results(full_retset, k_search, indices, distances, query_norm);
+    }
+    else if (_decoupled_vectors)
+    {
+        range_state->num_checked = 0;
+        check_range_results();
+    }
+
+#ifdef USE_BING_INFRA
+    ctx.m_completeCount = 0;
+#endif
+
+    if (stats != nullptr)
+    {
+        stats->total_us = (float)query_timer.elapsed();
+    }
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::reserve_batch_scratch(SSDThreadData<T> *data, uint64_t count)
+{
+    VisitedSetPolicy visited_policy = _visited_policy == VisitedSetPolicy::AUTO
+                                          ? VisitedSet::resolve(VisitedSetPolicy::AUTO, _num_points * count)
+                                          : _visited_policy;
+    uint64_t num_allocated = 0;
+    while (data->batch_scratch.size() < count)
+    {
+        data->batch_scratch.push_back(new SSDQueryScratch<T>(this->_aligned_dim, 4096, visited_policy, _num_points));
+        num_allocated++;
+    }
+    for (uint64_t q = 0; q < count; q++)
+        data->batch_scratch[q]->visited.init(visited_policy, _num_points, 4096);
+
+    if (num_allocated > 0)
+    {
+        diskann::cout << "Allocated " << num_allocated << " more query scratch for batched search, "
+                      << data->batch_scratch.size() << " on this thread context of "
+                      << SSDQueryScratch<T>::memory_usage(this->_aligned_dim, 4096, visited_policy, _num_points) / 1024
+                      << "KB each, tracking visited nodes with a " << VisitedSet::name(visited_policy) << std::endl;
+    }
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::batch_cached_beam_search(const T *queries, const uint64_t num_queries,
+                                                       const uint64_t query_aligned_dim, const uint64_t k_search,
+                                                       const uint64_t l_search, uint64_t *indices, float *distances,
+                                                       const uint64_t beam_width, const bool use_filter,
+                                                       const LabelT &filter_label, const bool use_reorder_data,
+                                                       const uint32_t io_limit, QueryStats *stats)
+{
+    if (!use_filter && !use_reorder_data)
+    {
+        batch_cached_beam_search(queries, num_queries, query_aligned_dim, k_search, l_search, indices, distances,
+                                 beam_width, io_limit, stats);
+        return;
+    }
+    // the lock-step hops implement neither, so the queries are searched one
+    // at a time
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        cached_beam_search(queries + q * query_aligned_dim, k_search, l_search, indices + q * k_search,
+                           distances == nullptr ? nullptr : distances + q * k_search, beam_width, use_filter,
+                           filter_label, io_limit, use_reorder_data, stats == nullptr ? nullptr : stats + q);
+    }
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::batch_cached_beam_search(const T *queries, const uint64_t num_queries,
+                                                       const uint64_t query_aligned_dim, const uint64_t k_search,
+                                                       const uint64_t l_search, uint64_t *indices, float *distances,
+                                                       const uint64_t beam_width, const uint32_t io_limit,
+                                                       QueryStats *stats)
+{
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    if (beam_width * num_sectors_per_node > defaults::MAX_N_SECTOR_READS)
+        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+
+    // the visited sets of a batch are bounded on their own, so the other
+    // buffers of a scratch decide how many queries fit in the budget
+    const uint64_t max_batch_size = (std::max)(
+        defaults::MAX_BATCH_SCRATCH_BYTES / SSDQueryScratch<T>::memory_usage(this->_aligned_dim, 0), (uint64_t)1);
+    if (num_queries > max_batch_size)
+    {
+        for (uint64_t start = 0; start < num_queries; start += max_batch_size)
+        {
+            batch_cached_beam_search(queries + start * query_aligned_dim,
+                                     (std::min)(max_batch_size, num_queries - start), query_aligned_dim, k_search,
+                                     l_search, indices + start * k_search,
+                                     distances == nullptr ? nullptr : distances + start * k_search, beam_width,
+                                     io_limit, stats == nullptr ? nullptr : stats + start);
+        }
+        return;
+    }
+
+    ScratchStoreManager<SSDThreadData<T>> manager(thread_data_pool());
+    auto data = manager.scratch_space();
+    // the copies of the PQ vectors and node cache on the NUMA node of data
+    const uint8_t *pq_data = local_pq_data(data->numa_node);
+    auto &nhood_cache = local_nhood_cache(data->numa_node);
+    auto &coord_cache = local_coord_cache(data->numa_node);
+    IOContext &ctx = data->ctx;
+    reserve_batch_scratch(data, num_queries);
+
+    Timer query_timer, io_timer, cpu_timer;
+
+    // lambda to batch compute query<-> node distances in PQ space
+    auto compute_dists = [this, pq_data](SSDQueryScratch<T> *query_scratch, const uint32_t *ids,
+                                         const uint64_t n_ids, float *dists_out) {
+        auto pq_query_scratch = query_scratch->pq_scratch();
+        if (this->_use_pq_fast_scan)
+        {
+            diskann::aggregate_coords_fast_scan(ids, n_ids, pq_data, this->_n_chunks,
+                                                pq_query_scratch->aligned_pq_coord_scratch);
+            diskann::pq_fast_scan_lookup(pq_query_scratch->aligned_pq_coord_scratch, n_ids, this->_n_chunks,
+                                         pq_query_scratch->aligned_pq_lut_scratch, pq_query_scratch->pq_lut_scale,
+                                         pq_query_scratch->pq_lut_bias, dists_out);
+            return;
+        }
+        diskann::aggregate_coords(ids, n_ids, pq_data, this->_n_chunks, pq_query_scratch->aligned_pq_coord_scratch);
+        diskann::pq_dist_lookup(pq_query_scratch->aligned_pq_coord_scratch, n_ids, this->_n_chunks,
+                                pq_query_scratch->aligned_pqtable_dist_scratch, dists_out);
+    };
+
+    // same expansion as cached_beam_search: full precision distance of the node
+    // into full_retset, PQ distances of its unvisited neighbors into retset
+    auto expand_node = [&](const uint64_t q, const uint32_t id, T *node_fp_coords, const uint64_t nnbrs,
+                           uint32_t *node_nbrs) {
+        SSDQueryScratch<T> *query_scratch = data->batch_scratch[q];
+        float *query_float = query_scratch->pq_scratch()->aligned_query_float;
+        float *dist_scratch = query_scratch->pq_scratch()->aligned_dist_scratch;
+        QueryStats *query_stats = stats == nullptr ? nullptr : stats + q;
+
+        cpu_timer.reset();
+        float cur_expanded_dist;
+        if (_decoupled_vectors)
+        {
+            compute_dists(query_scratch, &id, 1, dist_scratch);
+            cur_expanded_dist = dist_scratch[0];
+        }
+        else if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist =
+                _dist_cmp->compare(query_scratch->aligned_query_T(), node_fp_coords, (uint32_t)_aligned_dim);
+        }
+        else
+        {
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords);
+            else
+                cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)node_fp_coords);
+        }
+        if (!is_deleted(id))
+            query_scratch->full_retset.push_back(Neighbor(id, cur_expanded_dist));
+
+        compute_dists(query_scratch, node_nbrs, nnbrs, dist_scratch);
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t nbr_id = node_nbrs[m];
+            if (query_scratch->visited.insert(nbr_id))
+            {
+                if (_dummy_pts.find(nbr_id) != _dummy_pts.end())
+                    continue;
+                query_scratch->retset.insert(Neighbor(nbr_id, dist_scratch[m]));
+            }
+        }
+        if (query_stats != nullptr)
+        {
+            query_stats->n_cmps += (uint32_t)nnbrs;
+            query_stats->cpu_us += (float)cpu_timer.elapsed();
+        }
+    };
+
+    std::vector<float> query_norms(num_queries);
+    std::vector<uint32_t> num_ios(num_queries, 0);
+    std::vector<EarlyTermination> early_stops(num_queries,
+                                              EarlyTermination(k_search, _early_stop_patience, _early_stop_ratio));
+    std::vector<uint8_t> stopped(num_queries, 0);
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        SSDQueryScratch<T> *query_scratch = data->batch_scratch[q];
+        query_scratch->reset();
+        query_norms[q] = preprocess_query(queries + q * query_aligned_dim, query_scratch);
+
+        uint32_t best_medoid = get_best_medoid(query_scratch->pq_scratch()->aligned_query_float);
+        float *dist_scratch = query_scratch->pq_scratch()->aligned_dist_scratch;
+        compute_dists(query_scratch, &best_medoid, 1, dist_scratch);
+        query_scratch->retset.reserve(tombstone_l_search(l_search));
+        query_scratch->retset.insert(Neighbor(best_medoid, dist_scratch[0]));
+        query_scratch->visited.insert(best_medoid);
+    }
+
+    // cleared every hop
+    std::vector<std::vector<std::pair<uint32_t, char *>>> frontier_nhoods(num_queries);
+    std::vector<std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>>> cached_nhoods(num_queries);
+    std::vector<AlignedRead> frontier_read_reqs;
+    frontier_read_reqs.reserve(num_queries * beam_width);
+    // the query that issued each read, which is charged for the evictions of
+    // its sector from the sector cache
+    std::vector<uint64_t> frontier_read_queries;
+    frontier_read_queries.reserve(num_queries * beam_width);
+    // sector # -> buffer it is read into during this hop
+    tsl::robin_map<uint64_t, char *> hop_sectors;
+    hop_sectors.reserve(num_queries * beam_width);
+
+    while (true)
+    {
+        frontier_read_reqs.clear();
+        frontier_read_queries.clear();
+        hop_sectors.clear();
+
+        // find the new beam of every query that is not done yet; a sector is
+        // read into the scratch of the first query that asks for it
+        bool any_active = false;
+        for (uint64_t q = 0; q < num_queries; q++)
+        {
+            SSDQueryScratch<T> *query_scratch = data->batch_scratch[q];
+            NeighborPriorityQueue &retset = query_scratch->retset;
+            frontier_nhoods[q].clear();
+            cached_nhoods[q].clear();
+            if (stopped[q] || !retset.has_unexpanded_node() || num_ios[q] >= io_limit)
+                continue;
+            any_active = true;
+
+            query_scratch->sector_idx = 0;
+            uint32_t num_seen = 0;
+            while (retset.has_unexpanded_node() && frontier_nhoods[q].size() < beam_width && num_seen < beam_width)
+            {
+                auto nbr = retset.closest_unexpanded();
+                num_seen++;
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+                auto iter = nhood_cache.find(nbr.id);
+                if (iter != nhood_cache.end())
+                {
+                    cached_nhoods[q].push_back(std::make_pair(nbr.id, iter->second));
+                    if (stats != nullptr)
+                        stats[q].n_cache_hits++;
+                    continue;
+                }
+
+                uint64_t sector = get_node_sector((size_t)nbr.id);
+                auto sector_iter = hop_sectors.find(sector);
+                char *buf;
+                if (_mapped_index != nullptr)
+                {
+                    buf = _mapped_index + sector * defaults::SECTOR_LEN;
+                }
+                else if (sector_iter == hop_sectors.end())
+                {
+                    buf = query_scratch->sector_scratch +
+                          num_sectors_per_node * query_scratch->sector_idx * defaults::SECTOR_LEN;
+                    query_scratch->sector_idx++;
+                    hop_sectors.insert(std::make_pair(sector, buf));
+                    if (_sector_cache != nullptr && _sector_cache->lookup(sector, buf))
+                    {
+                        if (stats != nullptr)
+                            stats[q].n_sector_cache_hits++;
+                    }
+                    else
+                    {
+                        if (stats != nullptr && _sector_cache != nullptr)
+                            stats[q].n_sector_cache_misses++;
+                        frontier_read_reqs.emplace_back(sector * defaults::SECTOR_LEN,
+                                                        num_sectors_per_node * defaults::SECTOR_LEN, buf);
+                        frontier_read_queries.push_back(q);
+                        if (stats != nullptr)
+                        {
+                            stats[q].n_4k++;
+                            stats[q].n_ios++;
+                        }
+                    }
+                }
+                else
+                {
+                    buf = sector_iter->second;
+                    if (stats != nullptr)
+                        stats[q].n_shared_ios++;
+                }
+                frontier_nhoods[q].push_back(std::make_pair(nbr.id, buf));
+                num_ios[q]++;
+            }
+        }
+        if (!any_active)
+            break;
+
+        // one read for the whole batch
+        float hop_io_us = 0;
+        if (!frontier_read_reqs.empty())
+        {
             io_timer.reset();
 #ifdef USE_BING_INFRA
-            reader->read(frontier_read_reqs, ctx,
-                         true); // asynhronous reader for Bing.
+            reader->read(frontier_read_reqs, ctx, false);
 #else
             reader->read(frontier_read_reqs, ctx); // synchronous IO linux
 #endif
-            if (stats != nullptr)
+            hop_io_us = (float)io_timer.elapsed();
+        }
+        if (_sector_cache != nullptr)
+        {
+            for (size_t r = 0; r < frontier_read_reqs.size(); r++)
             {
-                stats->io_us += (float)io_timer.elapsed();
+                auto &req = frontier_read_reqs[r];
+                if (_sector_cache->insert(req.offset / defaults::SECTOR_LEN, (char *)req.buf) && stats != nullptr)
+                    stats[frontier_read_queries[r]].n_sector_cache_evictions++;
             }
         }
 
-        // process cached nhoods
-        for (auto &cached_nhood : cached_nhoods)
+        for (uint64_t q = 0; q < num_queries; q++)
         {
-            auto global_cache_iter = _coord_cache.find(cached_nhood.first);
-            T *node_fp_coords_copy = global_cache_iter->second;
-            float cur_expanded_dist;
-            if (!_use_disk_index_pq)
+            if (stats != nullptr && !frontier_nhoods[q].empty())
             {
-                cur_expanded_dist = _dist_cmp->compare(aligned_query_T, node_fp_coords_copy, (uint32_t)_aligned_dim);
+                stats[q].n_hops++;
+                stats[q].io_us += hop_io_us;
             }
-            else
+
+            for (auto &cached_nhood : cached_nhoods[q])
             {
-                if (metric == diskann::Metric::INNER_PRODUCT)
-                    cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords_copy);
-                else
-                    cur_expanded_dist = _disk_pq_table.l2_distance( // disk_pq does not support OPQ yet
-                        query_float, (uint8_t *)node_fp_coords_copy);
+                expand_node(q, cached_nhood.first, coord_cache.find(cached_nhood.first)->second,
+                            cached_nhood.second.first, cached_nhood.second.second);
             }
-            full_retset.push_back(Neighbor((uint32_t)cached_nhood.first, cur_expanded_dist));
-
-            uint64_t nnbrs = cached_nhood.second.first;
-            uint32_t *node_nbrs = cached_nhood.second.second;
-
-            // compute node_nbrs <-> query dists in PQ space
-            cpu_timer.reset();
-            compute_dists(node_nbrs, nnbrs, dist_scratch);
-            if (stats != nullptr)
+            for (auto &frontier_nhood : frontier_nhoods[q])
             {
-                stats->n_cmps += (uint32_t)nnbrs;
-                stats->cpu_us += (float)cpu_timer.elapsed();
+                char *node_disk_buf = offset_to_node(frontier_nhood.second, frontier_nhood.first);
+                uint32_t *node_buf = offset_to_node_nhood(node_disk_buf, data->batch_scratch[q]->nhood_scratch);
+                T *data_buf = data->batch_scratch[q]->coord_scratch;
+                memcpy(data_buf, offset_to_node_coords(node_disk_buf), _disk_bytes_per_point);
+                expand_node(q, frontier_nhood.first, data_buf, (uint64_t)(*node_buf), node_buf + 1);
             }
 
-            // process prefetched nhood
-            for (uint64_t m = 0; m < nnbrs; ++m)
+            if (early_stops[q].enabled() && (!frontier_nhoods[q].empty() || !cached_nhoods[q].empty()) &&
+                early_stops[q].should_stop(data->batch_scratch[q]->full_retset, data->batch_scratch[q]->retset))
             {
-                uint32_t id = node_nbrs[m];
-                if (visited.insert(id).second)
-                {
-                    if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
-                        continue;
-
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
-                        continue;
-                    cmps++;
-                    float dist = dist_scratch[m];
-                    Neighbor nn(id, dist);
-                    retset.insert(nn);
-                }
+                stopped[q] = 1;
+                if (stats != nullptr)
+                    stats[q].n_hops_saved =
+                        EarlyTermination::estimate_hops_left(data->batch_scratch[q]->retset, beam_width);
             }
         }
-#ifdef USE_BING_INFRA
-        // process each frontier nhood - compute distances to unvisited nodes
-        int completedIndex = -1;
-        long requestCount = static_cast<long>(frontier_read_reqs.size());
-        // If we issued read requests and if a read is complete or there are
-        // reads in wait state, then enter the while loop.
-        while (requestCount > 0 && getNextCompletedRequest(reader, ctx, requestCount, completedIndex))
+    }
+
+    for (uint64_t q = 0; q < num_queries; q++)
+    {
+        std::vector<Neighbor> &full_retset = data->batch_scratch[q]->full_retset;
+        std::sort(full_retset.begin(), full_retset.end());
+        if (_decoupled_vectors)
         {
-            assert(completedIndex >= 0);
-            auto &frontier_nhood = frontier_nhoods[completedIndex];
-            (*ctx.m_pRequestsStatus)[completedIndex] = IOContext::PROCESS_COMPLETE;
-#else
-        for (auto &frontier_nhood : frontier_nhoods)
+            rerank_full_precision(data->batch_scratch[q], ctx, k_search * FULL_PRECISION_REORDER_MULTIPLIER,
+                                  stats == nullptr ? nullptr : stats + q);
+        }
+        copy_results(full_retset, k_search, indices + q * k_search,
+                     distances == nullptr ? nullptr : distances + q * k_search, query_norms[q]);
+    }
+
+    // every query of the batch waits for the whole batch
+    if (stats != nullptr)
+    {
+        float total_us = (float)query_timer.elapsed();
+        for (uint64_t q = 0; q < num_queries; q++)
         {
-#endif
-            char *node_disk_buf = offset_to_node(frontier_nhood.second, frontier_nhood.first);
-            uint32_t *node_buf = offset_to_node_nhood(node_disk_buf);
-            uint64_t nnbrs = (uint64_t)(*node_buf);
-            T *node_fp_coords = offset_to_node_coords(node_disk_buf);
-            memcpy(data_buf, node_fp_coords, _disk_bytes_per_point);
-            float cur_expanded_dist;
-            if (!_use_disk_index_pq)
-            {
-                cur_expanded_dist = _dist_cmp->compare(aligned_query_T, data_buf, (uint32_t)_aligned_dim);
-            }
-            else
-            {
-                if (metric == diskann::Metric::INNER_PRODUCT)
-                    cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)data_buf);
-                else
-                    cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)data_buf);
-            }
-            full_retset.push_back(Neighbor(frontier_nhood.first, cur_expanded_dist));
-            uint32_t *node_nbrs = (node_buf + 1);
-            // compute node_nbrs <-> query dist in PQ space
-            cpu_timer.reset();
-            compute_dists(node_nbrs, nnbrs, dist_scratch);
-            if (stats != nullptr)
-            {
-                stats->n_cmps += (uint32_t)nnbrs;
-                stats->cpu_us += (float)cpu_timer.elapsed();
-            }
+            stats[q].total_us = total_us;
+        }
+    }
+}
 
-            cpu_timer.reset();
-            // process prefetch-ed nhood
-            for (uint64_t m = 0; m < nnbrs; ++m)
-            {
-                uint32_t id = node_nbrs[m];
-                if (visited.insert(id).second)
-                {
-                    if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
-                        continue;
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::start_async_search(const uint32_t num_workers, const uint32_t queue_depth)
+{
+    if (!_async_workers.empty())
+        throw ANNException("Async search is already running", -1, __FUNCSIG__, __FILE__, __LINE__);
+    if (num_workers == 0 || num_workers > _max_nthreads)
+        throw ANNException("Number of async search workers must be between 1 and the number of threads of load()", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+    if (queue_depth == 0 || queue_depth > MAX_IO_DEPTH)
+        throw ANNException("Async search queue depth must be between 1 and MAX_IO_DEPTH", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    // the visited sets of the queries in flight are bounded on their own, see
+    // reserve_batch_scratch
+    uint64_t scratch_bytes = queue_depth * SSDQueryScratch<T>::memory_usage(this->_aligned_dim, 0);
+    if (scratch_bytes > defaults::MAX_BATCH_SCRATCH_BYTES)
+        throw ANNException("Async search queue depth needs more query scratch per worker than "
+                           "defaults::MAX_BATCH_SCRATCH_BYTES",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    diskann::cout << "Async search keeps " << scratch_bytes / (1024 * 1024) << "MB of query scratch per worker, "
+                  << "besides visited sets" << std::endl;
+    // reranking reads the full precision vectors with blocking reads, which
+    // would take the completions of the reads in flight
+    if (_decoupled_vectors)
+        throw ANNException("Async search does not support decoupled vectors", -1, __FUNCSIG__, __FILE__, __LINE__);
+
+    _async_queue_depth = queue_depth;
+    _async_stopping = false;
+    for (uint32_t w = 0; w < num_workers; w++)
+    {
+        _async_workers.emplace_back(&PQFlashIndex<T, LabelT>::async_search_worker, this, w);
+    }
+}
 
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
-                        continue;
-                    cmps++;
-                    float dist = dist_scratch[m];
-                    if (stats != nullptr)
-                    {
-                        stats->n_cmps++;
-                    }
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::async_search(const T *query, const uint64_t k_search, const uint64_t l_search,
+                                           const uint64_t beam_width, AsyncSearchCallback on_done,
+                                           const uint32_t io_limit)
+{
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    if (beam_width * num_sectors_per_node > defaults::MAX_N_SECTOR_READS)
+        throw ANNException("Beamwidth can not be higher than defaults::MAX_N_SECTOR_READS", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    if (beam_width * _async_queue_depth > MAX_IO_DEPTH)
+        throw ANNException("Beamwidth times async search queue depth can not be higher than MAX_IO_DEPTH", -1,
+                           __FUNCSIG__, __FILE__, __LINE__);
+
+    AsyncSearchRequest request;
+    request.query.assign(query, query + this->_data_dim);
+    request.k_search = k_search;
+    request.l_search = l_search;
+    request.beam_width = beam_width;
+    request.io_limit = io_limit;
+    request.on_done = std::move(on_done);
+    {
+        std::lock_guard<std::mutex> lock(_async_mutex);
+        if (_async_workers.empty() || _async_stopping)
+            throw ANNException("Async search is not running, call start_async_search() first", -1, __FUNCSIG__,
+                               __FILE__, __LINE__);
+        _async_queue.push_back(std::move(request));
+    }
+    _async_cv.notify_one();
+}
 
-                    Neighbor nn(id, dist);
-                    retset.insert(nn);
-                }
-            }
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::stop_async_search()
+{
+    {
+        std::lock_guard<std::mutex> lock(_async_mutex);
+        _async_stopping = true;
+    }
+    _async_cv.notify_all();
+    for (auto &worker : _async_workers)
+    {
+        worker.join();
+    }
+    _async_workers.clear();
+}
 
-            if (stats != nullptr)
-            {
-                stats->cpu_us += (float)cpu_timer.elapsed();
-            }
-        }
+// Each query in flight has a slot with its own query scratch, whose sector
+// scratch its beam is read into. A slot runs hops until it has reads in
+// flight or is done; the worker then waits for any read of any slot, and a
+// slot whose reads have all completed expands its beam and runs on.
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::async_search_worker(uint32_t worker)
+{
+    // a worker keeps its context until stop_async_search(), so the workers
+    // are spread over the nodes instead of taking the contexts of whichever
+    // node they happen to start on
+    std::unique_ptr<numa::ScopedNodeBinding> binding(
+        _numa_thread_data.empty() ? nullptr
+                                  : new numa::ScopedNodeBinding(worker % (uint32_t)_numa_thread_data.size()));
+    ScratchStoreManager<SSDThreadData<T>> manager(thread_data_pool());
+    auto data = manager.scratch_space();
+    // the copies of the PQ vectors and node cache on the NUMA node of data
+    const uint8_t *pq_data = local_pq_data(data->numa_node);
+    auto &nhood_cache = local_nhood_cache(data->numa_node);
+    auto &coord_cache = local_coord_cache(data->numa_node);
+    IOContext &ctx = data->ctx;
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
 
-        hops++;
+    struct Slot
+    {
+        AsyncSearchRequest request;
+        SSDQueryScratch<T> *scratch = nullptr;
+        float query_norm = 0;
+        EarlyTermination early_stop{0, 0, 0};
+        bool stopped = false;
+        uint32_t num_ios = 0;
+        // nodes of the current beam that are expanded from the sector scratch
+        std::vector<std::pair<uint32_t, char *>> frontier;
+        uint64_t reads_pending = 0;
+        QueryStats stats;
+        Timer query_timer, io_timer;
+    };
+    std::vector<Slot> slots(_async_queue_depth);
+    reserve_batch_scratch(data, slots.size());
+    std::vector<uint32_t> free_slots;
+    for (uint32_t s = 0; s < slots.size(); s++)
+    {
+        slots[s].scratch = data->batch_scratch[s];
+        free_slots.push_back((uint32_t)slots.size() - 1 - s);
     }
 
-    // re-sort by distance
-    std::sort(full_retset.begin(), full_retset.end());
+    // buf of every read in flight -> (slot, sector)
+    tsl::robin_map<char *, std::pair<uint32_t, uint64_t>> inflight;
+    std::vector<AlignedRead> read_reqs;
+    std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>> cached_nhoods;
+    std::vector<void *> completed_bufs;
+    std::vector<uint64_t> result_ids;
+    std::vector<float> result_dists;
 
-    if (use_reorder_data)
-    {
-        if (!(this->_reorder_data_exists))
+    // lambda to batch compute query<-> node distances in PQ space
+    auto compute_dists = [this, pq_data](SSDQueryScratch<T> *query_scratch, const uint32_t *ids,
+                                         const uint64_t n_ids, float *dists_out) {
+        auto pq_query_scratch = query_scratch->pq_scratch();
+        if (this->_use_pq_fast_scan)
         {
-            throw ANNException("Requested use of reordering data which does "
-                               "not exist in index "
-                               "file",
-                               -1, __FUNCSIG__, __FILE__, __LINE__);
+            diskann::aggregate_coords_fast_scan(ids, n_ids, pq_data, this->_n_chunks,
+                                                pq_query_scratch->aligned_pq_coord_scratch);
+            diskann::pq_fast_scan_lookup(pq_query_scratch->aligned_pq_coord_scratch, n_ids, this->_n_chunks,
+                                         pq_query_scratch->aligned_pq_lut_scratch, pq_query_scratch->pq_lut_scale,
+                                         pq_query_scratch->pq_lut_bias, dists_out);
+            return;
         }
+        diskann::aggregate_coords(ids, n_ids, pq_data, this->_n_chunks, pq_query_scratch->aligned_pq_coord_scratch);
+        diskann::pq_dist_lookup(pq_query_scratch->aligned_pq_coord_scratch, n_ids, this->_n_chunks,
+                                pq_query_scratch->aligned_pqtable_dist_scratch, dists_out);
+    };
 
-        std::vector<AlignedRead> vec_read_reqs;
-
-        if (full_retset.size() > k_search * FULL_PRECISION_REORDER_MULTIPLIER)
-            full_retset.erase(full_retset.begin() + k_search * FULL_PRECISION_REORDER_MULTIPLIER, full_retset.end());
+    // same expansion as batch_cached_beam_search
+    auto expand_node = [&](Slot &slot, const uint32_t id, T *node_fp_coords, const uint64_t nnbrs,
+                           uint32_t *node_nbrs) {
+        SSDQueryScratch<T> *query_scratch = slot.scratch;
+        float *query_float = query_scratch->pq_scratch()->aligned_query_float;
+        float *dist_scratch = query_scratch->pq_scratch()->aligned_dist_scratch;
 
-        for (size_t i = 0; i < full_retset.size(); ++i)
+        Timer cpu_timer;
+        float cur_expanded_dist;
+        if (!_use_disk_index_pq)
+        {
+            cur_expanded_dist =
+                _dist_cmp->compare(query_scratch->aligned_query_T(), node_fp_coords, (uint32_t)_aligned_dim);
+        }
+        else
         {
-            // MULTISECTORFIX
-            vec_read_reqs.emplace_back(VECTOR_SECTOR_NO(((size_t)full_retset[i].id)) * defaults::SECTOR_LEN,
-                                       defaults::SECTOR_LEN, sector_scratch + i * defaults::SECTOR_LEN);
+            if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_fp_coords);
+            else
+                cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)node_fp_coords);
+        }
+        if (!is_deleted(id))
+            query_scratch->full_retset.push_back(Neighbor(id, cur_expanded_dist));
 
-            if (stats != nullptr)
+        compute_dists(query_scratch, node_nbrs, nnbrs, dist_scratch);
+        for (uint64_t m = 0; m < nnbrs; ++m)
+        {
+            uint32_t nbr_id = node_nbrs[m];
+            if (query_scratch->visited.insert(nbr_id))
             {
-                stats->n_4k++;
-                stats->n_ios++;
+                if (_dummy_pts.find(nbr_id) != _dummy_pts.end())
+                    continue;
+                query_scratch->retset.insert(Neighbor(nbr_id, dist_scratch[m]));
             }
         }
+        slot.stats.n_cmps += (uint32_t)nnbrs;
+        slot.stats.cpu_us += (float)cpu_timer.elapsed();
+    };
 
-        io_timer.reset();
-#ifdef USE_BING_INFRA
-        reader->read(vec_read_reqs, ctx, true); // async reader windows.
-#else
-        reader->read(vec_read_reqs, ctx); // synchronous IO linux
-#endif
-        if (stats != nullptr)
+    // expands the nodes of the beam once their sectors are in, and checks
+    // whether the search should stop
+    auto finish_hop = [&](Slot &slot) {
+        for (auto &frontier_nhood : slot.frontier)
         {
-            stats->io_us += io_timer.elapsed();
+            char *node_disk_buf = offset_to_node(frontier_nhood.second, frontier_nhood.first);
+            uint32_t *node_buf = offset_to_node_nhood(node_disk_buf, slot.scratch->nhood_scratch);
+            T *data_buf = slot.scratch->coord_scratch;
+            memcpy(data_buf, offset_to_node_coords(node_disk_buf), _disk_bytes_per_point);
+            expand_node(slot, frontier_nhood.first, data_buf, (uint64_t)(*node_buf), node_buf + 1);
         }
-
-        for (size_t i = 0; i < full_retset.size(); ++i)
+        if (slot.early_stop.enabled() && slot.early_stop.should_stop(slot.scratch->full_retset, slot.scratch->retset))
         {
-            auto id = full_retset[i].id;
-            // MULTISECTORFIX
-            auto location = (sector_scratch + i * defaults::SECTOR_LEN) + VECTOR_SECTOR_OFFSET(id);
-            full_retset[i].distance = _dist_cmp->compare(aligned_query_T, (T *)location, (uint32_t)this->_data_dim);
+            slot.stopped = true;
+            slot.stats.n_hops_saved =
+                EarlyTermination::estimate_hops_left(slot.scratch->retset, slot.request.beam_width);
         }
+    };
 
+    auto finish_query = [&](const uint32_t s) {
+        Slot &slot = slots[s];
+        std::vector<Neighbor> &full_retset = slot.scratch->full_retset;
         std::sort(full_retset.begin(), full_retset.end());
-    }
+        result_ids.resize(slot.request.k_search);
+        result_dists.resize(slot.request.k_search);
+        copy_results(full_retset, slot.request.k_search, result_ids.data(), result_dists.data(), slot.query_norm);
+        slot.stats.total_us = (float)slot.query_timer.elapsed();
+        slot.request.on_done(result_ids.data(), result_dists.data(), slot.stats);
+        slot.request.on_done = nullptr;
+        free_slots.push_back(s);
+    };
 
-    // copy k_search values
-    for (uint64_t i = 0; i < k_search; i++)
-    {
-        indices[i] = full_retset[i].id;
-        auto key = (uint32_t)indices[i];
-        if (_dummy_pts.find(key) != _dummy_pts.end())
+    // runs hops of the query in slot s until it has reads in flight or is done
+    auto run_query = [&](const uint32_t s) {
+        Slot &slot = slots[s];
+        SSDQueryScratch<T> *query_scratch = slot.scratch;
+        NeighborPriorityQueue &retset = query_scratch->retset;
+        const uint64_t beam_width = slot.request.beam_width;
+        while (!slot.stopped && retset.has_unexpanded_node() && slot.num_ios < slot.request.io_limit)
         {
-            indices[i] = _dummy_to_real_map[key];
+            slot.frontier.clear();
+            cached_nhoods.clear();
+            read_reqs.clear();
+            query_scratch->sector_idx = 0;
+            uint32_t num_seen = 0;
+            while (retset.has_unexpanded_node() && slot.frontier.size() < beam_width && num_seen < beam_width)
+            {
+                auto nbr = retset.closest_unexpanded();
+                num_seen++;
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+                auto iter = nhood_cache.find(nbr.id);
+                if (iter != nhood_cache.end())
+                {
+                    cached_nhoods.push_back(std::make_pair(nbr.id, iter->second));
+                    slot.stats.n_cache_hits++;
+                    continue;
+                }
+
+                uint64_t sector = get_node_sector((size_t)nbr.id);
+                char *buf;
+                if (_mapped_index != nullptr)
+                {
+                    buf = _mapped_index + sector * defaults::SECTOR_LEN;
+                }
+                else
+                {
+                    buf = query_scratch->sector_scratch +
+                          num_sectors_per_node * query_scratch->sector_idx * defaults::SECTOR_LEN;
+                    query_scratch->sector_idx++;
+                    if (_sector_cache != nullptr && _sector_cache->lookup(sector, buf))
+                    {
+                        slot.stats.n_sector_cache_hits++;
+                    }
+                    else
+                    {
+                        if (_sector_cache != nullptr)
+                            slot.stats.n_sector_cache_misses++;
+                        read_reqs.emplace_back(sector * defaults::SECTOR_LEN,
+                                               num_sectors_per_node * defaults::SECTOR_LEN, buf);
+                        slot.stats.n_4k++;
+                        slot.stats.n_ios++;
+                    }
+                }
+                slot.frontier.push_back(std::make_pair(nbr.id, buf));
+                slot.num_ios++;
+            }
+            if (!slot.frontier.empty())
+                slot.stats.n_hops++;
+
+            for (auto &cached_nhood : cached_nhoods)
+            {
+                expand_node(slot, cached_nhood.first, coord_cache.find(cached_nhood.first)->second,
+                            cached_nhood.second.first, cached_nhood.second.second);
+            }
+
+            if (!read_reqs.empty())
+            {
+#if !defined(_WINDOWS) && !defined(USE_BING_INFRA)
+                // suspend the query until its reads are in
+                slot.reads_pending = read_reqs.size();
+                for (auto &req : read_reqs)
+                {
+                    inflight.insert(std::make_pair((char *)req.buf,
+                                                   std::make_pair(s, req.offset / defaults::SECTOR_LEN)));
+                }
+                slot.io_timer.reset();
+                reader->submit_reqs(read_reqs, ctx);
+                return;
+#else
+                slot.io_timer.reset();
+                reader->read(read_reqs, ctx, false);
+                slot.stats.io_us += (float)slot.io_timer.elapsed();
+                if (_sector_cache != nullptr)
+                {
+                    for (auto &req : read_reqs)
+                        _sector_cache->insert(req.offset / defaults::SECTOR_LEN, (char *)req.buf);
+                }
+#endif
+            }
+            finish_hop(slot);
         }
+        finish_query(s);
+    };
 
-        if (distances != nullptr)
+    while (true)
+    {
+        // take queued queries into the free slots; block only when no
+        // query is in flight
+        std::vector<uint32_t> started;
         {
-            distances[i] = full_retset[i].distance;
-            if (metric == diskann::Metric::INNER_PRODUCT)
+            std::unique_lock<std::mutex> lock(_async_mutex);
+            if (free_slots.size() == slots.size())
+            {
+                _async_cv.wait(lock, [this] { return _async_stopping || !_async_queue.empty(); });
+                if (_async_queue.empty())
+                    break;
+            }
+            while (!free_slots.empty() && !_async_queue.empty())
             {
-                // flip the sign to convert min to max
-                distances[i] = (-distances[i]);
-                // rescale to revert back to original norms (cancelling the
-                // effect of base and query pre-processing)
-                if (_max_base_norm != 0)
-                    distances[i] *= (_max_base_norm * query_norm);
+                uint32_t s = free_slots.back();
+                free_slots.pop_back();
+                slots[s].request = std::move(_async_queue.front());
+                _async_queue.pop_front();
+                started.push_back(s);
             }
         }
-    }
 
-#ifdef USE_BING_INFRA
-    ctx.m_completeCount = 0;
-#endif
+        for (uint32_t s : started)
+        {
+            Slot &slot = slots[s];
+            SSDQueryScratch<T> *query_scratch = slot.scratch;
+            slot.query_timer.reset();
+            slot.stats = QueryStats();
+            slot.stopped = false;
+            slot.num_ios = 0;
+            slot.early_stop = EarlyTermination(slot.request.k_search, _early_stop_patience, _early_stop_ratio);
+
+            query_scratch->reset();
+            slot.query_norm = preprocess_query(slot.request.query.data(), query_scratch);
+            uint32_t best_medoid = get_best_medoid(query_scratch->pq_scratch()->aligned_query_float);
+            float *dist_scratch = query_scratch->pq_scratch()->aligned_dist_scratch;
+            compute_dists(query_scratch, &best_medoid, 1, dist_scratch);
+            query_scratch->retset.reserve(tombstone_l_search(slot.request.l_search));
+            query_scratch->retset.insert(Neighbor(best_medoid, dist_scratch[0]));
+            query_scratch->visited.insert(best_medoid);
+            run_query(s);
+        }
 
-    if (stats != nullptr)
-    {
-        stats->total_us = (float)query_timer.elapsed();
+#if !defined(_WINDOWS) && !defined(USE_BING_INFRA)
+        if (inflight.empty())
+            continue;
+        completed_bufs.clear();
+        reader->get_completed_reqs(ctx, 1, completed_bufs);
+        for (void *completed : completed_bufs)
+        {
+            auto iter = inflight.find((char *)completed);
+            assert(iter != inflight.end());
+            uint32_t s = iter->second.first;
+            uint64_t sector = iter->second.second;
+            inflight.erase(iter);
+
+            Slot &slot = slots[s];
+            if (_sector_cache != nullptr && _sector_cache->insert(sector, (char *)completed))
+                slot.stats.n_sector_cache_evictions++;
+            if (--slot.reads_pending > 0)
+                continue;
+            slot.stats.io_us += (float)slot.io_timer.elapsed();
+            finish_hop(slot);
+            run_query(s);
+        }
+#endif
     }
 }
 
-// range search returns results of all neighbors within distance of range.
-// indices and distances need to be pre-allocated of size l_search and the
-// return value is the number of matching hits.
+template <typename T, typename LabelT>
+uint64_t PQFlashIndex<T, LabelT>::range_search_beam_width(const uint64_t l_search, const uint64_t min_beam_width)
+{
+    uint64_t beam_width = min_beam_width > (l_search / 5) ? min_beam_width : l_search / 5;
+    beam_width = (beam_width > 100) ? 100 : beam_width;
+    // a beam must fit in the sector scratch
+    const uint64_t num_sectors_per_node =
+        _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    return (std::min)(beam_width, defaults::MAX_N_SECTOR_READS / num_sectors_per_node);
+}
+
+// range search returns results of all neighbors within distance of range,
+// sorted by distance, and the number of matching hits.
 template <typename T, typename LabelT>
 uint32_t PQFlashIndex<T, LabelT>::range_search(const T *query1, const double range, const uint64_t min_l_search,
                                                const uint64_t max_l_search, std::vector<uint64_t> &indices,
                                                std::vector<float> &distances, const uint64_t min_beam_width,
                                                QueryStats *stats)
 {
-    uint32_t res_count = 0;
-
-    bool stop_flag = false;
+    std::vector<std::pair<float, uint64_t>> results;
+    RangeSearchCallback collect = [&results](uint64_t id, float dist) {
+        results.emplace_back(dist, id);
+        return true;
+    };
+    uint32_t res_count = range_search(query1, range, min_l_search, max_l_search, collect, min_beam_width, stats);
 
-    uint32_t l_search = (uint32_t)min_l_search; // starting size of the candidate list
-    while (!stop_flag)
-    {
-        indices.resize(l_search);
-        distances.resize(l_search);
-        uint64_t cur_bw = min_beam_width > (l_search / 5) ? min_beam_width : l_search / 5;
-        cur_bw = (cur_bw > 100) ? 100 : cur_bw;
-        for (auto &x : distances)
-            x = std::numeric_limits<float>::max();
-        this->cached_beam_search(query1, l_search, l_search, indices.data(), distances.data(), cur_bw, false, stats);
-        for (uint32_t i = 0; i < l_search; i++)
-        {
-            if (distances[i] > (float)range)
-            {
-                res_count = i;
-                break;
-            }
-            else if (i == l_search - 1)
-                res_count = l_search;
-        }
-        if (res_count < (uint32_t)(l_search / 2.0))
-            stop_flag = true;
-        l_search = l_search * 2;
-        if (l_search > max_l_search)
-            stop_flag = true;
-    }
+    std::sort(results.begin(), results.end());
     indices.resize(res_count);
     distances.resize(res_count);
+    for (uint32_t i = 0; i < res_count; i++)
+    {
+        distances[i] = results[i].first;
+        indices[i] = results[i].second;
+    }
     return res_count;
 }
 
+template <typename T, typename LabelT>
+uint32_t PQFlashIndex<T, LabelT>::range_search(const T *query1, const double range, const uint64_t min_l_search,
+                                               const uint64_t max_l_search, const RangeSearchCallback &callback,
+                                               const uint64_t min_beam_width, QueryStats *stats)
+{
+    RangeSearchState range_state;
+    range_state.range = (float)range;
+    range_state.max_l_search = max_l_search;
+    range_state.min_beam_width = min_beam_width;
+    range_state.callback = &callback;
+
+    LabelT dummy_filter = 0;
+    cached_beam_search_impl(query1, min_l_search, min_l_search, nullptr, nullptr,
+                            range_search_beam_width(min_l_search, min_beam_width), false, dummy_filter,
+                            std::numeric_limits<uint32_t>::max(), false, stats, &range_state);
+    return range_state.num_results;
+}
+
 template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::get_data_dim()
 {
     return _data_dim;
@@ -1773,8 +3772,8 @@ template <typename T, typename LabelT> char *PQFlashIndex<T, LabelT>::getHeaderB
 template <typename T, typename LabelT>
 std::vector<std::uint8_t> PQFlashIndex<T, LabelT>::get_pq_vector(std::uint64_t vid)
 {
-    std::uint8_t *pqVec = &this->data[vid * this->_n_chunks];
-    return std::vector<std::uint8_t>(pqVec, pqVec + this->_n_chunks);
+    std::uint8_t *pqVec = &this->data[vid * this->_pq_code_len];
+    return std::vector<std::uint8_t>(pqVec, pqVec + this->_pq_code_len);
 }
 
 template <typename T, typename LabelT> std::uint64_t PQFlashIndex<T, LabelT>::get_num_points()
@@ -1782,6 +3781,110 @@ template <typename T, typename LabelT> std::uint64_t PQFlashIndex<T, LabelT>::ge
     return _num_points;
 }
 
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::set_pipelined_search(bool enable)
+{
+#if defined(_WINDOWS) || defined(USE_BING_INFRA)
+    if (enable)
+    {
+        diskann::cerr << "Pipelined search is only supported on Linux, ignoring." << std::endl;
+    }
+#else
+    _use_pipelined_search = enable;
+#endif
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_speculative_prefetch(uint32_t num_nodes)
+{
+#if defined(_WINDOWS) || defined(USE_BING_INFRA)
+    if (num_nodes > 0)
+    {
+        diskann::cerr << "Speculative prefetch is only supported on Linux, ignoring." << std::endl;
+    }
+#else
+    _prefetch_nodes = (uint32_t)(std::min)((uint64_t)num_nodes, defaults::MAX_N_PREFETCH_SECTORS);
+#endif
+}
+
+template <typename T, typename LabelT> bool PQFlashIndex<T, LabelT>::lazy_delete(uint32_t id)
+{
+    if (!_tombstones.set(id))
+        return false;
+    // results report dummy points under the id of their real point
+    auto dummies = _real_to_dummy_map.find(id);
+    if (dummies != _real_to_dummy_map.end())
+    {
+        for (auto dummy : dummies->second)
+            _tombstones.set(dummy);
+    }
+    return true;
+}
+
+template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::get_num_deleted() const
+{
+    return _tombstones.count();
+}
+
+template <typename T, typename LabelT> std::vector<uint32_t> PQFlashIndex<T, LabelT>::get_deleted_ids() const
+{
+    std::vector<uint32_t> deleted_ids;
+    deleted_ids.reserve(_tombstones.count());
+    for (uint64_t id = 0; id < _tombstones.size() && deleted_ids.size() < _tombstones.count(); id++)
+    {
+        if (_tombstones.test(id))
+            deleted_ids.push_back((uint32_t)id);
+    }
+    return deleted_ids;
+}
+
+template <typename T, typename LabelT> uint64_t PQFlashIndex<T, LabelT>::get_tombstone_memory() const
+{
+    return _tombstones.memory_bytes();
+}
+
+template <typename T, typename LabelT>
+uint64_t PQFlashIndex<T, LabelT>::tombstone_l_search(const uint64_t l_search) const
+{
+    uint64_t num_deleted = _tombstones.count();
+    if (num_deleted == 0)
+        return l_search;
+    uint64_t max_l_search = l_search * defaults::MAX_TOMBSTONE_L_SCALE;
+    uint64_t num_live = _tombstones.size() - (std::min)(num_deleted, _tombstones.size());
+    if (num_live * defaults::MAX_TOMBSTONE_L_SCALE <= _tombstones.size())
+        return max_l_search;
+    return (std::min)(max_l_search, DIV_ROUND_UP(l_search * _tombstones.size(), num_live));
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::enable_sector_cache(uint64_t budget_bytes)
+{
+#if defined(_WINDOWS) || defined(USE_BING_INFRA)
+    if (budget_bytes > 0)
+    {
+        diskann::cerr << "Dynamic sector cache is only supported on Linux, ignoring." << std::endl;
+    }
+#else
+    if (budget_bytes == 0)
+    {
+        _sector_cache.reset();
+        return;
+    }
+    if (_mapped_index != nullptr)
+    {
+        diskann::cerr << "Disk index is memory mapped, not using a sector cache." << std::endl;
+        return;
+    }
+    uint64_t num_sectors_per_node = _nnodes_per_sector > 0 ? 1 : DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
+    _sector_cache.reset(new SectorCache(budget_bytes, num_sectors_per_node * defaults::SECTOR_LEN));
+#endif
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_early_termination(uint32_t patience_hops, float converge_ratio)
+{
+    _early_stop_patience = patience_hops;
+    _early_stop_ratio = converge_ratio;
+}
+
 // instantiations
 template class PQFlashIndex<uint8_t>;
 template class PQFlashIndex<int8_t>;
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <iomanip>
+#include <sstream>
+
+#include "query_metrics.h"
+
+namespace diskann
+{
+namespace
+{
+thread_local std::vector<HopTrace> *current_hop_trace = nullptr;
+
+// upper bounds of the buckets of the exported histograms, in microseconds
+const uint64_t PROMETHEUS_BUCKETS_US[] = {100,   250,   500,    1000,   2500,   5000,   10000,
+                                          25000, 50000, 100000, 250000, 500000, 1000000};
+
+void write_counter(std::ostringstream &out, const std::string &name, const std::string &help, uint64_t value)
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " counter\n";
+    out << name << " " << value << "\n";
+}
+
+void write_histogram(std::ostringstream &out, const std::string &name, const std::string &help,
+                     const LatencyHistogram &histogram)
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " histogram\n";
+    for (uint64_t bound_us : PROMETHEUS_BUCKETS_US)
+    {
+        std::ostringstream le;
+        le << bound_us / 1e6;
+        out << name << "_bucket{le=\"" << le.str() << "\"} " << histogram.count_at_or_below(bound_us) << "\n";
+    }
+    out << name << "_bucket{le=\"+Inf\"} " << histogram.count() << "\n";
+    out << name << "_sum " << std::fixed << std::setprecision(6) << histogram.sum() / 1e6 << "\n";
+    out.unsetf(std::ios_base::floatfield);
+    out << name << "_count " << histogram.count() << "\n";
+}
+} // namespace
+
+HopTraceScope::HopTraceScope(std::vector<HopTrace> &trace) : _previous(current_hop_trace)
+{
+    current_hop_trace = &trace;
+}
+
+HopTraceScope::~HopTraceScope()
+{
+    current_hop_trace = _previous;
+}
+
+std::vector<HopTrace> *HopTraceScope::current()
+{
+    return current_hop_trace;
+}
+
+void QueryMetrics::record(const QueryStats &stats)
+{
+    _total_us.record((uint64_t)stats.total_us);
+    _io_us.record((uint64_t)stats.io_us);
+    _cpu_us.record((uint64_t)stats.cpu_us);
+    _n_ios.fetch_add(stats.n_ios, std::memory_order_relaxed);
+    _n_hops.fetch_add(stats.n_hops, std::memory_order_relaxed);
+    _n_cmps.fetch_add(stats.n_cmps, std::memory_order_relaxed);
+    _n_cache_hits.fetch_add(stats.n_cache_hits, std::memory_order_relaxed);
+    _n_sector_cache_hits.fetch_add(stats.n_sector_cache_hits, std::memory_order_relaxed);
+    _n_sector_cache_misses.fetch_add(stats.n_sector_cache_misses, std::memory_order_relaxed);
+    if (stats.hop_trace != nullptr)
+    {
+        for (const HopTrace &hop : *stats.hop_trace)
+            _hop_io_us.record((uint64_t)hop.io_us);
+    }
+}
+
+void QueryMetrics::reset()
+{
+    _total_us.reset();
+    _io_us.reset();
+    _cpu_us.reset();
+    _hop_io_us.reset();
+    _n_ios.store(0, std::memory_order_relaxed);
+    _n_hops.store(0, std::memory_order_relaxed);
+    _n_cmps.store(0, std::memory_order_relaxed);
+    _n_cache_hits.store(0, std::memory_order_relaxed);
+    _n_sector_cache_hits.store(0, std::memory_order_relaxed);
+    _n_sector_cache_misses.store(0, std::memory_order_relaxed);
+}
+
+uint64_t QueryMetrics::num_queries() const
+{
+    return _total_us.count();
+}
+
+const LatencyHistogram &QueryMetrics::latency() const
+{
+    return _total_us;
+}
+
+std::string QueryMetrics::to_prometheus(const std::string &prefix) const
+{
+    std::ostringstream out;
+    write_counter(out, prefix + "_queries_total", "Searches recorded.", num_queries());
+    write_histogram(out, prefix + "_latency_seconds", "Time to answer a search.", _total_us);
+    write_histogram(out, prefix + "_io_wait_seconds", "Time a search spent waiting for reads.", _io_us);
+    write_histogram(out, prefix + "_cpu_seconds", "Time a search spent computing distances.", _cpu_us);
+    write_histogram(out, prefix + "_hop_io_wait_seconds", "Time a traced hop spent waiting for reads.", _hop_io_us);
+    write_counter(out, prefix + "_reads_total", "Reads issued by searches.", _n_ios.load());
+    write_counter(out, prefix + "_hops_total", "Hops made by searches.", _n_hops.load());
+    write_counter(out, prefix + "_distance_computations_total", "Distances computed by searches.", _n_cmps.load());
+    write_counter(out, prefix + "_node_cache_hits_total", "Nodes expanded from the node cache.",
+                  _n_cache_hits.load());
+    write_counter(out, prefix + "_sector_cache_hits_total", "Node reads served by the sector cache.",
+                  _n_sector_cache_hits.load());
+    write_counter(out, prefix + "_sector_cache_misses_total", "Node reads that missed the sector cache.",
+                  _n_sector_cache_misses.load());
+    return out.str();
+}
+} // namespace diskann
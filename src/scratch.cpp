@@ -2,7 +2,6 @@
 // Licensed under the MIT license.
 
 #include <vector>
-#include <boost/dynamic_bitset.hpp>
 
 #include "scratch.h"
 #include "pq_scratch.h"
@@ -34,7 +33,6 @@ InMemQueryScratch<T>::InMemQueryScratch(uint32_t search_l, uint32_t indexing_l,
         this->_pq_scratch = nullptr;
 
     _occlude_factor.reserve(maxc);
-    _inserted_into_pool_bs = new boost::dynamic_bitset<>();
     _id_scratch.reserve((size_t)std::ceil(1.5 * defaults::GRAPH_SLACK_FACTOR * _R));
     _dist_scratch.reserve((size_t)std::ceil(1.5 * defaults::GRAPH_SLACK_FACTOR * _R));
 
@@ -47,8 +45,7 @@ template <typename T> void InMemQueryScratch<T>::clear()
     _best_l_nodes.clear();
     _occlude_factor.clear();
 
-    _inserted_into_pool_rs.clear();
-    _inserted_into_pool_bs->reset();
+    _inserted_into_pool.clear();
 
     _id_scratch.clear();
     _dist_scratch.clear();
@@ -66,7 +63,8 @@ template <typename T> void InMemQueryScratch<T>::resize_for_new_L(uint32_t new_l
         _pool.reserve(3 * _L + _R);
         _best_l_nodes.reserve(_L);
 
-        _inserted_into_pool_rs.reserve(20 * _L);
+        if (_inserted_into_pool.mode() == VisitedSetPolicy::HASH_SET)
+            _inserted_into_pool.init(VisitedSetPolicy::HASH_SET, 0, 20 * (size_t)_L);
     }
 }
 
@@ -79,7 +77,6 @@ template <typename T> InMemQueryScratch<T>::~InMemQueryScratch()
     }
 
     delete this->_pq_scratch;
-    delete _inserted_into_pool_bs;
 }
 
 //
@@ -93,38 +90,67 @@ template <typename T> void SSDQueryScratch<T>::reset()
     full_retset.clear();
 }
 
-template <typename T> SSDQueryScratch<T>::SSDQueryScratch(size_t aligned_dim, size_t visited_reserve)
+template <typename T>
+SSDQueryScratch<T>::SSDQueryScratch(size_t aligned_dim, size_t visited_reserve, VisitedSetPolicy visited_policy,
+                                    uint64_t num_points)
 {
     size_t coord_alloc_size = ROUND_UP(sizeof(T) * aligned_dim, 256);
 
     diskann::alloc_aligned((void **)&coord_scratch, coord_alloc_size, 256);
     diskann::alloc_aligned((void **)&sector_scratch, defaults::MAX_N_SECTOR_READS * defaults::SECTOR_LEN,
                            defaults::SECTOR_LEN);
+    diskann::alloc_aligned((void **)&prefetch_scratch, defaults::MAX_N_PREFETCH_SECTORS * defaults::SECTOR_LEN,
+                           defaults::SECTOR_LEN);
     diskann::alloc_aligned((void **)&this->_aligned_query_T, aligned_dim * sizeof(T), 8 * sizeof(T));
+    nhood_scratch = new uint32_t[defaults::MAX_GRAPH_DEGREE + 1];
 
     this->_pq_scratch = new PQScratch<T>(defaults::MAX_GRAPH_DEGREE, aligned_dim);
 
     memset(coord_scratch, 0, coord_alloc_size);
     memset(this->_aligned_query_T, 0, aligned_dim * sizeof(T));
 
-    visited.reserve(visited_reserve);
+    visited.init(visited_policy, num_points, visited_reserve);
     full_retset.reserve(visited_reserve);
 }
 
+template <typename T>
+uint64_t SSDQueryScratch<T>::memory_usage(size_t aligned_dim, size_t visited_reserve, VisitedSetPolicy visited_policy,
+                                          uint64_t num_points)
+{
+    uint64_t pq_bytes = defaults::MAX_GRAPH_DEGREE * (MAX_PQ_CHUNKS + sizeof(float)) +
+                        (256 + NUM_PQ_CENTROIDS_4BIT) * MAX_PQ_CHUNKS * sizeof(float) + 2 * aligned_dim * sizeof(float);
+    return (defaults::MAX_N_SECTOR_READS + defaults::MAX_N_PREFETCH_SECTORS) * defaults::SECTOR_LEN +
+           2 * ROUND_UP(sizeof(T) * aligned_dim, 256) + (defaults::MAX_GRAPH_DEGREE + 1) * sizeof(uint32_t) +
+           pq_bytes + visited_reserve * sizeof(Neighbor) +
+           VisitedSet::memory_usage(visited_policy, num_points, visited_reserve);
+}
+
 template <typename T> SSDQueryScratch<T>::~SSDQueryScratch()
 {
     diskann::aligned_free((void *)coord_scratch);
     diskann::aligned_free((void *)sector_scratch);
+    diskann::aligned_free((void *)prefetch_scratch);
     diskann::aligned_free((void *)this->_aligned_query_T);
+    delete[] nhood_scratch;
 
     delete this->_pq_scratch;
 }
 
 template <typename T>
-SSDThreadData<T>::SSDThreadData(size_t aligned_dim, size_t visited_reserve) : scratch(aligned_dim, visited_reserve)
+SSDThreadData<T>::SSDThreadData(size_t aligned_dim, size_t visited_reserve, VisitedSetPolicy visited_policy,
+                                uint64_t num_points)
+    : scratch(aligned_dim, visited_reserve, visited_policy, num_points)
 {
 }
 
+template <typename T> SSDThreadData<T>::~SSDThreadData()
+{
+    for (auto batch_query_scratch : batch_scratch)
+    {
+        delete batch_query_scratch;
+    }
+}
+
 template <typename T> void SSDThreadData<T>::clear()
 {
     scratch.reset();
@@ -135,6 +161,8 @@ template <typename T> PQScratch<T>::PQScratch(size_t graph_degree, size_t aligne
     diskann::alloc_aligned((void **)&aligned_pq_coord_scratch,
                            (size_t)graph_degree * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t), 256);
     diskann::alloc_aligned((void **)&aligned_pqtable_dist_scratch, 256 * (size_t)MAX_PQ_CHUNKS * sizeof(float), 256);
+    diskann::alloc_aligned((void **)&aligned_pq_lut_scratch,
+                           NUM_PQ_CENTROIDS_4BIT * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t), 256);
     diskann::alloc_aligned((void **)&aligned_dist_scratch, (size_t)graph_degree * sizeof(float), 256);
     diskann::alloc_aligned((void **)&aligned_query_float, aligned_dim * sizeof(float), 8 * sizeof(float));
     diskann::alloc_aligned((void **)&rotated_query, aligned_dim * sizeof(float), 8 * sizeof(float));
@@ -147,6 +175,7 @@ template <typename T> PQScratch<T>::~PQScratch()
 {
     diskann::aligned_free((void *)aligned_pq_coord_scratch);
     diskann::aligned_free((void *)aligned_pqtable_dist_scratch);
+    diskann::aligned_free((void *)aligned_pq_lut_scratch);
     diskann::aligned_free((void *)aligned_dist_scratch);
     diskann::aligned_free((void *)aligned_query_float);
     diskann::aligned_free((void *)rotated_query);
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cstring>
+
+#include "defaults.h"
+#include "logger.h"
+#include "sector_cache.h"
+#include "utils.h"
+
+namespace diskann
+{
+SectorCache::SectorCache(uint64_t budget_bytes, uint64_t entry_len, uint32_t num_shards) : _entry_len(entry_len)
+{
+    uint64_t num_entries = budget_bytes / entry_len;
+    num_shards = (uint32_t)(std::max)((uint64_t)1, (std::min)((uint64_t)num_shards, num_entries));
+    _shards = std::vector<Shard>(num_shards);
+    for (uint32_t s = 0; s < num_shards; s++)
+    {
+        Shard &shard = _shards[s];
+        shard.num_slots = (uint32_t)(num_entries / num_shards + (s < num_entries % num_shards ? 1 : 0));
+        shard.slot_of.reserve(shard.num_slots);
+        shard.sector_of.resize(shard.num_slots);
+        shard.referenced.resize(shard.num_slots, 0);
+        if (shard.num_slots > 0)
+        {
+            diskann::alloc_aligned((void **)&shard.buf, shard.num_slots * _entry_len, defaults::SECTOR_LEN);
+        }
+        _capacity += shard.num_slots;
+    }
+    diskann::cout << "Sector cache: " << _capacity << " entries of " << _entry_len << "B in " << num_shards
+                  << " shards" << std::endl;
+}
+
+SectorCache::~SectorCache()
+{
+    for (auto &shard : _shards)
+    {
+        if (shard.buf != nullptr)
+            diskann::aligned_free(shard.buf);
+    }
+}
+
+bool SectorCache::lookup(uint64_t sector, char *buf)
+{
+    Shard &shard = shard_of(sector);
+    std::lock_guard<std::mutex> guard(shard.mut);
+    auto iter = shard.slot_of.find(sector);
+    if (iter == shard.slot_of.end())
+        return false;
+
+    uint32_t slot = iter->second;
+    shard.referenced[slot] = 1;
+    // copied under the lock, since the slot can be evicted once it is released
+    memcpy(buf, shard.buf + slot * _entry_len, _entry_len);
+    return true;
+}
+
+bool SectorCache::insert(uint64_t sector, const char *buf)
+{
+    Shard &shard = shard_of(sector);
+    std::lock_guard<std::mutex> guard(shard.mut);
+    if (shard.num_slots == 0 || shard.slot_of.find(sector) != shard.slot_of.end())
+        return false;
+
+    uint32_t slot;
+    bool evicted = false;
+    if (shard.num_used < shard.num_slots)
+    {
+        slot = shard.num_used++;
+    }
+    else
+    {
+        // advance the clock hand, giving referenced entries a second chance
+        while (shard.referenced[shard.hand])
+        {
+            shard.referenced[shard.hand] = 0;
+            shard.hand = (shard.hand + 1) % shard.num_slots;
+        }
+        slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.num_slots;
+        shard.slot_of.erase(shard.sector_of[slot]);
+        evicted = true;
+    }
+
+    memcpy(shard.buf + slot * _entry_len, buf, _entry_len);
+    shard.sector_of[slot] = sector;
+    shard.referenced[slot] = 0;
+    shard.slot_of.insert(std::make_pair(sector, slot));
+    return evicted;
+}
+
+uint64_t SectorCache::capacity() const
+{
+    return _capacity;
+}
+} // namespace diskann
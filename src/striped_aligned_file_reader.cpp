@@ -0,0 +1,295 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef _WINDOWS
+
+#include "striped_aligned_file_reader.h"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include "ann_exception.h"
+#include "defaults.h"
+#include "tsl/robin_map.h"
+#include "utils.h"
+#define MAX_EVENTS 1024
+
+StripedAlignedFileReader::StripedAlignedFileReader()
+{
+}
+
+StripedAlignedFileReader::~StripedAlignedFileReader()
+{
+    if (!_stripe_fds.empty())
+    {
+        std::cerr << "close() not called" << std::endl;
+        close();
+    }
+    deregister_all_threads();
+}
+
+io_context_t &StripedAlignedFileReader::get_ctx()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    else
+    {
+        return ctx_map[std::this_thread::get_id()];
+    }
+}
+
+void StripedAlignedFileReader::register_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(my_id) != ctx_map.end())
+    {
+        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
+        return;
+    }
+    StripeContext *sctx = new StripeContext();
+    int ret = io_setup(MAX_EVENTS, &sctx->aio_ctx);
+    if (ret != 0)
+    {
+        delete sctx;
+        if (ret == -EAGAIN)
+        {
+            std::cerr << "io_setup() failed with EAGAIN: Consider increasing /proc/sys/fs/aio-max-nr" << std::endl;
+        }
+        else
+        {
+            std::cerr << "io_setup() failed; returned " << ret << ": " << ::strerror(-ret) << std::endl;
+        }
+        return;
+    }
+    ctx_map[my_id] = reinterpret_cast<io_context_t>(sctx);
+}
+
+void StripedAlignedFileReader::deregister_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    auto iter = ctx_map.find(my_id);
+    assert(iter != ctx_map.end());
+    StripeContext *sctx = to_stripe_ctx(iter.value());
+    io_destroy(sctx->aio_ctx);
+    delete sctx;
+    ctx_map.erase(my_id);
+}
+
+void StripedAlignedFileReader::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        StripeContext *sctx = to_stripe_ctx(x.value());
+        io_destroy(sctx->aio_ctx);
+        delete sctx;
+    }
+    ctx_map.clear();
+}
+
+void StripedAlignedFileReader::open(const std::string &fname)
+{
+    // first line: sectors per run, then one stripe path per line
+    std::string manifest = fname + "_stripes.txt";
+    std::ifstream manifest_reader(manifest);
+    uint64_t stripe_sectors = 0;
+    if (!(manifest_reader >> stripe_sectors) || stripe_sectors == 0)
+    {
+        throw diskann::ANNException("Failed to read the stripe list " + manifest, -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
+    _stripe_len = stripe_sectors * diskann::defaults::SECTOR_LEN;
+
+    std::string stripe_file;
+    std::getline(manifest_reader, stripe_file);
+    while (std::getline(manifest_reader, stripe_file))
+    {
+        if (stripe_file.empty())
+            continue;
+        FileHandle fd = ::open(stripe_file.c_str(), O_DIRECT | O_RDONLY | O_LARGEFILE);
+        if (fd == -1)
+        {
+            std::string err = ::strerror(errno);
+            close();
+            throw diskann::ANNException("Failed to open stripe " + stripe_file + ": " + err, -1, __FUNCSIG__,
+                                        __FILE__, __LINE__);
+        }
+        _stripe_fds.push_back(fd);
+        std::cerr << "Opened stripe " << _stripe_fds.size() - 1 << " : " << stripe_file << std::endl;
+    }
+    if (_stripe_fds.empty())
+    {
+        throw diskann::ANNException("No stripes listed in " + manifest, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    diskann::cout << "Disk index " << fname << " is striped over " << _stripe_fds.size() << " files, "
+                  << stripe_sectors << " sector(s) at a time" << std::endl;
+}
+
+void StripedAlignedFileReader::close()
+{
+    for (auto fd : _stripe_fds)
+    {
+        ::close(fd);
+    }
+    _stripe_fds.clear();
+}
+
+void StripedAlignedFileReader::prep_reqs(std::vector<AlignedRead> &read_reqs, std::vector<struct iocb> &cbs,
+                                         tsl::robin_map<void *, uint32_t> *pending)
+{
+    uint64_t n_stripes = _stripe_fds.size();
+    for (auto &req : read_reqs)
+    {
+        uint64_t offset = req.offset;
+        uint64_t remaining = req.len;
+        char *buf = (char *)req.buf;
+        uint32_t n_pieces = 0;
+        while (remaining > 0)
+        {
+            uint64_t run = offset / _stripe_len;
+            uint64_t in_run = offset % _stripe_len;
+            uint64_t len = (std::min)(remaining, _stripe_len - in_run);
+            uint64_t stripe_offset = (run / n_stripes) * _stripe_len + in_run;
+
+            cbs.emplace_back();
+            io_prep_pread(&cbs.back(), _stripe_fds[run % n_stripes], buf, len, stripe_offset);
+            // every piece hands back the buf of the whole request
+            cbs.back().data = req.buf;
+
+            offset += len;
+            buf += len;
+            remaining -= len;
+            n_pieces++;
+        }
+        if (pending != nullptr && n_pieces > 1)
+            (*pending)[req.buf] = n_pieces;
+    }
+}
+
+void StripedAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_context_t &ctx, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    assert(!_stripe_fds.empty());
+    StripeContext *sctx = to_stripe_ctx(ctx);
+
+    std::vector<struct iocb> cb;
+    cb.reserve(read_reqs.size());
+    prep_reqs(read_reqs, cb, nullptr);
+
+    // the pieces are independent reads, so they are issued and reaped in
+    // chunks of MAX_EVENTS regardless of which request they belong to
+    std::vector<struct iocb *> cbs(cb.size());
+    for (uint64_t i = 0; i < cb.size(); i++)
+        cbs[i] = cb.data() + i;
+    std::vector<struct io_event> evts(MAX_EVENTS);
+    for (uint64_t start = 0; start < cb.size(); start += MAX_EVENTS)
+    {
+        uint64_t n_ops = (std::min)((uint64_t)cb.size() - start, (uint64_t)MAX_EVENTS);
+        int64_t ret = io_submit(sctx->aio_ctx, (int64_t)n_ops, cbs.data() + start);
+        if (ret != (int64_t)n_ops)
+        {
+            std::cerr << "io_submit() failed; returned " << ret << ", expected=" << n_ops << ", ernno=" << errno
+                      << "=" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        ret = io_getevents(sctx->aio_ctx, (int64_t)n_ops, (int64_t)n_ops, evts.data(), nullptr);
+        if (ret != (int64_t)n_ops)
+        {
+            std::cerr << "io_getevents() failed; returned " << ret << ", expected=" << n_ops << ", ernno=" << errno
+                      << "=" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        for (int64_t i = 0; i < ret; i++)
+        {
+            if ((int64_t)evts[i].res < 0)
+            {
+                std::cerr << "aio read failed; returned " << (int64_t)evts[i].res << "="
+                          << ::strerror(-(int64_t)evts[i].res) << std::endl;
+                exit(-1);
+            }
+        }
+    }
+}
+
+void StripedAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(!_stripe_fds.empty());
+    if (read_reqs.empty())
+        return;
+    StripeContext *sctx = to_stripe_ctx(ctx);
+
+    std::vector<struct iocb> cb;
+    cb.reserve(read_reqs.size());
+    prep_reqs(read_reqs, cb, &sctx->pending_pieces);
+    std::vector<struct iocb *> cbs(cb.size());
+    for (uint64_t i = 0; i < cb.size(); i++)
+        cbs[i] = cb.data() + i;
+
+    // the kernel copies each iocb at submission, so cb can go out of scope
+    // while the reads are still in flight
+    uint64_t n_ops = cb.size();
+    uint64_t n_submitted = 0;
+    while (n_submitted < n_ops)
+    {
+        int64_t ret = io_submit(sctx->aio_ctx, (int64_t)(n_ops - n_submitted), cbs.data() + n_submitted);
+        if (ret <= 0)
+        {
+            std::cerr << "io_submit() failed; returned " << ret << ", expected=" << n_ops - n_submitted
+                      << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        n_submitted += (uint64_t)ret;
+    }
+}
+
+uint64_t StripedAlignedFileReader::get_completed_reqs(io_context_t &ctx, uint64_t min_completions,
+                                                      std::vector<void *> &completed_bufs)
+{
+    StripeContext *sctx = to_stripe_ctx(ctx);
+    struct io_event evts[MAX_IO_DEPTH];
+    uint64_t n_completed = 0;
+    // a completed piece of a split request only counts once all the pieces
+    // of its request are in, so keep reaping until enough requests are
+    do
+    {
+        int64_t min_evts = n_completed < min_completions ? 1 : 0;
+        int64_t ret = io_getevents(sctx->aio_ctx, min_evts, MAX_IO_DEPTH, evts, nullptr);
+        if (ret < min_evts)
+        {
+            std::cerr << "io_getevents() failed; returned " << ret << ", expected at least " << min_evts
+                      << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        for (int64_t i = 0; i < ret; i++)
+        {
+            if ((int64_t)evts[i].res < 0)
+            {
+                std::cerr << "aio read failed; returned " << (int64_t)evts[i].res << "="
+                          << ::strerror(-(int64_t)evts[i].res) << std::endl;
+                exit(-1);
+            }
+            auto iter = sctx->pending_pieces.find(evts[i].data);
+            if (iter != sctx->pending_pieces.end())
+            {
+                if (--iter.value() > 0)
+                    continue;
+                sctx->pending_pieces.erase(iter);
+            }
+            completed_bufs.push_back(evts[i].data);
+            n_completed++;
+        }
+    } while (n_completed < min_completions);
+    return n_completed;
+}
+
+#endif
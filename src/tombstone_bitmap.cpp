@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <bitset>
+#include <fstream>
+#include <vector>
+
+#include "logger.h"
+#include "tombstone_bitmap.h"
+#include "utils.h"
+
+namespace diskann
+{
+namespace
+{
+const uint64_t TOMBSTONE_FILE_MAGIC = 0x424d54534e4e4144; // "DANNSTMB"
+const uint32_t TOMBSTONE_FILE_VERSION = 1;
+const uint64_t TOMBSTONE_FILE_HEADER_SIZE = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+} // namespace
+
+void TombstoneBitmap::resize(uint64_t num_ids)
+{
+    _num_ids = num_ids;
+    _words.reset(new std::atomic<uint64_t>[num_words()]);
+    clear();
+}
+
+void TombstoneBitmap::clear()
+{
+    for (uint64_t w = 0; w < num_words(); w++)
+        _words[w].store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+}
+
+bool TombstoneBitmap::set(uint64_t id)
+{
+    if (id >= _num_ids)
+        return false;
+    uint64_t bit = (uint64_t)1 << (id & 63);
+    if (_words[id >> 6].fetch_or(bit, std::memory_order_relaxed) & bit)
+        return false;
+    _count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t TombstoneBitmap::memory_bytes() const
+{
+    return num_words() * sizeof(uint64_t);
+}
+
+void TombstoneBitmap::save(const std::string &file, uint64_t index_checksum) const
+{
+    std::vector<uint64_t> words(num_words());
+    for (uint64_t w = 0; w < words.size(); w++)
+        words[w] = _words[w].load(std::memory_order_relaxed);
+    uint64_t num_ids = _num_ids, num_deleted = count();
+    uint32_t flags = 0;
+
+    std::ofstream writer;
+    writer.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    try
+    {
+        writer.open(file, std::ios::binary | std::ios::out | std::ios::trunc);
+        writer.write((const char *)&TOMBSTONE_FILE_MAGIC, sizeof(uint64_t));
+        writer.write((const char *)&TOMBSTONE_FILE_VERSION, sizeof(uint32_t));
+        writer.write((char *)&flags, sizeof(uint32_t));
+        writer.write((char *)&index_checksum, sizeof(uint64_t));
+        writer.write((char *)&num_ids, sizeof(uint64_t));
+        writer.write((char *)&num_deleted, sizeof(uint64_t));
+        writer.write((char *)words.data(), words.size() * sizeof(uint64_t));
+        writer.close();
+    }
+    catch (std::system_error &e)
+    {
+        throw FileException(file, e, __FUNCSIG__, __FILE__, __LINE__);
+    }
+}
+
+bool TombstoneBitmap::load(const std::string &file, uint64_t index_checksum)
+{
+    if (!file_exists(file))
+        return false;
+
+    std::ifstream reader(file, std::ios::binary | std::ios::ate);
+    uint64_t file_size = reader.tellg();
+    reader.seekg(0, reader.beg);
+
+    uint64_t magic = 0, checksum = 0, num_ids = 0, num_deleted = 0;
+    uint32_t version = 0, flags = 0;
+    reader.read((char *)&magic, sizeof(uint64_t));
+    reader.read((char *)&version, sizeof(uint32_t));
+    reader.read((char *)&flags, sizeof(uint32_t));
+    reader.read((char *)&checksum, sizeof(uint64_t));
+    reader.read((char *)&num_ids, sizeof(uint64_t));
+    reader.read((char *)&num_deleted, sizeof(uint64_t));
+
+    std::string reason;
+    if (!reader || magic != TOMBSTONE_FILE_MAGIC)
+        reason = "not a tombstone file";
+    else if (version != TOMBSTONE_FILE_VERSION)
+        reason = "unsupported version " + std::to_string(version);
+    else if (file_size != TOMBSTONE_FILE_HEADER_SIZE + (num_ids + 63) / 64 * sizeof(uint64_t))
+        reason = "truncated";
+    else if (num_ids != _num_ids || checksum != index_checksum)
+        reason = "saved for a different index file";
+    if (!reason.empty())
+    {
+        diskann::cerr << "Ignoring tombstone file " << file << ": " << reason << std::endl;
+        return false;
+    }
+
+    std::vector<uint64_t> words(num_words());
+    reader.read((char *)words.data(), words.size() * sizeof(uint64_t));
+    uint64_t loaded = 0;
+    for (uint64_t w = 0; w < words.size(); w++)
+    {
+        _words[w].store(words[w], std::memory_order_relaxed);
+        loaded += std::bitset<64>(words[w]).count();
+    }
+    _count.store(loaded, std::memory_order_relaxed);
+    if (loaded != num_deleted)
+        diskann::cerr << "Tombstone file " << file << " lists " << num_deleted << " deleted ids but holds " << loaded
+                      << std::endl;
+    return true;
+}
+} // namespace diskann
@@ -5,6 +5,11 @@
 
 #include <stdio.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #ifdef EXEC_ENV_OLS
 #include "aligned_file_reader.h"
 #endif
@@ -252,6 +257,116 @@ double calculate_range_search_recall(uint32_t num_queries, std::vector<std::vect
     return total_recall / (num_queries);
 }
 
+void alloc_aligned_large(void **ptr, size_t size, size_t align, bool huge_pages)
+{
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    if (huge_pages)
+        align = (std::max)(align, HUGE_PAGE_SIZE);
+    alloc_aligned(ptr, ROUND_UP(size, align), align);
+#ifdef __linux__
+    if (huge_pages && madvise(*ptr, ROUND_UP(size, align), MADV_HUGEPAGE) != 0)
+    {
+        diskann::cerr << "madvise(MADV_HUGEPAGE) failed: " << ::strerror(errno)
+                      << ". Continuing with regular pages." << std::endl;
+    }
+#endif
+}
+
+template <typename T>
+void load_bin_parallel(const std::string &bin_file, T *&data, size_t &npts, size_t &dim, uint32_t num_threads,
+                       bool huge_pages)
+{
+    const size_t header_size = 2 * sizeof(uint32_t);
+    get_bin_metadata(bin_file, npts, dim);
+    diskann::cout << "Reading bin file " << bin_file << " in parallel. #pts = " << npts << ", #dims = " << dim
+                  << "..." << std::endl;
+
+    size_t data_size = npts * dim * sizeof(T);
+    alloc_aligned_large((void **)&data, (std::max)(data_size, (size_t)1), 64, huge_pages);
+    if (data_size == 0)
+        return;
+
+#ifdef _WINDOWS
+    std::ifstream reader(bin_file, std::ios::binary);
+    reader.seekg(header_size, reader.beg);
+    reader.read((char *)data, data_size);
+    if (!reader)
+    {
+        aligned_free(data);
+        data = nullptr;
+        throw ANNException("Failed to read " + bin_file, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+#else
+    // O_DIRECT needs aligned offsets, lengths and buffers, so each chunk is
+    // read whole into an aligned bounce buffer and the payload copied out.
+    // Some file systems (tmpfs) refuse O_DIRECT; fall back to the page cache.
+    const size_t ALIGNMENT = 4096;
+    const size_t CHUNK_SIZE = 8 * 1024 * 1024;
+    int fd = ::open(bin_file.c_str(), O_RDONLY | O_DIRECT);
+    if (fd == -1)
+        fd = ::open(bin_file.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        aligned_free(data);
+        data = nullptr;
+        throw ANNException("Failed to open " + bin_file + ": " + ::strerror(errno), -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+
+    size_t file_size = header_size + data_size;
+    int64_t num_chunks = (int64_t)DIV_ROUND_UP(file_size, CHUNK_SIZE);
+    bool failed = false;
+#pragma omp parallel num_threads((std::max)(num_threads, 1u))
+    {
+        char *chunk_buf = nullptr;
+        alloc_aligned((void **)&chunk_buf, CHUNK_SIZE, ALIGNMENT);
+#pragma omp for schedule(dynamic, 1)
+        for (int64_t c = 0; c < num_chunks; c++)
+        {
+            size_t start = (size_t)c * CHUNK_SIZE;
+            size_t len = (std::min)(CHUNK_SIZE, file_size - start);
+            size_t aligned_len = ROUND_UP(len, ALIGNMENT);
+            // a short read at the end of the file is expected when
+            // aligned_len runs past it
+            size_t got = 0;
+            while (got < len)
+            {
+                ssize_t ret = ::pread(fd, chunk_buf + got, aligned_len - got, start + got);
+                if (ret <= 0)
+                    break;
+                got += (size_t)ret;
+            }
+            if (got < len)
+            {
+#pragma omp atomic write
+                failed = true;
+                continue;
+            }
+            size_t skip = start < header_size ? header_size - start : 0;
+            memcpy((char *)data + start + skip - header_size, chunk_buf + skip, len - skip);
+        }
+        aligned_free(chunk_buf);
+    }
+    ::close(fd);
+
+    if (failed)
+    {
+        aligned_free(data);
+        data = nullptr;
+        throw ANNException("Failed to read " + bin_file, -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+#endif
+    diskann::cout << "done." << std::endl;
+}
+
+template DISKANN_DLLEXPORT void load_bin_parallel<uint8_t>(const std::string &bin_file, uint8_t *&data, size_t &npts,
+                                                           size_t &dim, uint32_t num_threads, bool huge_pages);
+template DISKANN_DLLEXPORT void load_bin_parallel<uint32_t>(const std::string &bin_file, uint32_t *&data,
+                                                            size_t &npts, size_t &dim, uint32_t num_threads,
+                                                            bool huge_pages);
+template DISKANN_DLLEXPORT void load_bin_parallel<float>(const std::string &bin_file, float *&data, size_t &npts,
+                                                         size_t &dim, uint32_t num_threads, bool huge_pages);
+
 #ifdef EXEC_ENV_OLS
 void get_bin_metadata(AlignedFileReader &reader, size_t &npts, size_t &ndim, size_t offset)
 {
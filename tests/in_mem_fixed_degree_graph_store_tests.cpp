@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ann_exception.h"
+#include "in_mem_fixed_degree_graph_store.h"
+#include "in_mem_graph_store.h"
+
+namespace
+{
+const uint32_t NUM_POINTS = 100, MAX_DEGREE = 8, START = 7;
+const size_t NUM_FROZEN_POINTS = 1;
+
+// node i has i % MAX_DEGREE + 1 neighbours, so that some rows are full
+std::vector<uint32_t> make_neighbours(uint32_t i)
+{
+    std::vector<uint32_t> neighbours;
+    for (uint32_t j = 0; j <= i % MAX_DEGREE; j++)
+        neighbours.push_back((i * 31 + j * 17) % NUM_POINTS);
+    return neighbours;
+}
+
+void fill(diskann::AbstractGraphStore &graph_store)
+{
+    for (uint32_t i = 0; i < NUM_POINTS; i++)
+    {
+        auto neighbours = make_neighbours(i);
+        graph_store.set_neighbours(i, neighbours);
+    }
+}
+
+bool holds_graph(diskann::AbstractGraphStore &graph_store)
+{
+    bool ok = graph_store.get_max_observed_degree() == MAX_DEGREE;
+    for (uint32_t i = 0; i < NUM_POINTS; i++)
+    {
+        auto nbrs = graph_store.get_neighbours(i);
+        ok = ok && std::vector<uint32_t>(nbrs.begin(), nbrs.end()) == make_neighbours(i);
+    }
+    return ok;
+}
+
+// stores graph_store and loads the file into loaded
+void store_and_load(diskann::AbstractGraphStore &graph_store, diskann::AbstractGraphStore &loaded,
+                    const std::string &file_name)
+{
+    graph_store.store(file_name, NUM_POINTS, NUM_FROZEN_POINTS, START);
+    auto result = loaded.load(file_name, NUM_POINTS);
+    std::remove(file_name.c_str());
+    BOOST_TEST(std::get<0>(result) == NUM_POINTS);
+    BOOST_TEST(std::get<1>(result) == START);
+    BOOST_TEST(std::get<2>(result) == NUM_FROZEN_POINTS);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(InMemFixedDegreeGraphStore_tests)
+
+BOOST_AUTO_TEST_CASE(test_neighbours)
+{
+    diskann::InMemFixedDegreeGraphStore graph_store(NUM_POINTS, MAX_DEGREE);
+    fill(graph_store);
+    BOOST_TEST(holds_graph(graph_store));
+
+    graph_store.clear_neighbours(MAX_DEGREE);
+    BOOST_TEST(graph_store.get_neighbours(MAX_DEGREE).empty());
+    graph_store.add_neighbour(MAX_DEGREE, 42);
+    BOOST_TEST(graph_store.get_neighbours(MAX_DEGREE).size() == 1u);
+    BOOST_TEST(graph_store.get_neighbours(MAX_DEGREE)[0] == 42u);
+
+    // swapping a short row with a full one moves every slot of both
+    graph_store.swap_neighbours(1, 2 * MAX_DEGREE - 1);
+    std::vector<uint32_t> copied;
+    graph_store.copy_neighbours(1, copied);
+    BOOST_TEST(copied == make_neighbours(2 * MAX_DEGREE - 1));
+    graph_store.copy_neighbours(2 * MAX_DEGREE - 1, copied);
+    BOOST_TEST(copied == make_neighbours(1));
+
+    // growing keeps the rows below the old size and leaves the new ones empty
+    graph_store.resize_graph(2 * NUM_POINTS);
+    BOOST_TEST(graph_store.get_total_points() == 2u * NUM_POINTS);
+    graph_store.copy_neighbours(1, copied);
+    BOOST_TEST(copied == make_neighbours(2 * MAX_DEGREE - 1));
+    BOOST_TEST(graph_store.get_neighbours(NUM_POINTS + 1).empty());
+}
+
+// rows are padded so that each starts on a cache line, whatever the degree,
+// and the padding does not raise the degree a row takes
+BOOST_AUTO_TEST_CASE(test_row_alignment)
+{
+    for (uint32_t degree : {1u, 15u, 16u, 64u, 87u})
+    {
+        diskann::InMemFixedDegreeGraphStore graph_store(10, degree);
+        std::vector<uint32_t> widest(degree + 3, 5);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            bool aligned = true;
+            for (uint32_t i = 0; i < 10; i++)
+                aligned = aligned && (uintptr_t)(graph_store.get_neighbours(i).data() - 1) % 64 == 0;
+            BOOST_TEST(aligned);
+            BOOST_CHECK_THROW(graph_store.set_neighbours(0, widest), diskann::ANNException);
+            graph_store.resize_graph(20);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_overflow)
+{
+    diskann::InMemFixedDegreeGraphStore graph_store(2, MAX_DEGREE);
+    for (uint32_t j = 0; j < MAX_DEGREE; j++)
+        graph_store.add_neighbour(0, j);
+    BOOST_CHECK_THROW(graph_store.add_neighbour(0, MAX_DEGREE), diskann::ANNException);
+    BOOST_TEST(graph_store.get_neighbours(0).size() == MAX_DEGREE);
+
+    std::vector<uint32_t> too_many(MAX_DEGREE + 1, 1);
+    BOOST_CHECK_THROW(graph_store.set_neighbours(1, too_many), diskann::ANNException);
+    BOOST_TEST(graph_store.get_neighbours(1).empty());
+    too_many.pop_back();
+    graph_store.set_neighbours(1, too_many);
+    BOOST_TEST(graph_store.get_neighbours(1).size() == MAX_DEGREE);
+}
+
+// both stores write the same file layout, so each loads what the other stored
+BOOST_AUTO_TEST_CASE(test_file_compatibility)
+{
+    diskann::InMemGraphStore vector_store(NUM_POINTS, MAX_DEGREE);
+    fill(vector_store);
+    diskann::InMemFixedDegreeGraphStore fixed_loaded(NUM_POINTS, MAX_DEGREE);
+    store_and_load(vector_store, fixed_loaded, "in_mem_fixed_degree_graph_store_tests_from_vector.bin");
+    BOOST_TEST(holds_graph(fixed_loaded));
+    BOOST_TEST(fixed_loaded.get_max_range_of_graph() == MAX_DEGREE);
+
+    diskann::InMemFixedDegreeGraphStore fixed_store(NUM_POINTS, MAX_DEGREE);
+    fill(fixed_store);
+    diskann::InMemGraphStore vector_loaded(NUM_POINTS, MAX_DEGREE);
+    store_and_load(fixed_store, vector_loaded, "in_mem_fixed_degree_graph_store_tests_from_fixed.bin");
+    BOOST_TEST(holds_graph(vector_loaded));
+}
+
+// loading a graph of a higher degree than the store reserved widens its rows,
+// and loading more points than it holds adds rows
+BOOST_AUTO_TEST_CASE(test_load_grows_rows)
+{
+    diskann::InMemGraphStore vector_store(NUM_POINTS, MAX_DEGREE);
+    fill(vector_store);
+    diskann::InMemFixedDegreeGraphStore fixed_loaded(NUM_POINTS / 2, MAX_DEGREE / 2);
+    store_and_load(vector_store, fixed_loaded, "in_mem_fixed_degree_graph_store_tests_grow.bin");
+    BOOST_TEST(fixed_loaded.get_total_points() == NUM_POINTS);
+    BOOST_TEST(holds_graph(fixed_loaded));
+
+    // the widened rows take as many neighbours as the loaded graph has
+    std::vector<uint32_t> full(MAX_DEGREE, 3);
+    fixed_loaded.set_neighbours(0, full);
+    BOOST_TEST(fixed_loaded.get_neighbours(0).size() == MAX_DEGREE);
+    BOOST_CHECK_THROW(fixed_loaded.add_neighbour(0, 4), diskann::ANNException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
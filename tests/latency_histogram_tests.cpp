@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "latency_histogram.h"
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogram_tests)
+
+BOOST_AUTO_TEST_CASE(test_empty)
+{
+    diskann::LatencyHistogram histogram;
+    BOOST_TEST(histogram.count() == 0u);
+    BOOST_TEST(histogram.max() == 0u);
+    BOOST_TEST(histogram.mean() == 0.0);
+    BOOST_TEST(histogram.count_at_or_below(1000) == 0u);
+    BOOST_TEST(histogram.value_at_percentile(50) == 0u);
+}
+
+// values below 128 get a bucket each
+BOOST_AUTO_TEST_CASE(test_exact_values)
+{
+    diskann::LatencyHistogram histogram;
+    for (uint64_t v = 0; v < 128; v++)
+        histogram.record(v);
+
+    for (uint64_t v = 0; v < 128; v++)
+        BOOST_TEST(histogram.count_at_or_below(v) == v + 1);
+    BOOST_TEST(histogram.value_at_percentile(0) == 0u);
+    BOOST_TEST(histogram.value_at_percentile(50) == 63u);
+    BOOST_TEST(histogram.value_at_percentile(99) == 126u);
+    BOOST_TEST(histogram.value_at_percentile(100) == 127u);
+    BOOST_TEST(histogram.value_at_percentile(150) == 127u);
+    BOOST_TEST(histogram.value_at_percentile(-1) == 0u);
+
+    BOOST_TEST(histogram.count() == 128u);
+    BOOST_TEST(histogram.sum() == 127u * 128 / 2);
+    BOOST_TEST(histogram.mean() == 63.5);
+    BOOST_TEST(histogram.max() == 127u);
+}
+
+// from 128 on, each power of two is split into 64 buckets
+BOOST_AUTO_TEST_CASE(test_bucket_boundaries)
+{
+    diskann::LatencyHistogram histogram;
+    histogram.record(128);
+    BOOST_TEST(histogram.count_at_or_below(127) == 0u);
+    BOOST_TEST(histogram.count_at_or_below(128) == 1u);
+    // 128 and 129 share a bucket
+    BOOST_TEST(histogram.count_at_or_below(129) == 1u);
+    histogram.record(129);
+    BOOST_TEST(histogram.count_at_or_below(128) == 2u);
+    BOOST_TEST(histogram.count_at_or_below(130) == 2u);
+
+    histogram.record(255);
+    histogram.record(256);
+    BOOST_TEST(histogram.count_at_or_below(254) == 3u);
+    BOOST_TEST(histogram.count_at_or_below(255) == 3u);
+    BOOST_TEST(histogram.count_at_or_below(256) == 4u);
+    // 256 to 259 share a bucket
+    BOOST_TEST(histogram.count_at_or_below(259) == 4u);
+
+    // percentiles round up to the end of the bucket, but not past the max
+    BOOST_TEST(histogram.value_at_percentile(25) == 129u);
+    BOOST_TEST(histogram.value_at_percentile(75) == 255u);
+    BOOST_TEST(histogram.value_at_percentile(100) == 256u);
+
+    histogram.record(1000000);
+    histogram.record(2000000);
+    // 1000000 lands in [999424, 1007615]
+    BOOST_TEST(histogram.count_at_or_below(999423) == 4u);
+    BOOST_TEST(histogram.count_at_or_below(999424) == 5u);
+    BOOST_TEST(histogram.count_at_or_below(1007615) == 5u);
+    BOOST_TEST(histogram.count_at_or_below(1007616) == 5u);
+    BOOST_TEST(histogram.value_at_percentile(80) == 1007615u);
+    BOOST_TEST(histogram.value_at_percentile(100) == 2000000u);
+}
+
+BOOST_AUTO_TEST_CASE(test_largest_value)
+{
+    const uint64_t largest = (std::numeric_limits<uint64_t>::max)();
+    diskann::LatencyHistogram histogram;
+    histogram.record(largest);
+    BOOST_TEST(histogram.count_at_or_below(largest) == 1u);
+    BOOST_TEST(histogram.count_at_or_below(largest / 2) == 0u);
+    BOOST_TEST(histogram.value_at_percentile(50) == largest);
+    BOOST_TEST(histogram.max() == largest);
+}
+
+// percentiles read from the buckets are at most 1/64 above the exact ones
+BOOST_AUTO_TEST_CASE(test_percentiles)
+{
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(7, 2);
+    std::vector<uint64_t> values(100000);
+    diskann::LatencyHistogram histogram;
+    for (auto &value : values)
+    {
+        value = (uint64_t)dist(rng);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (double percentile : {0.0, 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 100.0})
+    {
+        uint64_t rank = (std::max)((uint64_t)1, (uint64_t)std::ceil(percentile / 100 * values.size()));
+        uint64_t exact = values[rank - 1];
+        uint64_t estimate = histogram.value_at_percentile(percentile);
+        BOOST_TEST(estimate >= exact);
+        BOOST_TEST(estimate <= exact + exact / 64);
+    }
+    BOOST_TEST(histogram.value_at_percentile(100) == values.back());
+    BOOST_TEST(histogram.max() == values.back());
+}
+
+BOOST_AUTO_TEST_CASE(test_reset)
+{
+    diskann::LatencyHistogram histogram;
+    histogram.record(10);
+    histogram.record(5000);
+    BOOST_TEST(histogram.count() == 2u);
+    BOOST_TEST(histogram.sum() == 5010u);
+    BOOST_TEST(histogram.mean() == 2505.0);
+
+    histogram.reset();
+    BOOST_TEST(histogram.count() == 0u);
+    BOOST_TEST(histogram.sum() == 0u);
+    BOOST_TEST(histogram.max() == 0u);
+    BOOST_TEST(histogram.count_at_or_below(10000) == 0u);
+    BOOST_TEST(histogram.value_at_percentile(100) == 0u);
+
+    histogram.record(3);
+    BOOST_TEST(histogram.value_at_percentile(100) == 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "nhood_codec.h"
+
+namespace
+{
+// packs nbrs into a buffer of exactly the packed size, checks its header and
+// returns the decoded ids
+std::vector<uint32_t> round_trip(std::vector<uint32_t> nbrs, uint32_t expected_width)
+{
+    std::vector<uint32_t> copy(nbrs);
+    uint64_t size = diskann::packed_nhood_size(copy.data(), (uint32_t)copy.size());
+    BOOST_TEST(size % sizeof(uint32_t) == 0u);
+
+    std::vector<char> packed(size);
+    BOOST_TEST(diskann::pack_nhood(nbrs.data(), (uint32_t)nbrs.size(), packed.data()) == size);
+    BOOST_TEST((uint32_t)(uint8_t)packed[2] == expected_width);
+
+    // room for the 8 ids the AVX2 decoder may write past the last gap
+    std::vector<uint32_t> decoded(nbrs.size() + 8);
+    uint32_t nnbrs = diskann::unpack_nhood(packed.data(), decoded.data());
+    decoded.resize(nnbrs);
+    return decoded;
+}
+
+// sorted ids whose largest gap takes exactly width bits, starting at first
+std::vector<uint32_t> make_nhood(uint32_t nnbrs, uint32_t width, uint32_t first, std::mt19937 &rng)
+{
+    std::vector<uint32_t> nbrs(nnbrs, first);
+    uint64_t max_gap = width == 0 ? 0 : (width == 32 ? 0xFFFFFFFFull : (1ull << width) - 1);
+    std::uniform_int_distribution<uint64_t> gap_dist(0, max_gap);
+    for (uint32_t i = 1; i < nnbrs; i++)
+    {
+        uint64_t gap = i == nnbrs / 2 || width == 0 ? max_gap : gap_dist(rng);
+        nbrs[i] = (uint32_t)(nbrs[i - 1] + gap);
+    }
+    std::shuffle(nbrs.begin(), nbrs.end(), rng);
+    return nbrs;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(NhoodCodec_tests)
+
+BOOST_AUTO_TEST_CASE(test_empty)
+{
+    BOOST_TEST(round_trip({}, 0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_single)
+{
+    auto decoded = round_trip({0xFFFFFFFFu}, 0);
+    BOOST_TEST(decoded.size() == 1u);
+    BOOST_TEST(decoded[0] == 0xFFFFFFFFu);
+}
+
+BOOST_AUTO_TEST_CASE(test_width_0)
+{
+    // only repeated ids have no gaps; lists of 9 or more go through the AVX2
+    // decoder where it is built
+    for (uint32_t nnbrs : {2u, 8u, 9u, 33u})
+    {
+        std::vector<uint32_t> nbrs(nnbrs, 12345);
+        BOOST_TEST(round_trip(nbrs, 0) == nbrs);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_width_32)
+{
+    std::vector<uint32_t> nbrs = {0xFFFFFFFFu, 0, 0x80000000u};
+    std::vector<uint32_t> sorted = {0, 0x80000000u, 0xFFFFFFFFu};
+    BOOST_TEST(round_trip(nbrs, 32) == sorted);
+
+    std::vector<uint32_t> two = {0, 0xFFFFFFFFu};
+    BOOST_TEST(round_trip(two, 32) == two);
+}
+
+// every width, with list lengths on both sides of the 8 gaps the AVX2
+// decoder takes at a time, which it only does for widths of up to 25
+BOOST_AUTO_TEST_CASE(test_all_widths)
+{
+    std::mt19937 rng(42);
+    for (uint32_t width = 1; width <= 32; width++)
+    {
+        // the ids must fit in 32 bits
+        uint64_t max_nnbrs = width >= 23 ? (1ull << (32 - width)) : 512;
+        for (uint32_t nnbrs : {2u, 8u, 9u, 16u, 17u, 64u, 512u})
+        {
+            if (nnbrs - 1 > max_nnbrs)
+                continue;
+            uint32_t first = width >= 23 ? 0 : (uint32_t)(rng() % 1000);
+            auto nbrs = make_nhood(nnbrs, width, first, rng);
+            auto decoded = round_trip(nbrs, width);
+            std::sort(nbrs.begin(), nbrs.end());
+            BOOST_TEST(decoded == nbrs);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "pq.h"
+
+namespace
+{
+const uint64_t NUM_POINTS = 200;
+
+// scores n_ids random points of random 4-bit codes with the fast-scan kernel
+// and checks them against scalar sums of the quantized table, which the
+// kernel must match up to float rounding, and against the float table, which
+// the quantized one approximates to half a step per chunk
+void check_lookup(const uint64_t pq_nchunks, const uint64_t n_ids, std::mt19937 &rng)
+{
+    const uint64_t code_len = DIV_ROUND_UP(pq_nchunks, 2);
+    const uint64_t nchunks_even = ROUND_UP(pq_nchunks, 2);
+
+    std::uniform_int_distribution<uint32_t> byte_dist(0, 255);
+    std::vector<uint8_t> all_coords(NUM_POINTS * code_len);
+    for (auto &byte : all_coords)
+        byte = (uint8_t)byte_dist(rng);
+    std::uniform_int_distribution<uint32_t> id_dist(0, NUM_POINTS - 1);
+    std::vector<uint32_t> ids(n_ids);
+    for (auto &id : ids)
+        id = id_dist(rng);
+
+    std::uniform_real_distribution<float> dist_dist(0, 100);
+    std::vector<float> pq_dists(NUM_PQ_CENTROIDS_4BIT * pq_nchunks);
+    for (auto &d : pq_dists)
+        d = dist_dist(rng);
+
+    std::vector<uint8_t> lut(NUM_PQ_CENTROIDS_4BIT * nchunks_even);
+    float scale = 0, bias = 0;
+    diskann::quantize_fast_scan_lut(pq_dists.data(), pq_nchunks, lut.data(), scale, bias);
+
+    std::vector<uint8_t> block_codes(ROUND_UP(n_ids, PQ_FAST_SCAN_BLOCK) * nchunks_even / 2);
+    diskann::aggregate_coords_fast_scan(ids.data(), n_ids, all_coords.data(), pq_nchunks, block_codes.data());
+    // one more to catch writes past the last point
+    std::vector<float> dists(n_ids + 1, -1.0f);
+    diskann::pq_fast_scan_lookup(block_codes.data(), n_ids, pq_nchunks, lut.data(), scale, bias, dists.data());
+
+    for (uint64_t i = 0; i < n_ids; i++)
+    {
+        uint32_t quantized = 0;
+        float exact = 0;
+        for (uint64_t chunk = 0; chunk < pq_nchunks; chunk++)
+        {
+            uint8_t byte = all_coords[ids[i] * code_len + chunk / 2];
+            uint8_t code = chunk % 2 == 0 ? byte & 0x0f : byte >> 4;
+            quantized += lut[chunk * NUM_PQ_CENTROIDS_4BIT + code];
+            exact += pq_dists[chunk * NUM_PQ_CENTROIDS_4BIT + code];
+        }
+        float expected = bias + quantized * (1.0f / scale);
+        BOOST_TEST(std::fabs(dists[i] - expected) <= 1e-3f * (1.0f + std::fabs(expected)));
+        BOOST_TEST(std::fabs(dists[i] - exact) <= (0.5f * pq_nchunks + 1) / scale);
+    }
+    BOOST_TEST(dists[n_ids] == -1.0f);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PQFastScan_tests)
+
+// odd chunk counts read the padding chunk, and partial blocks leave the
+// unused lanes out of the results; 8 and more chunks take the AVX-512 loop
+// where it is built
+BOOST_AUTO_TEST_CASE(test_lookup)
+{
+    std::mt19937 rng(42);
+    for (uint64_t pq_nchunks : {1u, 2u, 7u, 8u, 13u, 32u})
+    {
+        for (uint64_t n_ids : {1u, 31u, 32u, 75u})
+            check_lookup(pq_nchunks, n_ids, rng);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
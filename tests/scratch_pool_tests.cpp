@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "scratch_pool.h"
+
+BOOST_AUTO_TEST_SUITE(ScratchPool_tests)
+
+BOOST_AUTO_TEST_CASE(test_push_pop)
+{
+    diskann::ScratchPool<int *> pool(nullptr, 4);
+    BOOST_TEST(pool.empty());
+    BOOST_TEST(pool.pop() == nullptr);
+
+    int a = 0, b = 0;
+    int *pa = &a, *pb = &b;
+    pool.push(pa);
+    BOOST_TEST(pool.size() == 1u);
+    // a thread takes back the item it pushed last, from its own slot
+    BOOST_TEST(pool.pop() == pa);
+    BOOST_TEST(pool.empty());
+
+    pool.push(pa);
+    pool.push(pb);
+    BOOST_TEST(pool.size() == 2u);
+    std::set<int *> popped = {pool.pop(), pool.pop()};
+    BOOST_TEST((popped == std::set<int *>{pa, pb}));
+    BOOST_TEST(pool.pop() == nullptr);
+    BOOST_TEST(pool.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_overflow)
+{
+    const uint64_t num_slots = 4, num_items = 11;
+    diskann::ScratchPool<int *> pool(nullptr, num_slots);
+
+    std::vector<int> items(num_items);
+    std::vector<int *> ptrs;
+    for (auto &item : items)
+        ptrs.push_back(&item);
+    pool.insert(ptrs.begin(), ptrs.end());
+    BOOST_TEST(pool.size() == num_items);
+
+    // items beyond the slots come back from the overflow list
+    std::set<int *> popped;
+    for (uint64_t i = 0; i < num_items; i++)
+    {
+        int *item = pool.pop();
+        BOOST_TEST(item != nullptr);
+        popped.insert(item);
+    }
+    BOOST_TEST(popped.size() == num_items);
+    BOOST_TEST(pool.pop() == nullptr);
+    BOOST_TEST(pool.empty());
+}
+
+// threads take an item, check that no other thread holds it, and return it,
+// with fewer items than threads so that they contend and wait
+BOOST_AUTO_TEST_CASE(test_concurrent)
+{
+    const uint32_t num_threads = 8, num_items = 3, num_rounds = 20000;
+    diskann::ScratchPool<std::atomic<int> *> pool(nullptr, 2);
+    std::vector<std::atomic<int>> holders(num_items);
+    for (auto &holder : holders)
+    {
+        holder = 0;
+        std::atomic<int> *item = &holder;
+        pool.push(item);
+    }
+
+    std::atomic<uint64_t> num_shared{0};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&]() {
+            for (uint32_t r = 0; r < num_rounds; r++)
+            {
+                std::atomic<int> *item = pool.pop();
+                while (item == nullptr)
+                {
+                    pool.wait_for_push_notify();
+                    item = pool.pop();
+                }
+                if (item->fetch_add(1) != 0)
+                    num_shared++;
+                item->fetch_sub(1);
+                pool.push(item);
+                pool.push_notify_all();
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_TEST(num_shared.load() == 0u);
+    BOOST_TEST(pool.size() == num_items);
+    std::set<std::atomic<int> *> popped;
+    for (uint32_t i = 0; i < num_items; i++)
+        popped.insert(pool.pop());
+    BOOST_TEST(popped.size() == num_items);
+    BOOST_TEST(popped.count(nullptr) == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
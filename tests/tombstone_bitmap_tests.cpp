@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "tombstone_bitmap.h"
+
+namespace
+{
+const uint64_t NUM_IDS = 1000;
+const uint64_t CHECKSUM = 0x0123456789abcdef;
+
+// a bitmap of NUM_IDS ids with every id divisible by 7 deleted
+void make_bitmap(diskann::TombstoneBitmap &bitmap)
+{
+    bitmap.resize(NUM_IDS);
+    for (uint64_t id = 0; id < NUM_IDS; id += 7)
+        bitmap.set(id);
+}
+
+bool holds_bitmap(const diskann::TombstoneBitmap &bitmap)
+{
+    bool ok = bitmap.size() == NUM_IDS && bitmap.count() == (NUM_IDS + 6) / 7;
+    for (uint64_t id = 0; id < NUM_IDS; id++)
+        ok = ok && bitmap.test(id) == (id % 7 == 0);
+    return ok;
+}
+
+// removes the file when the test case ends
+struct TempFile
+{
+    std::string name;
+    explicit TempFile(const std::string &name) : name(name)
+    {
+    }
+    ~TempFile()
+    {
+        std::remove(name.c_str());
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TombstoneBitmap_tests)
+
+BOOST_AUTO_TEST_CASE(test_set)
+{
+    diskann::TombstoneBitmap bitmap;
+    bitmap.resize(130);
+    BOOST_TEST(bitmap.count() == 0u);
+    BOOST_TEST(bitmap.memory_bytes() == 3 * sizeof(uint64_t));
+
+    BOOST_TEST(bitmap.set(0));
+    BOOST_TEST(bitmap.set(63));
+    BOOST_TEST(bitmap.set(64));
+    BOOST_TEST(bitmap.set(129));
+    BOOST_TEST(!bitmap.set(64));
+    BOOST_TEST(!bitmap.set(130));
+    BOOST_TEST(bitmap.count() == 4u);
+    BOOST_TEST(bitmap.test(63));
+    BOOST_TEST(!bitmap.test(62));
+    BOOST_TEST(!bitmap.test(65));
+
+    bitmap.clear();
+    BOOST_TEST(bitmap.count() == 0u);
+    BOOST_TEST(!bitmap.test(129));
+}
+
+BOOST_AUTO_TEST_CASE(test_save_load)
+{
+    TempFile file("tombstone_bitmap_tests_save_load.bin");
+    diskann::TombstoneBitmap saved;
+    make_bitmap(saved);
+    saved.save(file.name, CHECKSUM);
+
+    diskann::TombstoneBitmap loaded;
+    loaded.resize(NUM_IDS);
+    loaded.set(1);
+    BOOST_TEST(loaded.load(file.name, CHECKSUM));
+    BOOST_TEST(holds_bitmap(loaded));
+}
+
+// a file saved for another index, or damaged, leaves the bitmap unchanged
+BOOST_AUTO_TEST_CASE(test_reject)
+{
+    TempFile file("tombstone_bitmap_tests_reject.bin");
+    {
+        diskann::TombstoneBitmap saved;
+        saved.resize(NUM_IDS);
+        saved.set(1);
+        saved.save(file.name, CHECKSUM);
+    }
+
+    diskann::TombstoneBitmap bitmap;
+    make_bitmap(bitmap);
+    BOOST_TEST(!bitmap.load(file.name, CHECKSUM + 1));
+    BOOST_TEST(holds_bitmap(bitmap));
+    BOOST_TEST(!bitmap.load("tombstone_bitmap_tests_missing.bin", CHECKSUM));
+    BOOST_TEST(holds_bitmap(bitmap));
+
+    diskann::TombstoneBitmap other_size;
+    other_size.resize(NUM_IDS + 64);
+    BOOST_TEST(!other_size.load(file.name, CHECKSUM));
+    BOOST_TEST(other_size.count() == 0u);
+
+    // drop the last word
+    {
+        std::ifstream reader(file.name, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(reader)), std::istreambuf_iterator<char>());
+        reader.close();
+        std::ofstream writer(file.name, std::ios::binary | std::ios::trunc);
+        writer.write(contents.data(), contents.size() - sizeof(uint64_t));
+    }
+    BOOST_TEST(!bitmap.load(file.name, CHECKSUM));
+    BOOST_TEST(holds_bitmap(bitmap));
+
+    {
+        std::ofstream writer(file.name, std::ios::binary | std::ios::trunc);
+        writer << "not a tombstone file, but long enough to hold its header";
+    }
+    BOOST_TEST(!bitmap.load(file.name, CHECKSUM));
+    BOOST_TEST(holds_bitmap(bitmap));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
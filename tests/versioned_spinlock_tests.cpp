@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "locking.h"
+#include "in_mem_fixed_degree_graph_store.h"
+
+BOOST_AUTO_TEST_SUITE(VersionedSpinlock_tests)
+
+BOOST_AUTO_TEST_CASE(test_version)
+{
+    diskann::versioned_spinlock lock;
+
+    uint32_t version = lock.read_begin();
+    BOOST_TEST(version % 2 == 0u);
+    BOOST_TEST(!lock.read_retry(version));
+
+    BOOST_TEST(lock.try_lock());
+    BOOST_TEST(!lock.try_lock());
+    lock.unlock();
+    BOOST_TEST(lock.read_retry(version));
+    BOOST_TEST(lock.read_begin() == version + 2);
+
+    {
+        diskann::VersionedLockGuard guard(lock);
+        BOOST_TEST(!lock.try_lock());
+    }
+    BOOST_TEST(lock.read_begin() == version + 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_mutual_exclusion)
+{
+    const uint32_t num_threads = 4, num_increments = 100000;
+    diskann::versioned_spinlock lock;
+    uint64_t counter = 0;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < num_increments; i++)
+            {
+                diskann::VersionedLockGuard guard(lock);
+                counter++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_TEST(counter == (uint64_t)num_threads * num_increments);
+}
+
+// Writers rewrite the neighbours of one node under its lock while readers
+// copy them without locking, as Index::copy_neighbours does for a graph
+// store with lock free reads. Every copy that passes the version check must
+// be one that a writer stored: the degree is v % max_degree + 1 and every
+// neighbour is v.
+BOOST_AUTO_TEST_CASE(test_lock_free_reads)
+{
+    const uint32_t max_degree = 32, num_writers = 2, num_readers = 4, num_writes = 20000;
+    diskann::InMemFixedDegreeGraphStore graph_store(1, max_degree);
+    BOOST_TEST(graph_store.supports_lock_free_reads());
+    diskann::versioned_spinlock lock;
+    {
+        std::vector<uint32_t> neighbours(1, 0);
+        graph_store.set_neighbours(0, neighbours);
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> num_consistent{0}, num_torn{0};
+
+    std::vector<std::thread> writers, readers;
+    for (uint32_t w = 0; w < num_writers; w++)
+    {
+        writers.emplace_back([&, w]() {
+            std::vector<uint32_t> neighbours;
+            for (uint32_t i = 0; i < num_writes; i++)
+            {
+                uint32_t v = i * num_writers + w;
+                neighbours.assign(v % max_degree + 1, v);
+                diskann::VersionedLockGuard guard(lock);
+                graph_store.set_neighbours(0, neighbours);
+            }
+        });
+    }
+    for (uint32_t r = 0; r < num_readers; r++)
+    {
+        readers.emplace_back([&]() {
+            std::vector<uint32_t> neighbours;
+            while (!done.load())
+            {
+                uint32_t version;
+                do
+                {
+                    version = lock.read_begin();
+                    graph_store.copy_neighbours(0, neighbours);
+                } while (lock.read_retry(version));
+
+                bool consistent = !neighbours.empty() && neighbours.size() == neighbours[0] % max_degree + 1;
+                for (auto id : neighbours)
+                    consistent = consistent && id == neighbours[0];
+                (consistent ? num_consistent : num_torn)++;
+            }
+        });
+    }
+
+    for (auto &writer : writers)
+        writer.join();
+    done = true;
+    for (auto &reader : readers)
+        reader.join();
+
+    BOOST_TEST(num_torn.load() == 0u);
+    BOOST_TEST(num_consistent.load() > 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
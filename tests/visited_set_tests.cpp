@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include "visited_set.h"
+
+using diskann::VisitedSet;
+using diskann::VisitedSetPolicy;
+
+BOOST_AUTO_TEST_SUITE(VisitedSet_tests)
+
+BOOST_AUTO_TEST_CASE(test_resolve)
+{
+    const uint64_t max_array_ids = diskann::defaults::MAX_VISITED_ARRAY_BYTES / sizeof(VisitedSet::stamp_t);
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::AUTO, max_array_ids) == VisitedSetPolicy::EPOCH_ARRAY));
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::AUTO, max_array_ids + 1) == VisitedSetPolicy::BITSET));
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::AUTO, diskann::defaults::MAX_VISITED_BITSET_POINTS) ==
+                VisitedSetPolicy::BITSET));
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::AUTO, diskann::defaults::MAX_VISITED_BITSET_POINTS + 1) ==
+                VisitedSetPolicy::HASH_SET));
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::HASH_SET, 10) == VisitedSetPolicy::HASH_SET));
+    BOOST_TEST((VisitedSet::resolve(VisitedSetPolicy::EPOCH_ARRAY, 1ull << 40) == VisitedSetPolicy::EPOCH_ARRAY));
+
+    BOOST_TEST(VisitedSet::memory_usage(VisitedSetPolicy::EPOCH_ARRAY, 1000, 0) == 2000u);
+    BOOST_TEST(VisitedSet::memory_usage(VisitedSetPolicy::BITSET, 1000, 0) == 128u);
+}
+
+BOOST_AUTO_TEST_CASE(test_modes)
+{
+    for (auto policy : {VisitedSetPolicy::EPOCH_ARRAY, VisitedSetPolicy::BITSET, VisitedSetPolicy::HASH_SET})
+    {
+        VisitedSet visited;
+        visited.init(policy, 1000, 100);
+        BOOST_TEST((visited.mode() == policy));
+
+        for (int query = 0; query < 3; query++)
+        {
+            for (uint64_t id = query; id < 1000; id += 7)
+            {
+                BOOST_TEST(!visited.contains(id));
+                BOOST_TEST(visited.insert(id));
+                BOOST_TEST(!visited.insert(id));
+            }
+            for (uint64_t id = 0; id < 1000; id++)
+                BOOST_TEST(visited.contains(id) == (id >= (uint64_t)query && (id - query) % 7 == 0));
+            visited.clear();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_switch_mode)
+{
+    VisitedSet visited;
+    visited.init(VisitedSetPolicy::AUTO, 100, 10);
+    BOOST_TEST((visited.mode() == VisitedSetPolicy::EPOCH_ARRAY));
+    visited.insert(5);
+
+    // growing the index keeps the ids visited so far
+    visited.init(VisitedSetPolicy::AUTO, 200, 10);
+    BOOST_TEST(visited.contains(5));
+    BOOST_TEST(visited.insert(150));
+
+    visited.clear();
+    visited.init(VisitedSetPolicy::BITSET, 200, 10);
+    BOOST_TEST((visited.mode() == VisitedSetPolicy::BITSET));
+    BOOST_TEST(!visited.contains(150));
+    BOOST_TEST(visited.insert(199));
+
+    visited.clear();
+    visited.init(VisitedSetPolicy::HASH_SET, 200, 10);
+    BOOST_TEST((visited.mode() == VisitedSetPolicy::HASH_SET));
+    BOOST_TEST(!visited.contains(199));
+}
+
+// the 16-bit epoch wraps after 65535 clears; stamps left from before must not
+// read as visited afterwards
+BOOST_AUTO_TEST_CASE(test_epoch_wrap)
+{
+    VisitedSet visited;
+    visited.init(VisitedSetPolicy::EPOCH_ARRAY, 10, 0);
+
+    // stamped with epoch 1, the epoch the array returns to after wrapping
+    BOOST_TEST(visited.insert(1));
+    for (uint32_t i = 0; i < 65534; i++)
+    {
+        visited.clear();
+        BOOST_TEST(!visited.contains(1));
+    }
+
+    // the last epoch before the wrap
+    BOOST_TEST(visited.insert(2));
+    BOOST_TEST(visited.contains(2));
+    visited.clear();
+
+    for (uint64_t id = 0; id < 10; id++)
+        BOOST_TEST(!visited.contains(id));
+    BOOST_TEST(visited.insert(1));
+    BOOST_TEST(visited.insert(2));
+    BOOST_TEST(!visited.insert(2));
+
+    visited.clear();
+    BOOST_TEST(!visited.contains(1));
+    BOOST_TEST(!visited.contains(2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()